@@ -12,6 +12,7 @@ list(APPEND srcs
     "${CMAKE_CURRENT_LIST_DIR}/efuse.c"
     "${CMAKE_CURRENT_LIST_DIR}/gpio.c"
     "${CMAKE_CURRENT_LIST_DIR}/i2c.c"
+    "${CMAKE_CURRENT_LIST_DIR}/mmu.c"
     "${CMAKE_CURRENT_LIST_DIR}/rtc.c"
     "${CMAKE_CURRENT_LIST_DIR}/true-rng.c"
     "${CMAKE_CURRENT_LIST_DIR}/uart.c"
@@ -4,12 +4,14 @@
 
 #include <sys/errno.h>
 #include <sys/mutex.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <semaphore.h>
 
 #include <esp_log.h>
 
 #include <rtos/kernel.h>
+#include <rtos/devfs.h>
 #include <soc/soc_caps.h>
 #include <soc/i2c_reg.h>
 
@@ -29,6 +31,9 @@ void I2C1_IntrHandler(void *arg);
 #define I2C_SCL_FILTER_CYCLE        (5)
 #define I2C_SDA_FILTER_CYCLE        (5)
 
+// opened by /dev/i2c-N: bus speed until other fd has configured it, slave address by ioctl(I2C_SLAVE)
+#define I2C_DEVFS_DEFAULT_KBPS          (100)
+
 // I2C ext. errno, NEED to process before return to caller
 #define I2C_ERR_NACK                    (ESP_ERR_BASE + 1)
 
@@ -126,15 +131,21 @@ static unsigned I2C_fifo_read(i2c_dev_t *dev, void *buf, unsigned bufsize);
 static ssize_t I2C_read(int fd, void *buf, size_t bufsize);
 static ssize_t I2C_write(int fd, void const *buf, size_t count);
 static off_t I2C_seek(int fd, off_t offset, int mode);
+static int I2C_ioctl(int fd, unsigned long int request, va_list vl);
 static int I2C_close(int fd);
 
+static int I2C_open(struct I2C_context *context, uint16_t da, uint16_t kbps, uint8_t page_size, uint32_t highest_addr);
+static int I2C_devfs_open(void *arg, int flags);
+static uint8_t I2C_sa_bytes(uint32_t highest_addr);
+
 // const
 static struct FD_implement const implement =
 {
     .close  = I2C_close,
     .read   = I2C_read,
     .write  = I2C_write,
-    .seek   = I2C_seek
+    .seek   = I2C_seek,
+    .ioctl  = I2C_ioctl,
 };
 
 // var
@@ -164,6 +175,9 @@ void I2C_initialize()
         sem_init_np(&context->evt, 0, 0, 1);
         esp_intr_alloc(ETS_I2C_EXT1_INTR_SOURCE, ESP_INTR_FLAG_INTRDISABLED, I2C1_IntrHandler, context, &context->intr_hdl);
     }
+
+    DEVFS_register("i2c-0", S_IFCHR | S_IRUSR | S_IWUSR, I2C_devfs_open, &i2c_context[0]);
+    DEVFS_register("i2c-1", S_IFCHR | S_IRUSR | S_IWUSR, I2C_devfs_open, &i2c_context[1]);
 }
 
 /****************************************************************************
@@ -171,59 +185,12 @@ void I2C_initialize()
  ****************************************************************************/
 int I2C_createfd(int nb, uint16_t da, uint16_t kbps, uint8_t page_size, uint32_t highest_addr)
 {
-    struct I2C_context *context;
-
     if (SOC_I2C_NUM <= nb)
         return __set_errno_neg(ENODEV);
     if (1000 < kbps || 0 == kbps)
         return __set_errno_neg(EINVAL);
     else
-        context = &i2c_context[nb];
-
-    int retval = I2C_configure(context->dev, I2C_MASTER_MODE, kbps);
-    if (0 != retval)
-        return __set_errno_neg(retval);
-
-    struct I2C_fd_ext *ext = KERNEL_mallocz(sizeof(struct I2C_fd_ext));
-    if (NULL == ext)
-    {
-        I2C_deconfigure(context->dev);
-        return __set_errno_neg(ENOMEM);
-    }
-
-    int fd = KERNEL_createfd(FD_TAG_CHAR, &implement, ext);
-    if (-1 != fd)
-    {
-        context->fd_count ++;
-        context->kbps = kbps;
-
-        AsFD(fd)->read_rdy = AsFD(fd)->write_rdy = &context->lock;
-
-        ext->context = context;
-        ext->da = da;
-        ext->kbps = kbps;
-        ext->page_size = page_size;
-        ext->highest_addr = highest_addr;
-
-        if (0 == highest_addr)                      // no Addressing
-            ext->sa_bytes = 0;
-        else if (highest_addr < 256)                // 256 Bytes
-            ext->sa_bytes = 1;
-        else if (highest_addr < 256 * 256)          // 64k
-            ext->sa_bytes = 2;
-        else if (highest_addr < 256 * 256 * 256)    // 16m
-            ext->sa_bytes = 3;
-        else
-            ext->sa_bytes = 4;
-
-        esp_intr_enable(context->intr_hdl);
-    }
-    else
-    {
-        KERNEL_mfree(ext);
-        I2C_deconfigure(context->dev);
-    }
-    return fd;
+        return I2C_open(&i2c_context[nb], da, kbps, page_size, highest_addr);
 }
 
 int I2C_configure(i2c_dev_t *dev, enum I2C_mode_t mode, uint16_t kbps)
@@ -755,6 +722,27 @@ static off_t I2C_seek(int fd, off_t offset, int mode)
         return (off_t)AsFD(fd)->position;
 }
 
+static int I2C_ioctl(int fd, unsigned long int request, va_list vl)
+{
+    struct I2C_fd_ext *ext = (struct I2C_fd_ext *)AsFD(fd)->ext;
+
+    switch (request)
+    {
+    case I2C_SLAVE:
+    case I2C_SLAVE_FORCE:
+        ext->da = (uint16_t)va_arg(vl, int);
+        return 0;
+
+    case I2C_SA_HIGHEST:
+        ext->highest_addr = va_arg(vl, uint32_t);
+        ext->sa_bytes = I2C_sa_bytes(ext->highest_addr);
+        return 0;
+
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+}
+
 static int I2C_close(int fd)
 {
     struct I2C_fd_ext *ext = (struct I2C_fd_ext *)AsFD(fd)->ext;
@@ -833,3 +821,76 @@ void I2C0_IntrHandler(void *arg)
 
 void I2C1_IntrHandler(void *arg)
     __attribute__((alias("I2C_IntrHandler")));
+
+/****************************************************************************
+ *  @private
+ ****************************************************************************/
+static int I2C_open(struct I2C_context *context, uint16_t da, uint16_t kbps, uint8_t page_size, uint32_t highest_addr)
+{
+    /// controller is configured by first fd, the others share it and switch bps by I/O
+    if (0 == context->fd_count)
+    {
+        int retval = I2C_configure(context->dev, I2C_MASTER_MODE, kbps);
+        if (0 != retval)
+            return __set_errno_neg(retval);
+
+        context->kbps = kbps;
+    }
+
+    struct I2C_fd_ext *ext = KERNEL_mallocz(sizeof(struct I2C_fd_ext));
+    if (NULL == ext)
+    {
+        if (0 == context->fd_count)
+            I2C_deconfigure(context->dev);
+        return __set_errno_neg(ENOMEM);
+    }
+
+    int fd = KERNEL_createfd(FD_TAG_CHAR, &implement, ext);
+    if (-1 != fd)
+    {
+        context->fd_count ++;
+
+        AsFD(fd)->read_rdy = AsFD(fd)->write_rdy = &context->lock;
+
+        ext->context = context;
+        ext->da = da;
+        ext->kbps = kbps;
+        ext->page_size = page_size;
+        ext->highest_addr = highest_addr;
+        ext->sa_bytes = I2C_sa_bytes(highest_addr);
+
+        esp_intr_enable(context->intr_hdl);
+    }
+    else
+    {
+        KERNEL_mfree(ext);
+
+        if (0 == context->fd_count)
+            I2C_deconfigure(context->dev);
+    }
+    return fd;
+}
+
+static int I2C_devfs_open(void *arg, int flags)
+{
+    ARG_UNUSED(flags);
+    struct I2C_context *context = arg;
+
+    /// reuse bus speed of opened fds
+    uint16_t kbps = context->fd_count ? context->kbps : I2C_DEVFS_DEFAULT_KBPS;
+    return I2C_open(context, 0, kbps, 0, 0);
+}
+
+static uint8_t I2C_sa_bytes(uint32_t highest_addr)
+{
+    if (0 == highest_addr)                      // no Addressing
+        return 0;
+    else if (highest_addr < 256)                // 256 Bytes
+        return 1;
+    else if (highest_addr < 256 * 256)          // 64k
+        return 2;
+    else if (highest_addr < 256 * 256 * 256)    // 16m
+        return 3;
+    else
+        return 4;
+}
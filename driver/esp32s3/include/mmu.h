@@ -0,0 +1,41 @@
+#ifndef __ESP32S3_MMU_H
+#define __ESP32S3_MMU_H                 1
+
+#include <features.h>
+#include <stdint.h>
+#include <stddef.h>
+
+    /// maximum simultaneous mapped regions
+    #define MMU_MAX_MAPPED_REGIONS      (16)
+
+__BEGIN_DECLS
+
+    /**
+     *  MMU_map_flash()
+     *      map flash physical region into data bus (read only by cache)
+     *      MMU pages are reserved through esp-idf spi_flash_mmap(), they never collide with
+     *          esp_partition_mmap() / spi_flash_mmap() of other components
+     *  @returns
+     *      On Success virtual address of paddr is returned
+     *      On error, NULL is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: paddr region is out of flash addressable range
+     *      ENOMEM: no consecutive free MMU entries / mapping records
+     */
+extern __attribute__((nothrow))
+    void const *MMU_map_flash(uintptr_t paddr, size_t size);
+
+    /**
+     *  MMU_unmap()
+     *      release the reservation of region MMU_map_flash() returned by spi_flash_munmap()
+     *  @returns
+     *      On Success 0 is returned
+     *      On Error an errno shall be returned to indicate the error
+     *  @errors
+     *      EINVAL: vaddr is not mapped by MMU_map_flash()
+     */
+extern __attribute__((nothrow))
+    int MMU_unmap(void const *vaddr);
+
+__END_DECLS
+#endif
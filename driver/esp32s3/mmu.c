@@ -0,0 +1,107 @@
+#include <stdbool.h>
+#include <sys/errno.h>
+#include <sys/spinlock.h>
+
+#include "spi_flash_mmap.h"
+#include "mmu.h"
+
+/****************************************************************************
+ *  @def
+ ****************************************************************************/
+/**
+ *  MMU pages are reserved through esp-idf spi_flash_mmap(), the same bookkeeping of
+ *      esp_partition_mmap() / spi_flash_mmap() users, entries are never written behind its back
+ *  .a region records only the handle of the reservation for MMU_unmap() by address
+ */
+struct MMU_region
+{
+    uintptr_t vaddr;
+    size_t size;
+    spi_flash_mmap_handle_t handle;
+    bool used;
+};
+
+/****************************************************************************
+ *  @internal
+ ****************************************************************************/
+static spinlock_t MMU_lock = SPINLOCK_INITIALIZER;
+static struct MMU_region MMU_regions[MMU_MAX_MAPPED_REGIONS] = {0};
+
+/****************************************************************************
+ *  @implements
+ ****************************************************************************/
+void const *MMU_map_flash(uintptr_t paddr, size_t size)
+{
+    if (0 == size)
+        return __set_errno_nullptr(EINVAL);
+
+    struct MMU_region *region = NULL;
+
+    /// @reserve a record first, spi_flash_mmap() can not be called inside the spinlock
+    spin_lock(&MMU_lock);
+    for (unsigned i = 0; i < lengthof(MMU_regions); i ++)
+    {
+        if (! MMU_regions[i].used)
+        {
+            region = &MMU_regions[i];
+            region->used = true;
+            region->size = 0;
+            break;
+        }
+    }
+    spin_unlock(&MMU_lock);
+
+    if (! region)
+        return __set_errno_nullptr(ENOMEM);
+
+    uintptr_t page_base = paddr & ~(uintptr_t)(SPI_FLASH_MMU_PAGE_SIZE - 1);
+    size_t map_size = (size_t)(paddr - page_base) + size;
+    void const *ptr;
+    spi_flash_mmap_handle_t handle;
+
+    esp_err_t err = spi_flash_mmap(page_base, map_size, SPI_FLASH_MMAP_DATA, &ptr, &handle);
+    if (ESP_OK != err)
+    {
+        spin_lock(&MMU_lock);
+        region->used = false;
+        spin_unlock(&MMU_lock);
+
+        return __set_errno_nullptr(ESP_ERR_NO_MEM == err ? ENOMEM : EINVAL);
+    }
+
+    spin_lock(&MMU_lock);
+    region->vaddr = (uintptr_t)ptr;
+    region->size = map_size;
+    region->handle = handle;
+    spin_unlock(&MMU_lock);
+
+    return (uint8_t const *)ptr + (paddr - page_base);
+}
+
+int MMU_unmap(void const *vaddr)
+{
+    spi_flash_mmap_handle_t handle = 0;
+    int retval = EINVAL;
+
+    spin_lock(&MMU_lock);
+    for (unsigned i = 0; i < lengthof(MMU_regions); i ++)
+    {
+        struct MMU_region *iter = &MMU_regions[i];
+
+        /// size is 0 while the reservation is still in progress
+        if (iter->used && (uintptr_t)vaddr >= iter->vaddr && (uintptr_t)vaddr < iter->vaddr + iter->size)
+        {
+            handle = iter->handle;
+            iter->used = false;
+            iter->size = 0;
+
+            retval = 0;
+            break;
+        }
+    }
+    spin_unlock(&MMU_lock);
+
+    if (0 == retval)
+        spi_flash_munmap(handle);
+    return retval;
+}
@@ -1,11 +1,23 @@
 #include <sched.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/errno.h>
+#include <sys/stat.h>
 #include <semaphore.h>
+#include <sys/mutex.h>
+#include <sys/spinlock.h>
 
 #include <rtos/kernel.h>
+#include <rtos/devfs.h>
+#include <rtos/bytering.h>
+#include <soc/soc.h>
 #include <soc/soc_caps.h>
 #include <soc/uart_reg.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/uhci_struct.h>
+#include <soc/gdma_struct.h>
+#include <soc/gdma_channel.h>
 
 #include <esp_attr.h>
 #include <esp_log.h>
@@ -24,6 +36,69 @@ static __attribute__((used)) char const *RS485_TAG = "rs485";
  ****************************************************************************/
 extern int __stdout_fd;
 
+/// configuration of /dev/ttySN until it was configured by UART_createfd()
+#define UART_DEVFS_DEFAULT_BPS          (115200)
+
+/// software RX ring of each fd opened device, power of 2
+#ifndef UART_RX_RING_SIZE
+    #define UART_RX_RING_SIZE           (1024)
+#endif
+/// RX fifo level of interrupt, SOC_UART_FIFO_LEN is 128
+#ifndef UART_RX_FIFO_LEVEL
+    #define UART_RX_FIFO_LEVEL          (96)
+#endif
+/// RX idle bit times of interrupt to drain the tail of burst
+#ifndef UART_RX_IDLE_BITS
+    #define UART_RX_IDLE_BITS           (10)
+#endif
+
+/// software TX ring of each fd opened device, power of 2
+#ifndef UART_TX_RING_SIZE
+    #define UART_TX_RING_SIZE           (1024)
+#endif
+/// TX fifo level of refilling interrupt
+#ifndef UART_TX_FIFO_LEVEL
+    #define UART_TX_FIFO_LEVEL          (32)
+#endif
+
+#define UART_INTR_RX                    (UART_INTR_RXFIFO_FULL | UART_INTR_RXFIFO_TOUT | UART_INTR_RXFIFO_OVF)
+
+#define UART_PIN_NONE                   (0xFF)
+#define UART_XON_CHAR                   (0x11)
+#define UART_XOFF_CHAR                  (0x13)
+
+/// UHCI0 DMA: rx is a circular chain of blocks, tx links descriptors over the written buffer
+#ifndef UART_DMA_RX_BLOCKS
+    #define UART_DMA_RX_BLOCKS          (4)
+#endif
+#ifndef UART_DMA_RX_BLOCK_SIZE
+    #define UART_DMA_RX_BLOCK_SIZE      (512)
+#endif
+#ifndef UART_DMA_TX_DESCS
+    #define UART_DMA_TX_DESCS           (4)
+#endif
+/// tx of buffer out of DMA capable memory, ex. flash rodata / psram
+#ifndef UART_DMA_TX_BOUNCE_SIZE
+    #define UART_DMA_TX_BOUNCE_SIZE     (256)
+#endif
+
+#define GDMA_DESC_MAX_SIZE              (4092)
+#define GDMA_PERI_SEL_NONE              (0x3F)
+
+/// SLIP frame in rx ring: 2 bytes little endian length followed by payload
+#define UART_FRAME_MAX                  (0x7FFF)
+#define UART_FRAME_DROPPED              (0x8000)
+
+/// frame ends queued by rx line idle
+#ifndef UART_IDLE_FRAMES
+    #define UART_IDLE_FRAMES            (8)
+#endif
+
+/// console ring of each core
+#ifndef UART_CONSOLE_RING_SIZE
+    #define UART_CONSOLE_RING_SIZE      (1024)
+#endif
+
 void UART0_IntrHandler(void *arg);
 void UART1_IntrHandler(void *arg);
 void UART2_IntrHandler(void *arg);
@@ -94,20 +169,96 @@ struct UART_gpio_cfg
     uint8_t CTS_pin_nb;
 };
 
+/// written back by DMA: volatile, the owner bit is polled by ISR
+struct GDMA_desc
+{
+    volatile uint32_t size: 12;
+    volatile uint32_t length: 12;
+    volatile uint32_t reserved24: 4;
+    volatile uint32_t err_eof: 1;
+    volatile uint32_t reserved29: 1;
+    volatile uint32_t suc_eof: 1;
+    volatile uint32_t owner: 1;         // 1: DMA, written back 0 by DMA
+    void *volatile buf;
+    struct GDMA_desc *volatile next;
+};
+
 struct UART_context
 {
     struct UART_gpio_cfg gpio_cfg;
     uart_dev_t *dev;
     intr_handle_t intr_hdl;
+    /// int_ena is modified by tasks and ISR of both cores, every read-modify-write holds it
+    spinlock_t intr_lock;
 
     uint32_t bps;
+    /// cached configuration: opening /dev/ttySN reuses it
+    enum UART_parity_t parity;
+    enum UART_stopbits_t stopbits;
+    /// fds sharing the configured device, deconfigure by last close(), modified with intr_lock
+    uint32_t fd_count;
+
+    /**
+     *  rx: ISR drains fifo into rx_ring, readers are serialized by rd_lock
+     *      .read_rdy is a hint, it is given by ISR and re-given by read() when anything is left
+     *      .rx_stalled: ring was full, RX interrupts are disabled until read() makes room
+     */
+    bytering_t rx_ring;
+    uint8_t *rx_buf;
+    mutex_t rd_lock;
+    bool rx_stalled;
+
+    uint32_t rx_ring_size;
+    uint16_t rxfifo_full_thrhd;
+    uint16_t rx_tout_thrhd;
+    /// UART_DMA_NONE: rx / tx through fifo by cpu
+    enum UART_dma_t dma;
+
+    /**
+     *  flow control by rx fifo level: a stalled rx ring leaves bytes in fifo, the peer is held by
+     *      RTS / XOFF until read() makes room
+     */
+    enum UART_flow_t flow;
+    uint16_t flow_thrhd;
+
+    /**
+     *  rs485: DE is driven by RTS under hardware RS485 mode, setup / hold delays are timed by rs485_conf
+     *      .collisions: RS485_CLASH counted by ISR
+     *  frame_idle_bits: read() returns one frame delimited by rx line idle
+     *      .ISR queues frame ends by total bytes received, read() dequeues them by total bytes delivered
+     *      .rx_idle_pending: the line became idle when rx was stalled
+     */
+    enum UART_rs485_t rs485;
+    uint8_t rs485_tx_dly;
+    uint8_t rs485_turnaround;
+    uint16_t frame_idle_bits;
+    uint32_t collisions;
+
+    bool rx_idle_pending;
+    uint32_t rx_received;
+    uint32_t rx_delivered;
+    uint32_t frame_last;
+    uint32_t frame_head;
+    uint32_t frame_tail;
+    uint32_t frame_end[UART_IDLE_FRAMES];
+
+    /**
+     *  tx: write() copies into tx_ring and returns, ISR refills fifo by its empty threshold
+     *      .writers are serialized by wr_lock, they wait when tx_hiwat bytes are queued
+     *      .write_rdy is a hint, it is given by ISR when queued bytes fall below tx_hiwat
+     *      .tx_idle is given by ISR when everything queued was shifted out, see tcdrain()
+     */
+    bytering_t tx_ring;
+    uint8_t *tx_buf;
+    mutex_t wr_lock;
+
+    uint32_t tx_ring_size;
+    uint32_t tx_hiwat;
+    uint16_t txfifo_empty_thrhd;
 
     sem_t read_rdy;
     sem_t write_rdy;
-
-    // tx write ptr
-    uint8_t *tx_ptr;
-    uint8_t *tx_end;
+    sem_t tx_idle;
 };
 
 /****************************************************************************
@@ -116,10 +267,25 @@ struct UART_context
 static PERIPH_module_t UART_periph_module(uart_dev_t *dev, struct UART_context **context);
 static void UART_configure_bps(uart_dev_t *dev, uint32_t bps);
 static void UART_configure_context_bps(struct UART_context *context, uart_dev_t *dev);
+static int UART_route_pins(struct UART_context *context);
+static uint32_t UART_timeo(int fd, uint32_t timeo);
+static void UART_rx_drain(struct UART_context *context, uart_dev_t *dev, bool idle);
+static void UART_rx_resume(struct UART_context *context);
+static bool UART_rx_pending(struct UART_context *context);
+static void UART_frame_end(struct UART_context *context);
+static ssize_t UART_idle_frame_read(struct UART_context *context, void *buf, size_t bufsize);
+static size_t UART_tx_room(struct UART_context *context);
+static bool UART_tx_busy(struct UART_context *context, uart_dev_t *dev);
+static void UART_tx_refill(struct UART_context *context, uart_dev_t *dev);
+static void UART_tx_drain(struct UART_context *context);
+static void UART_intr_update(struct UART_context *context, uart_dev_t *dev, uint32_t disable, uint32_t enable);
+static int UART_release(struct UART_context *context, uint32_t write_timeo);
 // io
 static ssize_t UART_read(int fd, void *buf, size_t bufsize);
 static ssize_t UART_write(int fd, void const *buf, size_t count);
 static int UART_close(int fd);
+static int UART_sync(int fd);
+static int UART_devfs_open(void *arg, int flags);
 
 // const
 static struct FD_implement const implement =
@@ -127,24 +293,214 @@ static struct FD_implement const implement =
     .close = UART_close,
     .read = UART_read,
     .write = UART_write,
+    .sync = UART_sync,
+};
+
+/**
+ *  UHCI0 is the only UART DMA bridge, it serves one uart at a time
+ *      .rx: GDMA fills the circular chain, ISR moves completed blocks into the rx ring
+ *      .tx: write() links descriptors over its buffer and waits the last one was written back,
+ *          by write_timeo: the round is stopped when it timed out
+ *      .tx non-blocking: one round from the bounce buffer, .tx_pending is waited by the next write() / fsync()
+ *      .tx_lock: ISR completing the round against write() stopping it
+ */
+struct UART_dma
+{
+    struct UART_context *context;
+    unsigned ch;
+    intr_handle_t rx_intr;
+    intr_handle_t tx_intr;
+
+    struct GDMA_desc *rx_next;
+    struct GDMA_desc *tx_last;
+    bool tx_pending;
+    spinlock_t tx_lock;
+    sem_t tx_done;
+
+    /// SLIP frame being received, header is reserved in rx ring when the frame begins
+    struct
+    {
+        bool open;
+        bool dropped;
+        uint8_t *hdr[2];
+        uint32_t len;
+    } frame;
+
+    struct GDMA_desc rx_desc[UART_DMA_RX_BLOCKS];
+    struct GDMA_desc tx_desc[UART_DMA_TX_DESCS];
+    uint8_t rx_blocks[UART_DMA_RX_BLOCKS][UART_DMA_RX_BLOCK_SIZE] __attribute__((aligned(4)));
+    uint8_t tx_bounce[UART_DMA_TX_BOUNCE_SIZE] __attribute__((aligned(4)));
+};
+
+static int UART_dma_start(struct UART_context *context, int nb);
+static void UART_dma_stop(void);
+static ssize_t UART_dma_tx(void const *buf, size_t count, uint32_t timeo);
+static int UART_dma_tx_wait(uint32_t timeo);
+static void UART_dma_tx_abort(void);
+static ssize_t UART_frame_read(bytering_t *ring, void *buf, size_t bufsize);
+static void UART_dma_rx_intr(void *arg);
+static void UART_dma_tx_intr(void *arg);
+
+/**
+ *  console: console_write() appends to the ring of running core and returns, UART0 ISR drains rings into fifo
+ *      .producers never lock, drain_lock serializes the consumer side: ISR, dropping oldest and flushing
+ *      .room is a hint for UART_CONSOLE_BLOCK writers, it is given by ISR when anything was drained
+ *      .sync: written through fifo by spinning, until UART_initialize() and since UART_console_panic()
+ */
+struct UART_console
+{
+    bool sync;
+    enum UART_console_overflow_t overflow;
+    unsigned curr;
+    uint32_t dropped;
+
+    spinlock_t drain_lock;
+    sem_t room;
+
+    bytering_t ring[SOC_CPU_CORES_NUM];
+    uint8_t buf[SOC_CPU_CORES_NUM][UART_CONSOLE_RING_SIZE];
 };
 
+static bool UART_console_refill(uart_dev_t *dev);
+static bool UART_console_pending(void);
+static void UART_console_flush(uart_dev_t *dev);
+static void UART_console_IntrHandler(uart_dev_t *dev);
+static void UART_ring_discard(bytering_t *ring, size_t count);
+
 // var
-static struct UART_context uart_context[SOC_UART_NUM] = {0};
+static struct UART_context uart_context[SOC_UART_NUM] =
+{
+    [0 ... SOC_UART_NUM - 1] =
+    {
+        .intr_lock = SPINLOCK_INITIALIZER,
+        .rd_lock = MUTEX_INITIALIZER,
+        .wr_lock = MUTEX_INITIALIZER,
+    },
+};
+
+static struct UART_dma UART_dma =
+{
+    .tx_lock = SPINLOCK_INITIALIZER,
+};
+
+static struct UART_console UART_console =
+{
+    .sync = true,
+    .overflow = UART_CONSOLE_DROP_OLDEST,
+    .drain_lock = SPINLOCK_INITIALIZER,
+};
 
 /****************************************************************************
  *  @implements: console io, esp32s3 always enable UART0 as console
  ****************************************************************************/
 ssize_t console_write(void const *buf, size_t count)
 {
+    if (UART_console.sync)
+    {
+        size_t written = 0;
+
+        while (written < count)
+            written += (size_t)UART_fifo_write(&UART0, (uint8_t *)buf + written, count - written);
+
+        return (ssize_t)count;
+    }
+
+    /// a task may be moved to the other core meanwhile, it keeps writing the same ring
+    bytering_t *ring = &UART_console.ring[__get_CORE_ID()];
     size_t written = 0;
 
-    while (written < count)
-        written += (size_t)UART_fifo_write(&UART0, (uint8_t *)buf + written, count - written);
+    while (true)
+    {
+        written += bytering_write(ring, (uint8_t const *)buf + written, count - written);
+        UART_intr_update(&uart_context[0], &UART0, 0, UART_INTR_TXFIFO_EMPTY);
+
+        if (written == count)
+            break;
+
+        if (UART_CONSOLE_BLOCK == UART_console.overflow)
+        {
+            // ISR or interrupts disabled: drain by itself
+            if (0 != __get_IPSR())
+                UART_console_refill(&UART0);
+            else
+                sem_wait(&UART_console.room);
+        }
+        else
+        {
+            spin_lock(&UART_console.drain_lock);
+
+            size_t dropping = bytering_readable(ring);
+            if (dropping > count - written)
+                dropping = count - written;
+            UART_ring_discard(ring, dropping);
+
+            spin_unlock(&UART_console.drain_lock);
 
+            /// nothing is droppable: the ring is reserved by preempted writers, the rest of this write is dropped
+            if (0 == dropping)
+            {
+                __atomic_add_fetch(&UART_console.dropped, (uint32_t)(count - written), __ATOMIC_RELAXED);
+                break;
+            }
+            __atomic_add_fetch(&UART_console.dropped, (uint32_t)dropping, __ATOMIC_RELAXED);
+        }
+    }
     return (ssize_t)count;
 }
 
+int console_drain(void)
+{
+    if (UART_console.sync)
+        return 0;
+
+    while (UART_console_pending())
+    {
+        if (0 != __get_IPSR())
+            UART_console_refill(&UART0);
+        else
+        {
+            UART_intr_update(&uart_context[0], &UART0, 0, UART_INTR_TXFIFO_EMPTY);
+            sem_wait(&UART_console.room);
+        }
+    }
+
+    while (0 != UART0.status.txfifo_cnt || 0 != UART0.fsm_status.st_utx_out)
+        sched_yield();
+
+    return 0;
+}
+
+int UART_console_configure(enum UART_console_overflow_t overflow)
+{
+    switch (overflow)
+    {
+    case UART_CONSOLE_DROP_OLDEST:
+    case UART_CONSOLE_BLOCK:
+        UART_console.overflow = overflow;
+        return 0;
+
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+}
+
+uint32_t UART_console_dropped(void)
+{
+    return __atomic_load_n(&UART_console.dropped, __ATOMIC_RELAXED);
+}
+
+void UART_console_panic(void)
+{
+    if (UART_console.sync)
+        return;
+
+    UART_console.sync = true;
+    /// the other core was stalled, intr_lock maybe held by it is ignored
+    UART0.int_ena.txfifo_empty_int_ena = 0;
+
+    UART_console_flush(&UART0);
+}
+
 /****************************************************************************
  *  @implements
  ****************************************************************************/
@@ -155,11 +511,50 @@ void UART_initialize(void)
     esp_intr_alloc(ETS_UART0_INTR_SOURCE, ESP_INTR_FLAG_INTRDISABLED, UART0_IntrHandler, &uart_context[0], &uart_context[0].intr_hdl);
     esp_intr_alloc(ETS_UART1_INTR_SOURCE, ESP_INTR_FLAG_INTRDISABLED, UART1_IntrHandler, &uart_context[1], &uart_context[1].intr_hdl);
     esp_intr_alloc(ETS_UART2_INTR_SOURCE, ESP_INTR_FLAG_INTRDISABLED, UART2_IntrHandler, &uart_context[2], &uart_context[2].intr_hdl);
+
+    for (unsigned i = 0; i < lengthof(uart_context); i ++)
+    {
+        struct UART_context *context = &uart_context[i];
+        char name[] = "ttyS0";
+
+        context->bps = UART_DEVFS_DEFAULT_BPS;
+        context->parity = UART_PARITY_NONE;
+        context->stopbits = UART_STOP_BITS_ONE;
+
+        context->rx_ring_size = UART_RX_RING_SIZE;
+        context->rxfifo_full_thrhd = UART_RX_FIFO_LEVEL;
+        context->rx_tout_thrhd = UART_RX_IDLE_BITS;
+
+        context->tx_ring_size = UART_TX_RING_SIZE;
+        context->tx_hiwat = UART_TX_RING_SIZE;
+        context->txfifo_empty_thrhd = UART_TX_FIFO_LEVEL;
+
+        context->gpio_cfg.TXD_pin_nb = context->gpio_cfg.RXD_pin_nb = UART_PIN_NONE;
+        context->gpio_cfg.RTS_pin_nb = context->gpio_cfg.CTS_pin_nb = UART_PIN_NONE;
+
+        name[4] = (char)('0' + i);
+        DEVFS_register(name, S_IFCHR | S_IRUSR | S_IWUSR, UART_devfs_open, context);
+    }
+
+    // default pins of iomux
+    uart_context[0].gpio_cfg.TXD_pin_nb = (uint8_t)(IOMUX_UART0_TXD >> 12);
+    uart_context[0].gpio_cfg.RXD_pin_nb = (uint8_t)(IOMUX_UART0_RXD >> 12);
+    uart_context[1].gpio_cfg.TXD_pin_nb = (uint8_t)(IOMUX_UART1_TXD >> 12);
+    uart_context[1].gpio_cfg.RXD_pin_nb = (uint8_t)(IOMUX_UART1_RXD >> 12);
+
+    for (unsigned i = 0; i < lengthof(UART_console.ring); i ++)
+        bytering_init(&UART_console.ring[i], UART_console.buf[i], UART_CONSOLE_RING_SIZE);
+    sem_init_np(&UART_console.room, 0, 0, 1);
+
+    // console is buffered from now, UART0 interrupt drains it before UART0 was opened
+    UART_intr_update(&uart_context[0], &UART0, (uint32_t)~0, 0);
+    UART_console.sync = false;
+    esp_intr_enable(uart_context[0].intr_hdl);
 }
 
 int UART_createfd(int nb, uint32_t bps, enum UART_parity_t parity, enum UART_stopbits_t stopbits)
 {
-    if (SOC_UART_NUM < (unsigned)nb)
+    if (SOC_UART_NUM <= (unsigned)nb)
         return __set_errno_neg(EINVAL);
 
     struct UART_context *context = &uart_context[nb];
@@ -182,29 +577,313 @@ int UART_createfd(int nb, uint32_t bps, enum UART_parity_t parity, enum UART_sto
         break;
     }
 
+    int err;
+    int fd;
+
+    context->rx_buf = KERNEL_malloc(context->rx_ring_size);
+    if (NULL == context->rx_buf)
+    {
+        err = ENOMEM;
+        goto uart_createfd_rx_buf_fail;
+    }
+
+    // DMA mode transmits from the written buffer
+    if (UART_DMA_NONE == context->dma)
+    {
+        context->tx_buf = KERNEL_malloc(context->tx_ring_size);
+        if (NULL == context->tx_buf)
+        {
+            err = ENOMEM;
+            goto uart_createfd_tx_buf_fail;
+        }
+        bytering_init(&context->tx_ring, context->tx_buf, context->tx_ring_size);
+    }
+
+    bytering_init(&context->rx_ring, context->rx_buf, context->rx_ring_size);
+    context->rx_stalled = false;
+
+    context->rx_idle_pending = false;
+    context->rx_received = context->rx_delivered = 0;
+    context->frame_last = context->frame_head = context->frame_tail = 0;
+    context->collisions = 0;
+
     sem_init_np(&context->read_rdy, 0, 0, 1);
     sem_init_np(&context->write_rdy, 0, 1, 1);
+    sem_init_np(&context->tx_idle, 0, 0, 1);
 
-    int retval = UART_configure(dev, bps, parity, stopbits);
+    err = UART_configure(dev, bps, parity, stopbits);
+    if (0 != err)
+        goto uart_createfd_configure_fail;
 
-    if (0 == retval)
+    if (UART_DMA_NONE != context->dma)
     {
-        retval = KERNEL_createfd(FD_TAG_CHAR, &implement, context);
-        // use first uart as stdout when no stdout fd is assigned
-        if (-1 == __stdout_fd)
-            __stdout_fd = retval;
+        err = UART_dma_start(context, nb);
+        if (0 != err)
+            goto uart_createfd_dma_fail;
     }
-    else
-        retval = __set_errno_neg(retval);
 
+    fd = KERNEL_createfd(FD_TAG_CHAR, &implement, context);
+    if (-1 == fd)
+    {
+        err = errno;
+        goto uart_createfd_fd_fail;
+    }
+    AsFD(fd)->read_rdy = &context->read_rdy;
+    AsFD(fd)->write_rdy = &context->write_rdy;
+
+    context->parity = parity;
+    context->stopbits = stopbits;
+
+    spin_lock(&context->intr_lock);
+    context->fd_count = 1;
+    spin_unlock(&context->intr_lock);
+
+    // use first uart as stdout when no stdout fd is assigned
+    if (-1 == __stdout_fd)
+        __stdout_fd = fd;
+
+    /// UART0 interrupt is dispatched to console before the device is set
     context->dev = dev;
+
+    // rx is always on, one interrupt drains a burst by fifo threshold or idle timeout
+    if (UART_DMA_NONE == context->dma)
+        UART_intr_update(context, dev, 0, UART_INTR_RX);
+
     esp_intr_enable(context->intr_hdl);
-    return retval;
+    return fd;
+
+uart_createfd_fd_fail:
+    if (UART_DMA_NONE != context->dma)
+        UART_dma_stop();
+uart_createfd_dma_fail:
+    UART_deconfigure(dev);
+uart_createfd_configure_fail:
+    if (NULL != context->tx_buf)
+    {
+        KERNEL_mfree(context->tx_buf);
+        context->tx_buf = NULL;
+    }
+uart_createfd_tx_buf_fail:
+    KERNEL_mfree(context->rx_buf);
+    context->rx_buf = NULL;
+uart_createfd_rx_buf_fail:
+    return __set_errno_neg(err);
+}
+
+int UART_rx_configure(int nb, uint32_t ring_size, unsigned fifo_thrhd, unsigned idle_bits)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+    if (0 == ring_size || 0 != (ring_size & (ring_size - 1)))
+        return __set_errno_neg(EINVAL);
+    if (0 == fifo_thrhd || SOC_UART_FIFO_LEN <= fifo_thrhd)
+        return __set_errno_neg(EINVAL);
+    if (0 == idle_bits || UART_RX_TOUT_THRHD_V < idle_bits)
+        return __set_errno_neg(EINVAL);
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+
+    context->rx_ring_size = ring_size;
+    context->rxfifo_full_thrhd = (uint16_t)fifo_thrhd;
+    context->rx_tout_thrhd = (uint16_t)idle_bits;
+    return 0;
+}
+
+int UART_tx_configure(int nb, uint32_t ring_size, uint32_t hiwat, unsigned fifo_thrhd)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+    if (0 == ring_size || 0 != (ring_size & (ring_size - 1)))
+        return __set_errno_neg(EINVAL);
+    if (0 == hiwat || ring_size < hiwat)
+        return __set_errno_neg(EINVAL);
+    if (SOC_UART_FIFO_LEN <= fifo_thrhd)
+        return __set_errno_neg(EINVAL);
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+
+    context->tx_ring_size = ring_size;
+    context->tx_hiwat = hiwat;
+    context->txfifo_empty_thrhd = (uint16_t)fifo_thrhd;
+    return 0;
+}
+
+int UART_dma_configure(int nb, enum UART_dma_t mode)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+
+    switch (mode)
+    {
+    default:
+        return __set_errno_neg(EINVAL);
+    case UART_DMA_NONE:
+    case UART_DMA_STREAM:
+    case UART_DMA_SLIP:
+        break;
+    }
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+
+    if (UART_DMA_NONE != mode)
+    {
+        // DE and frame ends are driven by ISR through fifo
+        if (UART_RS485_NONE != context->rs485 || 0 != context->frame_idle_bits)
+            return __set_errno_neg(EINVAL);
+
+        for (unsigned i = 0; i < lengthof(uart_context); i ++)
+        {
+            if (context != &uart_context[i] && UART_DMA_NONE != uart_context[i].dma)
+                return __set_errno_neg(EBUSY);
+        }
+    }
+
+    context->dma = mode;
+    return 0;
+}
+
+int UART_rs485_configure(int nb, enum UART_rs485_t mode, unsigned tx_delay_bits, unsigned turnaround_bits,
+    unsigned frame_idle_bits)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+
+    switch (mode)
+    {
+    default:
+        return __set_errno_neg(EINVAL);
+    case UART_RS485_NONE:
+    case UART_RS485_HALF_DUPLEX:
+    case UART_RS485_COLLISION_DETECT:
+        break;
+    }
+    if (UART_RS485_TX_DLY_NUM_V < tx_delay_bits || 2 < turnaround_bits)
+        return __set_errno_neg(EINVAL);
+    if (UART_RX_TOUT_THRHD_V < frame_idle_bits)
+        return __set_errno_neg(EINVAL);
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+    if ((UART_RS485_NONE != mode || 0 != frame_idle_bits) && UART_DMA_NONE != context->dma)
+        return __set_errno_neg(EINVAL);
+    // RTS is flow control
+    if (UART_RS485_NONE != mode && UART_FLOW_RTS_CTS == context->flow)
+        return __set_errno_neg(EINVAL);
+
+    context->rs485 = mode;
+    context->rs485_tx_dly = (uint8_t)tx_delay_bits;
+    context->rs485_turnaround = (uint8_t)turnaround_bits;
+    context->frame_idle_bits = (uint16_t)frame_idle_bits;
+    return 0;
+}
+
+uint32_t UART_rs485_collisions(int nb)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return 0;
+    else
+        return __atomic_load_n(&uart_context[nb].collisions, __ATOMIC_RELAXED);
+}
+
+int UART_flow_configure(int nb, enum UART_flow_t flow, unsigned rx_thrhd)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+
+    switch (flow)
+    {
+    default:
+        return __set_errno_neg(EINVAL);
+    case UART_FLOW_NONE:
+        break;
+    case UART_FLOW_RTS_CTS:
+    case UART_FLOW_XON_XOFF:
+        if (2 > rx_thrhd || SOC_UART_FIFO_LEN <= rx_thrhd)
+            return __set_errno_neg(EINVAL);
+        break;
+    }
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+    // RTS is DE of RS485
+    if (UART_FLOW_RTS_CTS == flow && UART_RS485_NONE != context->rs485)
+        return __set_errno_neg(EINVAL);
+
+    context->flow = flow;
+    context->flow_thrhd = (uint16_t)rx_thrhd;
+    return 0;
+}
+
+int UART_pins_configure(int nb, int txd, int rxd, int rts, int cts)
+{
+    if (SOC_UART_NUM <= (unsigned)nb)
+        return __set_errno_neg(EINVAL);
+    if (SOC_GPIO_PIN_COUNT <= txd || SOC_GPIO_PIN_COUNT <= rxd ||
+        SOC_GPIO_PIN_COUNT <= rts || SOC_GPIO_PIN_COUNT <= cts)
+    {
+        return __set_errno_neg(EINVAL);
+    }
+
+    struct UART_context *context = &uart_context[nb];
+    if (NULL != context->dev)
+        return __set_errno_neg(EBUSY);
+
+    context->gpio_cfg.TXD_pin_nb = 0 > txd ? UART_PIN_NONE : (uint8_t)txd;
+    context->gpio_cfg.RXD_pin_nb = 0 > rxd ? UART_PIN_NONE : (uint8_t)rxd;
+    context->gpio_cfg.RTS_pin_nb = 0 > rts ? UART_PIN_NONE : (uint8_t)rts;
+    context->gpio_cfg.CTS_pin_nb = 0 > cts ? UART_PIN_NONE : (uint8_t)cts;
+    return 0;
+}
+
+int UART_autobaud(int nb, unsigned edges, uint32_t timeout)
+{
+    if (SOC_UART_NUM <= (unsigned)nb || 2 > edges || UART_RXD_EDGE_CNT_V < edges)
+        return __set_errno_neg(EINVAL);
+
+    struct UART_context *context = &uart_context[nb];
+    uart_dev_t *dev = context->dev;
+    if (NULL == dev)
+        return __set_errno_neg(ENODEV);
+
+    // restart counters
+    dev->conf0.autobaud_en = 0;
+    dev->conf0.autobaud_en = 1;
+
+    for (uint32_t elapsed = 0; edges > dev->rxd_cnt.rxd_edge_cnt; elapsed ++)
+    {
+        if (elapsed >= timeout)
+        {
+            dev->conf0.autobaud_en = 0;
+            return __set_errno_neg(ETIMEDOUT);
+        }
+        msleep(1);
+    }
+
+    /// the shortest low / high pulses are one bit each, counted by sclk
+    uint32_t bit_cycles = (dev->lowpulse.lowpulse_min_cnt + dev->highpulse.highpulse_min_cnt + 2) / 2;
+    dev->conf0.autobaud_en = 0;
+
+    uint32_t bps = CLK_uart_sclk_freq(dev) / bit_cycles;
+
+    while (dev->id.reg_update);
+    UART_configure_bps(dev, bps);
+    dev->id.reg_update = 1;
+
+    return (int)bps;
 }
 
 int UART_configure(uart_dev_t *dev, uint32_t bps, enum UART_parity_t parity, enum UART_stopbits_t stopbits)
 {
-    PERIPH_module_t uart_module = UART_periph_module(dev, NULL);
+    struct UART_context *context;
+    PERIPH_module_t uart_module = UART_periph_module(dev, &context);
 
     if (PERIPH_MODULE_MAX == uart_module)
         return ENODEV;
@@ -214,13 +893,9 @@ int UART_configure(uart_dev_t *dev, uint32_t bps, enum UART_parity_t parity, enu
         // UART0 is default esp-idf enabled debug tracing port, it always enabled, but still we need to taking control
         if (PERIPH_UART0_MODULE == uart_module)
         {
-            dev->int_ena.val = 0;
+            UART_intr_update(context, dev, (uint32_t)~0, 0);
             dev->int_clr.val = (uint32_t)~0;
             while (0 != dev->status.txfifo_cnt) sched_yield();
-
-            // this is not sdk configurable, always TXD = 43, RXD = 44
-            IOMUX_configure(IOMUX_UART0_TXD);
-            IOMUX_configure(IOMUX_UART0_RXD);
         }
         else
             return EBUSY;
@@ -228,10 +903,12 @@ int UART_configure(uart_dev_t *dev, uint32_t bps, enum UART_parity_t parity, enu
     else
         CLK_periph_enable(uart_module);
 
-    // TODO: uing sdkconfig to configure UART1/UART2 pins
     while (dev->id.reg_update);
 
-    int retval;
+    int retval = UART_route_pins(context);
+    if (0 != retval)
+        goto uart_configure_fail_exit;
+
     // uart normal
     dev->rs485_conf.val = 0;
     dev->conf0.irda_en = 0;
@@ -277,14 +954,74 @@ int UART_configure(uart_dev_t *dev, uint32_t bps, enum UART_parity_t parity, enu
 
     UART_configure_bps(dev, bps);
 
-    dev->conf1.rxfifo_full_thrhd = 1;
+    unsigned rxfifo_full_thrhd = context->rxfifo_full_thrhd;
+    // fifo is drained before the peer is held
+    if (UART_FLOW_NONE != context->flow && rxfifo_full_thrhd >= context->flow_thrhd)
+        rxfifo_full_thrhd = context->flow_thrhd - 1U;
+
+    if (0 == context->frame_idle_bits)
+        dev->mem_conf.rx_tout_thrhd = BIT_WIDTH_OF(10, context->rx_tout_thrhd);
+    else
+    {
+        // one byte is left in fifo until the line is idle, see UART_rx_drain()
+        if (2 > rxfifo_full_thrhd)
+            rxfifo_full_thrhd = 2;
+        dev->mem_conf.rx_tout_thrhd = BIT_WIDTH_OF(10, context->frame_idle_bits);
+        // transmitted frames are separated by the same idle
+        dev->idle_conf.tx_idle_num = BIT_WIDTH_OF(10, context->frame_idle_bits);
+    }
+    dev->conf1.rxfifo_full_thrhd = BIT_WIDTH_OF(10, rxfifo_full_thrhd);
+    dev->conf1.rx_tout_en = 1;
+    dev->conf1.txfifo_empty_thrhd = BIT_WIDTH_OF(10, context->txfifo_empty_thrhd);
+
+    if (UART_RS485_NONE != context->rs485)
+    {
+        // hardware RS485: transmitter drives RTS as DE, no toggling by ISR
+        dev->conf0.irda_dplx = 0;
+        dev->conf0.loopback = 0;
+
+        /// collision detect: receiver hears the echo, hardware compares it with transmitted
+        dev->rs485_conf.rs485tx_rx_en = UART_RS485_COLLISION_DETECT == context->rs485;
+        /// transmitter waits the bus is quiet
+        dev->rs485_conf.rs485rxby_tx_en = 0;
+        dev->rs485_conf.rs485_tx_dly_num = BIT_WIDTH_OF(4, context->rs485_tx_dly);
+        dev->rs485_conf.dl0_en = 0 < context->rs485_turnaround;
+        dev->rs485_conf.dl1_en = 1 < context->rs485_turnaround;
+        dev->rs485_conf.rs485_en = 1;
+    }
+
+    dev->conf1.rx_flow_en = 0;
+    dev->conf0.tx_flow_en = 0;
+    dev->flow_conf.sw_flow_con_en = 0;
+
+    switch (context->flow)
+    {
+    case UART_FLOW_NONE:
+        break;
+
+    case UART_FLOW_RTS_CTS:
+        dev->mem_conf.rx_flow_thrhd = BIT_WIDTH_OF(10, context->flow_thrhd);
+        dev->conf1.rx_flow_en = 1;
+        dev->conf0.tx_flow_en = 1;
+        break;
+
+    case UART_FLOW_XON_XOFF:
+        dev->swfc_conf0.xoff_char = UART_XOFF_CHAR;
+        dev->swfc_conf0.xoff_threshold = BIT_WIDTH_OF(10, context->flow_thrhd);
+        dev->swfc_conf1.xon_char = UART_XON_CHAR;
+        dev->swfc_conf1.xon_threshold = BIT_WIDTH_OF(10, context->flow_thrhd / 2U);
+        // XON / XOFF are not received as data
+        dev->flow_conf.xonoff_del = 1;
+        dev->flow_conf.sw_flow_con_en = 1;
+        break;
+    }
     // clear rx fifo
     while (0 != dev->status.rxfifo_cnt)
         UART_fifo_rx(dev);
 
-    dev->int_ena.val = UART_INTR_PARITY_ERR | UART_INTR_FRAME_ERR |
+    UART_intr_update(context, dev, (uint32_t)~0, UART_INTR_PARITY_ERR | UART_INTR_FRAME_ERR |
         UART_INTR_RS485_PARITY_ERR | UART_INTR_RS485_FRAME_ERR |
-        0;
+        (UART_RS485_COLLISION_DETECT == context->rs485 ? UART_INTR_RS485_CLASH : 0));
 
     if (false)
     {
@@ -423,6 +1160,35 @@ static PERIPH_module_t UART_periph_module(uart_dev_t *dev, struct UART_context *
     return module;
 }
 
+static int UART_route_pins(struct UART_context *context)
+{
+    static uint16_t const signals[SOC_UART_NUM][4] =
+    {
+        {U0TXD_OUT_IDX, U0RXD_IN_IDX, U0RTS_OUT_IDX, U0CTS_IN_IDX},
+        {U1TXD_OUT_IDX, U1RXD_IN_IDX, U1RTS_OUT_IDX, U1CTS_IN_IDX},
+        {U2TXD_OUT_IDX, U2RXD_IN_IDX, U2RTS_OUT_IDX, U2CTS_IN_IDX},
+    };
+    uint16_t const *sig = signals[context - uart_context];
+    struct UART_gpio_cfg const *cfg = &context->gpio_cfg;
+    int retval = 0;
+
+    if (UART_PIN_NONE != cfg->TXD_pin_nb)
+        retval = IOMUX_route_output(cfg->TXD_pin_nb, sig[0], PUSH_PULL_UP, false, false);
+    if (0 == retval && UART_PIN_NONE != cfg->RXD_pin_nb)
+        retval = IOMUX_route_input(cfg->RXD_pin_nb, sig[1], false, PULL_UP, true);
+
+    // RTS: flow control or DE of RS485
+    if (0 == retval && UART_PIN_NONE != cfg->RTS_pin_nb &&
+        (UART_FLOW_RTS_CTS == context->flow || UART_RS485_NONE != context->rs485))
+    {
+        retval = IOMUX_route_output(cfg->RTS_pin_nb, sig[2], PUSH_PULL, false, false);
+    }
+    if (0 == retval && UART_PIN_NONE != cfg->CTS_pin_nb && UART_FLOW_RTS_CTS == context->flow)
+        retval = IOMUX_route_input(cfg->CTS_pin_nb, sig[3], false, PULL_UP, true);
+
+    return retval;
+}
+
 static void UART_configure_bps(uart_dev_t *dev, uint32_t bps)
 {
     struct UART_context *context;
@@ -448,89 +1214,564 @@ static void UART_configure_context_bps(struct UART_context *context, uart_dev_t
     dev->clk_conf.sclk_div_num = BIT_WIDTH_OF(8, sclk_div - 1);
 }
 
+static uint32_t UART_timeo(int fd, uint32_t timeo)
+{
+    if (FD_FLAG_NONBLOCK & AsFD(fd)->flags)
+        return 0;
+    else if (0 == timeo)
+        return WAIT_FOREVER;
+    else
+        return timeo;
+}
+
 static ssize_t UART_read(int fd, void *buf, size_t bufsize)
 {
     struct UART_context *context = AsFD(fd)->ext;
-    uart_dev_t *dev = context->dev;
-    int retval;
+    uint32_t timeo = UART_timeo(fd, AsFD(fd)->read_timeo);
 
-    if (0 != dev->status.rxfifo_cnt)
+    if (0 != mutex_trylock(&context->rd_lock, timeo))
+        return __set_errno_neg(EAGAIN);
+
+    ssize_t retval;
+    while (true)
     {
-        retval = (int)UART_fifo_read(dev, buf, bufsize);
+        /// read_rdy is only a hint, it is re-given below when anything is left
+        sem_trywait(&context->read_rdy);
+
+        if (UART_DMA_SLIP == context->dma)
+            retval = UART_frame_read(&context->rx_ring, buf, bufsize);
+        else if (0 != context->frame_idle_bits)
+            retval = UART_idle_frame_read(context, buf, bufsize);
+        else
+            retval = (ssize_t)bytering_read(&context->rx_ring, buf, bufsize);
         if (0 < retval)
-            return retval;
+            break;
+
+        if (0 != sem_timedwait_ms(&context->read_rdy, timeo))
+        {
+            retval = __set_errno_neg(EAGAIN);
+            break;
+        }
     }
 
-    // enable rxfifo intr
-    dev->int_ena.rxfifo_full_int_ena = 1;
+    if (0 < retval && context->rx_stalled)
+        UART_rx_resume(context);
+    if (UART_rx_pending(context))
+        sem_post(&context->read_rdy);
+
+    mutex_unlock(&context->rd_lock);
+    return retval;
+}
+
+static ssize_t UART_write(int fd, void const *buf, size_t count)
+{
+    struct UART_context *context = AsFD(fd)->ext;
+    uint32_t timeo = UART_timeo(fd, AsFD(fd)->write_timeo);
 
-    uint32_t timeo;
-    if (! (FD_FLAG_NONBLOCK & AsFD(fd)->flags))
+    if (0 != mutex_trylock(&context->wr_lock, timeo))
+        return __set_errno_neg(EAGAIN);
+
+    ssize_t retval;
+    if (UART_DMA_NONE != context->dma)
     {
-        timeo = AsFD(fd)->read_timeo;
-        if (0 == timeo)
-            timeo = WAIT_FOREVER;
+        retval = UART_dma_tx(buf, count, timeo);
+        sem_post(&context->write_rdy);
+
+        mutex_unlock(&context->wr_lock);
+        return retval;
     }
-    else
-        timeo = 0;
 
-    retval = sem_timedwait_ms(&context->read_rdy, timeo);
-    if (0 != retval)
-        return __set_errno_neg(EAGAIN);
+    size_t written = 0;
+    while (true)
+    {
+        /// write_rdy is only a hint, it is re-given below when there is room
+        sem_trywait(&context->write_rdy);
+
+        size_t room = UART_tx_room(context);
+        if (0 != room)
+        {
+            if (room > count - written)
+                room = count - written;
+
+            written += bytering_write(&context->tx_ring, (uint8_t const *)buf + written, room);
+            // ISR refills fifo from now on
+            UART_intr_update(context, context->dev, 0, UART_INTR_TXFIFO_EMPTY);
+        }
+
+        if (count == written || (0 != written && (FD_FLAG_NONBLOCK & AsFD(fd)->flags)))
+            break;
+
+        if (0 != sem_timedwait_ms(&context->write_rdy, timeo))
+            break;
+    }
+
+    if (0 != written)
+        retval = (ssize_t)written;
     else
-        return (int)UART_fifo_read(dev, buf, bufsize);
+        retval = __set_errno_neg(EAGAIN);
+
+    if (0 != UART_tx_room(context))
+        sem_post(&context->write_rdy);
+
+    mutex_unlock(&context->wr_lock);
+    return retval;
 }
 
-static ssize_t UART_write(int fd, void const *buf, size_t count)
+static int UART_close(int fd)
 {
     struct UART_context *context = AsFD(fd)->ext;
+    /// read_rdy / write_rdy are embedded in context, never destroy them with the fd
+    AsFD(fd)->read_rdy = AsFD(fd)->write_rdy = INVALID_HANDLE;
+
+    return UART_release(context, AsFD(fd)->write_timeo);
+}
+
+static int UART_release(struct UART_context *context, uint32_t write_timeo)
+{
+    spin_lock(&context->intr_lock);
+    uint32_t fd_count = -- context->fd_count;
+    spin_unlock(&context->intr_lock);
+
+    if (0 != fd_count)
+        return 0;
+
     uart_dev_t *dev = context->dev;
+    if (context == UART_dma.context)
+    {
+        // pending non-blocking output is transmitted before the device is gone
+        UART_dma_tx_wait(0 == write_timeo ? WAIT_FOREVER : write_timeo);
+        UART_dma_stop();
+    }
+    else
+    {
+        // queued output is transmitted before the device is gone
+        UART_tx_drain(context);
+        UART_intr_update(context, dev, UART_INTR_RX | UART_INTR_TXFIFO_EMPTY | UART_INTR_TX_DONE, 0);
+    }
+
+    int retval = UART_deconfigure(dev);
 
-    uint32_t timeo;
-    if (! (FD_FLAG_NONBLOCK & AsFD(fd)->flags))
+    if (0 == retval)
     {
-        timeo = AsFD(fd)->write_timeo;
-        if (0 == timeo)
-            timeo = WAIT_FOREVER;
+        context->dev = NULL;
+
+        KERNEL_mfree(context->rx_buf);
+        context->rx_buf = NULL;
+        if (NULL != context->tx_buf)
+        {
+            KERNEL_mfree(context->tx_buf);
+            context->tx_buf = NULL;
+        }
+        return retval;
     }
     else
-        timeo = 0;
+        return __set_errno_neg(retval);
+}
 
-    int retval = sem_timedwait_ms(&context->write_rdy, timeo);
-    if (0 != retval)
+static int UART_sync(int fd)
+{
+    struct UART_context *context = AsFD(fd)->ext;
+
+    int retval = 0;
+
+    mutex_lock(&context->wr_lock);
+    // blocking DMA write() returns after the transmission, a non-blocking one leaves its round pending
+    if (UART_DMA_NONE == context->dma)
+        UART_tx_drain(context);
+    else if (0 != UART_dma_tx_wait(0 == AsFD(fd)->write_timeo ? WAIT_FOREVER : AsFD(fd)->write_timeo))
+        retval = __set_errno_neg(ETIMEDOUT);
+    mutex_unlock(&context->wr_lock);
+
+    return retval;
+}
+
+static int UART_devfs_open(void *arg, int flags)
+{
+    ARG_UNUSED(flags);
+    struct UART_context *context = arg;
+
+    /// the device is shared only while the last close() is not deconfiguring it
+    spin_lock(&context->intr_lock);
+    bool shared = 0 != context->fd_count;
+    if (shared)
+        context->fd_count ++;
+    spin_unlock(&context->intr_lock);
+
+    /// first open programs the device by cached configuration, the others share it
+    if (! shared)
+        return UART_createfd((int)(context - uart_context), context->bps, context->parity, context->stopbits);
+
+    int fd = KERNEL_createfd(FD_TAG_CHAR, &implement, context);
+    if (-1 == fd)
+    {
+        int err = errno;
+        UART_release(context, 0);
+        return __set_errno_neg(err);
+    }
+
+    AsFD(fd)->read_rdy = &context->read_rdy;
+    AsFD(fd)->write_rdy = &context->write_rdy;
+    return fd;
+}
+
+/****************************************************************************
+ *  @internal: UHCI DMA
+ ****************************************************************************/
+static void GDMA_desc_set(struct GDMA_desc *desc, void *buf, size_t size, size_t length, struct GDMA_desc *next)
+{
+    desc->size = BIT_WIDTH_OF(12, size);
+    desc->length = BIT_WIDTH_OF(12, length);
+    desc->err_eof = 0;
+    desc->suc_eof = 0;
+    desc->buf = buf;
+    desc->next = next;
+    /// descriptor and buffer are written before DMA owns it
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    desc->owner = 1;
+}
+
+static int UART_dma_start(struct UART_context *context, int nb)
+{
+    bool gdma_enabled = false;
+    int ch;
+
+    if (! CLK_periph_is_enabled(PERIPH_GDMA_MODULE))
+    {
+        CLK_periph_enable(PERIPH_GDMA_MODULE);
+        gdma_enabled = true;
+    }
+    GDMA.misc_conf.clk_en = 1;
+
+    // GDMA channels are shared with esp-idf's allocator, which hands out from channel 0: claim from the top
+    for (ch = SOC_GDMA_PAIRS_PER_GROUP - 1; ch >= 0; ch --)
+    {
+        if (GDMA_PERI_SEL_NONE == GDMA.channel[ch].in.peri_sel.sel &&
+            GDMA_PERI_SEL_NONE == GDMA.channel[ch].out.peri_sel.sel)
+        {
+            break;
+        }
+    }
+    if (0 > ch)
+        goto uart_dma_start_channel_fail;
+
+    if (0 != esp_intr_alloc(ETS_DMA_IN_CH0_INTR_SOURCE + ch, ESP_INTR_FLAG_INTRDISABLED,
+            UART_dma_rx_intr, &UART_dma, &UART_dma.rx_intr))
+    {
+        goto uart_dma_start_channel_fail;
+    }
+    if (0 != esp_intr_alloc(ETS_DMA_OUT_CH0_INTR_SOURCE + ch, ESP_INTR_FLAG_INTRDISABLED,
+            UART_dma_tx_intr, &UART_dma, &UART_dma.tx_intr))
+    {
+        goto uart_dma_start_rx_intr_fail;
+    }
+
+    UART_dma.context = context;
+    UART_dma.ch = (unsigned)ch;
+    UART_dma.tx_last = NULL;
+    UART_dma.tx_pending = false;
+    UART_dma.frame.open = false;
+    sem_init_np(&UART_dma.tx_done, 0, 0, 1);
+
+    // UHCI0 bridges the uart fifo and GDMA
+    CLK_periph_enable(PERIPH_UHCI0_MODULE);
+
+    UHCI0.conf0.val = 0;
+    UHCI0.conf0.tx_rst = 1;
+    UHCI0.conf0.tx_rst = 0;
+    UHCI0.conf0.rx_rst = 1;
+    UHCI0.conf0.rx_rst = 0;
+    UHCI0.conf0.clk_en = 1;
+
+    switch (nb)
+    {
+    default:
+    case 0:
+        UHCI0.conf0.uart0_ce = 1;
+        break;
+    case 1:
+        UHCI0.conf0.uart1_ce = 1;
+        break;
+    case 2:
+        UHCI0.conf0.uart2_ce = 1;
+        break;
+    }
+
+    // no UHCI packet header / checksum / crc
+    UHCI0.conf1.val = 0;
+    UHCI0.conf1.crc_disable = 1;
+
+    UHCI0.esc_conf0.seper_char = 0xC0;
+    UHCI0.esc_conf0.seper_esc_char0 = 0xDB;
+    UHCI0.esc_conf0.seper_esc_char1 = 0xDC;
+    UHCI0.esc_conf1.seq0 = 0xDB;
+    UHCI0.esc_conf1.seq0_char0 = 0xDB;
+    UHCI0.esc_conf1.seq0_char1 = 0xDD;
+
+    UHCI0.escape_conf.val = 0;
+    if (UART_DMA_SLIP == context->dma)
+    {
+        // frames are separated / escaped by hardware, one frame ends one inlink eof
+        UHCI0.conf0.seper_en = 1;
+        UHCI0.escape_conf.tx_c0_esc_en = 1;
+        UHCI0.escape_conf.tx_db_esc_en = 1;
+        UHCI0.escape_conf.rx_c0_esc_en = 1;
+        UHCI0.escape_conf.rx_db_esc_en = 1;
+    }
+    else
+    {
+        // rx line idle ends the inlink: the tail of burst is delivered without waiting the block full
+        UHCI0.conf0.uart_idle_eof_en = 1;
+    }
+
+    // GDMA pair
+    GDMA.channel[ch].in.conf0.in_rst = 1;
+    GDMA.channel[ch].in.conf0.in_rst = 0;
+    GDMA.channel[ch].out.conf0.out_rst = 1;
+    GDMA.channel[ch].out.conf0.out_rst = 0;
+
+    GDMA.channel[ch].in.conf1.in_check_owner = 0;
+    GDMA.channel[ch].out.conf1.out_check_owner = 0;
+    GDMA.channel[ch].out.conf0.out_auto_wrback = 1;
+    GDMA.channel[ch].out.conf0.out_eof_mode = 1;
+
+    GDMA.channel[ch].in.peri_sel.sel = SOC_GDMA_TRIG_PERIPH_UHCI0;
+    GDMA.channel[ch].out.peri_sel.sel = SOC_GDMA_TRIG_PERIPH_UHCI0;
+
+    for (unsigned i = 0; i < UART_DMA_RX_BLOCKS; i ++)
+    {
+        GDMA_desc_set(&UART_dma.rx_desc[i], UART_dma.rx_blocks[i], UART_DMA_RX_BLOCK_SIZE, 0,
+            &UART_dma.rx_desc[(i + 1) % UART_DMA_RX_BLOCKS]);
+    }
+    UART_dma.rx_next = &UART_dma.rx_desc[0];
+
+    GDMA.channel[ch].in.int_ena.val = 0;
+    GDMA.channel[ch].in.int_clr.val = (uint32_t)~0;
+    GDMA.channel[ch].in.int_ena.in_suc_eof = 1;
+    GDMA.channel[ch].in.int_ena.in_done = 1;
+
+    GDMA.channel[ch].out.int_ena.val = 0;
+    GDMA.channel[ch].out.int_clr.val = (uint32_t)~0;
+    GDMA.channel[ch].out.int_ena.out_done = 1;
+    GDMA.channel[ch].out.int_ena.out_total_eof = 1;
+
+    esp_intr_enable(UART_dma.rx_intr);
+    esp_intr_enable(UART_dma.tx_intr);
+
+    GDMA.channel[ch].in.link.addr = BIT_WIDTH_OF(20, (uintptr_t)&UART_dma.rx_desc[0]);
+    GDMA.channel[ch].in.link.start = 1;
+    return 0;
+
+uart_dma_start_rx_intr_fail:
+    esp_intr_free(UART_dma.rx_intr);
+uart_dma_start_channel_fail:
+    if (gdma_enabled)
+        CLK_periph_disable(PERIPH_GDMA_MODULE);
+    return EBUSY;
+}
+
+static void UART_dma_stop(void)
+{
+    unsigned ch = UART_dma.ch;
+
+    GDMA.channel[ch].in.link.stop = 1;
+    GDMA.channel[ch].out.link.stop = 1;
+    GDMA.channel[ch].in.int_ena.val = 0;
+    GDMA.channel[ch].out.int_ena.val = 0;
+
+    esp_intr_free(UART_dma.rx_intr);
+    esp_intr_free(UART_dma.tx_intr);
+
+    GDMA.channel[ch].in.peri_sel.sel = GDMA_PERI_SEL_NONE;
+    GDMA.channel[ch].out.peri_sel.sel = GDMA_PERI_SEL_NONE;
+
+    UHCI0.conf0.val = 0;
+    CLK_periph_disable(PERIPH_UHCI0_MODULE);
+
+    UART_dma.context = NULL;
+}
+
+/**
+ *  link descriptors over the buffer, or over the bounce buffer when it is out of DMA capable memory
+ *      .SLIP: the whole write() is one frame, only the last descriptor ends it
+ *      .timeo 0 is non-blocking: one round from the bounce buffer without waiting it
+ *  @returns
+ *      bytes of completed rounds, -1 of EAGAIN when nothing was sent
+ */
+static ssize_t UART_dma_tx(void const *buf, size_t count, uint32_t timeo)
+{
+    if (0 != UART_dma_tx_wait(timeo))
         return __set_errno_neg(EAGAIN);
 
-    retval = (int)UART_fifo_write(dev, buf, count);
-    if ((size_t)retval < count)
+    bool nonblock = 0 == timeo;
+    bool capable = ! nonblock && SOC_DMA_LOW <= (uintptr_t)buf && (uintptr_t)buf + count <= SOC_DMA_HIGH;
+    unsigned ch = UART_dma.ch;
+    size_t sent = 0;
+
+    while (sent < count)
     {
-        if (! (FD_FLAG_NONBLOCK & AsFD(fd)->flags))
+        struct GDMA_desc *desc = NULL;
+        size_t chunk = 0;
+
+        if (capable)
+        {
+            for (unsigned i = 0; i < UART_DMA_TX_DESCS && sent + chunk < count; i ++)
+            {
+                size_t len = count - sent - chunk;
+                if (GDMA_DESC_MAX_SIZE < len)
+                    len = GDMA_DESC_MAX_SIZE;
+
+                desc = &UART_dma.tx_desc[i];
+                GDMA_desc_set(desc, (uint8_t *)buf + sent + chunk, len, len, desc + 1);
+                chunk += len;
+            }
+        }
+        else
         {
-            context->tx_ptr = (uint8_t *)buf + retval;
-            context->tx_end = (uint8_t *)buf + count;
+            chunk = count - sent;
+            if (UART_DMA_TX_BOUNCE_SIZE < chunk)
+                chunk = UART_DMA_TX_BOUNCE_SIZE;
 
-            dev->int_ena.tx_done_int_ena = 1;
-            sem_wait(&context->write_rdy);
+            memcpy(UART_dma.tx_bounce, (uint8_t const *)buf + sent, chunk);
 
-            retval = (ssize_t)count;
+            desc = &UART_dma.tx_desc[0];
+            GDMA_desc_set(desc, UART_dma.tx_bounce, chunk, chunk, NULL);
         }
+
+        desc->next = NULL;
+        /// non-blocking SLIP: every round is a frame
+        desc->suc_eof = nonblock || (sent + chunk == count);
+        UART_dma.tx_last = desc;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        GDMA.channel[ch].out.link.addr = BIT_WIDTH_OF(20, (uintptr_t)&UART_dma.tx_desc[0]);
+        GDMA.channel[ch].out.link.start = 1;
+
+        if (nonblock)
+        {
+            UART_dma.tx_pending = true;
+            sent += chunk;
+            break;
+        }
+        if (0 != sem_timedwait_ms(&UART_dma.tx_done, timeo))
+        {
+            /// the round may be reading the caller's buffer: stop it, it was not sent as a whole
+            UART_dma_tx_abort();
+            break;
+        }
+        sent += chunk;
     }
 
-    sem_post(&context->write_rdy);
-    return retval;
+    if (0 == sent)
+        return __set_errno_neg(EAGAIN);
+    else
+        return (ssize_t)sent;
 }
 
-static int UART_close(int fd)
+/**
+ *  wait the pending non-blocking round
+ *  @returns
+ *      0 when nothing is pending, EAGAIN when it was not completed in timeo
+ */
+static int UART_dma_tx_wait(uint32_t timeo)
 {
-    struct UART_context *context = AsFD(fd)->ext;
-    int retval = UART_deconfigure(context->dev);
+    if (! UART_dma.tx_pending)
+        return 0;
+    if (0 != sem_timedwait_ms(&UART_dma.tx_done, timeo))
+        return EAGAIN;
 
-    if (0 == retval)
+    UART_dma.tx_pending = false;
+    return 0;
+}
+
+static void UART_dma_tx_abort(void)
+{
+    unsigned ch = UART_dma.ch;
+
+    spin_lock(&UART_dma.tx_lock);
+    GDMA.channel[ch].out.link.stop = 1;
+    GDMA.channel[ch].out.conf0.out_rst = 1;
+    GDMA.channel[ch].out.conf0.out_rst = 0;
+    UART_dma.tx_last = NULL;
+    spin_unlock(&UART_dma.tx_lock);
+
+    /// completed just before it was stopped
+    sem_trywait(&UART_dma.tx_done);
+}
+
+static IRAM_ATTR void UART_ring_discard(bytering_t *ring, size_t count)
+{
+    while (0 != count)
     {
-        context->dev = NULL;
-        return retval;
+        size_t readable;
+        bytering_peek(ring, &readable);
+
+        if (readable > count)
+            readable = count;
+
+        bytering_consume(ring, readable);
+        count -= readable;
     }
+}
+
+/**
+ *  read one frame delimited by rx line idle, the rest of frame exceeds bufsize is discarded
+ *      .bytes of a queued frame end were committed before it
+ */
+static ssize_t UART_idle_frame_read(struct UART_context *context, void *buf, size_t bufsize)
+{
+    uint32_t head = context->frame_head;
+
+    if (head == __atomic_load_n(&context->frame_tail, __ATOMIC_ACQUIRE))
+        return 0;
+
+    size_t len = context->frame_end[head % UART_IDLE_FRAMES] - context->rx_delivered;
+    size_t count = len < bufsize ? len : bufsize;
+
+    bytering_read(&context->rx_ring, buf, count);
+    UART_ring_discard(&context->rx_ring, len - count);
+
+    context->rx_delivered += (uint32_t)len;
+    __atomic_store_n(&context->frame_head, head + 1, __ATOMIC_RELEASE);
+
+    return (ssize_t)count;
+}
+
+static bool UART_rx_pending(struct UART_context *context)
+{
+    if (0 != context->frame_idle_bits)
+        return context->frame_head != __atomic_load_n(&context->frame_tail, __ATOMIC_ACQUIRE);
     else
-        return __set_errno_neg(retval);
+        return 0 != bytering_readable(&context->rx_ring);
+}
+
+/**
+ *  read one SLIP frame, the rest of frame exceeds bufsize is discarded
+ *      .a frame is published with its header, it is whole readable once the header is
+ */
+static ssize_t UART_frame_read(bytering_t *ring, void *buf, size_t bufsize)
+{
+    while (2 <= bytering_readable(ring))
+    {
+        uint8_t hdr[2];
+        bytering_read(ring, hdr, sizeof(hdr));
+
+        size_t len = (size_t)(hdr[0] | (hdr[1] << 8));
+        if (UART_FRAME_DROPPED & len)
+        {
+            UART_ring_discard(ring, len & UART_FRAME_MAX);
+            continue;
+        }
+        // empty frame: back to back separators
+        if (0 == len)
+            continue;
+
+        size_t count = len < bufsize ? len : bufsize;
+        bytering_read(ring, buf, count);
+        UART_ring_discard(ring, len - count);
+
+        return (ssize_t)count;
+    }
+    return 0;
 }
 
 /****************************************************************************
@@ -562,36 +1803,431 @@ static IRAM_ATTR void UART_IntrHandler(struct UART_context *context)
     }
     */
 
-    if (UART_INTR_RXFIFO_FULL & flags)
+    if (UART_INTR_RX & flags)
     {
-        dev->int_ena.rxfifo_full_int_ena = 0;
-        sem_post(&context->read_rdy);
+        /// cleared before draining, a timeout of bytes arriving meanwhile is not lost
+        dev->int_clr.val = UART_INTR_RX & flags;
+        UART_rx_drain(context, dev, 0 != (UART_INTR_RXFIFO_TOUT & flags));
     }
 
+    /// parity / frame errors of the echo are line errors, not collisions
+    if (UART_INTR_RS485_CLASH & flags)
+        __atomic_add_fetch(&context->collisions, 1, __ATOMIC_RELAXED);
+
+    if (UART_INTR_TXFIFO_EMPTY & flags)
+        UART_tx_refill(context, dev);
+
     if (UART_INTR_TX_DONE & flags)
     {
-        if (context->tx_ptr)
+        UART_intr_update(context, dev, UART_INTR_TX_DONE, 0);
+        sem_post(&context->tx_idle);
+    }
+
+    dev->int_clr.val = flags & ~(uint32_t)UART_INTR_RX;
+}
+
+/**
+ *  move everything in rx fifo into the ring
+ *      .the ring is full: RX interrupts are disabled, the rest stays in fifo until read() makes room
+ *      .idle framing: one byte is left in fifo until the line is idle, an empty fifo never misses the
+ *          idle timeout. a frame exceeds the ring is split
+ */
+static IRAM_ATTR void UART_rx_drain(struct UART_context *context, uart_dev_t *dev, bool idle)
+{
+    unsigned keep = (0 != context->frame_idle_bits && ! idle) ? 1 : 0;
+    size_t filled = 0;
+    unsigned count;
+
+    while (keep < (count = dev->status.rxfifo_cnt))
+    {
+        size_t span;
+        uint8_t *ptr = bytering_acquire(&context->rx_ring, count - keep, &span);
+
+        if (NULL == ptr)
         {
-            context->tx_ptr += UART_fifo_write(dev, context->tx_ptr, (unsigned)(context->tx_end - context->tx_ptr));
+            UART_intr_update(context, dev, UART_INTR_RX, 0);
+            context->rx_stalled = true;
 
-            if (context->tx_ptr == context->tx_end)
+            if (0 != context->frame_idle_bits)
             {
-                context->tx_ptr = NULL;
-                sem_post(&context->write_rdy);
+                context->rx_idle_pending = idle;
+                /// no frame to read(): the ring is split as a frame
+                idle = context->frame_tail == __atomic_load_n(&context->frame_head, __ATOMIC_ACQUIRE);
             }
+            break;
         }
+
+        /// span <= rxfifo_cnt, fifo is never shrinked by others
+        for (size_t i = 0; i < span; i ++)
+            ptr[i] = (uint8_t)dev->fifo.rxfifo_rd_byte;
+
+        bytering_commit(&context->rx_ring, span);
+        filled += span;
+    }
+    context->rx_received += (uint32_t)filled;
+
+    if (0 != context->frame_idle_bits)
+    {
+        if (idle)
+            UART_frame_end(context);
+    }
+    else if (0 != filled)
+        sem_post(&context->read_rdy);
+}
+
+/**
+ *  queue the end of frame being received, an empty frame is ignored
+ *      .the queue is full: the frame is merged into next
+ */
+static IRAM_ATTR void UART_frame_end(struct UART_context *context)
+{
+    if (context->frame_last == context->rx_received)
+        return;
+    if (UART_IDLE_FRAMES == context->frame_tail - __atomic_load_n(&context->frame_head, __ATOMIC_ACQUIRE))
+        return;
+
+    context->frame_end[context->frame_tail % UART_IDLE_FRAMES] = context->rx_received;
+    context->frame_last = context->rx_received;
+    __atomic_store_n(&context->frame_tail, context->frame_tail + 1, __ATOMIC_RELEASE);
+
+    sem_post(&context->read_rdy);
+}
+
+/**
+ *  move the tx ring into fifo, ISR is the only consumer of tx ring
+ *      .the ring is empty: stop refilling, TX_DONE tells when the last byte was shifted out
+ */
+static IRAM_ATTR void UART_tx_refill(struct UART_context *context, uart_dev_t *dev)
+{
+    void const *ptr;
+    size_t count;
+
+    while (NULL != (ptr = bytering_peek(&context->tx_ring, &count)))
+    {
+        size_t written = 0;
+
+        while (written < count && SOC_UART_FIFO_LEN > dev->status.txfifo_cnt)
+            dev->fifo.rxfifo_rd_byte = ((uint8_t const *)ptr)[written ++];
+
+        bytering_consume(&context->tx_ring, written);
+        if (written < count)
+            break;
+    }
+
+    bool empty = 0 == bytering_readable(&context->tx_ring);
+    /// UART0 shares the fifo with console
+    if (&UART0 == dev)
+        empty = UART_console_refill(dev) && empty;
+
+    if (empty)
+    {
+        UART_intr_update(context, dev, UART_INTR_TXFIFO_EMPTY, 0);
+
+        /// a writer enabled it after rings were checked empty
+        if (0 != bytering_readable(&context->tx_ring) || (&UART0 == dev && UART_console_pending()))
+            UART_intr_update(context, dev, 0, UART_INTR_TXFIFO_EMPTY);
         else
-            dev->int_ena.tx_done_int_ena = 0;
+        {
+            dev->int_clr.tx_done_int_clr = 1;
+            UART_intr_update(context, dev, 0, UART_INTR_TX_DONE);
+        }
     }
 
-    dev->int_clr.val = flags;
+    if (0 != UART_tx_room(context))
+        sem_post(&context->write_rdy);
 }
 
-void UART0_IntrHandler(void *arg)
-__attribute__((alias("UART_IntrHandler")));
+static IRAM_ATTR size_t UART_tx_room(struct UART_context *context)
+{
+    size_t queued = bytering_size(&context->tx_ring) - bytering_writable(&context->tx_ring);
+    return queued < context->tx_hiwat ? context->tx_hiwat - queued : 0;
+}
+
+static bool UART_tx_busy(struct UART_context *context, uart_dev_t *dev)
+{
+    return 0 != bytering_readable(&context->tx_ring) ||
+        0 != dev->status.txfifo_cnt || 0 != dev->fsm_status.st_utx_out;
+}
+
+/**
+ *  wait everything queued was shifted out, caller holds wr_lock: no more is queued meanwhile
+ *      .tx_idle is only a hint, the state is re-checked after each
+ */
+static void UART_tx_drain(struct UART_context *context)
+{
+    uart_dev_t *dev = context->dev;
+
+    while (UART_tx_busy(context, dev))
+    {
+        // armed before re-checking: the completion after it is never missed
+        dev->int_clr.tx_done_int_clr = 1;
+        UART_intr_update(context, dev, 0, UART_INTR_TX_DONE);
+
+        if (UART_tx_busy(context, dev))
+            sem_wait(&context->tx_idle);
+    }
+}
+
+/**
+ *  room was made by read(): drain what was left in fifo, then re-enable RX interrupts
+ *      .ISR is not draining when stalled, read() is the only producer until then
+ */
+static void UART_rx_resume(struct UART_context *context)
+{
+    uart_dev_t *dev = context->dev;
+
+    bool idle = context->rx_idle_pending;
+
+    context->rx_stalled = false;
+    context->rx_idle_pending = false;
+    UART_rx_drain(context, dev, idle);
+
+    /// stale raw status only raises an interrupt of empty fifo
+    if (! context->rx_stalled)
+        UART_intr_update(context, dev, 0, UART_INTR_RX);
+}
+
+static IRAM_ATTR void UART_intr_update(struct UART_context *context, uart_dev_t *dev, uint32_t disable, uint32_t enable)
+{
+    spin_lock(&context->intr_lock);
+    dev->int_ena.val = (dev->int_ena.val & ~disable) | enable;
+    spin_unlock(&context->intr_lock);
+}
+
+IRAM_ATTR void UART0_IntrHandler(void *arg)
+{
+    struct UART_context *context = arg;
+
+    if (NULL != context->dev)
+        UART_IntrHandler(context);
+    else
+        UART_console_IntrHandler(&UART0);
+}
 
 void UART1_IntrHandler(void *arg)
 __attribute__((alias("UART_IntrHandler")));
 
 void UART2_IntrHandler(void *arg)
 __attribute__((alias("UART_IntrHandler")));
+
+/**
+ *  move console rings into fifo, a ring is drained until empty before the next
+ *  @returns
+ *      true when all rings are empty
+ */
+static IRAM_ATTR bool UART_console_refill(uart_dev_t *dev)
+{
+    size_t drained = 0;
+    unsigned empties = 0;
+
+    spin_lock(&UART_console.drain_lock);
+
+    while (empties < lengthof(UART_console.ring))
+    {
+        bytering_t *ring = &UART_console.ring[UART_console.curr];
+        size_t count;
+        void const *ptr = bytering_peek(ring, &count);
+
+        if (NULL == ptr)
+        {
+            UART_console.curr = (UART_console.curr + 1) % lengthof(UART_console.ring);
+            empties ++;
+            continue;
+        }
+        empties = 0;
+
+        size_t written = 0;
+        while (written < count && SOC_UART_FIFO_LEN > dev->status.txfifo_cnt)
+            dev->fifo.rxfifo_rd_byte = ((uint8_t const *)ptr)[written ++];
+
+        bytering_consume(ring, written);
+        drained += written;
+
+        if (written < count)
+            break;
+    }
+
+    spin_unlock(&UART_console.drain_lock);
+
+    if (0 != drained)
+        sem_post(&UART_console.room);
+
+    return lengthof(UART_console.ring) == empties;
+}
+
+static IRAM_ATTR bool UART_console_pending(void)
+{
+    for (unsigned i = 0; i < lengthof(UART_console.ring); i ++)
+    {
+        if (0 != bytering_readable(&UART_console.ring[i]))
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  panic: everything buffered is written by spinning
+ *      .the other core was stalled, the lock maybe held by it is ignored
+ */
+static void UART_console_flush(uart_dev_t *dev)
+{
+    for (unsigned i = 0; i < lengthof(UART_console.ring); i ++)
+    {
+        bytering_t *ring = &UART_console.ring[(UART_console.curr + i) % lengthof(UART_console.ring)];
+        size_t count;
+        void const *ptr;
+
+        while (NULL != (ptr = bytering_peek(ring, &count)))
+        {
+            size_t written = 0;
+
+            while (written < count)
+                written += UART_fifo_write(dev, (uint8_t const *)ptr + written, (unsigned)(count - written));
+
+            bytering_consume(ring, count);
+        }
+    }
+}
+
+/**
+ *  UART0 is not opened: only TXFIFO_EMPTY is enabled for console
+ */
+static IRAM_ATTR void UART_console_IntrHandler(uart_dev_t *dev)
+{
+    uint32_t flags = dev->int_st.val;
+
+    if (UART_INTR_TXFIFO_EMPTY & flags)
+    {
+        if (UART_console_refill(dev))
+        {
+            UART_intr_update(&uart_context[0], dev, UART_INTR_TXFIFO_EMPTY, 0);
+
+            /// a writer enabled it after rings were checked empty
+            if (UART_console_pending())
+                UART_intr_update(&uart_context[0], dev, 0, UART_INTR_TXFIFO_EMPTY);
+        }
+    }
+
+    dev->int_clr.val = flags;
+}
+
+/**
+ *  SLIP: accumulate the frame into reserved space of rx ring, publish it with header by eof
+ *      .a frame that does not fit, exceeds UART_FRAME_MAX or has decoding error is published as dropped,
+ *      read() skips it
+ */
+static IRAM_ATTR bool UART_dma_rx_frame(bytering_t *ring, struct GDMA_desc *desc)
+{
+    uint8_t const *data = desc->buf;
+    size_t count = desc->length;
+
+    if (! UART_dma.frame.open)
+    {
+        UART_dma.frame.open = true;
+        UART_dma.frame.dropped = false;
+        UART_dma.frame.len = 0;
+        UART_dma.frame.hdr[0] = NULL;
+
+        if (2 <= bytering_writable(ring))
+        {
+            size_t span;
+
+            UART_dma.frame.hdr[0] = bytering_acquire(ring, 2, &span);
+            if (2 == span)
+                UART_dma.frame.hdr[1] = UART_dma.frame.hdr[0] + 1;
+            else
+                UART_dma.frame.hdr[1] = bytering_acquire(ring, 1, &span);
+        }
+    }
+
+    if (NULL == UART_dma.frame.hdr[0])
+        UART_dma.frame.dropped = true;
+
+    while (0 != count && ! UART_dma.frame.dropped)
+    {
+        size_t span;
+        uint8_t *ptr = NULL;
+
+        if (UART_FRAME_MAX - UART_dma.frame.len >= count)
+            ptr = bytering_acquire(ring, count, &span);
+
+        if (NULL == ptr)
+        {
+            UART_dma.frame.dropped = true;
+            break;
+        }
+
+        memcpy(ptr, data, span);
+        data += span;
+        count -= span;
+        UART_dma.frame.len += span;
+    }
+
+    if (desc->err_eof)
+        UART_dma.frame.dropped = true;
+    if (! desc->suc_eof && ! desc->err_eof)
+        return false;
+
+    UART_dma.frame.open = false;
+    if (NULL == UART_dma.frame.hdr[0])
+        return false;
+
+    uint32_t hdr = UART_dma.frame.len | (UART_dma.frame.dropped ? UART_FRAME_DROPPED : 0);
+    *UART_dma.frame.hdr[0] = (uint8_t)hdr;
+    *UART_dma.frame.hdr[1] = (uint8_t)(hdr >> 8);
+
+    bytering_commit(ring, 2 + UART_dma.frame.len);
+    return true;
+}
+
+static IRAM_ATTR void UART_dma_rx_intr(void *arg)
+{
+    struct UART_dma *dma = arg;
+    struct UART_context *context = dma->context;
+    uint32_t flags = GDMA.channel[dma->ch].in.int_st.val;
+    bool filled = false;
+
+    GDMA.channel[dma->ch].in.int_clr.val = flags;
+
+    // blocks written back by DMA, in order of the circular chain
+    while (0 == dma->rx_next->owner)
+    {
+        struct GDMA_desc *desc = dma->rx_next;
+        /// block content is read after the owner was written back
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        // stream: the rest of block is lost when the ring is full
+        if (UART_DMA_SLIP == context->dma)
+            filled |= UART_dma_rx_frame(&context->rx_ring, desc);
+        else
+            filled |= 0 != bytering_write(&context->rx_ring, desc->buf, desc->length);
+
+        desc->length = 0;
+        desc->err_eof = 0;
+        desc->suc_eof = 0;
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        desc->owner = 1;
+        dma->rx_next = desc->next;
+    }
+
+    if (filled)
+        sem_post(&context->read_rdy);
+}
+
+static IRAM_ATTR void UART_dma_tx_intr(void *arg)
+{
+    struct UART_dma *dma = arg;
+    uint32_t flags = GDMA.channel[dma->ch].out.int_st.val;
+
+    GDMA.channel[dma->ch].out.int_clr.val = flags;
+
+    // every descriptor raises out_done, the round is completed when its last one was written back
+    spin_lock(&dma->tx_lock);
+    if (NULL != dma->tx_last && 0 == dma->tx_last->owner)
+    {
+        dma->tx_last = NULL;
+        /// posted under tx_lock: a stopped round never completes after UART_dma_tx_abort()
+        sem_post(&dma->tx_done);
+    }
+    spin_unlock(&dma->tx_lock);
+}
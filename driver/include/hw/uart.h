@@ -33,6 +33,33 @@
         UART_STOP_BITS_TWO,
     };
 
+    enum UART_dma_t
+    {
+        UART_DMA_NONE,
+        UART_DMA_STREAM,
+        UART_DMA_SLIP,
+    };
+
+    enum UART_rs485_t
+    {
+        UART_RS485_NONE,
+        UART_RS485_HALF_DUPLEX,
+        UART_RS485_COLLISION_DETECT,
+    };
+
+    enum UART_flow_t
+    {
+        UART_FLOW_NONE,
+        UART_FLOW_RTS_CTS,
+        UART_FLOW_XON_XOFF,
+    };
+
+    enum UART_console_overflow_t
+    {
+        UART_CONSOLE_DROP_OLDEST,
+        UART_CONSOLE_BLOCK,
+    };
+
 __BEGIN_DECLS
     /**
      *  create uart fd
@@ -43,5 +70,193 @@ __BEGIN_DECLS
 extern __attribute__((nothrow))
     int UART_createfd(int nb, uint32_t bps, enum UART_parity_t parity, enum UART_stopbits_t stopbits);
 
+    /**
+     *  configure uart rx buffering, it takes effect by next UART_createfd() or opening /dev/ttySN
+     *
+     *  @param ring_size
+     *      software rx ring in bytes, power of 2
+     *  @param fifo_thrhd
+     *      rx fifo level to interrupt, 1 ~ fifo length - 1
+     *  @param idle_bits
+     *      rx line idle in bit times to interrupt, the tail of burst below fifo_thrhd is drained by it
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL
+     *      EBUSY: the uart is opened
+     */
+extern __attribute__((nothrow))
+    int UART_rx_configure(int nb, uint32_t ring_size, unsigned fifo_thrhd, unsigned idle_bits);
+
+    /**
+     *  configure uart tx buffering, it takes effect by next UART_createfd() or opening /dev/ttySN
+     *      write() copies into the ring and returns, it waits / returns EAGAIN when hiwat bytes are queued,
+     *      tcdrain() / fsync() waits the queued was transmitted
+     *
+     *  @param ring_size
+     *      software tx ring in bytes, power of 2
+     *  @param hiwat
+     *      queued bytes of writers waiting, 1 ~ ring_size
+     *  @param fifo_thrhd
+     *      tx fifo level to refill, 0 ~ fifo length - 1
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL
+     *      EBUSY: the uart is opened
+     */
+extern __attribute__((nothrow))
+    int UART_tx_configure(int nb, uint32_t ring_size, uint32_t hiwat, unsigned fifo_thrhd);
+
+    /**
+     *  configure uart DMA mode, it takes effect by next UART_createfd() or opening /dev/ttySN
+     *      .DMA is provided by one bridge, only one uart can be configured at a time
+     *
+     *  @param mode
+     *      UART_DMA_NONE: rx / tx through fifo by cpu
+     *      UART_DMA_STREAM: bytes stream, rx line idle delivers what was received
+     *      UART_DMA_SLIP: SLIP frames encoded / decoded by hardware, one write() sends a frame,
+     *          one read() receives a frame, the rest of frame exceeds the read buffer is discarded
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: or RS485 / idle framing is configured for the uart
+     *      EBUSY: the uart is opened, or DMA is configured for another uart
+     */
+extern __attribute__((nothrow))
+    int UART_dma_configure(int nb, enum UART_dma_t mode);
+
+    /**
+     *  configure uart RS485, it takes effect by next UART_createfd() or opening /dev/ttySN
+     *      .hardware RS485 mode: RTS pin drives DE of the transceiver, high when transmitting, low when
+     *          receiving, DE setup / hold are timed by the uart without cpu
+     *      .DMA mode is not supported
+     *
+     *  @param mode
+     *      UART_RS485_NONE: frame_idle_bits is still applied
+     *      UART_RS485_HALF_DUPLEX: receiver is disabled when transmitting
+     *      UART_RS485_COLLISION_DETECT: receiver hears the echo when transmitting, the echo is read()
+     *          as received, RS485 clashes are counted by UART_rs485_collisions()
+     *  @param tx_delay_bits
+     *      DE setup: bit times of delaying transmission after DE was asserted, 0 ~ 15
+     *  @param turnaround_bits
+     *      DE hold: extra bit times after the last stop bit before DE is released, 0 ~ 2
+     *  @param frame_idle_bits
+     *      0: bytes stream
+     *      otherwise rx line idle in bit times delimits frames, one read() returns one frame, the rest of
+     *          frame exceeds the read buffer is discarded. transmitted frames are separated by the same idle
+     *          ex. Modbus-RTU 3.5 characters: 39 bits of 8E1
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: or DMA is configured for the uart, or RTS is flow control
+     *      EBUSY: the uart is opened
+     */
+extern __attribute__((nothrow))
+    int UART_rs485_configure(int nb, enum UART_rs485_t mode, unsigned tx_delay_bits, unsigned turnaround_bits,
+        unsigned frame_idle_bits);
+
+    /**
+     *  @returns
+     *      total of RS485 clashes since the uart was opened, parity / frame errors are not counted
+     */
+extern __attribute__((nothrow))
+    uint32_t UART_rs485_collisions(int nb);
+
+    /**
+     *  configure uart flow control, it takes effect by next UART_createfd() or opening /dev/ttySN
+     *      .the peer is held when rx fifo reaches rx_thrhd, it happens when the rx ring is full
+     *      .rx fifo threshold of UART_rx_configure() is lowered below rx_thrhd when it is not
+     *
+     *  @param flow
+     *      UART_FLOW_RTS_CTS: RTS is deasserted by rx_thrhd, transmission is paused by CTS
+     *      UART_FLOW_XON_XOFF: XOFF is sent by rx_thrhd and XON by half of it, transmission is paused
+     *          by received XOFF. XON (0x11) / XOFF (0x13) are never read() as data
+     *  @param rx_thrhd
+     *      rx fifo level, 2 ~ fifo length - 1
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: or RTS is DE of RS485
+     *      EBUSY: the uart is opened
+     */
+extern __attribute__((nothrow))
+    int UART_flow_configure(int nb, enum UART_flow_t flow, unsigned rx_thrhd);
+
+    /**
+     *  configure uart pins routed by GPIO matrix, it takes effect by next UART_createfd() or opening
+     *      /dev/ttySN
+     *      .default UART0: TXD 43, RXD 44. UART1: TXD 17, RXD 18. UART2: none
+     *      .RTS is routed by flow control or RS485, CTS by flow control
+     *
+     *  @param txd, rxd, rts, cts
+     *      pin number, -1 is not routed
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL
+     *      EBUSY: the uart is opened
+     */
+extern __attribute__((nothrow))
+    int UART_pins_configure(int nb, int txd, int rxd, int rts, int cts);
+
+    /**
+     *  detect baudrate of opened uart by its received signal, the detected is applied
+     *      .peer sends a pattern of single bit pulses, ex. 'U' (0x55)
+     *      .bytes received before the detection are garbage
+     *
+     *  @param edges
+     *      rxd edges to count before the detection, 2 ~ 1023, ex. 'U' has 10 edges of 8N1
+     *  @param timeout
+     *      milliseconds
+     *  @returns
+     *      On success detected baudrate is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL
+     *      ENODEV: the uart is not opened
+     *      ETIMEDOUT
+     */
+extern __attribute__((nothrow))
+    int UART_autobaud(int nb, unsigned edges, uint32_t timeout);
+
+/****************************************************************************
+ *  console: stdout / stderr without fd are written to UART0 through the console
+ *      .console_write() appends to the buffer of running core, UART0 interrupt transmits it
+ ****************************************************************************/
+    /**
+     *  configure console overflow policy, default UART_CONSOLE_DROP_OLDEST
+     *
+     *  @param overflow
+     *      UART_CONSOLE_DROP_OLDEST: the oldest buffered output is dropped to make room, writer never waits
+     *      UART_CONSOLE_BLOCK: writer waits the room, ISR writer transmits by itself
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL
+     */
+extern __attribute__((nothrow))
+    int UART_console_configure(enum UART_console_overflow_t overflow);
+
+    /**
+     *  @returns
+     *      total of console output bytes dropped by overflow
+     */
+extern __attribute__((nothrow))
+    uint32_t UART_console_dropped(void);
+
+    /**
+     *  panic: transmit everything buffered by spinning, console is synchronous since
+     */
+extern __attribute__((nothrow))
+    void UART_console_panic(void);
+
 __END_DECLS
 #endif
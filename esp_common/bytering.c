@@ -0,0 +1,177 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <esp_attr.h>
+#include <string.h>
+#include <sys/errno.h>
+
+#include <rtos/bytering.h>
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static uint32_t BYTERING_reserve(bytering_t *ring, size_t count, bool contiguous, uint32_t *pos);
+
+/***************************************************************************/
+/** @implements
+****************************************************************************/
+int bytering_init(bytering_t *ring, void *buf, size_t size)
+{
+    if (0 == size || 0 != (size & (size - 1)))
+        return __set_errno_neg(EINVAL);
+
+    ring->buf = buf;
+    ring->mask = (uint32_t)(size - 1);
+
+    ring->head = 0;
+    ring->reserve = 0;
+    ring->committed = 0;
+    ring->ready = 0;
+    return 0;
+}
+
+void bytering_reset(bytering_t *ring)
+{
+    bytering_consume(ring, bytering_readable(ring));
+}
+
+IRAM_ATTR
+size_t bytering_write(bytering_t *ring, void const *data, size_t count)
+{
+    uint32_t pos;
+    size_t written = BYTERING_reserve(ring, count, false, &pos);
+
+    if (0 != written)
+    {
+        size_t offset = pos & ring->mask;
+        size_t first = ring->mask + 1 - offset;
+
+        if (first > written)
+            first = written;
+
+        memcpy(ring->buf + offset, data, first);
+        memcpy(ring->buf, (uint8_t const *)data + first, written - first);
+
+        bytering_commit(ring, written);
+    }
+    return written;
+}
+
+IRAM_ATTR
+void *bytering_acquire(bytering_t *ring, size_t count, size_t *span)
+{
+    uint32_t pos;
+    *span = BYTERING_reserve(ring, count, true, &pos);
+
+    if (0 != *span)
+        return ring->buf + (pos & ring->mask);
+    else
+        return NULL;
+}
+
+IRAM_ATTR
+void bytering_commit(bytering_t *ring, size_t span)
+{
+    if (0 == span)
+        return;
+
+    /**
+     *  totals of committed and reserved are equal: nothing reserved is being written, everything
+     *      reserved is readable. otherwise the last committing producer publishes
+     */
+    uint32_t committed = __atomic_add_fetch(&ring->committed, (uint32_t)span, __ATOMIC_ACQ_REL);
+    if (committed != __atomic_load_n(&ring->reserve, __ATOMIC_ACQUIRE))
+        return;
+
+    uint32_t ready = __atomic_load_n(&ring->ready, __ATOMIC_RELAXED);
+
+    /// a later committing producer may have published further
+    while (0 < (int32_t)(committed - ready) &&
+        ! __atomic_compare_exchange_n(&ring->ready, &ready, committed, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+IRAM_ATTR
+void const *bytering_peek(bytering_t *ring, size_t *count)
+{
+    size_t readable = bytering_readable(ring);
+
+    if (0 == readable)
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    size_t offset = ring->head & ring->mask;
+    size_t contiguous = ring->mask + 1 - offset;
+
+    *count = readable < contiguous ? readable : contiguous;
+    return ring->buf + offset;
+}
+
+IRAM_ATTR
+void bytering_consume(bytering_t *ring, size_t count)
+{
+    /// producers see the space after the consumer finished reading
+    __atomic_store_n(&ring->head, ring->head + (uint32_t)count, __ATOMIC_RELEASE);
+}
+
+IRAM_ATTR
+size_t bytering_read(bytering_t *ring, void *buf, size_t bufsize)
+{
+    size_t retval = 0;
+
+    /// at most twice: the head, then the beginning of buffer
+    while (retval < bufsize)
+    {
+        size_t count;
+        void const *ptr = bytering_peek(ring, &count);
+
+        if (NULL == ptr)
+            break;
+        if (count > bufsize - retval)
+            count = bufsize - retval;
+
+        memcpy((uint8_t *)buf + retval, ptr, count);
+        bytering_consume(ring, count);
+        retval += count;
+    }
+    return retval;
+}
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+IRAM_ATTR
+static uint32_t BYTERING_reserve(bytering_t *ring, size_t count, bool contiguous, uint32_t *pos)
+{
+    uint32_t reserve = __atomic_load_n(&ring->reserve, __ATOMIC_RELAXED);
+    uint32_t grant;
+
+    do
+    {
+        grant = ring->mask + 1 - (reserve - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE));
+
+        if (contiguous && grant > ring->mask + 1 - (reserve & ring->mask))
+            grant = ring->mask + 1 - (reserve & ring->mask);
+        if (grant > count)
+            grant = (uint32_t)count;
+        if (0 == grant)
+            return 0;
+    }
+    while (! __atomic_compare_exchange_n(&ring->reserve, &reserve, reserve + grant, true,
+        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    *pos = reserve;
+    return grant;
+}
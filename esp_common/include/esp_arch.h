@@ -22,6 +22,21 @@ static inline
     #endif
     }
 
+    /**
+     *  times the interrupt was dispatched to its handler on cpu, 0 when not supported
+    */
+static inline
+    uint32_t __intr_nb_count(unsigned intr_nb, unsigned cpu)
+    {
+    #ifdef __XTENSA__
+        return xt_int_count(intr_nb, cpu);
+    #else
+        (void)intr_nb;
+        (void)cpu;
+        return 0;
+    #endif
+    }
+
 static inline
     intr_handler_t __intr_nb_set_handler(unsigned intr_nb, intr_handler_t handler, void* arg)
     {
@@ -0,0 +1,202 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __AIO_H
+#define __AIO_H                         1
+
+#include <features.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/_timespec.h>
+
+    /// aio_cancel() @returns
+    #define AIO_CANCELED                (0)
+    #define AIO_NOTCANCELED             (1)
+    #define AIO_ALLDONE                 (2)
+
+    /// aiocb.aio_lio_opcode of lio_listio()
+    #define LIO_READ                    (0)
+    #define LIO_WRITE                   (1)
+    #define LIO_NOP                     (2)
+
+    /// lio_listio() mode
+    #define LIO_WAIT                    (0)
+    #define LIO_NOWAIT                  (1)
+
+    /// devices with queued requests have their own worker thread
+    #ifndef AIO_MAX_DEVICES
+        #define AIO_MAX_DEVICES         (4)
+    #endif
+    /// threads blocking in aio_suspend() / lio_listio(LIO_WAIT) at same time
+    #ifndef AIO_MAX_SUSPEND
+        #define AIO_MAX_SUSPEND         (8)
+    #endif
+    #define AIO_LISTIO_MAX              (16)
+
+    /**
+     *  completion latency histogram: from submitted to completed
+     *      bucket i counts latency < AIO_LATENCY_BUCKET_US(i),
+     *      the last bucket counts everything else
+     */
+    #define AIO_LATENCY_BUCKETS         (16)
+    #define AIO_LATENCY_BUCKET_US(i)    (64ULL << (i))
+
+    struct aiocb
+    {
+        int aio_fildes;
+        off_t aio_offset;
+        volatile void *aio_buf;
+        size_t aio_nbytes;
+        /// not supported: requests to the same device are served in FIFO order
+        int aio_reqprio;
+        /**
+         *  SIGEV_NONE / SIGEV_THREAD, 0 of a zero initialized aiocb is SIGEV_NONE
+         *      .SIGEV_THREAD: sigev_notify_function() is called by device's worker thread,
+         *          it should be short, other requests of the device are waiting
+         */
+        struct sigevent aio_sigevent;
+        int aio_lio_opcode;
+
+        /// @private
+        struct aiocb *__next;
+        int __opcode;
+        int __error;
+        ssize_t __return;
+        int64_t __submit_us;
+    };
+
+    /**
+     *  aio_init() configuration, 0 for default
+     *      .changing aio_threads / aio_priority / aio_stack_size only affects workers not yet started
+     */
+    struct aioinit
+    {
+        /// maximum worker threads, limited by AIO_MAX_DEVICES
+        int aio_threads;
+        /// queue depth of each device, aio_read() / aio_write() return EAGAIN when it was full
+        int aio_num;
+        int aio_priority;
+        int aio_stack_size;
+    };
+
+    struct aio_stats
+    {
+        uint32_t submitted;
+        uint32_t completed;
+        uint32_t failed;
+        uint32_t cancelled;
+        /// EAGAIN by queue depth
+        uint32_t queue_full;
+        /// maximum queued requests of any device
+        uint32_t max_depth;
+
+        uint32_t latency_max_us;
+        uint64_t latency_total_us;
+        uint32_t latency_hist[AIO_LATENCY_BUCKETS];
+    };
+
+__BEGIN_DECLS
+
+    /**
+     *  aio_init()
+     *      glibc extension
+     */
+extern __attribute__((nonnull, nothrow))
+    void aio_init(struct aioinit const *init);
+
+    /**
+     *  aio_read() / aio_write()
+     *      queue the request to worker of device which fd belongs, requests of different devices
+     *      are overlapped, requests of the same device are served in order
+     *      .aio_offset is ignored by non-seekable fds
+     *      .the fd position is not used nor changed when the fd implements positional .pread / .pwrite,
+     *          otherwise it is moved and restored around the request, see pread()
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EBADF
+     *      EINVAL: aio_sigevent is not 0 / SIGEV_NONE / SIGEV_THREAD
+     *      EAGAIN: queue of device is full, or no more worker for a new device
+     */
+extern __attribute__((nonnull, nothrow))
+    int aio_read(struct aiocb *aiocbp);
+extern __attribute__((nonnull, nothrow))
+    int aio_write(struct aiocb *aiocbp);
+
+    /**
+     *  aio_fsync()
+     *      queue fsync() after all requests of the device queued before
+     *      op O_SYNC / O_DSYNC are same
+     */
+extern __attribute__((nonnull, nothrow))
+    int aio_fsync(int op, struct aiocb *aiocbp);
+
+    /**
+     *  aio_error()
+     *  @returns
+     *      EINPROGRESS / ECANCELED / 0 / errno of the request
+     */
+extern __attribute__((nonnull, nothrow))
+    int aio_error(struct aiocb const *aiocbp);
+
+    /**
+     *  aio_return()
+     *      retrieve the return of read() / write() / fsync(), call once when aio_error() is not EINPROGRESS
+     *  @errors
+     *      EINVAL: request is in progress
+     */
+extern __attribute__((nonnull, nothrow))
+    ssize_t aio_return(struct aiocb *aiocbp);
+
+    /**
+     *  aio_suspend()
+     *      wait until one of the list completed, NULL elements are ignored
+     *      .timeout is relative, NULL to wait forever
+     *  @errors
+     *      EAGAIN: timeout, or AIO_MAX_SUSPEND threads are waiting
+     */
+extern __attribute__((nonnull(1), nothrow))
+    int aio_suspend(struct aiocb const * const list[], int nent, struct timespec const *timeout);
+
+    /**
+     *  aio_cancel()
+     *      cancel queued requests, requests in progress can not be cancelled
+     *      .aiocbp NULL to cancel all requests of fd
+     *  @returns
+     *      AIO_CANCELED / AIO_NOTCANCELED / AIO_ALLDONE
+     */
+extern __attribute__((nothrow))
+    int aio_cancel(int fd, struct aiocb *aiocbp);
+
+    /**
+     *  lio_listio()
+     *      .sevp is not supported, must be NULL, 0 or SIGEV_NONE
+     *  @errors
+     *      EIO: one or more requests failed, check by aio_error()
+     */
+extern __attribute__((nonnull(2), nothrow))
+    int lio_listio(int mode, struct aiocb * const list[], int nent, struct sigevent *sevp);
+
+    /**
+     *  aio_stats_np()
+     *      not posix: counters and latency histogram, cleared when reset is true
+     */
+extern __attribute__((nonnull, nothrow))
+    void aio_stats_np(struct aio_stats *stats, bool reset);
+
+__END_DECLS
+#endif
@@ -44,6 +44,9 @@ __BEGIN_DECLS
     };
     /// get dirent size by length of name
     #define DIRENT_SIZE(NAMELEN)        (offsetof(struct dirent, d_name) + NAMELEN)
+    /// record length of packed dirent by getdents(), d_name is '\0' terminated
+    #define DIRENT_RECLEN(NAMELEN)      \
+        ((DIRENT_SIZE((size_t)(NAMELEN) + 1) + __alignof__(struct dirent) - 1) & ~(__alignof__(struct dirent) - 1))
 
     struct DIR
     {
@@ -105,9 +108,35 @@ extern __attribute__((nonnull, nothrow))
 extern __attribute__((nonnull, nothrow))
     int dirfd(DIR *dir);
 
+    /**
+     *  getdents()
+     *      read multiple directory entries of directory fd in one call
+     *      .entries are packed in buf, each entry occupies DIRENT_RECLEN(ent->d_namelen) bytes
+     *      .d_mode / d_ino / d_size and file times are filled, no stat() is required per entry
+     *      .'.' and '..' are not returned, they are provided by readdir() only
+     *  @returns
+     *      On success the number of bytes filled, 0 at end of directory
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EBADF
+     *      ENOTDIR
+     *      EINVAL: buf is too small for the next entry
+     */
+extern __attribute__((nonnull, nothrow))
+    ssize_t getdents(int fd, void *buf, size_t count);
+
 extern __attribute__((nonnull, nothrow))
     int alphasort(struct dirent const **a, struct dirent const **b);
 
+    /**
+     *  scandir()
+     *      scans the directory by getdents(), entries including '.' and '..' are passed to filter()
+     *      when not NULL, and the entries filter() returns nonzero are sorted by compar() when
+     *      not NULL. *entrylist and each entry are malloc()ed, the caller should free() them.
+     *  @returns
+     *      On success the number of entries in *entrylist
+     *      On error, -1 is returned, and errno is set to indicate the error
+     */
 extern __attribute__((nothrow))
     int scandir(char const *pathname, struct dirent ***entrylist,
         int (* filter)(struct dirent const *),
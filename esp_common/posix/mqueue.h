@@ -17,6 +17,7 @@
 
 #include <features.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <sys/types.h>
 
 __BEGIN_DECLS
@@ -26,6 +27,7 @@ typedef int                         mqd_t;
 struct mq_attr
 {
     // Message queue flags.
+    //  UltraCore: mq_open() also accepts MQUEUE_FLAG_RING / MQUEUE_FLAG_SPSC / MQUEUE_FLAG_VARLEN, see rtos/user.h
     uint32_t mq_flags;
     // Maximum number of messages.
     uint32_t mq_maxmsg;
@@ -37,6 +39,12 @@ struct mq_attr
 #define MQATTR_INITIALIZER(maxmsg, msgsize) \
     {.mq_flags = 0, .mq_maxmsg = maxmsg, .mq_msgsize = msgsize, .mq_curmsgs = 0}
 
+/**
+ *  mq_open()
+ *      .mq_attr.mq_flags of MQUEUE_FLAG_RING / MQUEUE_FLAG_SPSC / MQUEUE_FLAG_VARLEN creates the mqueue
+ *          by rtos/user.h extension, those mqueues are received in sending order and msg_prio is
+ *          ignored for ordering
+ */
 extern  __attribute__((nothrow, nonnull(1)))
     mqd_t mq_open(char const *name, int flags, /* optional mode_t, struct mq_attr * */...);
 extern  __attribute__((nothrow))
@@ -49,6 +57,24 @@ extern  __attribute__((nothrow, nonnull(2)))
 extern  __attribute__((nothrow, nonnull(2)))
     int mq_setattr(mqd_t mqd, struct mq_attr const *restrict attr, struct mq_attr *restrict oattr);
 
+    /// sigev_notify of mq_notify(): sem_post() to sigev_value.sival_ptr
+    #define SIGEV_SEMAPHORE_NP          (0x100)
+
+/**
+ *  mq_notify()
+ *      notify once when a message arrives the empty mqueue and no receiver is blocked
+ *      .SIGEV_THREAD: sigev_notify_function() is called by a notification worker shared by all mqueues,
+ *          sigev_notify_attributes is ignored
+ *          .the worker queues up to 16 pending calls, a message arrives while they are full keeps the
+ *              registration for the next message, counted as overflows of /proc/mqueue
+ *      .SIGEV_SEMAPHORE_NP: sem_post() to sigev_value.sival_ptr by the sender, no thread is involved
+ *      .NULL notification removes the registration
+ *  @errors
+ *      EBADF: mqd is not a mqueue descriptor
+ *      EBUSY: notification was already registered
+ *      EINVAL: sigev_notify is not SIGEV_NONE / SIGEV_THREAD / SIGEV_SEMAPHORE_NP
+ *      EAGAIN: SIGEV_THREAD requires the notification worker, it failed to create
+ */
 extern  __attribute__((nothrow))
     int mq_notify(mqd_t mqd, struct sigevent const *notification);
 
@@ -58,11 +84,32 @@ extern  __attribute__((nothrow, nonnull(2, 5)))
     ssize_t mq_timedreceive(mqd_t mqd, void *restrict buf, size_t bufsize, unsigned int *restrict prio,
         struct timespec const *restrict abs_ts);
 
+/**
+ *  mq_send() / mq_timedsend()
+ *      .msg_prio is checked against MQ_PRIO_MAX always
+ *      .ring mode (MQUEUE_FLAG_RING / MQUEUE_FLAG_SPSC) ignores msg_prio for ordering, it is carried to
+ *          the receiver but messages are never sorted, a higher priority message does not overtake
+ *      .MQUEUE_FLAG_SPLIT does not even carry msg_prio, it is received as 0
+ */
 extern  __attribute__((nothrow, nonnull(2)))
     int mq_send(mqd_t mqd, void const *buf, size_t count, unsigned int prio);
 extern  __attribute__((nothrow, nonnull(2, 5)))
     int mq_timedsend(mqd_t mqd, void const *buf, size_t count, unsigned int prio,
         struct timespec const *abs_ts);
 
+/**
+ *  UltraCore extension: mq_send_batch() / mq_receive_batch()
+ *      move up to msg_count messages of mq_msgsize packed in buf
+ *      .the first message waits as mq_send() / mq_receive(), the rest are moved only while the queue
+ *          is not full / empty
+ *      .prio of mq_receive_batch() is an optional array of msg_count
+ *  @returns
+ *      the number of messages moved, -1 and errno is set on error
+ */
+extern  __attribute__((nothrow, nonnull(2)))
+    ssize_t mq_send_batch(mqd_t mqd, void const *buf, size_t msg_count, unsigned int prio);
+extern  __attribute__((nothrow, nonnull(2)))
+    ssize_t mq_receive_batch(mqd_t mqd, void *buf, size_t msg_count, unsigned int *prio);
+
 __END_DECLS
 #endif
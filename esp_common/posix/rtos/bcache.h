@@ -0,0 +1,164 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_BCACHE_H
+#define __FS_BCACHE_H                   1
+
+#include <features.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+    /**
+     *  block device under the cache
+     *      .read() / write() are called with addr and size aligned to cache block size,
+     *          except the last partial block of device, its size is clamped to device size
+     *      .write() is responsible for erasing, one coalesced write may cover multiple blocks
+     *      .all callbacks @returns 0 on success, otherwise an errno
+     */
+    struct BCACHE_device
+    {
+        void *ctx;
+        /// device size in bytes
+        uint64_t size;
+
+        int (* read)  (void *ctx, uint64_t addr, void *buf, size_t size);
+        int (* write) (void *ctx, uint64_t addr, void const *buf, size_t size);
+        /// optional: device level barrier after cache was written back
+        int (* sync)  (void *ctx);
+    };
+
+    enum BCACHE_policy_t
+    {
+        BCACHE_POLICY_LRU               = 0,
+        /// adaptive replacement cache: scan resistant, tracks recently evicted blocks
+        BCACHE_POLICY_ARC,
+    };
+
+    enum BCACHE_placement_t
+    {
+        BCACHE_PLACE_INTERNAL           = 0,
+        BCACHE_PLACE_PSRAM,
+        /// PSRAM when available, otherwise internal RAM
+        BCACHE_PLACE_PREFER_PSRAM,
+    };
+
+    /// every write is written back immediately, reads are still cached
+    #define BCACHE_FLAG_WRITE_THROUGH   (1U << 0)
+
+    struct BCACHE_config
+    {
+        /// power of 2, usually the erase size of device
+        uint32_t block_size;
+        /// blocks resident in cache
+        uint16_t block_count;
+        /// maximum continuous dirty blocks merged into one device write, 0 / 1 for no merging
+        uint16_t coalesce_max;
+
+        enum BCACHE_policy_t policy;
+        enum BCACHE_placement_t placement;
+        unsigned flags;
+    };
+
+    /// hit rate = hits / (hits + misses)
+    struct BCACHE_stats
+    {
+        uint32_t hits;
+        uint32_t misses;
+        /// ARC: misses found in recently evicted history
+        uint32_t ghost_hits;
+        uint32_t evictions;
+
+        uint32_t device_reads;
+        uint32_t device_writes;
+        /// blocks written by device_writes, > device_writes when writes was coalesced
+        uint32_t blocks_written;
+        /// current dirty blocks
+        uint32_t dirty;
+    };
+
+    struct BCACHE;
+
+__BEGIN_DECLS
+
+    /**
+     *  BCACHE_create()
+     *      create a cache over device, device must be valid until BCACHE_destroy()
+     *  @returns
+     *      On success the cache is returned
+     *      On error, NULL is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: block_size is not power of 2, or block_count is 0
+     *      ENOMEM
+     */
+extern __attribute__((nonnull, nothrow))
+    struct BCACHE *BCACHE_create(struct BCACHE_device const *dev, struct BCACHE_config const *config);
+
+    /**
+     *  BCACHE_destroy()
+     *      write back all dirty blocks and release the cache
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, the cache is kept, and errno is set to indicate the error
+     */
+extern __attribute__((nonnull, nothrow))
+    int BCACHE_destroy(struct BCACHE *cache);
+
+    /**
+     *  BCACHE_pread() / BCACHE_pwrite()
+     *      byte access through the cache, partial block writes are merged in cache
+     *  @returns
+     *      On success the number of bytes transferred, less than count at end of device
+     *      On error, -1 is returned, and errno is set to indicate the error
+     */
+extern __attribute__((nonnull, nothrow))
+    ssize_t BCACHE_pread(struct BCACHE *cache, void *buf, size_t count, uint64_t offset);
+extern __attribute__((nonnull, nothrow))
+    ssize_t BCACHE_pwrite(struct BCACHE *cache, void const *buf, size_t count, uint64_t offset);
+
+    /**
+     *  BCACHE_sync()
+     *      barrier: write back all dirty blocks in ascending order, then device->sync()
+     */
+extern __attribute__((nonnull, nothrow))
+    int BCACHE_sync(struct BCACHE *cache);
+
+    /**
+     *  BCACHE_invalidate()
+     *      write back and drop all cached blocks, eg. device was modified by other path
+     */
+extern __attribute__((nonnull, nothrow))
+    int BCACHE_invalidate(struct BCACHE *cache);
+
+    /**
+     *  BCACHE_get_stats()
+     *      counters are cleared when reset is true, except the dirty
+     */
+extern __attribute__((nonnull, nothrow))
+    void BCACHE_get_stats(struct BCACHE *cache, struct BCACHE_stats *stats, bool reset);
+
+    /**
+     *  BCACHE_createfd()
+     *      create a block special fd reading / writing through the cache
+     *      .fsync() is BCACHE_sync(), close() writes back but not destroy the cache
+     *      .close() releases the fd even when writing back failed, and reports the error
+     *  @returns
+     *      On success fd is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     */
+extern __attribute__((nonnull, nothrow))
+    int BCACHE_createfd(struct BCACHE *cache);
+
+__END_DECLS
+#endif
@@ -0,0 +1,161 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __C_BYTE_RING_H
+#define __C_BYTE_RING_H                 1
+
+#include <features.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/****************************************************************************
+ *  @declaration
+ ***************************************************************************/
+    /**
+     *  @bytering
+     *      lock-free byte ring of multi-producer and single-consumer
+     *
+     *  .producers: tasks / ISRs of any core, no critical section is entered
+     *      bytering_write(...);
+     *      or
+     *      ptr = bytering_acquire(..., &span);     // contiguous span, ex. DMA target
+     *      ...
+     *      bytering_commit(..., span);
+     *
+     *  .consumer: only one task at a time
+     *      ptr = bytering_peek(..., &count);       // zero-copy
+     *      ...
+     *      bytering_consume(..., count);
+     *      or
+     *      bytering_read(...);
+     *
+     *  .space is claimed by CAS of reserve, and published by totals of committed bytes:
+     *      a producer never blocks on other producers, but bytes become readable only when all
+     *      reserved before them were committed
+     *
+     *  .consumer starvation: ready advances only when a commit catches committed up with reserve,
+     *      every outstanding span holds back everything committed after it
+     *      .a preempted producer holds back the consumer until it is scheduled again
+     *      .producers overlapping continuously hold back the consumer until the ring is full: no more
+     *          is reserved, the last outstanding commit publishes everything
+     *      the consumer never waits longer than the longest acquire() / commit() window or one ring
+     *      of bytes, keep the window short, eg. no blocking between acquire() and commit()
+     */
+    struct bytering_t
+    {
+        uint8_t *buf;
+        uint32_t mask;
+
+        /// free running positions
+        uint32_t head;          // consumer
+        uint32_t reserve;       // claimed by producers
+        uint32_t committed;     // total of committed bytes
+        uint32_t ready;         // readable by consumer
+    };
+    typedef struct bytering_t       bytering_t;
+
+__BEGIN_DECLS
+/****************************************************************************
+ *  byte ring @basic
+ ****************************************************************************/
+    /**
+     *  bytering_init()
+     *      size must be power of 2
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: size is not power of 2
+     */
+extern __attribute__((nonnull, nothrow))
+    int bytering_init(bytering_t *ring, void *buf, size_t size);
+
+    /**
+     *  bytering_reset(): drop everything
+     *      .only when no producer is writting
+     */
+extern __attribute__((nonnull, nothrow))
+    void bytering_reset(bytering_t *ring);
+
+static inline __attribute__((nonnull, nothrow))
+    size_t bytering_size(bytering_t const *ring)
+    {
+        return ring->mask + 1;
+    }
+
+static inline __attribute__((nonnull, nothrow))
+    size_t bytering_readable(bytering_t const *ring)
+    {
+        return __atomic_load_n(&ring->ready, __ATOMIC_ACQUIRE) - ring->head;
+    }
+
+static inline __attribute__((nonnull, nothrow))
+    size_t bytering_writable(bytering_t const *ring)
+    {
+        return ring->mask + 1 -
+            (__atomic_load_n(&ring->reserve, __ATOMIC_RELAXED) - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE));
+    }
+
+/****************************************************************************
+ *  byte ring @producer: ISR safe
+ ****************************************************************************/
+    /**
+     *  bytering_write()
+     *  @returns
+     *      bytes written, it can be less than count when the ring is full
+     */
+extern __attribute__((nonnull, nothrow))
+    size_t bytering_write(bytering_t *ring, void const *data, size_t count);
+
+    /**
+     *  bytering_acquire() / bytering_commit()
+     *      claim a contiguous span of up to count bytes, it is shorter when the ring is full or at the
+     *      end of buffer
+     *      .span is never shrinked, the whole acquired span must be committed
+     *  @returns
+     *      pointer to the span, NULL when the ring is full
+     */
+extern __attribute__((nonnull, nothrow))
+    void *bytering_acquire(bytering_t *ring, size_t count, size_t *span);
+
+extern __attribute__((nonnull, nothrow))
+    void bytering_commit(bytering_t *ring, size_t span);
+
+/****************************************************************************
+ *  byte ring @consumer
+ ****************************************************************************/
+    /**
+     *  bytering_peek()
+     *      contiguous readable bytes at the head, the rest follows at the beginning of buffer
+     *  @returns
+     *      pointer to readable bytes, NULL when the ring is empty
+     */
+extern __attribute__((nonnull, nothrow))
+    void const *bytering_peek(bytering_t *ring, size_t *count);
+
+extern __attribute__((nonnull, nothrow))
+    void bytering_consume(bytering_t *ring, size_t count);
+
+    /**
+     *  bytering_read()
+     *  @returns
+     *      bytes read
+     */
+extern __attribute__((nonnull, nothrow))
+    size_t bytering_read(bytering_t *ring, void *buf, size_t bufsize);
+
+__END_DECLS
+#endif
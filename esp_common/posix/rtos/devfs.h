@@ -0,0 +1,93 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_DEVFS_H
+#define __FS_DEVFS_H                    1
+
+#include <features.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <rtos/filesystem.h>
+
+    /// devfs is mounted as '/dev' when filesystem initializing
+    #define DEVFS_DIR                   "dev"
+
+    /// registered nodes, ino of nodes are 1 ~ DEVFS_MAX_NODES
+    #ifndef DEVFS_MAX_NODES
+        #define DEVFS_MAX_NODES         (32)
+    #endif
+    #define DEVFS_NAME_MAX              (15)
+
+    /**
+     *  DEVFS_open_t
+     *      called by every open("/dev/name") with flags of open(), @returns the fd of device
+     *      .arg is the driver's per-device context it was registered, the configuration cached in
+     *          it is reused, clocks and pins are programmed once instead of on each open
+     *      .the fd is owned by driver, it is not a filesystem fd
+     */
+    typedef int (* DEVFS_open_t)(void *arg, int flags);
+
+    /**
+     *  DEVFS_release_t
+     *      called once the node was removed by DEVFS_unregister() / unlink(), with devfs locked
+     *      .open() of the node is never called after, fds already opened are not affected
+     */
+    typedef void (* DEVFS_release_t)(void *arg);
+
+__BEGIN_DECLS
+
+    /**
+     *  DEVFS_implement
+     *      flat namespace of device nodes, lookup by name is O(1) hashing
+     */
+extern
+    struct FS_implement const DEVFS_implement;
+
+    /**
+     *  DEVFS_register()
+     *      register node '/dev/name', eg. "ttyS0" / "i2c-0"
+     *  @param mode
+     *      S_IFCHR / S_IFBLK with permission bits
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: name is empty or contains '/'
+     *      ENAMETOOLONG: name exceeds DEVFS_NAME_MAX
+     *      EEXIST: name is already registered
+     *      ENOSPC: DEVFS_MAX_NODES was reached
+     */
+extern __attribute__((nonnull(1, 3), nothrow))
+    int DEVFS_register(char const *name, mode_t mode, DEVFS_open_t open, void *arg);
+
+    /**
+     *  DEVFS_register_release()
+     *      DEVFS_register() with release called when the node is removed, eg. to free arg
+     */
+extern __attribute__((nonnull(1, 3, 4), nothrow))
+    int DEVFS_register_release(char const *name, mode_t mode, DEVFS_open_t open,
+        DEVFS_release_t release, void *arg);
+
+    /**
+     *  DEVFS_unregister()
+     *      remove node '/dev/name', same as unlink("/dev/name"), fds already opened are not affected
+     *  @errors
+     *      ENOENT
+     */
+extern __attribute__((nonnull, nothrow))
+    int DEVFS_unregister(char const *name);
+
+__END_DECLS
+#endif
@@ -53,8 +53,13 @@ extern __attribute__((nothrow))
         ino_t ino_working;
         /// file or directory's size
         size_t size;
+        /// content owned by this fd only, eg. procfs rendered text, data is shared by the mount
+        void *fd_data;
     };
 
+    struct dirent;
+    struct stat;
+
     struct FS_implement
     {
         char *name;
@@ -64,21 +69,30 @@ extern __attribute__((nothrow))
         struct FD_implement const *fsio;
 
         int (* open)    (struct fsio_t *fsio);
+        /// create(): fsio->ino_working is the ino of parent directory
         int (* create)  (struct fsio_t *fsio, char const *name, mode_t mode);
         int (* truncate)(struct fsio_t *fsio, off_t size);
         int (* unlink)  (struct fsio_t *fsio, ino_t ino);
         int (* format)  (struct fsio_t *fsio, char const *fstype);
+        /**
+         *  optional: find name in directory fsio without enumerating it by readdir()
+         *      @returns 0 on success with ent filled, -1 and errno is set to ENOENT when not found
+         */
+        int (* lookup)  (struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent);
+        /**
+         *  optional: fill as many packed dirents as bufsize can hold from AsFD(fd)->position
+         *      fd is directory, see getdents() for the buffer layout
+         *      @returns bytes filled, 0 at end of directory
+         */
+        ssize_t (* getdents)(int fd, void *buf, size_t bufsize);
+        /**
+         *  optional: complete struct stat for fstat()
+         *      st_mode / st_ino / st_size / st_nlink are filled from fd before calling
+         */
+        int (* fstat)   (struct fsio_t *fsio, struct stat *st);
     };
     struct FD_implement;
 
-    /**
-     *  FILESYSTEM_lock() / FILESYSTEM_unlock()
-     */
-extern __attribute((nothrow))
-    void FILESYSTEM_lock(void);
-extern __attribute((nothrow))
-    void FILESYSTEM_unlock(void);
-
 extern __attribute__((nothrow))
     int FILESYSTEM_format(char const *pathmnt, char const *fstype);
 
@@ -98,18 +112,41 @@ extern
 extern __attribute__((nothrow))
     void FILESYSTEM_init_root(void);
 
+    /// directory of root where filesystems are mounted
+    #define FILESYSTEM_MOUNT_DIR        "mnt"
+    #ifndef FILESYSTEM_MAX_MOUNTS
+        #define FILESYSTEM_MAX_MOUNTS   (8)
+    #endif
+    #define FILESYSTEM_MOUNT_NAME_MAX   (15)
+
     /**
      *  FILESYSTEM_mount()
-     *      mount filesystem into '/mnt'
+     *      mount filesystem into '/mnt/name', or into '/name' when name is "/name", eg. devfs "/dev"
+     *      .the mount is resolved before walking the root filesystem, '/mnt' is not required to exist
+     *      .filesystems of different mounts share no lock, they are running concurrently
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: name is empty or contains '/' other than the leading
+     *      ENAMETOOLONG: name exceeds FILESYSTEM_MOUNT_NAME_MAX
+     *      EEXIST: name is already mounted
+     *      ENOSPC: FILESYSTEM_MAX_MOUNTS was reached
      */
-extern __attribute__((nonnull, nothrow))
+extern __attribute__((nonnull(1, 2), nothrow))
     int FILESYSTEM_mount(char const *name, struct FS_implement const *fs, void *data);
 
     /**
      *  FILESYSTEM_unmount()
-     *      unmount '/mnt/name'
+     *      unmount '/mnt/name' or "/name", waits for path walkings in progress through the mount
+     *      .fails when any fd opened under the mount is still opened, the mount is kept
+     *      .destroy data by the filesystem after, eg. TMPFS_destroy()
      *  @returns
      *      data FILESYSTEM_mount was provided
+     *      On error, NULL is returned, and errno is set to indicate the error
+     *  @errors
+     *      ENOENT: name is not mounted
+     *      EBUSY: fds of the mount are still opened, including opened directories
      */
 extern __attribute__((nonnull, nothrow))
     void *FILESYSTEM_unmount(char const *name);
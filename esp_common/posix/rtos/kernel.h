@@ -62,6 +62,32 @@
         off_t   (* seek)  (int fd, off_t offset, int origin);
         int     (* close) (int fd);
         int     (* ioctl) (int fd, unsigned long int request, va_list vl);
+        /**
+         *  optional: directly access fd's content without copying, eg. flash cache mapped storage
+         *      @returns pointer to the content at offset, *count is limited to contiguous bytes available
+         *          NULL when offset is out of content
+         *      the content must stay in place while the fd is opened, storage which may
+         *          reallocate its content (eg. tmpfs) must not implement this
+         */
+        void const *(* peek)(int fd, off_t offset, size_t *count);
+        /**
+         *  optional: fd's content is resident in memory-mappable flash, see mmap()
+         *      @returns 0 on success with flash physical address of offset stored in *paddr,
+         *          *count is limited to bytes physically contiguous in flash
+         *          an errno on error, eg. ENXIO when offset is out of content
+         */
+        int (* flash_addr)(int fd, off_t offset, uintptr_t *paddr, size_t *count);
+        /**
+         *  optional: write back fd's buffered content to its storage, see fsync()
+         *      @returns 0 on success, -1 and errno is set on error
+         */
+        int (* sync)(int fd);
+        /**
+         *  optional: read / write at offset without using nor changing the fd position, see pread()
+         *      aio executes requests by them, fds without them are accessed by seeking
+         */
+        ssize_t (* pread) (int fd, void *buf, size_t bufsize, off_t offset);
+        ssize_t (* pwrite)(int fd, void const *buf, size_t count, off_t offset);
     };
 
     /// indicate the fd is non-block
@@ -172,6 +198,23 @@ extern __attribute__((nonnull, nothrow))
 extern __attribute__((nonnull, nothrow))
     void KERNEL_handle_recycle(void);
 
+    struct KERNEL_handle_stats
+    {
+        /// handles of static pool and dynamic allocated blocks
+        uint32_t total;
+        /// in use, including released but not yet recycled by idle
+        uint32_t used;
+        uint32_t peak;
+        /// released, waiting for KERNEL_handle_recycle()
+        uint32_t destroying;
+    };
+
+    /**
+     *  KERNEL_handle_stats(): handle pool usage
+     */
+extern __attribute__((nonnull, nothrow))
+    void KERNEL_handle_stats(struct KERNEL_handle_stats *stats);
+
     /**
      *   KERNEL_createfd(): create a file descriptor
      *      @returns
@@ -0,0 +1,60 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_PARTITION_H
+#define __FS_PARTITION_H                1
+
+#include <features.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+    struct BCACHE_device;
+
+__BEGIN_DECLS
+
+    /**
+     *  PARTITION_register()
+     *      register the data partition of label as read-only block node '/dev/label'
+     *      .read() / lseek() access the raw content by esp_partition_read()
+     *      .mmap() maps the content into data bus without copying, eg. assets:
+     *          int fd = open("/dev/assets", O_RDONLY);
+     *          void const *ptr = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      ENOENT: no data partition of label
+     *      ENAMETOOLONG: label exceeds DEVFS_NAME_MAX
+     *      EEXIST: node of label is already registered
+     *      ENOSPC: DEVFS_MAX_NODES was reached
+     */
+extern __attribute__((nonnull, nothrow))
+    int PARTITION_register(char const *label);
+
+    /**
+     *  PARTITION_bcache_device()
+     *      fill dev to access the data partition of label under BCACHE_create()
+     *      .write() erases the range before programming, block_size of cache must be
+     *          a multiple of flash sector size
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      ENOENT: no data partition of label
+     */
+extern __attribute__((nonnull, nothrow))
+    int PARTITION_bcache_device(char const *label, struct BCACHE_device *dev);
+
+__END_DECLS
+#endif
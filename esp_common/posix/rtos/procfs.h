@@ -0,0 +1,104 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_PROCFS_H
+#define __FS_PROCFS_H                   1
+
+#include <features.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <rtos/filesystem.h>
+
+    /// procfs is mounted as '/proc' when filesystem initializing
+    #define PROCFS_DIR                  "proc"
+
+    /// registered files, including the builtin
+    #ifndef PROCFS_MAX_NODES
+        #define PROCFS_MAX_NODES        (16)
+    #endif
+    #define PROCFS_NAME_MAX             (15)
+    /// longest line PROCFS_printf() renders, on stack of the opener
+    #define PROCFS_LINE_MAX             (128)
+    /// first buffer size to render a file into, it grows when the rendering overflows
+    #ifndef PROCFS_RENDER_SIZE
+        #define PROCFS_RENDER_SIZE      (512)
+    #endif
+
+    /**
+     *  rendering buffer of an open()
+     *      bytes beyond bufsize are counted and dropped, the file is rendered again into a larger buffer
+     */
+    struct PROCFS_output
+    {
+        char *buf;
+        size_t bufsize;
+        size_t filled;
+
+        /// bytes rendered so far
+        uintptr_t rendered;
+    };
+
+    /**
+     *  PROCFS_generator_t
+     *      render the whole file by PROCFS_printf() / PROCFS_write() when it is opened
+     *      .it may stop early when PROCFS_full() is true
+     *      .read() / lseek() are served from the rendered text, the file is a snapshot of the open()
+     */
+    typedef void (* PROCFS_generator_t)(struct PROCFS_output *out, void *arg);
+
+__BEGIN_DECLS
+
+    /**
+     *  PROCFS_implement
+     *      read-only files rendered by generators
+     *      .builtin: handles / meminfo / threads / aio / interrupts
+     */
+extern
+    struct FS_implement const PROCFS_implement;
+
+    /**
+     *  PROCFS_register()
+     *      register file '/proc/name' rendered by generator
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EINVAL: name is empty or contains '/'
+     *      ENAMETOOLONG: name exceeds PROCFS_NAME_MAX
+     *      EEXIST: name is already registered
+     *      ENOSPC: PROCFS_MAX_NODES was reached
+     */
+extern __attribute__((nonnull(1, 2), nothrow))
+    int PROCFS_register(char const *name, PROCFS_generator_t generator, void *arg);
+
+    /**
+     *  PROCFS_printf() / PROCFS_write()
+     *      append to the rendering, bytes out of the buffer are counted and dropped
+     *      .PROCFS_printf() truncates a line exceeds PROCFS_LINE_MAX
+     */
+extern __attribute__((nonnull, nothrow, format(printf, 2, 3)))
+    void PROCFS_printf(struct PROCFS_output *out, char const *fmt, ...);
+extern __attribute__((nonnull, nothrow))
+    void PROCFS_write(struct PROCFS_output *out, void const *buf, size_t count);
+
+static inline __attribute__((nonnull, nothrow))
+    bool PROCFS_full(struct PROCFS_output const *out)
+    {
+        return out->filled == out->bufsize;
+    }
+
+__END_DECLS
+#endif
@@ -0,0 +1,84 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_TMPFS_H
+#define __FS_TMPFS_H                    1
+
+#include <features.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <rtos/filesystem.h>
+
+    /// file content is allocated from PSRAM, directory nodes always stay in internal RAM
+    #define TMPFS_FLAG_PSRAM            (1U << 0)
+
+    /// size cap of the root instance when TMPFS_implement is used as FS_root, 0 for unlimited
+    #ifndef TMPFS_ROOT_SIZE_CAP
+        #define TMPFS_ROOT_SIZE_CAP     (0)
+    #endif
+    #ifndef TMPFS_ROOT_FLAGS
+        #define TMPFS_ROOT_FLAGS        (0)
+    #endif
+
+__BEGIN_DECLS
+
+    /**
+     *  TMPFS_implement
+     *      RAM backed filesystem
+     *      .as root: assign &TMPFS_implement to FS_root in FILESYSTEM_init_root(),
+     *          the instance is created on first open by TMPFS_ROOT_SIZE_CAP / TMPFS_ROOT_FLAGS
+     *      .as mount: FILESYSTEM_mount(name, &TMPFS_implement, TMPFS_create(...))
+     */
+extern
+    struct FS_implement const TMPFS_implement;
+
+    /**
+     *  TMPFS_create()
+     *      create a tmpfs instance to pass to FILESYSTEM_mount() as data
+     *  @param size_cap
+     *      maximum bytes of file content, nodes, directory hash tables and the ino table
+     *      the instance may allocate, 0 for unlimited
+     *  @param flags
+     *      TMPFS_FLAG_PSRAM
+     *  @returns
+     *      On success the instance is returned
+     *      On error, NULL is returned, and errno is set to indicate the error
+     *  @errors
+     *      ENOMEM
+     */
+extern __attribute__((nothrow))
+    void *TMPFS_create(size_t size_cap, unsigned flags);
+
+    /**
+     *  TMPFS_destroy()
+     *      release the instance and all its files
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EBUSY: instance still has opened files
+     */
+extern __attribute__((nonnull, nothrow))
+    int TMPFS_destroy(void *tmpfs);
+
+    /**
+     *  TMPFS_usage()
+     *      @returns bytes currently allocated by the instance, *size_cap is optional
+     */
+extern __attribute__((nonnull(1), nothrow))
+    size_t TMPFS_usage(void *tmpfs, size_t *size_cap);
+
+__END_DECLS
+#endif
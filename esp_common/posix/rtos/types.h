@@ -57,7 +57,7 @@
  *  @def: semaphore.h   sem_t
  ***************************************************************************/
     #define SEMA_INITIALIZER(INIT_COUNT, MAX_COUNT) \
-        {.glist_next = 0, .cid = CID_SEMAPHORE, .flags = HDL_FLAG_INITIALIZER, .rsv = {0}, .init_sem{.initial_count = INIT_COUNT, .max_count = MAX_COUNT}}
+        {.glist_next = 0, .cid = CID_SEMAPHORE, .flags = HDL_FLAG_INITIALIZER, .rsv = {0}, .init_sem = {.initial_count = INIT_COUNT, .max_count = MAX_COUNT}}
 
     // sem_t initializer alias
     #define SEMAPHORE_INITIALIZER       SEMA_INITIALIZER
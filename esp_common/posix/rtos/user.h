@@ -94,8 +94,38 @@ extern __attribute__((nothrow, nonnull))
 /***************************************************************************/
 /** @mqueue
 ****************************************************************************/
-    #define MQUEUE_MAX_MSG_SIZE         (1024)
-    #define MQUEUE_MAX_MSG              (128)
+    /// ceilings of mqueue_create() / mqueue_create_np(), MQUEUE_FLAG_VARLEN is limited by its own budget
+    #ifndef MQUEUE_MAX_MSG_SIZE
+        #define MQUEUE_MAX_MSG_SIZE     (1024)
+    #endif
+    #ifndef MQUEUE_MAX_MSG
+        #define MQUEUE_MAX_MSG          (128)
+    #endif
+
+    /**
+     *  lock-free ring of messages, also accepted by mq_attr.mq_flags of mq_open()
+     *      .messages are received in sending order, priority is carried but not sorted
+     *      .msg_count is rounded up to power of 2
+     *      .send / receive only block on full / empty, no lock is taken otherwise
+     */
+    #define MQUEUE_FLAG_RING            (1U << 16)
+    /// ring of single sender and single receiver, no atomic read-modify-write at all
+    #define MQUEUE_FLAG_SPSC            (MQUEUE_FLAG_RING | (1U << 17))
+
+    /**
+     *  variable-length messages in a byte budget, see mqueue_create_varlen_np()
+     *      .also accepted by mq_attr.mq_flags of mq_open(), mq_maxmsg is the byte budget
+     *      .mq_send() / write() sends count bytes up to msg_size, receiving returns the length of message
+     *      .messages are received in sending order, priority is carried but not sorted
+     *      .mq_send_batch() / mq_receive_batch() are not supported
+     */
+    #define MQUEUE_FLAG_VARLEN          (1U << 18)
+    /**
+     *  message may wrap around the end of budget, the longest message can be almost the whole budget
+     *      .priority is not carried, received as 0
+     *      .loaned slot is not supported
+     */
+    #define MQUEUE_FLAG_SPLIT           (MQUEUE_FLAG_VARLEN | (1U << 19))
 
     /**
      *  mqueue_create(): create a mqueue
@@ -108,6 +138,29 @@ extern __attribute__((nothrow, nonnull))
      */
 extern __attribute__((nothrow))
     int mqueue_create(char const *name, uint16_t msg_size, uint16_t msg_count);
+    /**
+     *  mqueue_create_np(): create a mqueue by MQUEUE_FLAG_*
+     *      @errors
+     *          EINVAL: MQUEUE_FLAG_RING with msg_count of 0
+     *          ENOMEM
+     *          EEXIST
+     */
+extern __attribute__((nothrow))
+    int mqueue_create_np(char const *name, uint16_t msg_size, uint16_t msg_count, uint32_t flags);
+    /**
+     *  mqueue_create_varlen_np(): create a MQUEUE_FLAG_VARLEN mqueue, flags is 0 or MQUEUE_FLAG_SPLIT
+     *      .msg_size is the longest message of this mqueue, up to UINT16_MAX
+     *      .bytes is the budget of all queued messages, a message takes its length rounded up to 4,
+     *          plus 8 bytes of header and 4 bytes of priority
+     *      .without MQUEUE_FLAG_SPLIT the longest message must fit in half of the budget
+     *      .loaned slot takes budget of its requested count until it was committed
+     *      @errors
+     *          EINVAL: msg_size / bytes is 0, or the longest message never fits in the budget
+     *          ENOMEM
+     *          EEXIST
+     */
+extern __attribute__((nothrow))
+    int mqueue_create_varlen_np(char const *name, uint32_t msg_size, uint32_t bytes, uint32_t flags);
 
     /**
      *  mqueue_destroy()
@@ -155,5 +208,40 @@ extern __attribute__((nonnull, nothrow))
 extern __attribute__((nonnull, nothrow))
     ssize_t mqueue_timedsend(int mqd, void const *msg, uint32_t timeout, unsigned int prio);
 
+    /**
+     *  mqueue_send_acquire() / mqueue_send_commit()
+     *      zero-copy sending: the slot of count bytes is filled in place, then committed by priority
+     *      .MQUEUE_FLAG_VARLEN takes count bytes of the budget, count is the length received
+     *      .fixed size mqueues always deliver msg_size bytes, count is only checked
+     *      .every acquired slot must be committed, a slot of ring mqueue being filled holds back
+     *          receivers of the slots after it
+     *  @returns
+     *      mqueue_send_acquire() returns pointer to the slot, NULL and errno is set on error
+     *  @errors
+     *      EBADF
+     *      EMSGSIZE: count > msg_size
+     *      EAGAIN: timeout is 0 and mqueue is full
+     *      ETIMEDOUT
+     *      EINVAL: mqueue_send_commit() prio >= MQ_PRIO_MAX, nothing is published and the slot is
+     *          still acquired, commit it again by a valid prio
+     */
+extern __attribute__((nothrow))
+    void *mqueue_send_acquire(int mqd, size_t count, uint32_t timeout);
+extern __attribute__((nonnull, nothrow))
+    int mqueue_send_commit(int mqd, void *payload, unsigned int prio);
+
+    /**
+     *  mqueue_recv_borrow() / mqueue_recv_release()
+     *      zero-copy receiving: the message is read in place, then its slot is released to senders
+     *  @errors
+     *      EBADF
+     *      EAGAIN: timeout is 0 and mqueue is empty
+     *      ETIMEDOUT
+     */
+extern __attribute__((nothrow))
+    void *mqueue_recv_borrow(int mqd, uint32_t timeout, unsigned int *prio);
+extern __attribute__((nonnull, nothrow))
+    int mqueue_recv_release(int mqd, void *payload);
+
 __END_DECLS
 #endif
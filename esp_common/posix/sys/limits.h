@@ -68,6 +68,13 @@
      */
     #define SYMLINK_MAX                 128
 
+/* Runtime Invariant Values */
+    /**
+     *      Maximum number of message priorities supported by the implementation.
+     *  .Minimum Acceptable Value: {_POSIX_MQ_PRIO_MAX}
+     */
+    #define MQ_PRIO_MAX                 32
+
 // include next
 #include <limits.h>
 #endif
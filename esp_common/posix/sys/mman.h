@@ -0,0 +1,72 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __SYS_MMAN_H
+#define __SYS_MMAN_H                    1
+
+#include <features.h>
+#include <sys/types.h>
+
+    /// protection options
+    #define PROT_NONE                   (0x0)
+    #define PROT_READ                   (0x1)
+    #define PROT_WRITE                  (0x2)
+    #define PROT_EXEC                   (0x4)
+
+    /// flag options
+    #define MAP_SHARED                  (0x01)
+    #define MAP_PRIVATE                 (0x02)
+    #define MAP_FIXED                   (0x10)
+
+    #define MAP_FAILED                  ((void *)-1)
+
+__BEGIN_DECLS
+
+    /**
+     *  mmap()
+     *      map pages of memory
+     *  @DESCRIPTION
+     *      The mmap() function shall establish a mapping between an address space of a process and a memory
+     *          object.
+     *      UltraCore only supports read-only mapping of files whose storage is contiguous in flash, the
+     *          returned address is cache mapped by MMU, accessing it costs no RAM.
+     *          .prot: PROT_READ only
+     *          .flags: MAP_SHARED or MAP_PRIVATE, they are equivalent as mapping is read-only
+     *          .addr: is ignored, MAP_FIXED is not supported
+     *      MMU pages are reserved by esp-idf spi_flash_mmap() for each mmap(), and released by munmap()
+     *      raw flash partitions registered by PARTITION_register() are mappable as '/dev/label'
+     *  @RETURN VALUE
+     *      Upon successful completion, the mmap() function shall return the address at which the mapping
+     *          was placed; otherwise, it shall return a value of MAP_FAILED and set errno to indicate the error.
+     *  @ERRORS
+     *      EBADF: The fildes argument is not a valid open file descriptor.
+     *      EINVAL: len is zero, or MAP_FIXED was specified.
+     *      ENODEV: The fildes argument refers to a file whose storage is not mappable, or not contiguous.
+     *      ENOMEM: No MMU pages available to establish the mapping.
+     *      ENOTSUP: prot requests PROT_WRITE or PROT_EXEC.
+     */
+extern __attribute__((nothrow))
+    void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off);
+
+    /**
+     *  munmap()
+     *      unmap pages of memory
+     *  @ERRORS
+     *      EINVAL: addr is not returned by mmap()
+     */
+extern __attribute__((nothrow))
+    int munmap(void *addr, size_t len);
+
+__END_DECLS
+#endif
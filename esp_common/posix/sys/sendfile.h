@@ -0,0 +1,88 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __SYS_SENDFILE_H
+#define __SYS_SENDFILE_H                1
+
+#include <features.h>
+#include <sys/types.h>
+
+    /// internal transfer buffer size of sendfile() / splice()
+    #ifndef SENDFILE_BUFSIZE
+        #define SENDFILE_BUFSIZE        (4096)
+    #endif
+    /// flash mapping window of sendfile() / splice(), one mapping at a time limits MMU pages in use
+    #ifndef SENDFILE_MAP_SIZE
+        #define SENDFILE_MAP_SIZE       (0x10000)
+    #endif
+
+    /// splice() flags
+    #define SPLICE_F_MOVE               (1U << 0)
+    #define SPLICE_F_NONBLOCK           (1U << 1)
+    #define SPLICE_F_MORE               (1U << 2)
+    #define SPLICE_F_GIFT               (1U << 3)
+
+__BEGIN_DECLS
+
+    /**
+     *  sendfile()
+     *      transfer data between file descriptors
+     *  @DESCRIPTION
+     *      sendfile() copies data between one file descriptor and another. because this copying is done
+     *          within the kernel, sendfile() is more efficient than the combination of read(2) and write(2),
+     *          which would require transferring data to and from user space.
+     *      in_fd should be a file descriptor opened for reading and out_fd should be a descriptor opened
+     *          for writing.
+     *      if offset is not NULL, then it points to a variable holding the file offset from which sendfile()
+     *          will start reading data from in_fd. when sendfile() returns, this variable will be set to the
+     *          offset of the byte following the last byte that was read. if offset is not NULL, then
+     *          sendfile() does not modify the file offset of in_fd; otherwise the file offset is adjusted
+     *          to reflect the number of bytes read from in_fd.
+     *      when in_fd implements peek() or its storage is mappable by mmap() (eg. '/dev/label' of
+     *          PARTITION_register()), data is written to out_fd directly from its mapped memory without
+     *          copying, run by run, the rest falls back to the buffered copy.
+     *  @RETURN VALUE
+     *      If the transfer was successful, the number of bytes written to out_fd is returned.
+     *      On error, -1 is returned, and errno is set appropriately.
+     *  @ERRORS
+     *      EBADF: in_fd was not opened for reading or out_fd was not opened for writing.
+     *      EINVAL: offset is not NULL but in_fd is not seekable.
+     *      ENOMEM: insufficient memory to allocate transfer buffer.
+     *      EAGAIN: nonblocking I/O has been selected using O_NONBLOCK and the write would block.
+     */
+extern __attribute__((nothrow))
+    ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
+    /**
+     *  splice()
+     *      splice data to/from a pipe
+     *  @DESCRIPTION
+     *      splice() moves data between two file descriptors without copying between kernel address space
+     *          and user address space. It transfers up to len bytes of data from the file descriptor
+     *          fd_in to the file descriptor fd_out.
+     *      UltraCore does not require one of the fds to refer to a pipe, any pair of FD_implement
+     *          backends can be spliced.
+     *      off_in / off_out: same meaning of offset in sendfile(), NULL for using current fd position.
+     *      flags:
+     *          SPLICE_F_NONBLOCK: do not retry when either end returns EAGAIN.
+     *          SPLICE_F_MOVE / SPLICE_F_MORE / SPLICE_F_GIFT: ignored
+     *  @RETURN VALUE
+     *      Upon successful completion, splice() returns the number of bytes spliced to or from the pipe.
+     *      On error, -1 is returned, and errno is set appropriately.
+     */
+extern __attribute__((nothrow))
+    ssize_t splice(int fd_in, off_t *off_in, int fd_out, off_t *off_out, size_t len, unsigned int flags);
+
+__END_DECLS
+#endif
@@ -491,6 +491,8 @@ extern __attribute__((nothrow))
 
 extern __attribute__((nothrow))
     int pipe(int fildes[2]);
+extern __attribute__((nothrow))
+    int pipe2(int fildes[2], int flags);
 
 extern __attribute__((nothrow))
     int fdatasync(int fildes);
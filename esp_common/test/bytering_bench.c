@@ -0,0 +1,387 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host throughput of bytering against esp-idf ringbuffer, pthread producers against one consumer
+ *
+ *      cc -O2 -no-pie -pthread -I esp_common/test/host -idirafter esp_common/posix \
+ *          esp_common/test/bytering_bench.c esp_common/test/host/kernel.c \
+ *          freertos/esp_ringbuf.c -o bytering_bench && ./bytering_bench
+ *
+ *  every mode moves RECORDS records of RECORD_SIZE bytes per producer, nobody blocks:
+ *      full / empty ring is retried after sched_yield()
+ *  copy:
+ *      bytering_write() / bytering_read()
+ *      xRingbufferSend() / xRingbufferReceiveUpTo() of RINGBUF_TYPE_BYTEBUF
+ *  zero copy:
+ *      bytering_acquire() / bytering_commit(), bytering_peek() / bytering_consume()
+ *      xRingbufferSendAcquire() / xRingbufferSendComplete() of RINGBUF_TYPE_NOSPLIT,
+ *          xRingbufferReceive() / vRingbufferReturnItem()
+ *  copy modes verify the bytes of each producer, zero copy modes also verify record order
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ringbuf.h>
+#include "../bytering.c"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define RING_SIZE                       (1024)
+#define PRODUCERS_MAX                   (4)
+#define RECORDS                         (200000)
+#define RECORD_SIZE                     (8)
+#define RECV_MAX                        (256)
+
+enum bench_mode
+{
+    BYTERING_COPY,
+    RINGBUF_BYTEBUF,
+    BYTERING_ZERO_COPY,
+    RINGBUF_NOSPLIT,
+};
+
+struct producer_t
+{
+    pthread_t thread;
+    unsigned id;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static enum bench_mode mode;
+static unsigned producers_count;
+
+static bytering_t ring;
+static RingbufHandle_t rb;
+static StaticRingbuffer_t rb_static;
+/// NOSPLIT headers are 8 bytes, rounded up to 32bit
+static uint8_t ring_buf[RING_SIZE] __attribute__((aligned(4)));
+
+static struct producer_t producers[PRODUCERS_MAX];
+
+static void record_fill(uint8_t *rec, unsigned id, uint32_t seq)
+{
+    rec[0] = (uint8_t)(id + 1);
+    rec[1] = (uint8_t)seq;
+    rec[2] = (uint8_t)(seq >> 8);
+    rec[3] = (uint8_t)(seq >> 16);
+    rec[4] = (uint8_t)(seq >> 24);
+    rec[5] = (uint8_t)(rec[0] + rec[1] + rec[2] + rec[3] + rec[4]);
+    rec[6] = 0xA5;
+    rec[7] = (uint8_t)~rec[0];
+}
+
+static uint64_t clock_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void *producer_routine(void *arg)
+{
+    struct producer_t *self = arg;
+    uint8_t rec[RECORD_SIZE];
+
+    /// copy modes fill records with one byte per producer, the stream of bytering_write() may be split
+    memset(rec, (int)(self->id + 1), sizeof(rec));
+
+    for (uint32_t seq = 0; seq < RECORDS; seq ++)
+    {
+        switch (mode)
+        {
+        case BYTERING_COPY:
+            for (size_t written = 0; written < RECORD_SIZE; )
+            {
+                size_t count = bytering_write(&ring, rec + written, RECORD_SIZE - written);
+
+                if (0 == count)
+                    sched_yield();
+                written += count;
+            }
+            break;
+
+        case RINGBUF_BYTEBUF:
+            while (pdTRUE != xRingbufferSend(rb, rec, RECORD_SIZE, 0))
+                sched_yield();
+            break;
+
+        case BYTERING_ZERO_COPY:
+            for (;;)
+            {
+                size_t span;
+                uint8_t *ptr = bytering_acquire(&ring, RECORD_SIZE, &span);
+
+                if (! ptr)
+                {
+                    sched_yield();
+                    continue;
+                }
+                /// too short at the end of buffer: pad and retry from the start
+                if (RECORD_SIZE > span)
+                {
+                    memset(ptr, 0, span);
+                    bytering_commit(&ring, span);
+                    continue;
+                }
+
+                record_fill(ptr, self->id, seq);
+                bytering_commit(&ring, span);
+                break;
+            }
+            break;
+
+        case RINGBUF_NOSPLIT:
+            for (;;)
+            {
+                void *ptr;
+
+                if (pdTRUE != xRingbufferSendAcquire(rb, &ptr, RECORD_SIZE, 0))
+                {
+                    sched_yield();
+                    continue;
+                }
+
+                record_fill(ptr, self->id, seq);
+                xRingbufferSendComplete(rb, ptr);
+                break;
+            }
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int record_check(uint8_t const *rec, uint32_t *next_seq)
+{
+    unsigned id = rec[0] - 1U;
+    uint8_t expect[RECORD_SIZE];
+
+    if (producers_count <= id)
+        goto record_corrupted;
+
+    record_fill(expect, id, next_seq[id]);
+    if (0 != memcmp(expect, rec, RECORD_SIZE))
+        goto record_corrupted;
+
+    next_seq[id] ++;
+    return 0;
+
+record_corrupted:
+    fprintf(stderr, "record corrupted or out of order: %02x %02x %02x %02x %02x %02x %02x %02x\n",
+        rec[0], rec[1], rec[2], rec[3], rec[4], rec[5], rec[6], rec[7]);
+    return -1;
+}
+
+static int consume(void)
+{
+    size_t const total = (size_t)producers_count * RECORDS * RECORD_SIZE;
+    size_t received = 0;
+    size_t bytes[PRODUCERS_MAX] = {0};
+    uint32_t next_seq[PRODUCERS_MAX] = {0};
+
+    while (received < total)
+    {
+        uint8_t buf[RECV_MAX];
+        uint8_t const *ptr;
+        size_t count;
+
+        switch (mode)
+        {
+        case BYTERING_COPY:
+            count = bytering_read(&ring, buf, sizeof(buf));
+            if (0 == count)
+            {
+                sched_yield();
+                continue;
+            }
+            for (size_t i = 0; i < count; i ++)
+            {
+                unsigned id = buf[i] - 1U;
+
+                if (producers_count <= id)
+                {
+                    fprintf(stderr, "unexpected byte 0x%02x\n", buf[i]);
+                    return -1;
+                }
+                bytes[id] ++;
+            }
+            received += count;
+            break;
+
+        case RINGBUF_BYTEBUF:
+            ptr = xRingbufferReceiveUpTo(rb, &count, 0, RECV_MAX);
+            if (! ptr)
+            {
+                sched_yield();
+                continue;
+            }
+            for (size_t i = 0; i < count; i ++)
+            {
+                unsigned id = ptr[i] - 1U;
+
+                if (producers_count <= id)
+                {
+                    fprintf(stderr, "unexpected byte 0x%02x\n", ptr[i]);
+                    return -1;
+                }
+                bytes[id] ++;
+            }
+            vRingbufferReturnItem(rb, (void *)ptr);
+            received += count;
+            break;
+
+        case BYTERING_ZERO_COPY:
+            ptr = bytering_peek(&ring, &count);
+            if (! ptr)
+            {
+                sched_yield();
+                continue;
+            }
+            for (size_t i = 0; i < count; )
+            {
+                if (0 == ptr[i])
+                {
+                    i ++;
+                    continue;
+                }
+                /// records were acquired as one contiguous span
+                if (RECORD_SIZE > count - i || 0 != record_check(&ptr[i], next_seq))
+                {
+                    fprintf(stderr, "record split at the end of span\n");
+                    return -1;
+                }
+                i += RECORD_SIZE;
+                received += RECORD_SIZE;
+            }
+            bytering_consume(&ring, count);
+            break;
+
+        case RINGBUF_NOSPLIT:
+            ptr = xRingbufferReceive(rb, &count, 0);
+            if (! ptr)
+            {
+                sched_yield();
+                continue;
+            }
+            if (RECORD_SIZE != count || 0 != record_check(ptr, next_seq))
+                return -1;
+            vRingbufferReturnItem(rb, (void *)ptr);
+            received += RECORD_SIZE;
+            break;
+        }
+    }
+
+    for (unsigned id = 0; id < producers_count; id ++)
+    {
+        if (BYTERING_COPY == mode || RINGBUF_BYTEBUF == mode)
+        {
+            if (RECORDS * RECORD_SIZE != bytes[id])
+            {
+                fprintf(stderr, "producer %u: %zu / %u bytes\n", id, bytes[id], RECORDS * RECORD_SIZE);
+                return -1;
+            }
+        }
+        else if (RECORDS != next_seq[id])
+        {
+            fprintf(stderr, "producer %u: %u / %u records\n", id, next_seq[id], RECORDS);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench(char const *name, enum bench_mode bench_mode, unsigned count)
+{
+    mode = bench_mode;
+    producers_count = count;
+
+    switch (mode)
+    {
+    case BYTERING_COPY:
+    case BYTERING_ZERO_COPY:
+        if (0 != bytering_init(&ring, ring_buf, RING_SIZE))
+        {
+            perror("bytering_init");
+            return -1;
+        }
+        break;
+
+    case RINGBUF_BYTEBUF:
+    case RINGBUF_NOSPLIT:
+        rb = xRingbufferCreateStatic(RING_SIZE, RINGBUF_BYTEBUF == mode ? RINGBUF_TYPE_BYTEBUF : RINGBUF_TYPE_NOSPLIT,
+            ring_buf, &rb_static);
+        if (! rb)
+        {
+            fprintf(stderr, "xRingbufferCreateStatic failed\n");
+            return -1;
+        }
+        break;
+    }
+
+    uint64_t start = clock_ns();
+
+    for (unsigned i = 0; i < producers_count; i ++)
+    {
+        producers[i].id = i;
+        pthread_create(&producers[i].thread, NULL, producer_routine, &producers[i]);
+    }
+
+    /// producers may be spinning on the full ring when consume() failed
+    if (0 != consume())
+    {
+        fprintf(stderr, "%s x%u: failed\n", name, producers_count);
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned i = 0; i < producers_count; i ++)
+        pthread_join(producers[i].thread, NULL);
+
+    uint64_t elapsed = clock_ns() - start;
+    uint64_t records = (uint64_t)producers_count * RECORDS;
+
+    if (RINGBUF_BYTEBUF == mode || RINGBUF_NOSPLIT == mode)
+        vRingbufferDelete(rb);
+
+    printf("%-20s x%u: %10.0f records/s %8.1f MB/s %7.1f ns/record\n", name, producers_count,
+        (double)records * 1e9 / (double)elapsed,
+        (double)(records * RECORD_SIZE) * 1e3 / (double)elapsed,
+        (double)elapsed / (double)records);
+    return 0;
+}
+
+/***************************************************************************/
+/** @main
+****************************************************************************/
+int main(void)
+{
+    unsigned const counts[] = {1, PRODUCERS_MAX};
+
+    for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i ++)
+    {
+        bench("bytering write", BYTERING_COPY, counts[i]);
+        bench("ringbuf bytebuf", RINGBUF_BYTEBUF, counts[i]);
+        bench("bytering acquire", BYTERING_ZERO_COPY, counts[i]);
+        bench("ringbuf nosplit", RINGBUF_NOSPLIT, counts[i]);
+    }
+    return EXIT_SUCCESS;
+}
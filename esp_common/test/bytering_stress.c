@@ -0,0 +1,249 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host stress test of bytering: pthread producers against one consumer
+ *
+ *      cc -O2 -pthread -I esp_common/test/host -idirafter esp_common/posix \
+ *          esp_common/test/bytering_stress.c -o bytering_stress && ./bytering_stress
+ *
+ *  bytes in the ring:
+ *      0x00                pad of an acquired span too short for a record
+ *      0x80 | id           runs written by bytering_write(), partial writes are allowed, counted by producer
+ *      id + 1              begins a record of RECORD_SIZE bytes acquired as one contiguous span:
+ *                          [id + 1] [seq: 4 LE] [sum of previous 5] [0xA5] [~(id + 1)]
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../bytering.c"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define RING_SIZE                       (1024)
+#define PRODUCERS                       (4)
+#define RECORDS                         (200000)
+#define RECORD_SIZE                     (8)
+#define RUN_MAX                         (13)
+
+struct producer_t
+{
+    pthread_t thread;
+    unsigned id;
+    uint32_t seed;
+    /// bytes of 0x80 | id written
+    size_t run_bytes;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static bytering_t ring;
+static uint8_t ring_buf[RING_SIZE];
+static struct producer_t producers[PRODUCERS];
+static unsigned producers_done = 0;
+
+static uint32_t rand_next(uint32_t *seed)
+{
+    *seed = *seed * 1103515245U + 12345U;
+    return *seed >> 16;
+}
+
+static void record_fill(uint8_t *rec, unsigned id, uint32_t seq)
+{
+    rec[0] = (uint8_t)(id + 1);
+    rec[1] = (uint8_t)seq;
+    rec[2] = (uint8_t)(seq >> 8);
+    rec[3] = (uint8_t)(seq >> 16);
+    rec[4] = (uint8_t)(seq >> 24);
+    rec[5] = (uint8_t)(rec[0] + rec[1] + rec[2] + rec[3] + rec[4]);
+    rec[6] = 0xA5;
+    rec[7] = (uint8_t)~rec[0];
+}
+
+static void *producer_routine(void *arg)
+{
+    struct producer_t *self = arg;
+    uint8_t run[RUN_MAX];
+
+    memset(run, 0x80 | self->id, sizeof(run));
+
+    for (uint32_t seq = 0; seq < RECORDS; )
+    {
+        if (0 == rand_next(&self->seed) % 3)
+        {
+            size_t len = 1 + rand_next(&self->seed) % RUN_MAX;
+            self->run_bytes += bytering_write(&ring, run, len);
+        }
+
+        size_t span;
+        uint8_t *ptr = bytering_acquire(&ring, RECORD_SIZE, &span);
+
+        if (NULL == ptr)
+        {
+            sched_yield();
+            continue;
+        }
+        if (RECORD_SIZE > span)
+        {
+            /// end of buffer or the ring is nearly full
+            memset(ptr, 0, span);
+            bytering_commit(&ring, span);
+            continue;
+        }
+
+        record_fill(ptr, self->id, seq ++);
+        bytering_commit(&ring, span);
+    }
+
+    __atomic_add_fetch(&producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int consume(void)
+{
+    uint32_t next_seq[PRODUCERS] = {0};
+    size_t run_bytes[PRODUCERS] = {0};
+    uint8_t rec[RECORD_SIZE];
+    size_t rec_len = 0;
+    uint32_t rounds = 0;
+
+    while (true)
+    {
+        bool done = PRODUCERS == __atomic_load_n(&producers_done, __ATOMIC_ACQUIRE);
+        size_t count;
+        uint8_t const *ptr = bytering_peek(&ring, &count);
+
+        if (NULL == ptr)
+        {
+            if (done)
+                break;
+
+            sched_yield();
+            continue;
+        }
+
+        /// also exercise bytering_read() with a short buffer
+        uint8_t tmp[5];
+        if (0 == ++ rounds % 7)
+        {
+            count = bytering_read(&ring, tmp, sizeof(tmp));
+            ptr = tmp;
+        }
+
+        for (size_t i = 0; i < count; i ++)
+        {
+            uint8_t ch = ptr[i];
+
+            if (0 != rec_len)
+            {
+                rec[rec_len ++] = ch;
+                if (RECORD_SIZE != rec_len)
+                    continue;
+
+                unsigned id = rec[0] - 1U;
+                uint32_t seq = rec[1] | (uint32_t)rec[2] << 8 | (uint32_t)rec[3] << 16 | (uint32_t)rec[4] << 24;
+                uint8_t expect[RECORD_SIZE];
+
+                record_fill(expect, id, next_seq[id]);
+                if (0 != memcmp(expect, rec, RECORD_SIZE))
+                {
+                    fprintf(stderr, "producer %u: record %u is corrupted or out of order, expected %u\n",
+                        id, seq, next_seq[id]);
+                    return -1;
+                }
+                next_seq[id] ++;
+                rec_len = 0;
+            }
+            else if (0 == ch)
+                continue;
+            else if (0x80 & ch)
+            {
+                if (PRODUCERS <= (ch & 0x7F))
+                {
+                    fprintf(stderr, "unexpected byte 0x%02x\n", ch);
+                    return -1;
+                }
+                run_bytes[ch & 0x7F] ++;
+            }
+            else if (PRODUCERS >= ch)
+                rec[rec_len ++] = ch;
+            else
+            {
+                fprintf(stderr, "unexpected byte 0x%02x\n", ch);
+                return -1;
+            }
+        }
+
+        if (ptr != tmp)
+            bytering_consume(&ring, count);
+    }
+
+    if (0 != rec_len)
+    {
+        fprintf(stderr, "truncated record at the end\n");
+        return -1;
+    }
+    for (unsigned id = 0; id < PRODUCERS; id ++)
+    {
+        if (RECORDS != next_seq[id] || producers[id].run_bytes != run_bytes[id])
+        {
+            fprintf(stderr, "producer %u: %u / %u records, %zu / %zu run bytes\n",
+                id, next_seq[id], RECORDS, run_bytes[id], producers[id].run_bytes);
+            return -1;
+        }
+    }
+    if (ring.head != ring.ready || ring.ready != ring.committed || ring.committed != ring.reserve)
+    {
+        fprintf(stderr, "positions mismatched: head %u ready %u committed %u reserve %u\n",
+            ring.head, ring.ready, ring.committed, ring.reserve);
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************/
+/** @main
+****************************************************************************/
+int main(void)
+{
+    if (0 != bytering_init(&ring, ring_buf, RING_SIZE))
+    {
+        perror("bytering_init");
+        return EXIT_FAILURE;
+    }
+    /// free running positions also wrap around 2^32
+    ring.head = ring.reserve = ring.committed = ring.ready = (uint32_t)-(RING_SIZE * 3 + 5);
+
+    for (unsigned i = 0; i < PRODUCERS; i ++)
+    {
+        producers[i].id = i;
+        producers[i].seed = 0x9E3779B9U * (i + 1);
+        pthread_create(&producers[i].thread, NULL, producer_routine, &producers[i]);
+    }
+
+    /// producers may be spinning on the full ring when consume() failed
+    if (0 != consume())
+        return EXIT_FAILURE;
+
+    for (unsigned i = 0; i < PRODUCERS; i ++)
+        pthread_join(producers[i].thread, NULL);
+
+    printf("bytering: %u producers x %u records passed\n", PRODUCERS, RECORDS);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_ESP_HEAP_CAPS_H
+#define __HOST_ESP_HEAP_CAPS_H          1
+
+#include <stdlib.h>
+
+/// host build of esp_common sources: one heap without capabilities
+    #define MALLOC_CAP_8BIT             (1U << 2)
+    #define MALLOC_CAP_SPIRAM           (1U << 10)
+    #define MALLOC_CAP_INTERNAL         (1U << 11)
+
+    #define heap_caps_malloc(size, caps)        ((void)(caps), malloc(size))
+    #define heap_caps_realloc(ptr, size, caps)  ((void)(caps), realloc(ptr, size))
+    #define heap_caps_free(ptr)         free(ptr)
+
+#endif
@@ -0,0 +1,61 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_FREERTOS_H
+#define __HOST_FREERTOS_H               1
+
+#include <assert.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <xtensa/spinlock.h>
+
+/**
+ *  host build of freertos users, eg. esp_ringbuf.c: types and critical sections over pthreads
+ *      .a tick is a millisecond
+ *      .critical sections are the host spinlock, nothing is blocked inside them
+ */
+    typedef long                    BaseType_t;
+    typedef unsigned long           UBaseType_t;
+    typedef uint32_t                TickType_t;
+
+    #define pdFALSE                     ((BaseType_t)0)
+    #define pdTRUE                      ((BaseType_t)1)
+    #define pdPASS                      (pdTRUE)
+    #define pdFAIL                      (pdFALSE)
+
+    #define portMAX_DELAY               ((TickType_t)0xFFFFFFFFUL)
+    #define portTICK_PERIOD_MS          ((TickType_t)1)
+
+    #define configASSERT(x)             assert(x)
+    #define configSUPPORT_STATIC_ALLOCATION     (1)
+
+    typedef spinlock_t              portMUX_TYPE;
+    #define portMUX_INITIALIZE(mux)     spinlock_init(mux)
+    #define portENTER_CRITICAL(mux)     spin_lock(mux)
+    #define portEXIT_CRITICAL(mux)      spin_unlock(mux)
+    #define portENTER_CRITICAL_ISR(mux) spin_lock(mux)
+    #define portEXIT_CRITICAL_ISR(mux)  spin_unlock(mux)
+    /// called inside critical sections, waiting tasks are polling instead
+    #define portYIELD_WITHIN_API()      ((void)0)
+
+    /// no task is ever placed on event lists, see list.h
+    typedef struct
+    {
+        UBaseType_t dummy;
+    } List_t;
+    typedef List_t                  StaticList_t;
+
+#endif
@@ -0,0 +1,37 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_FREERTOS_QUEUE_H
+#define __HOST_FREERTOS_QUEUE_H         1
+
+#include "FreeRTOS.h"
+
+/// host build of freertos users: queue sets are not supported
+    typedef void *                  QueueHandle_t;
+    typedef void *                  QueueSetHandle_t;
+    typedef void *                  QueueSetMemberHandle_t;
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, void const *item, TickType_t ticks_to_wait)
+{
+    (void)queue, (void)item, (void)ticks_to_wait;
+    return pdFAIL;
+}
+
+static inline BaseType_t xQueueSendFromISR(QueueHandle_t queue, void const *item, BaseType_t *woken)
+{
+    (void)queue, (void)item, (void)woken;
+    return pdFAIL;
+}
+
+#endif
@@ -0,0 +1,72 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_FREERTOS_TASK_H
+#define __HOST_FREERTOS_TASK_H          1
+
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "list.h"
+
+/**
+ *  host build of freertos users: blocking is polling until timeout
+ *      .vTaskPlaceOnEventList() only returns, the caller leaves its critical section and retries
+ */
+    typedef struct
+    {
+        TickType_t entry;
+    } TimeOut_t;
+
+static inline TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+static inline void vTaskInternalSetTimeOutState(TimeOut_t *timeout)
+{
+    timeout->entry = xTaskGetTickCount();
+}
+
+static inline BaseType_t xTaskCheckForTimeOut(TimeOut_t *timeout, TickType_t *ticks_to_wait)
+{
+    if (portMAX_DELAY == *ticks_to_wait)
+        return pdFALSE;
+
+    TickType_t elapsed = xTaskGetTickCount() - timeout->entry;
+    if (elapsed >= *ticks_to_wait)
+    {
+        *ticks_to_wait = 0;
+        return pdTRUE;
+    }
+
+    *ticks_to_wait -= elapsed;
+    timeout->entry += elapsed;
+    return pdFALSE;
+}
+
+static inline void vTaskPlaceOnEventList(List_t *list, TickType_t ticks_to_wait)
+{
+    (void)list, (void)ticks_to_wait;
+}
+
+static inline BaseType_t xTaskRemoveFromEventList(List_t *list)
+{
+    (void)list;
+    return pdFALSE;
+}
+
+#endif
@@ -0,0 +1,335 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host build of esp_common sources: kernel services over pthreads
+ *
+ *      fds are int of struct KERNEL_fd address as on target, link tests by -no-pie
+ *          so the static fd pool stays addressable by 32 bits
+ */
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rtos/kernel.h>
+#include <rtos/procfs.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define HOST_MAX_FDS                    (256)
+
+/// pthread_mutex_t is stored in the padding of struct KERNEL_hdl
+_Static_assert(sizeof(pthread_mutex_t) <= sizeof(((mutex_t *)0)->padding), "mutex_t");
+#define AsPthreadMutex(mutex)           ((pthread_mutex_t *)(mutex)->padding)
+
+/// counting semaphore of pthreads is stored in the padding of struct KERNEL_hdl
+struct HOST_sema
+{
+    pthread_mutex_t lock;
+    pthread_cond_t posted;
+    unsigned count;
+    unsigned max;
+};
+_Static_assert(sizeof(struct HOST_sema) <= sizeof(((sem_t *)0)->padding), "sem_t");
+#define AsHostSema(sema)                ((struct HOST_sema *)(sema)->padding)
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static pthread_mutex_t HOST_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct KERNEL_fd HOST_fds[HOST_MAX_FDS];
+
+/***************************************************************************/
+/** @implements kernel.h
+****************************************************************************/
+int KERNEL_createfd(uint16_t const TAG, struct FD_implement const *implement, void *ext)
+{
+    struct KERNEL_fd *fd = NULL;
+
+    pthread_mutex_lock(&HOST_lock);
+    for (unsigned i = 0; i < HOST_MAX_FDS; i ++)
+    {
+        if (CID_FREED == HOST_fds[i].cid)
+        {
+            fd = &HOST_fds[i];
+            memset(fd, 0, sizeof(*fd));
+            fd->cid = CID_FD;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&HOST_lock);
+
+    if (! fd)
+        return __set_errno_neg(EMFILE);
+
+    assert((uintptr_t)fd == (uintptr_t)(int)(intptr_t)fd);
+    fd->tag = TAG;
+    fd->implement = implement;
+    fd->ext = ext;
+    return (int)(intptr_t)fd;
+}
+
+int KERNEL_handle_release(handle_t hdl)
+{
+    int retval = 0;
+
+    if (CID_FD != AsKernelHdl(hdl)->cid)
+        return EBADF;
+    if (AsFD(hdl)->implement->close && 0 != AsFD(hdl)->implement->close((int)(intptr_t)hdl))
+        retval = errno;
+
+    pthread_mutex_lock(&HOST_lock);
+    AsKernelHdl(hdl)->cid = CID_FREED;
+    pthread_mutex_unlock(&HOST_lock);
+    return retval;
+}
+
+void *KERNEL_malloc(uint32_t size)
+{
+    return malloc(size);
+}
+
+void *KERNEL_mallocz(uint32_t size)
+{
+    return calloc(1, size);
+}
+
+void KERNEL_mfree(void *ptr)
+{
+    free(ptr);
+}
+
+/***************************************************************************/
+/** @implements sys/mutex.h
+****************************************************************************/
+int mutex_init(mutex_t *mutex, int flags)
+{
+    pthread_mutexattr_t attr;
+
+    pthread_mutexattr_init(&attr);
+    if (MUTEX_FLAG_RECURSIVE & flags)
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+    mutex->cid = CID_MUTEX;
+    mutex->flags = (uint8_t)flags;
+    pthread_mutex_init(AsPthreadMutex(mutex), &attr);
+
+    pthread_mutexattr_destroy(&attr);
+    return 0;
+}
+
+mutex_t *mutex_create(int flags)
+{
+    mutex_t *mutex = calloc(1, sizeof(mutex_t));
+
+    if (! mutex)
+        return __set_errno_nullptr(ENOMEM);
+
+    mutex_init(mutex, flags);
+    return mutex;
+}
+
+int mutex_destroy(mutex_t *mutex)
+{
+    pthread_mutex_destroy(AsPthreadMutex(mutex));
+    free(mutex);
+    return 0;
+}
+
+int mutex_lock(mutex_t *mutex)
+{
+    /// MUTEX_INITIALIZER is initialized on first use
+    if (HDL_FLAG_INITIALIZER & __atomic_load_n(&mutex->flags, __ATOMIC_ACQUIRE))
+    {
+        pthread_mutex_lock(&HOST_lock);
+        if (HDL_FLAG_INITIALIZER & mutex->flags)
+            mutex_init(mutex, mutex->flags & ~HDL_FLAG_INITIALIZER);
+        pthread_mutex_unlock(&HOST_lock);
+    }
+    return pthread_mutex_lock(AsPthreadMutex(mutex));
+}
+
+int mutex_unlock(mutex_t *mutex)
+{
+    return pthread_mutex_unlock(AsPthreadMutex(mutex));
+}
+
+/***************************************************************************/
+/** @implements semaphore.h
+****************************************************************************/
+static void HOST_sema_init(sem_t *sema, unsigned value, unsigned max)
+{
+    struct HOST_sema *hs = AsHostSema(sema);
+
+    pthread_mutex_init(&hs->lock, NULL);
+    pthread_cond_init(&hs->posted, NULL);
+    hs->count = value;
+    hs->max = max;
+
+    sema->cid = CID_SEMAPHORE;
+    __atomic_store_n(&sema->flags, 0, __ATOMIC_RELEASE);
+}
+
+static struct HOST_sema *HOST_sema(sem_t *sema)
+{
+    /// SEMA_INITIALIZER is initialized on first use
+    if (HDL_FLAG_INITIALIZER & __atomic_load_n(&sema->flags, __ATOMIC_ACQUIRE))
+    {
+        pthread_mutex_lock(&HOST_lock);
+        if (HDL_FLAG_INITIALIZER & sema->flags)
+            HOST_sema_init(sema, sema->init_sem.initial_count, sema->init_sem.max_count);
+        pthread_mutex_unlock(&HOST_lock);
+    }
+    return AsHostSema(sema);
+}
+
+int sem_init(sem_t *sema, int pshared, unsigned int value)
+{
+    return sem_init_np(sema, pshared, value, SEM_VALUE_MAX);
+}
+
+int sem_init_np(sem_t *sema, int pshared, unsigned int value, unsigned int max)
+{
+    if (pshared)
+        return __set_errno_neg(ENOSYS);
+
+    HOST_sema_init(sema, value, max);
+    return 0;
+}
+
+int sem_destroy(sem_t *sema)
+{
+    pthread_cond_destroy(&AsHostSema(sema)->posted);
+    pthread_mutex_destroy(&AsHostSema(sema)->lock);
+    sema->cid = CID_FREED;
+    return 0;
+}
+
+int sem_wait(sem_t *sema)
+{
+    return sem_timedwait_ms(sema, WAIT_FOREVER);
+}
+
+int sem_timedwait_ms(sem_t *sema, unsigned int millisecond)
+{
+    struct HOST_sema *hs = HOST_sema(sema);
+    struct timespec ts;
+    int err = 0;
+
+    if (WAIT_FOREVER != millisecond)
+    {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += millisecond / 1000;
+        ts.tv_nsec += (long)(millisecond % 1000) * 1000000;
+        if (1000000000 <= ts.tv_nsec)
+        {
+            ts.tv_sec ++;
+            ts.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&hs->lock);
+    while (0 == hs->count && 0 == err)
+    {
+        if (WAIT_FOREVER == millisecond)
+            pthread_cond_wait(&hs->posted, &hs->lock);
+        else
+            err = pthread_cond_timedwait(&hs->posted, &hs->lock, &ts);
+    }
+    if (0 != hs->count)
+    {
+        hs->count --;
+        err = 0;
+    }
+    pthread_mutex_unlock(&hs->lock);
+
+    if (0 != err)
+        return __set_errno_neg(ETIMEDOUT);
+    else
+        return 0;
+}
+
+int sem_post(sem_t *sema)
+{
+    struct HOST_sema *hs = HOST_sema(sema);
+    int retval = 0;
+
+    pthread_mutex_lock(&hs->lock);
+    if (hs->count < hs->max)
+    {
+        hs->count ++;
+        pthread_cond_signal(&hs->posted);
+    }
+    else
+        retval = __set_errno_neg(EOVERFLOW);
+    pthread_mutex_unlock(&hs->lock);
+
+    return retval;
+}
+
+int sem_getvalue(sem_t *restrict sema, int *restrict val)
+{
+    struct HOST_sema *hs = HOST_sema(sema);
+
+    pthread_mutex_lock(&hs->lock);
+    *val = (int)hs->count;
+    pthread_mutex_unlock(&hs->lock);
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements rtos/user.h unistd.h
+****************************************************************************/
+thread_id_t thread_create(void *(*start_rountine)(void *arg), void *arg, uint8_t priority,
+    uint32_t *stack, size_t stack_size)
+{
+    ARG_UNUSED(priority, stack, stack_size);
+    pthread_t thread;
+
+    if (0 != pthread_create(&thread, NULL, start_rountine, arg))
+        return __set_errno_nullptr(EAGAIN);
+
+    pthread_detach(thread);
+    return (thread_id_t)thread;
+}
+
+int msleep(uint32_t msec)
+{
+    struct timespec ts = {.tv_sec = msec / 1000, .tv_nsec = (long)(msec % 1000) * 1000000};
+    return nanosleep(&ts, NULL);
+}
+
+/***************************************************************************/
+/** @implements rtos/procfs.h: there is no /proc on host, nodes are never rendered
+****************************************************************************/
+int PROCFS_register(char const *name, PROCFS_generator_t generator, void *arg)
+{
+    ARG_UNUSED(name, generator, arg);
+    return 0;
+}
+
+void PROCFS_printf(struct PROCFS_output *out, char const *fmt, ...)
+{
+    ARG_UNUSED(out, fmt);
+}
+
+void PROCFS_write(struct PROCFS_output *out, void const *buf, size_t count)
+{
+    ARG_UNUSED(out, buf, count);
+}
@@ -0,0 +1,23 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_SEMAPHORE_H
+#define __HOST_SEMAPHORE_H              1
+
+#include <time.h>
+
+/// host build of esp_common sources: sem_t of posix/semaphore.h instead of glibc, implemented by kernel.c
+#include "../../posix/semaphore.h"
+
+#endif
@@ -0,0 +1,66 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __HOST_XTENSA_SPINLOCK_H
+#define __HOST_XTENSA_SPINLOCK_H        1
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/// host build of esp_common sources: recursive spinlock of threads instead of cores
+    struct xt_spinlock_t
+    {
+        pthread_t owner;
+        bool volatile owned;
+        unsigned lock_count;
+    };
+    typedef struct xt_spinlock_t    spinlock_t;
+
+    #define SPINLOCK_INITIALIZER        {.owned = false, .lock_count = 0}
+
+static inline void spinlock_init(spinlock_t *lock)
+{
+    lock->owner = (pthread_t)0;
+    lock->owned = false;
+    lock->lock_count = 0;
+}
+
+static inline void spin_lock(spinlock_t *lock)
+{
+    /// owner is cleared before unlocking, a stale owner never matches this thread
+    if (__atomic_load_n(&lock->owned, __ATOMIC_ACQUIRE) &&
+        pthread_equal(__atomic_load_n(&lock->owner, __ATOMIC_RELAXED), pthread_self()))
+    {
+        lock->lock_count ++;
+        return;
+    }
+    while (__atomic_exchange_n(&lock->owned, true, __ATOMIC_ACQUIRE))
+    {
+        while (__atomic_load_n(&lock->owned, __ATOMIC_RELAXED))
+            sched_yield();
+    }
+    __atomic_store_n(&lock->owner, pthread_self(), __ATOMIC_RELAXED);
+    lock->lock_count = 1;
+}
+
+static inline void spin_unlock(spinlock_t *lock)
+{
+    if (0 == -- lock->lock_count)
+    {
+        __atomic_store_n(&lock->owner, (pthread_t)0, __ATOMIC_RELAXED);
+        __atomic_store_n(&lock->owned, false, __ATOMIC_RELEASE);
+    }
+}
+
+#endif
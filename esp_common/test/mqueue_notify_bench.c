@@ -0,0 +1,225 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host latency benchmark of mq_notify(): mqueue_send() into the empty mqueue until the notified side runs
+ *
+ *      cc -O2 -no-pie -pthread -I esp_common/test/host -idirafter esp_common/posix \
+ *          esp_common/test/mqueue_notify_bench.c esp_common/test/host/kernel.c esp_common/glist.c \
+ *          freertos/esp_ringbuf.c \
+ *          -o mqueue_notify_bench && ./mqueue_notify_bench
+ *
+ *  .SIGEV_SEMAPHORE_NP: a thread waits on the semaphore posted by the sender
+ *  .SIGEV_THREAD: sigev_notify_function() called by the shared notification worker
+ *  .overflow: the worker is held in a callback while more mqueues than MQUEUE_NOTIFY_PENDING notify,
+ *      every notification is either queued or counted as overflow
+ *  .numbers are of host threads, they are relative between modes not absolute for the target
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../esp_system/posix/mqueue.c"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define MSG_SIZE                        (16)
+#define MSG_COUNT                       (4)
+#define ROUNDS                          (20000)
+#define OVERFLOW_MQUEUES                (MQUEUE_NOTIFY_PENDING + 8)
+
+#define CHECK(expr)                     \
+    do {                                \
+        if (! (expr))                   \
+        {                               \
+            fprintf(stderr, "%s:%d: %s failed, errno %d\n", __FILE__, __LINE__, #expr, errno); \
+            exit(EXIT_FAILURE);         \
+        }                               \
+    } while (0)
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int mqd;
+static struct sigevent sev;
+/// posted by the notified side after it took the message and registered again
+static sem_t ready;
+static sem_t notified;
+
+static uint64_t sent_ns;
+static uint32_t latency_ns[ROUNDS];
+
+static sem_t gate;
+static uint32_t gate_calls;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u32(void const *a, void const *b)
+{
+    uint32_t x = *(uint32_t const *)a, y = *(uint32_t const *)b;
+    return x < y ? -1 : x > y;
+}
+
+/// the notified side: record latency, drain the message and register again
+static void notified_round(unsigned round)
+{
+    uint8_t msg[MSG_SIZE];
+
+    latency_ns[round] = (uint32_t)(now_ns() - __atomic_load_n(&sent_ns, __ATOMIC_ACQUIRE));
+    CHECK(MSG_SIZE == mqueue_timedrecv(mqd, msg, 0, NULL));
+    CHECK(0 == mq_notify(mqd, &sev));
+    sem_post(&ready);
+}
+
+static void *sema_waiter(void *arg)
+{
+    ARG_UNUSED(arg);
+
+    for (unsigned round = 0; round < ROUNDS; round ++)
+    {
+        sem_wait(&notified);
+        notified_round(round);
+    }
+    return NULL;
+}
+
+static void thread_notification(union sigval value)
+{
+    /// rounds are serialized by ready
+    static unsigned round = 0;
+
+    ARG_UNUSED(value);
+    notified_round(round ++);
+}
+
+static void gate_notification(union sigval value)
+{
+    ARG_UNUSED(value);
+
+    if (1 == __atomic_add_fetch(&gate_calls, 1, __ATOMIC_SEQ_CST))
+        sem_wait(&gate);
+}
+
+static void report(char const *name)
+{
+    qsort(latency_ns, ROUNDS, sizeof(latency_ns[0]), cmp_u32);
+
+    uint64_t sum = 0;
+    for (unsigned i = 0; i < ROUNDS; i ++)
+        sum += latency_ns[i];
+
+    printf("%-12s %10.1f %10.1f %10.1f %10.1f\n", name,
+        latency_ns[0] / 1e3, (double)sum / ROUNDS / 1e3,
+        latency_ns[ROUNDS * 99 / 100] / 1e3, latency_ns[ROUNDS - 1] / 1e3);
+}
+
+static void run_rounds(void)
+{
+    uint8_t msg[MSG_SIZE] = {0};
+
+    CHECK(0 == mq_notify(mqd, &sev));
+    for (unsigned round = 0; round < ROUNDS; round ++)
+    {
+        __atomic_store_n(&sent_ns, now_ns(), __ATOMIC_RELEASE);
+        CHECK(MSG_SIZE == mqueue_send(mqd, msg, 0));
+        sem_wait(&ready);
+    }
+    CHECK(0 == mq_notify(mqd, NULL));
+}
+
+static void bench_semaphore(void)
+{
+    pthread_t waiter;
+
+    sev.sigev_notify = SIGEV_SEMAPHORE_NP;
+    sev.sigev_value.sival_ptr = &notified;
+
+    CHECK(0 == pthread_create(&waiter, NULL, sema_waiter, NULL));
+    run_rounds();
+    pthread_join(waiter, NULL);
+
+    report("semaphore");
+}
+
+static void bench_thread(void)
+{
+    sev.sigev_notify = SIGEV_THREAD;
+    sev.sigev_notify_function = thread_notification;
+    sev.sigev_value.sival_ptr = NULL;
+
+    run_rounds();
+    report("thread");
+}
+
+static void overflow(void)
+{
+    static int mqds[OVERFLOW_MQUEUES];
+    static char names[OVERFLOW_MQUEUES][16];
+    uint8_t msg[MSG_SIZE] = {0};
+
+    struct sigevent gate_sev =
+    {
+        .sigev_notify = SIGEV_THREAD,
+        .sigev_notify_function = gate_notification,
+    };
+    uint32_t queued = MQ_notifier.queued;
+    uint32_t overflows = MQ_notifier.overflows;
+
+    for (unsigned i = 0; i < OVERFLOW_MQUEUES; i ++)
+    {
+        snprintf(names[i], sizeof(names[i]), "overflow%u", i);
+        CHECK(-1 != (mqds[i] = mqueue_create(names[i], MSG_SIZE, MSG_COUNT)));
+        CHECK(0 == mq_notify(mqds[i], &gate_sev));
+    }
+    /// the first notification holds the worker, the rest fill the pending ring
+    for (unsigned i = 0; i < OVERFLOW_MQUEUES; i ++)
+        CHECK(MSG_SIZE == mqueue_send(mqds[i], msg, 0));
+
+    queued = MQ_notifier.queued - queued;
+    overflows = MQ_notifier.overflows - overflows;
+    sem_post(&gate);
+
+    CHECK(OVERFLOW_MQUEUES == queued + overflows);
+    CHECK(OVERFLOW_MQUEUES - MQUEUE_NOTIFY_PENDING - 1 <= overflows);
+    printf("overflow: %u mqueues, %u queued, %u overflows\n", OVERFLOW_MQUEUES, queued, overflows);
+
+    for (unsigned i = 0; i < OVERFLOW_MQUEUES; i ++)
+        CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)mqds[i]));
+}
+
+/***************************************************************************/
+/** @main
+****************************************************************************/
+int main(void)
+{
+    sem_init(&ready, 0, 0);
+    sem_init(&notified, 0, 0);
+    sem_init(&gate, 0, 0);
+
+    CHECK(-1 != (mqd = mqueue_create("notify", MSG_SIZE, MSG_COUNT)));
+
+    printf("%-12s %10s %10s %10s %10s\n", "us", "min", "avg", "p99", "max");
+    bench_semaphore();
+    bench_thread();
+
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)mqd));
+    overflow();
+    return EXIT_SUCCESS;
+}
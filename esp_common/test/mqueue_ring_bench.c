@@ -0,0 +1,205 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host throughput benchmark of mqueue: MQUEUE_FLAG_RING / MQUEUE_FLAG_SPSC against the priority queue
+ *
+ *      cc -O2 -no-pie -pthread -I esp_common/test/host -idirafter esp_common/posix \
+ *          esp_common/test/mqueue_ring_bench.c esp_common/test/host/kernel.c esp_common/glist.c \
+ *          freertos/esp_ringbuf.c \
+ *          -o mqueue_ring_bench && ./mqueue_ring_bench
+ *
+ *  every mode moves the same messages by mqueue_send() / mqueue_recv() of blocking fds:
+ *      [producer id] [seq: 4] [payload...], receiver checks seq of each producer is in sending order
+ *  .ring modes are also checked to ignore priority: a prio 31 message never overtakes prio 0
+ *  .mqueue_send_commit() of an invalid prio is checked to publish nothing
+ *  .numbers are of host threads, they are relative between modes not absolute for the target
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../esp_system/posix/mqueue.c"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define MSG_SIZE                        (32)
+#define MSG_COUNT                       (64)
+#define MESSAGES                        (400000)
+#define PRODUCERS_MAX                   (4)
+
+#define CHECK(expr)                     \
+    do {                                \
+        if (! (expr))                   \
+        {                               \
+            fprintf(stderr, "%s:%d: %s failed, errno %d\n", __FILE__, __LINE__, #expr, errno); \
+            exit(EXIT_FAILURE);         \
+        }                               \
+    } while (0)
+
+struct producer_t
+{
+    pthread_t thread;
+    int mqd;
+    uint8_t id;
+    uint32_t count;
+};
+
+struct mode_t
+{
+    char const *name;
+    uint32_t flags;
+    unsigned producers;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static struct mode_t const modes[] =
+{
+    {.name = "prio",        .flags = 0,                 .producers = 1},
+    {.name = "ring",        .flags = MQUEUE_FLAG_RING,  .producers = 1},
+    {.name = "spsc",        .flags = MQUEUE_FLAG_SPSC,  .producers = 1},
+    {.name = "prio x4",     .flags = 0,                 .producers = PRODUCERS_MAX},
+    {.name = "ring x4",     .flags = MQUEUE_FLAG_RING,  .producers = PRODUCERS_MAX},
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *producer_routine(void *arg)
+{
+    struct producer_t *self = arg;
+    uint8_t msg[MSG_SIZE] = {0};
+
+    msg[0] = self->id;
+    for (uint32_t seq = 0; seq < self->count; seq ++)
+    {
+        memcpy(&msg[1], &seq, sizeof(seq));
+        CHECK(MSG_SIZE == mqueue_send(self->mqd, msg, seq % MQ_PRIO_MAX));
+    }
+    return NULL;
+}
+
+static void ring_ignores_prio(uint32_t flags)
+{
+    int mqd = mqueue_create_np("prio_order", MSG_SIZE, MSG_COUNT, flags);
+    uint8_t msg[MSG_SIZE] = {0};
+    unsigned prio;
+
+    CHECK(-1 != mqd);
+
+    msg[0] = 0;
+    CHECK(MSG_SIZE == mqueue_send(mqd, msg, 0));
+    msg[0] = 1;
+    CHECK(MSG_SIZE == mqueue_send(mqd, msg, MQ_PRIO_MAX - 1));
+
+    /// priority is carried but not sorted
+    CHECK(MSG_SIZE == mqueue_recv(mqd, msg, &prio) && 0 == msg[0] && 0 == prio);
+    CHECK(MSG_SIZE == mqueue_recv(mqd, msg, &prio) && 1 == msg[0] && MQ_PRIO_MAX - 1 == prio);
+
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)mqd));
+}
+
+/// an invalid prio of commit publishes nothing, the slot is committed again
+static void commit_rejects_prio(uint32_t flags)
+{
+    int mqd = mqueue_create_np("commit_prio", MSG_SIZE, MSG_COUNT, flags);
+    uint8_t msg[MSG_SIZE];
+    unsigned prio;
+
+    CHECK(-1 != mqd);
+    CHECK(NULL == mqueue_send_acquire(mqd, MSG_SIZE + 1, 0) && EMSGSIZE == errno);
+
+    uint8_t *payload = mqueue_send_acquire(mqd, MSG_SIZE, 0);
+    CHECK(NULL != payload);
+    memset(payload, 0x5A, MSG_SIZE);
+
+    CHECK(-1 == mqueue_send_commit(mqd, payload, MQ_PRIO_MAX) && EINVAL == errno);
+    CHECK(-1 == mqueue_timedrecv(mqd, msg, 0, NULL) && EAGAIN == errno);
+    CHECK(0 == mqueue_send_commit(mqd, payload, 1));
+
+    CHECK(MSG_SIZE == mqueue_recv(mqd, msg, &prio) && 0x5A == msg[MSG_SIZE - 1] && 1 == prio);
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)mqd));
+}
+
+static double run(struct mode_t const *mode)
+{
+    struct producer_t producers[PRODUCERS_MAX];
+    uint32_t next_seq[PRODUCERS_MAX] = {0};
+    uint32_t per_producer = MESSAGES / mode->producers;
+    uint8_t msg[MSG_SIZE];
+
+    int mqd = mqueue_create_np(mode->name, MSG_SIZE, MSG_COUNT, mode->flags);
+    CHECK(-1 != mqd);
+
+    double start = now_sec();
+
+    for (unsigned i = 0; i < mode->producers; i ++)
+    {
+        producers[i].mqd = mqd;
+        producers[i].id = (uint8_t)i;
+        producers[i].count = per_producer;
+        CHECK(0 == pthread_create(&producers[i].thread, NULL, producer_routine, &producers[i]));
+    }
+
+    for (uint32_t received = 0; received < per_producer * mode->producers; received ++)
+    {
+        uint32_t seq;
+
+        CHECK(MSG_SIZE == mqueue_recv(mqd, msg, NULL));
+        CHECK(msg[0] < mode->producers);
+
+        memcpy(&seq, &msg[1], sizeof(seq));
+        /// the priority queue sorts by prio, only ring modes keep sending order
+        if (MQUEUE_FLAG_RING & mode->flags)
+            CHECK(next_seq[msg[0]] == seq);
+        next_seq[msg[0]] ++;
+    }
+
+    double elapsed = now_sec() - start;
+
+    for (unsigned i = 0; i < mode->producers; i ++)
+        pthread_join(producers[i].thread, NULL);
+
+    CHECK(0 == mqueue_queued(mqd));
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)mqd));
+    return elapsed;
+}
+
+/***************************************************************************/
+/** @main
+****************************************************************************/
+int main(void)
+{
+    ring_ignores_prio(MQUEUE_FLAG_RING);
+    ring_ignores_prio(MQUEUE_FLAG_SPSC);
+    commit_rejects_prio(0);
+    commit_rejects_prio(MQUEUE_FLAG_RING);
+
+    printf("%-10s %12s %12s\n", "mode", "msgs/s", "ns/msg");
+    for (unsigned i = 0; i < lengthof(modes); i ++)
+    {
+        double elapsed = run(&modes[i]);
+        uint32_t moved = MESSAGES / modes[i].producers * modes[i].producers;
+
+        printf("%-10s %12.0f %12.1f\n", modes[i].name, moved / elapsed, elapsed * 1e9 / moved);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+/**
+ *  host test of tmpfs: FS_implement hooks and fds against the host kernel
+ *
+ *      cc -O2 -no-pie -pthread -I esp_common/test/host -idirafter esp_common/posix \
+ *          esp_common/test/tmpfs_test.c esp_common/test/host/kernel.c -o tmpfs_test && ./tmpfs_test
+ */
+#include <stdio.h>
+
+#include "../../esp_system/posix/tmpfs.c"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define FILES                           (100)
+#define SIZE_CAP                        (8192)
+
+#define CHECK(expr)                         do {                                        if (! (expr))                           {                                           fprintf(stderr, "%s:%d: %s failed, errno %d\n", __FILE__, __LINE__, #expr, errno);             exit(EXIT_FAILURE);                 }                                   } while (0)
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static struct fsio_t fsios[FILES + 1];
+
+static int file_create(void *tmpfs, struct fsio_t *fsio, char const *name)
+{
+    memset(fsio, 0, sizeof(*fsio));
+    fsio->data = tmpfs;
+    fsio->flags = O_RDWR | O_CREAT;
+    fsio->ino_entry = fsio->ino_working = INO_CURRENT_DIR;
+
+    return TMPFS_implement.create(fsio, name, S_IRUSR | S_IWUSR);
+}
+
+static int file_unlink(void *tmpfs, char const *name)
+{
+    struct fsio_t dir = {.data = tmpfs, .ino_entry = INO_CURRENT_DIR};
+    uint8_t ent_buf[DIRENT_SIZE(NAME_MAX + 1)];
+    struct dirent *ent = (struct dirent *)ent_buf;
+
+    if (0 != TMPFS_implement.lookup(&dir, name, strlen(name), ent))
+        return -1;
+    return TMPFS_implement.unlink(&dir, ent->d_ino);
+}
+
+/// the ino table grows past TMPFS_INO_TABLE_INC, content survives the growth
+static void test_ino_table(void)
+{
+    void *tmpfs = TMPFS_create(0, 0);
+    char name[16];
+    int fds[FILES];
+
+    CHECK(NULL != tmpfs);
+
+    for (unsigned i = 0; i < FILES; i ++)
+    {
+        snprintf(name, sizeof(name), "file%u", i);
+        fds[i] = file_create(tmpfs, &fsios[i], name);
+        CHECK(-1 != fds[i]);
+        CHECK((ssize_t)sizeof(i) == TMPFS_fsio.write(fds[i], &i, sizeof(i)));
+    }
+    CHECK(FILES < ((struct TMPFS *)tmpfs)->inode_count);
+
+    /// ino of the freed node is reused
+    snprintf(name, sizeof(name), "file%u", FILES / 2);
+    ino_t ino = fsios[FILES / 2].ino_entry;
+    CHECK(0 == file_unlink(tmpfs, name));
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fds[FILES / 2]));
+    fds[FILES / 2] = file_create(tmpfs, &fsios[FILES / 2], "reused");
+    CHECK(-1 != fds[FILES / 2] && ino == fsios[FILES / 2].ino_entry);
+    CHECK((ssize_t)sizeof(unsigned) == TMPFS_fsio.write(fds[FILES / 2], &(unsigned){FILES / 2}, sizeof(unsigned)));
+
+    /// instance is busy while files are opened
+    CHECK(-1 == TMPFS_destroy(tmpfs) && EBUSY == errno);
+
+    for (unsigned i = 0; i < FILES; i ++)
+    {
+        unsigned val = ~i;
+
+        CHECK(0 == TMPFS_fsio.seek(fds[i], 0, SEEK_SET));
+        CHECK((ssize_t)sizeof(val) == TMPFS_fsio.read(fds[i], &val, sizeof(val)) && i == val);
+        CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fds[i]));
+    }
+    CHECK(0 == TMPFS_destroy(tmpfs));
+}
+
+/// every allocation including the ino table is counted, size_cap is never exceeded
+static void test_size_cap(void)
+{
+    void *tmpfs = TMPFS_create(SIZE_CAP, 0);
+    size_t size_cap;
+    char name[16];
+    unsigned count = 0;
+
+    CHECK(NULL != tmpfs);
+
+    /// root node and the first ino table
+    size_t initial = TMPFS_usage(tmpfs, &size_cap);
+    CHECK(SIZE_CAP == size_cap);
+    CHECK(sizeof(struct TMPFS_node) + 1 + TMPFS_INO_TABLE_INC * sizeof(struct TMPFS_node *) == initial);
+
+    while (true)
+    {
+        snprintf(name, sizeof(name), "f%u", count);
+        int fd = file_create(tmpfs, &fsios[0], name);
+
+        if (-1 == fd)
+        {
+            CHECK(ENOSPC == errno);
+            break;
+        }
+        CHECK(TMPFS_usage(tmpfs, NULL) <= SIZE_CAP);
+        CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fd));
+        count ++;
+    }
+    CHECK(TMPFS_INO_TABLE_INC < count);
+
+    /// content is limited by the rest
+    for (unsigned i = 0; i < count; i ++)
+    {
+        snprintf(name, sizeof(name), "f%u", i);
+        CHECK(0 == file_unlink(tmpfs, name));
+    }
+    int fd = file_create(tmpfs, &fsios[0], "content");
+    CHECK(-1 != fd);
+    CHECK(-1 == TMPFS_implement.truncate(&fsios[0], SIZE_CAP) && ENOSPC == errno);
+    CHECK(0 == TMPFS_implement.truncate(&fsios[0], TMPFS_BLOCK_SIZE));
+    CHECK(TMPFS_usage(tmpfs, NULL) <= SIZE_CAP);
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fd));
+    CHECK(0 == file_unlink(tmpfs, "content"));
+
+    /// the grown ino table and root's hash buckets stay allocated, the rest is returned
+    struct TMPFS *inst = tmpfs;
+    CHECK(sizeof(struct TMPFS_node) + 1 + (inst->inode_count + inst->inodes[0]->dir.bucket_count) *
+        sizeof(struct TMPFS_node *) == TMPFS_usage(tmpfs, NULL));
+    CHECK(0 == TMPFS_destroy(tmpfs));
+}
+
+/// an unlinked file is readable until its last close
+static void test_unlink_opened(void)
+{
+    void *tmpfs = TMPFS_create(0, 0);
+    char buf[8];
+
+    CHECK(NULL != tmpfs);
+
+    int fd = file_create(tmpfs, &fsios[0], "opened");
+    CHECK(-1 != fd);
+    CHECK(5 == TMPFS_fsio.write(fd, "hello", 5));
+    CHECK(0 == file_unlink(tmpfs, "opened"));
+    CHECK(-1 == file_unlink(tmpfs, "opened") && ENOENT == errno);
+
+    CHECK(0 == TMPFS_fsio.seek(fd, 0, SEEK_SET));
+    CHECK(5 == TMPFS_fsio.read(fd, buf, sizeof(buf)) && 0 == memcmp(buf, "hello", 5));
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fd));
+
+    CHECK(sizeof(struct TMPFS_node) + 1 + TMPFS_INO_TABLE_INC * sizeof(struct TMPFS_node *) +
+        TMPFS_HASH_BUCKETS * sizeof(struct TMPFS_node *) == TMPFS_usage(tmpfs, NULL));
+    CHECK(0 == TMPFS_destroy(tmpfs));
+}
+
+/// positional io leaves the fd position alone
+static void test_positional(void)
+{
+    void *tmpfs = TMPFS_create(0, 0);
+    char buf[8];
+
+    CHECK(NULL != tmpfs);
+
+    int fd = file_create(tmpfs, &fsios[0], "positional");
+    CHECK(-1 != fd);
+    CHECK(5 == TMPFS_fsio.write(fd, "hello", 5));
+    CHECK(5 == TMPFS_fsio.pwrite(fd, "world", 5, 8));
+    CHECK(5 == AsFD(fd)->position && 13 == fsios[0].size);
+
+    CHECK(5 == TMPFS_fsio.pread(fd, buf, sizeof(buf), 8) && 0 == memcmp(buf, "world", 5));
+    CHECK(0 == TMPFS_fsio.pread(fd, buf, sizeof(buf), 13));
+    CHECK(5 == AsFD(fd)->position);
+
+    /// the gap is zero filled
+    CHECK(3 == TMPFS_fsio.read(fd, buf, 3) && 0 == memcmp(buf, "\0\0\0", 3));
+    CHECK(0 == KERNEL_handle_release((handle_t)(intptr_t)fd));
+    CHECK(0 == file_unlink(tmpfs, "positional"));
+    CHECK(0 == TMPFS_destroy(tmpfs));
+}
+
+/***************************************************************************/
+/** @main
+****************************************************************************/
+int main(void)
+{
+    test_ino_table();
+    test_size_cap();
+    test_unlink_opened();
+    test_positional();
+
+    printf("tmpfs: passed\n");
+    return EXIT_SUCCESS;
+}
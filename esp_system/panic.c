@@ -73,6 +73,9 @@ static void print_abort_details(void const *f)
 // already been done, and panic_info_t has been filled.
 void esp_panic_handler(panic_info_t *info)
 {
+    // console output buffered before panic
+    UART_console_panic();
+
     // If the exception was due to an abort, override some of the panic info
     if (g_panic_abort) {
         info->description = NULL;
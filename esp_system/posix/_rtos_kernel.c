@@ -14,8 +14,17 @@ struct KERNEL_context_t
 
     glist_t hdl_freed_list;
     glist_t hdl_destroying_list;
+
+    /// handle pool counters, modified with lock
+    uint32_t hdl_total;
+    uint32_t hdl_used;
+    uint32_t hdl_peak;
 };
 static struct KERNEL_context_t KERNEL_context = {0};
+
+/// @weak reference, filesystem.c releases fsio and the parent directories of fd
+extern __attribute__((weak, nothrow))
+    void FILESYSTEM_fd_cleanup(int fd);
 static struct KERNEL_hdl statical_hdl[(4096 - sizeof(struct KERNEL_context_t))  / sizeof(struct KERNEL_hdl)] = {0};
 
 /***************************************************************************/
@@ -31,6 +40,8 @@ void KERNEL_init(void)
 
     for (unsigned I = 0; I < lengthof(statical_hdl); I++)
         glist_push_back(&KERNEL_context.hdl_freed_list, &statical_hdl[I]);
+
+    KERNEL_context.hdl_total = lengthof(statical_hdl);
 }
 
 /***************************************************************************/
@@ -54,6 +65,7 @@ handle_t KERNEL_handle_get(uint8_t cid)
                 glist_push_back(&KERNEL_context.hdl_freed_list, &blocks[I]);
 
             ptr = &blocks[0];
+            KERNEL_context.hdl_total += DYNAMIC_INC_DESCRIPTORS;
         }
         else
         {
@@ -61,6 +73,8 @@ handle_t KERNEL_handle_get(uint8_t cid)
             ptr = NULL;
         }
     }
+    if (ptr && ++ KERNEL_context.hdl_used > KERNEL_context.hdl_peak)
+        KERNEL_context.hdl_peak = KERNEL_context.hdl_used;
     spin_unlock(&KERNEL_context.lock);
 
     if (ptr)
@@ -76,6 +90,7 @@ handle_t KERNEL_handle_get(uint8_t cid)
 int KERNEL_handle_release(handle_t hdr)
 {
     int retval = 0;
+    bool release = false;
 
     switch (AsKernelHdl(hdr)->cid)
     {
@@ -83,38 +98,34 @@ int KERNEL_handle_release(handle_t hdr)
         break;
 
     case CID_FD:
-        if (AsFD(hdr)->implement->close)
-            retval = AsFD(hdr)->implement->close((int)hdr);
+        if (AsFD(hdr)->implement->close && 0 != AsFD(hdr)->implement->close((int)hdr))
+            retval = errno;
 
-        if (0 == retval)
-        {
-            /// @filesystem has ext cleanup to do
-            /*
-            if (NULL != AsFD(hdr)->fs)
-                FILESYSTEM_fd_cleanup((int)hdr);
-            */
+        /// POSIX: the fd is released even when close() reports an error, eg. EIO of writing back
+        release = true;
+
+        /// @filesystem has ext cleanup to do, fs is only set when filesystem.c was linked
+        if (NULL != AsFD(hdr)->fs)
+            FILESYSTEM_fd_cleanup((int)hdr);
 
-            spin_lock(&KERNEL_context.lock);
+        spin_lock(&KERNEL_context.lock);
+        {
+            /// preparing @recycle read_rdy hdr
+            ///     .not need to free it when ready_rdy is created by INITIALIZER
+            if ((INVALID_HANDLE != AsFD(hdr)->read_rdy))
             {
-                /// preparing @recycle read_rdy hdr
-                ///     .not need to free it when ready_rdy is created by INITIALIZER
-                if ((INVALID_HANDLE != AsFD(hdr)->read_rdy))
-                {
-                    AsKernelHdl(AsFD(hdr)->read_rdy)->flags |= HDL_FLAG_DESTROYING;
-                    glist_push_back(&KERNEL_context.hdl_destroying_list, AsFD(hdr)->read_rdy);
-                }
-                /// preparing @recycle write_rdy hdr
-                ///     .not need to free it when write_rdy is created by INITIALIZER
-                if ((INVALID_HANDLE != AsFD(hdr)->write_rdy))
-                {
-                    AsKernelHdl(AsFD(hdr)->write_rdy)->flags |= HDL_FLAG_DESTROYING;
-                    glist_push_back(&KERNEL_context.hdl_destroying_list, AsFD(hdr)->write_rdy);
-                }
+                AsKernelHdl(AsFD(hdr)->read_rdy)->flags |= HDL_FLAG_DESTROYING;
+                glist_push_back(&KERNEL_context.hdl_destroying_list, AsFD(hdr)->read_rdy);
+            }
+            /// preparing @recycle write_rdy hdr
+            ///     .not need to free it when write_rdy is created by INITIALIZER
+            if ((INVALID_HANDLE != AsFD(hdr)->write_rdy))
+            {
+                AsKernelHdl(AsFD(hdr)->write_rdy)->flags |= HDL_FLAG_DESTROYING;
+                glist_push_back(&KERNEL_context.hdl_destroying_list, AsFD(hdr)->write_rdy);
             }
-            spin_unlock(&KERNEL_context.lock);
         }
-        else
-            retval = errno;
+        spin_unlock(&KERNEL_context.lock);
         break;
 
     default:
@@ -126,7 +137,7 @@ int KERNEL_handle_release(handle_t hdr)
         break;
     }
 
-    if (0 == retval)
+    if (0 == retval || release)
     {
         spin_lock(&KERNEL_context.lock);
         {
@@ -150,12 +161,32 @@ void KERNEL_handle_recycle(void)
             hdl->cid = CID_FREED;
 
             if (HDL_FLAG_SYSMEM_MANAGED & hdl->flags)
+            {
                 glist_push_back(&KERNEL_context.hdl_freed_list, hdl);
+                KERNEL_context.hdl_used --;
+            }
         }
         spin_unlock(&KERNEL_context.lock);
     }
 }
 
+void KERNEL_handle_stats(struct KERNEL_handle_stats *stats)
+{
+    spin_lock(&KERNEL_context.lock);
+    stats->total = KERNEL_context.hdl_total;
+    stats->used = KERNEL_context.hdl_used;
+    stats->peak = KERNEL_context.hdl_peak;
+
+    stats->destroying = 0;
+    for (glist_iter_t iter = glist_iter_begin(&KERNEL_context.hdl_destroying_list);
+        iter != glist_iter_end(&KERNEL_context.hdl_destroying_list);
+        iter = glist_iter_next(&KERNEL_context.hdl_destroying_list, iter))
+    {
+        stats->destroying ++;
+    }
+    spin_unlock(&KERNEL_context.lock);
+}
+
 int KERNEL_createfd(uint16_t const TAG, struct FD_implement const *implement, void *ext)
 {
     struct KERNEL_fd *fd = KERNEL_handle_get(CID_FD);
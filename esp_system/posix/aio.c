@@ -0,0 +1,603 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <string.h>
+#include <sys/errno.h>
+#include <semaphore.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <esp_timer.h>
+
+/// @implements headers
+#include <aio.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define AIO_DEFAULT_QUEUE_DEPTH         (8)
+
+#ifndef O_DSYNC
+    #define O_DSYNC                     O_SYNC
+#endif
+
+/// private opcode of aio_fsync()
+#define AIO_OP_FSYNC                    (-1)
+
+/// sigev_notify of zero initialized struct sigevent
+#define AIO_SIGEV_NONE(notify)          (0 == (notify) || SIGEV_NONE == (notify))
+
+struct AIO_worker
+{
+    /// filesystem instance or device context of fd, NULL when worker is idle
+    void const *device;
+    thread_id_t thread;
+    sem_t queued;
+
+    struct aiocb *head;
+    struct aiocb *tail;
+    uint16_t depth;
+    struct aiocb *running;
+};
+
+struct AIO_waiter
+{
+    bool waiting;
+    sem_t completed;
+};
+
+struct AIO_context
+{
+    bool initialized;
+    struct aioinit init;
+
+    struct AIO_worker workers[AIO_MAX_DEVICES];
+    struct AIO_waiter waiters[AIO_MAX_SUSPEND];
+
+    struct aio_stats stats;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int AIO_submit(struct aiocb *aiocbp, int opcode);
+static void AIO_initialize(void);
+static void const *AIO_device(int fd);
+static struct AIO_worker *AIO_worker_get(void const *device, bool start);
+static void *AIO_worker_routine(void *arg);
+static ssize_t AIO_execute(struct aiocb *aiocbp);
+static void AIO_complete(struct aiocb *aiocbp, ssize_t retval, int err);
+static void AIO_wakeup(void);
+static void AIO_notify(struct sigevent const *sev);
+
+/// @variable
+static mutex_t AIO_lock = MUTEX_INITIALIZER;
+static struct AIO_context AIO_context = {0};
+
+/***************************************************************************/
+/** @implements aio.h
+****************************************************************************/
+void aio_init(struct aioinit const *init)
+{
+    mutex_lock(&AIO_lock);
+    AIO_initialize();
+
+    if (0 < init->aio_threads)
+        AIO_context.init.aio_threads = AIO_MAX_DEVICES < init->aio_threads ? AIO_MAX_DEVICES : init->aio_threads;
+    if (0 < init->aio_num)
+        AIO_context.init.aio_num = UINT16_MAX < init->aio_num ? UINT16_MAX : init->aio_num;
+    if (0 < init->aio_priority)
+        AIO_context.init.aio_priority = init->aio_priority;
+    if (THREAD_MINIMAL_STACK_SIZE <= init->aio_stack_size)
+        AIO_context.init.aio_stack_size = init->aio_stack_size;
+
+    mutex_unlock(&AIO_lock);
+}
+
+int aio_read(struct aiocb *aiocbp)
+{
+    return AIO_submit(aiocbp, LIO_READ);
+}
+
+int aio_write(struct aiocb *aiocbp)
+{
+    return AIO_submit(aiocbp, LIO_WRITE);
+}
+
+int aio_fsync(int op, struct aiocb *aiocbp)
+{
+    if (O_SYNC != op && O_DSYNC != op)
+        return __set_errno_neg(EINVAL);
+    else
+        return AIO_submit(aiocbp, AIO_OP_FSYNC);
+}
+
+int aio_error(struct aiocb const *aiocbp)
+{
+    mutex_lock(&AIO_lock);
+    int err = aiocbp->__error;
+    mutex_unlock(&AIO_lock);
+
+    return err;
+}
+
+ssize_t aio_return(struct aiocb *aiocbp)
+{
+    mutex_lock(&AIO_lock);
+    int err = aiocbp->__error;
+    ssize_t retval = aiocbp->__return;
+    mutex_unlock(&AIO_lock);
+
+    if (EINPROGRESS == err)
+        return __set_errno_neg(EINVAL);
+
+    if (0 != err)
+        errno = err;
+    return retval;
+}
+
+int aio_suspend(struct aiocb const * const list[], int nent, struct timespec const *timeout)
+{
+    int64_t deadline = 0;
+    if (timeout)
+        deadline = esp_timer_get_time() + (int64_t)timeout->tv_sec * 1000000 + timeout->tv_nsec / 1000;
+
+    mutex_lock(&AIO_lock);
+    AIO_initialize();
+
+    struct AIO_waiter *waiter = NULL;
+    for (unsigned i = 0; i < lengthof(AIO_context.waiters); i ++)
+    {
+        if (! AIO_context.waiters[i].waiting)
+        {
+            waiter = &AIO_context.waiters[i];
+            break;
+        }
+    }
+    if (! waiter)
+    {
+        mutex_unlock(&AIO_lock);
+        return __set_errno_neg(EAGAIN);
+    }
+
+    waiter->waiting = true;
+    /// drain the wakeup left by previous waiter
+    sem_trywait(&waiter->completed);
+
+    int err = 0;
+    while (true)
+    {
+        bool completed = false;
+        for (int i = 0; i < nent; i ++)
+        {
+            if (list[i] && EINPROGRESS != list[i]->__error)
+            {
+                completed = true;
+                break;
+            }
+        }
+        if (completed)
+            break;
+
+        mutex_unlock(&AIO_lock);
+        if (! timeout)
+            sem_wait(&waiter->completed);
+        else
+        {
+            int64_t remain = deadline - esp_timer_get_time();
+
+            if (0 >= remain)
+                err = EAGAIN;
+            else
+                sem_timedwait_ms(&waiter->completed, (unsigned)((remain + 999) / 1000));
+        }
+        mutex_lock(&AIO_lock);
+
+        if (0 != err)
+            break;
+    }
+
+    waiter->waiting = false;
+    mutex_unlock(&AIO_lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return 0;
+}
+
+int aio_cancel(int fd, struct aiocb *aiocbp)
+{
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+    if (aiocbp && fd != aiocbp->aio_fildes)
+        return __set_errno_neg(EINVAL);
+
+    struct aiocb *cancelled = NULL;
+    int retval = AIO_ALLDONE;
+
+    mutex_lock(&AIO_lock);
+    struct AIO_worker *worker = AIO_worker_get(AIO_device(fd), false);
+
+    if (worker)
+    {
+        struct aiocb **pp = &worker->head;
+        struct aiocb *prev = NULL;
+
+        while (*pp)
+        {
+            struct aiocb *iter = *pp;
+
+            if (fd == iter->aio_fildes && (! aiocbp || aiocbp == iter))
+            {
+                *pp = iter->__next;
+                if (worker->tail == iter)
+                    worker->tail = prev;
+                worker->depth --;
+
+                iter->__next = cancelled;
+                cancelled = iter;
+                retval = AIO_CANCELED;
+            }
+            else
+            {
+                prev = iter;
+                pp = &iter->__next;
+            }
+        }
+
+        struct aiocb *running = worker->running;
+        if (running && fd == running->aio_fildes && (! aiocbp || aiocbp == running))
+            retval = AIO_NOTCANCELED;
+    }
+    mutex_unlock(&AIO_lock);
+
+    /// worker wakes by sem with nothing queued, see AIO_worker_routine()
+    while (cancelled)
+    {
+        struct aiocb *iter = cancelled;
+        cancelled = iter->__next;
+
+        mutex_lock(&AIO_lock);
+        AIO_context.stats.cancelled ++;
+        mutex_unlock(&AIO_lock);
+
+        AIO_complete(iter, -1, ECANCELED);
+    }
+    return retval;
+}
+
+int lio_listio(int mode, struct aiocb * const list[], int nent, struct sigevent *sevp)
+{
+    if ((LIO_WAIT != mode && LIO_NOWAIT != mode) || AIO_LISTIO_MAX < nent)
+        return __set_errno_neg(EINVAL);
+    if (sevp && ! AIO_SIGEV_NONE(sevp->sigev_notify))
+        return __set_errno_neg(EINVAL);
+
+    bool failed = false;
+
+    for (int i = 0; i < nent; i ++)
+    {
+        struct aiocb *aiocbp = list[i];
+        int retval;
+
+        if (! aiocbp || LIO_NOP == aiocbp->aio_lio_opcode)
+            continue;
+        else if (LIO_READ == aiocbp->aio_lio_opcode)
+            retval = aio_read(aiocbp);
+        else if (LIO_WRITE == aiocbp->aio_lio_opcode)
+            retval = aio_write(aiocbp);
+        else
+            retval = __set_errno_neg(EINVAL);
+
+        if (0 != retval)
+        {
+            aiocbp->__error = errno;
+            aiocbp->__return = -1;
+            failed = true;
+        }
+    }
+
+    if (LIO_WAIT == mode)
+    {
+        for (int i = 0; i < nent; i ++)
+        {
+            struct aiocb const *wait[1] = {list[i]};
+
+            if (! wait[0] || LIO_NOP == wait[0]->aio_lio_opcode)
+                continue;
+
+            while (EINPROGRESS == aio_error(wait[0]))
+            {
+                /// all waiter slots are in use
+                if (0 != aio_suspend(wait, 1, NULL))
+                    msleep(1);
+            }
+
+            if (0 != aio_error(wait[0]))
+                failed = true;
+        }
+    }
+
+    if (failed)
+        return __set_errno_neg(EIO);
+    else
+        return 0;
+}
+
+void aio_stats_np(struct aio_stats *stats, bool reset)
+{
+    mutex_lock(&AIO_lock);
+    *stats = AIO_context.stats;
+
+    if (reset)
+        memset(&AIO_context.stats, 0, sizeof(AIO_context.stats));
+    mutex_unlock(&AIO_lock);
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static int AIO_submit(struct aiocb *aiocbp, int opcode)
+{
+    int fd = aiocbp->aio_fildes;
+
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+
+    if (! AIO_SIGEV_NONE(aiocbp->aio_sigevent.sigev_notify) &&
+        (SIGEV_THREAD != aiocbp->aio_sigevent.sigev_notify || ! aiocbp->aio_sigevent.sigev_notify_function))
+    {
+        return __set_errno_neg(EINVAL);
+    }
+
+    void const *device = AIO_device(fd);
+    int err = 0;
+
+    mutex_lock(&AIO_lock);
+    AIO_initialize();
+
+    struct AIO_worker *worker = AIO_worker_get(device, true);
+    if (! worker)
+        err = EAGAIN;
+    else if (AIO_context.init.aio_num <= worker->depth)
+    {
+        AIO_context.stats.queue_full ++;
+        err = EAGAIN;
+    }
+    else
+    {
+        aiocbp->__next = NULL;
+        aiocbp->__opcode = opcode;
+        aiocbp->__error = EINPROGRESS;
+        aiocbp->__return = -1;
+        aiocbp->__submit_us = esp_timer_get_time();
+
+        if (worker->tail)
+            worker->tail->__next = aiocbp;
+        else
+            worker->head = aiocbp;
+        worker->tail = aiocbp;
+
+        worker->depth ++;
+        if (AIO_context.stats.max_depth < worker->depth)
+            AIO_context.stats.max_depth = worker->depth;
+        AIO_context.stats.submitted ++;
+
+        sem_post(&worker->queued);
+    }
+    mutex_unlock(&AIO_lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return 0;
+}
+
+static void AIO_initialize(void)
+{
+    if (AIO_context.initialized)
+        return;
+
+    AIO_context.init.aio_threads = AIO_MAX_DEVICES;
+    AIO_context.init.aio_num = AIO_DEFAULT_QUEUE_DEPTH;
+    AIO_context.init.aio_priority = THREAD_DEFAULT_PRIORITY;
+    AIO_context.init.aio_stack_size = THREAD_DEFAULT_STACK_SIZE;
+
+    for (unsigned i = 0; i < lengthof(AIO_context.workers); i ++)
+        sem_init(&AIO_context.workers[i].queued, 0, 0);
+    for (unsigned i = 0; i < lengthof(AIO_context.waiters); i ++)
+        sem_init_np(&AIO_context.waiters[i].completed, 0, 0, 1);
+
+    AIO_context.initialized = true;
+}
+
+static void const *AIO_device(int fd)
+{
+    struct KERNEL_fd *kfd = AsFD(fd);
+
+    /// files of the same filesystem instance share one flash, they are serialized anyway
+    if (kfd->fs && kfd->fsio && ((struct fsio_t *)kfd->fsio)->data)
+        return ((struct fsio_t *)kfd->fsio)->data;
+    else if (kfd->fs)
+        return kfd->fs;
+    /// drivers share one implement for all ports, ext is the context of port
+    else if (kfd->ext)
+        return kfd->ext;
+    else
+        return kfd->implement;
+}
+
+static struct AIO_worker *AIO_worker_get(void const *device, bool start)
+{
+    struct AIO_worker *worker = NULL;
+
+    for (int i = 0; i < AIO_context.init.aio_threads; i ++)
+    {
+        if (device == AIO_context.workers[i].device)
+            return &AIO_context.workers[i];
+
+        /// prefer idle worker already started
+        if (! AIO_context.workers[i].device &&
+            (! worker || (! worker->thread && AIO_context.workers[i].thread)))
+        {
+            worker = &AIO_context.workers[i];
+        }
+    }
+
+    if (worker && start)
+    {
+        /// the thread is kept, the worker is bound to device until its queue was drained
+        if (! worker->thread)
+        {
+            worker->thread = thread_create(AIO_worker_routine, worker, (uint8_t)AIO_context.init.aio_priority,
+                NULL, (size_t)AIO_context.init.aio_stack_size);
+        }
+        if (worker->thread)
+            worker->device = device;
+        else
+            worker = NULL;
+    }
+    else
+        worker = NULL;
+
+    return worker;
+}
+
+static void *AIO_worker_routine(void *arg)
+{
+    struct AIO_worker *worker = arg;
+
+    while (true)
+    {
+        sem_wait(&worker->queued);
+
+        mutex_lock(&AIO_lock);
+        struct aiocb *aiocbp = worker->head;
+
+        if (aiocbp)
+        {
+            worker->head = aiocbp->__next;
+            if (! worker->head)
+                worker->tail = NULL;
+            worker->depth --;
+        }
+        /// requests were cancelled
+        else
+            worker->device = NULL;
+        worker->running = aiocbp;
+        mutex_unlock(&AIO_lock);
+
+        if (! aiocbp)
+            continue;
+
+        ssize_t retval = AIO_execute(aiocbp);
+        int err = 0 > retval ? errno : 0;
+
+        mutex_lock(&AIO_lock);
+        worker->running = NULL;
+
+        /// unbind the drained worker, contexts of closed devices must not hold it
+        if (! worker->head)
+            worker->device = NULL;
+        mutex_unlock(&AIO_lock);
+
+        AIO_complete(aiocbp, retval, err);
+    }
+    return NULL;
+}
+
+static ssize_t AIO_execute(struct aiocb *aiocbp)
+{
+    int fd = aiocbp->aio_fildes;
+
+    /// fd was closed after submitted
+    if (CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+
+    bool seekable = NULL != AsFD(fd)->implement->seek &&
+        0 == ((FD_TAG_CHAR | FD_TAG_FIFO | FD_TAG_SOCKET) & AsFD(fd)->tag);
+
+    /// pread() / pwrite() are positional by implement->pread / pwrite, the fd position of caller is untouched
+    switch (aiocbp->__opcode)
+    {
+    case LIO_READ:
+        if (seekable)
+            return pread(fd, (void *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
+        else
+            return read(fd, (void *)aiocbp->aio_buf, aiocbp->aio_nbytes);
+
+    case LIO_WRITE:
+        if (seekable)
+            return pwrite(fd, (void const *)aiocbp->aio_buf, aiocbp->aio_nbytes, aiocbp->aio_offset);
+        else
+            return write(fd, (void const *)aiocbp->aio_buf, aiocbp->aio_nbytes);
+
+    default:
+        return fsync(fd);
+    }
+}
+
+static void AIO_complete(struct aiocb *aiocbp, ssize_t retval, int err)
+{
+    /// aiocbp can be released as soon as __error was set
+    struct sigevent sev = aiocbp->aio_sigevent;
+    uint64_t latency = (uint64_t)(esp_timer_get_time() - aiocbp->__submit_us);
+
+    mutex_lock(&AIO_lock);
+    aiocbp->__return = retval;
+    aiocbp->__error = err;
+
+    if (ECANCELED != err)
+    {
+        struct aio_stats *stats = &AIO_context.stats;
+
+        if (0 == err)
+            stats->completed ++;
+        else
+            stats->failed ++;
+
+        if (stats->latency_max_us < latency)
+            stats->latency_max_us = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+        stats->latency_total_us += latency;
+
+        unsigned bucket = 0;
+        while (bucket < AIO_LATENCY_BUCKETS - 1 && latency >= AIO_LATENCY_BUCKET_US(bucket))
+            bucket ++;
+        stats->latency_hist[bucket] ++;
+    }
+
+    AIO_wakeup();
+    mutex_unlock(&AIO_lock);
+
+    AIO_notify(&sev);
+}
+
+static void AIO_wakeup(void)
+{
+    for (unsigned i = 0; i < lengthof(AIO_context.waiters); i ++)
+    {
+        /// semaphore max is 1, posting a waked waiter is no-op
+        if (AIO_context.waiters[i].waiting)
+            sem_post(&AIO_context.waiters[i].completed);
+    }
+}
+
+static void AIO_notify(struct sigevent const *sev)
+{
+    if (SIGEV_THREAD == sev->sigev_notify)
+        sev->sigev_notify_function(sev->sigev_value);
+}
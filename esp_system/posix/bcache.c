@@ -0,0 +1,888 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <string.h>
+#include <sys/errno.h>
+
+#include <esp_heap_caps.h>
+
+#include <unistd.h>
+#include <rtos/procfs.h>
+
+/// @implements headers
+#include <rtos/bcache.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+enum BCACHE_list_id
+{
+    /// LRU uses T1 only
+    BCACHE_T1                   = 0,
+    BCACHE_T2,
+    /// ARC ghosts: block numbers recently evicted from T1 / T2, without data
+    BCACHE_B1,
+    BCACHE_B2,
+    /// resident entries without content
+    BCACHE_FREE,
+    /// ghost entries not in use
+    BCACHE_GHOST_FREE,
+    BCACHE_LIST_COUNT,
+
+    BCACHE_LIST_NONE            = BCACHE_LIST_COUNT
+};
+
+struct BCACHE_entry
+{
+    /// lru => mru
+    struct BCACHE_entry *prev;
+    struct BCACHE_entry *next;
+    struct BCACHE_entry *hash_next;
+
+    uint32_t block;
+    uint8_t list;
+    bool dirty;
+    /// NULL for ghost entries
+    uint8_t *data;
+};
+
+struct BCACHE_list
+{
+    struct BCACHE_entry *lru;
+    struct BCACHE_entry *mru;
+    uint32_t count;
+};
+
+struct BCACHE
+{
+    struct BCACHE *glist_next;
+    mutex_t *lock;
+
+    struct BCACHE_device const *dev;
+    struct BCACHE_config config;
+    uint32_t block_shift;
+    uint32_t device_blocks;
+
+    struct BCACHE_list lists[BCACHE_LIST_COUNT];
+    /// ARC: target size of T1
+    uint32_t arc_p;
+
+    struct BCACHE_entry **buckets;
+    uint32_t bucket_mask;
+
+    uint8_t *slab;
+    /// coalescing writes
+    uint8_t *staging;
+    struct BCACHE_entry **run;
+
+    struct BCACHE_stats stats;
+    /// block_count resident entries, followed by block_count ghost entries when ARC
+    struct BCACHE_entry entries[];
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static struct BCACHE_entry *BCACHE_get(struct BCACHE *cache, uint32_t block, bool load, int *err);
+static int BCACHE_replace(struct BCACHE *cache, bool in_b2, struct BCACHE_entry **victim);
+static int BCACHE_evict(struct BCACHE *cache, struct BCACHE_entry *victim, enum BCACHE_list_id ghost);
+static void BCACHE_ghost_drop(struct BCACHE *cache, enum BCACHE_list_id ghost);
+static int BCACHE_writeback(struct BCACHE *cache, struct BCACHE_entry *entry);
+static int BCACHE_sync_locked(struct BCACHE *cache);
+static size_t BCACHE_device_span(struct BCACHE *cache, uint32_t block, uint32_t count);
+
+static void BCACHE_list_remove(struct BCACHE *cache, struct BCACHE_entry *entry);
+static void BCACHE_list_push(struct BCACHE *cache, enum BCACHE_list_id id, struct BCACHE_entry *entry);
+static struct BCACHE_entry *BCACHE_hash_find(struct BCACHE *cache, uint32_t block);
+static void BCACHE_hash_insert(struct BCACHE *cache, struct BCACHE_entry *entry);
+static void BCACHE_hash_remove(struct BCACHE *cache, struct BCACHE_entry *entry);
+static void *BCACHE_alloc(enum BCACHE_placement_t placement, size_t size);
+
+static ssize_t BCACHE_fd_read(int fd, void *buf, size_t bufsize);
+static ssize_t BCACHE_fd_write(int fd, void const *buf, size_t count);
+static ssize_t BCACHE_fd_pread(int fd, void *buf, size_t bufsize, off_t offset);
+static ssize_t BCACHE_fd_pwrite(int fd, void const *buf, size_t count, off_t offset);
+static off_t BCACHE_fd_seek(int fd, off_t offset, int origin);
+static int BCACHE_fd_close(int fd);
+static int BCACHE_fd_sync(int fd);
+
+static void BCACHE_procfs(struct PROCFS_output *out, void *arg);
+
+/// @variable
+static struct FD_implement const BCACHE_fdio =
+{
+    .read = BCACHE_fd_read,
+    .write = BCACHE_fd_write,
+    .seek = BCACHE_fd_seek,
+    .close = BCACHE_fd_close,
+    .ioctl = NULL,
+    .sync = BCACHE_fd_sync,
+    .pread = BCACHE_fd_pread,
+    .pwrite = BCACHE_fd_pwrite,
+};
+
+/// all caches for sync()
+static mutex_t BCACHE_list_lock = MUTEX_INITIALIZER;
+static glist_t BCACHE_caches = GLIST_INITIALIZER(BCACHE_caches);
+
+/***************************************************************************/
+/** @constructor
+****************************************************************************/
+#ifdef __GNUC__
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmissing-prototypes"
+#endif
+
+__attribute__((constructor, nothrow))
+static void BCACHE_initialize(void)
+{
+    PROCFS_register("bcache", BCACHE_procfs, NULL);
+}
+
+#ifdef __GNUC__
+    #pragma GCC diagnostic pop
+#endif
+
+/***************************************************************************/
+/** @implements bcache.h
+****************************************************************************/
+struct BCACHE *BCACHE_create(struct BCACHE_device const *dev, struct BCACHE_config const *config)
+{
+    if (0 == config->block_count || 0 == config->block_size ||
+        0 != (config->block_size & (config->block_size - 1)))
+    {
+        return __set_errno_nullptr(EINVAL);
+    }
+
+    uint32_t entry_count = config->block_count;
+    if (BCACHE_POLICY_ARC == config->policy)
+        entry_count *= 2;
+
+    struct BCACHE *cache = KERNEL_mallocz(sizeof(struct BCACHE) + entry_count * sizeof(struct BCACHE_entry));
+    if (! cache)
+        return __set_errno_nullptr(ENOMEM);
+
+    cache->dev = dev;
+    cache->config = *config;
+    if (1 > cache->config.coalesce_max)
+        cache->config.coalesce_max = 1;
+
+    while ((1U << cache->block_shift) < config->block_size)
+        cache->block_shift ++;
+    /// the last partial block is cached, device access of it is clamped to device size
+    cache->device_blocks = (uint32_t)((dev->size + config->block_size - 1) >> cache->block_shift);
+
+    /// hash buckets: power of 2 >= entries
+    uint32_t bucket_count = 1;
+    while (bucket_count < entry_count)
+        bucket_count <<= 1;
+    cache->bucket_mask = bucket_count - 1;
+
+    cache->buckets = KERNEL_mallocz(bucket_count * sizeof(struct BCACHE_entry *));
+    cache->run = KERNEL_malloc(cache->config.coalesce_max * sizeof(struct BCACHE_entry *));
+    cache->slab = BCACHE_alloc(config->placement, (size_t)config->block_count * config->block_size);
+
+    if (1 < cache->config.coalesce_max)
+        cache->staging = BCACHE_alloc(config->placement, (size_t)cache->config.coalesce_max * config->block_size);
+
+    /// handle managed mutex: destroyed handle is recycled after cache was freed
+    cache->lock = mutex_create(MUTEX_FLAG_NORMAL);
+
+    if (! cache->lock || ! cache->buckets || ! cache->run || ! cache->slab ||
+        (1 < cache->config.coalesce_max && ! cache->staging))
+    {
+        if (cache->lock)
+            mutex_destroy(cache->lock);
+        if (cache->buckets)
+            KERNEL_mfree(cache->buckets);
+        if (cache->run)
+            KERNEL_mfree(cache->run);
+        if (cache->slab)
+            heap_caps_free(cache->slab);
+        if (cache->staging)
+            heap_caps_free(cache->staging);
+
+        KERNEL_mfree(cache);
+        return __set_errno_nullptr(ENOMEM);
+    }
+
+    for (uint32_t i = 0; i < config->block_count; i ++)
+    {
+        cache->entries[i].data = &cache->slab[i << cache->block_shift];
+        BCACHE_list_push(cache, BCACHE_FREE, &cache->entries[i]);
+    }
+    for (uint32_t i = config->block_count; i < entry_count; i ++)
+        BCACHE_list_push(cache, BCACHE_GHOST_FREE, &cache->entries[i]);
+
+    mutex_lock(&BCACHE_list_lock);
+    glist_push_back(&BCACHE_caches, cache);
+    mutex_unlock(&BCACHE_list_lock);
+
+    return cache;
+}
+
+int BCACHE_destroy(struct BCACHE *cache)
+{
+    mutex_lock(&BCACHE_list_lock);
+
+    mutex_lock(cache->lock);
+    int err = BCACHE_sync_locked(cache);
+    mutex_unlock(cache->lock);
+
+    if (0 == err)
+    {
+        glist_iter_t iter = glist_find(&BCACHE_caches, cache);
+        if (iter)
+            glist_iter_extract(&BCACHE_caches, iter);
+    }
+    mutex_unlock(&BCACHE_list_lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+
+    mutex_destroy(cache->lock);
+
+    heap_caps_free(cache->slab);
+    if (cache->staging)
+        heap_caps_free(cache->staging);
+    KERNEL_mfree(cache->run);
+    KERNEL_mfree(cache->buckets);
+    KERNEL_mfree(cache);
+    return 0;
+}
+
+ssize_t BCACHE_pread(struct BCACHE *cache, void *buf, size_t count, uint64_t offset)
+{
+    uint32_t const block_size = cache->config.block_size;
+    uint8_t *dst = buf;
+    size_t transferred = 0;
+    int err = 0;
+
+    if (offset >= cache->dev->size)
+        return 0;
+    if (count > cache->dev->size - offset)
+        count = (size_t)(cache->dev->size - offset);
+
+    mutex_lock(cache->lock);
+    while (transferred < count)
+    {
+        uint32_t block = (uint32_t)(offset >> cache->block_shift);
+        uint32_t block_offset = (uint32_t)offset & (block_size - 1);
+
+        size_t len = block_size - block_offset;
+        if (len > count - transferred)
+            len = count - transferred;
+
+        struct BCACHE_entry *entry = BCACHE_get(cache, block, true, &err);
+        if (! entry)
+            break;
+
+        memcpy(&dst[transferred], &entry->data[block_offset], len);
+        transferred += len;
+        offset += len;
+    }
+    mutex_unlock(cache->lock);
+
+    if (0 != err && 0 == transferred)
+        return __set_errno_neg(err);
+    else
+        return (ssize_t)transferred;
+}
+
+ssize_t BCACHE_pwrite(struct BCACHE *cache, void const *buf, size_t count, uint64_t offset)
+{
+    uint32_t const block_size = cache->config.block_size;
+    uint8_t const *src = buf;
+    size_t transferred = 0;
+    int err = 0;
+
+    if (offset >= cache->dev->size)
+        return __set_errno_neg(ENOSPC);
+    if (count > cache->dev->size - offset)
+        count = (size_t)(cache->dev->size - offset);
+
+    mutex_lock(cache->lock);
+    while (transferred < count)
+    {
+        uint32_t block = (uint32_t)(offset >> cache->block_shift);
+        uint32_t block_offset = (uint32_t)offset & (block_size - 1);
+
+        size_t len = block_size - block_offset;
+        if (len > count - transferred)
+            len = count - transferred;
+
+        /// whole block overwrite: no need to read it from device
+        struct BCACHE_entry *entry = BCACHE_get(cache, block, len != block_size, &err);
+        if (! entry)
+            break;
+
+        memcpy(&entry->data[block_offset], &src[transferred], len);
+        if (! entry->dirty)
+        {
+            entry->dirty = true;
+            cache->stats.dirty ++;
+        }
+
+        if (BCACHE_FLAG_WRITE_THROUGH & cache->config.flags)
+        {
+            err = BCACHE_writeback(cache, entry);
+            if (0 != err)
+                break;
+        }
+
+        transferred += len;
+        offset += len;
+    }
+    mutex_unlock(cache->lock);
+
+    if (0 != err && 0 == transferred)
+        return __set_errno_neg(err);
+    else
+        return (ssize_t)transferred;
+}
+
+int BCACHE_sync(struct BCACHE *cache)
+{
+    mutex_lock(cache->lock);
+    int err = BCACHE_sync_locked(cache);
+    mutex_unlock(cache->lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return 0;
+}
+
+int BCACHE_invalidate(struct BCACHE *cache)
+{
+    mutex_lock(cache->lock);
+    int err = BCACHE_sync_locked(cache);
+
+    if (0 == err)
+    {
+        uint32_t entry_count = cache->config.block_count;
+        if (BCACHE_POLICY_ARC == cache->config.policy)
+            entry_count *= 2;
+
+        for (uint32_t i = 0; i < entry_count; i ++)
+        {
+            struct BCACHE_entry *entry = &cache->entries[i];
+
+            if (BCACHE_FREE != entry->list && BCACHE_GHOST_FREE != entry->list)
+            {
+                BCACHE_list_remove(cache, entry);
+                BCACHE_list_push(cache, entry->data ? BCACHE_FREE : BCACHE_GHOST_FREE, entry);
+            }
+        }
+        memset(cache->buckets, 0, (cache->bucket_mask + 1) * sizeof(struct BCACHE_entry *));
+        cache->arc_p = 0;
+    }
+    mutex_unlock(cache->lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return 0;
+}
+
+void BCACHE_get_stats(struct BCACHE *cache, struct BCACHE_stats *stats, bool reset)
+{
+    mutex_lock(cache->lock);
+    *stats = cache->stats;
+
+    if (reset)
+    {
+        uint32_t dirty = cache->stats.dirty;
+
+        memset(&cache->stats, 0, sizeof(cache->stats));
+        cache->stats.dirty = dirty;
+    }
+    mutex_unlock(cache->lock);
+}
+
+int BCACHE_createfd(struct BCACHE *cache)
+{
+    return KERNEL_createfd(FD_TAG_BLOCK, &BCACHE_fdio, cache);
+}
+
+/***************************************************************************/
+/** @implements unistd.h
+****************************************************************************/
+void sync(void)
+{
+    mutex_lock(&BCACHE_list_lock);
+
+    for (struct BCACHE **iter = glist_iter_begin(&BCACHE_caches);
+        iter != glist_iter_end(&BCACHE_caches);
+        iter = glist_iter_next(&BCACHE_caches, iter))
+    {
+        BCACHE_sync(*iter);
+    }
+    mutex_unlock(&BCACHE_list_lock);
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t BCACHE_fd_read(int fd, void *buf, size_t bufsize)
+{
+    ssize_t retval = BCACHE_pread(AsFD(fd)->ext, buf, bufsize, AsFD(fd)->position);
+
+    if (0 < retval)
+        AsFD(fd)->position += (uintptr_t)retval;
+    return retval;
+}
+
+static ssize_t BCACHE_fd_write(int fd, void const *buf, size_t count)
+{
+    ssize_t retval = BCACHE_pwrite(AsFD(fd)->ext, buf, count, AsFD(fd)->position);
+
+    if (0 < retval)
+        AsFD(fd)->position += (uintptr_t)retval;
+    return retval;
+}
+
+static ssize_t BCACHE_fd_pread(int fd, void *buf, size_t bufsize, off_t offset)
+{
+    return BCACHE_pread(AsFD(fd)->ext, buf, bufsize, (uint64_t)offset);
+}
+
+static ssize_t BCACHE_fd_pwrite(int fd, void const *buf, size_t count, off_t offset)
+{
+    return BCACHE_pwrite(AsFD(fd)->ext, buf, count, (uint64_t)offset);
+}
+
+static off_t BCACHE_fd_seek(int fd, off_t offset, int origin)
+{
+    struct BCACHE *cache = AsFD(fd)->ext;
+    off_t pos;
+
+    switch (origin)
+    {
+    case SEEK_SET:
+        pos = offset;
+        break;
+    case SEEK_CUR:
+        pos = (off_t)AsFD(fd)->position + offset;
+        break;
+    case SEEK_END:
+        pos = (off_t)cache->dev->size + offset;
+        break;
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+
+    if (0 > pos || (uint64_t)pos > cache->dev->size)
+        return __set_errno_neg(EINVAL);
+
+    AsFD(fd)->position = (uintptr_t)pos;
+    return pos;
+}
+
+static int BCACHE_fd_close(int fd)
+{
+    /// the fd is released by kernel even when writing back failed, the error is still reported
+    return BCACHE_sync(AsFD(fd)->ext);
+}
+
+static int BCACHE_fd_sync(int fd)
+{
+    return BCACHE_sync(AsFD(fd)->ext);
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct BCACHE_entry *BCACHE_get(struct BCACHE *cache, uint32_t block, bool load, int *err)
+{
+    struct BCACHE_entry *entry = BCACHE_hash_find(cache, block);
+    bool const arc = BCACHE_POLICY_ARC == cache->config.policy;
+
+    if (entry && entry->data)
+    {
+        cache->stats.hits ++;
+
+        /// ARC: second hit promotes to frequency list T2
+        BCACHE_list_remove(cache, entry);
+        BCACHE_list_push(cache, arc ? BCACHE_T2 : BCACHE_T1, entry);
+        return entry;
+    }
+    cache->stats.misses ++;
+
+    struct BCACHE_list *lists = cache->lists;
+    uint32_t const c = cache->config.block_count;
+    enum BCACHE_list_id target = BCACHE_T1;
+    struct BCACHE_entry *victim = NULL;
+
+    if (! arc)
+    {
+        *err = BCACHE_replace(cache, false, &victim);
+    }
+    else if (entry)
+    {
+        /// @ghost hit: adapt T1's target size to the list it was evicted from
+        bool in_b2 = BCACHE_B2 == entry->list;
+        cache->stats.ghost_hits ++;
+
+        if (! in_b2)
+        {
+            uint32_t delta = lists[BCACHE_B2].count > lists[BCACHE_B1].count ?
+                lists[BCACHE_B2].count / lists[BCACHE_B1].count : 1;
+
+            cache->arc_p = cache->arc_p + delta < c ? cache->arc_p + delta : c;
+        }
+        else
+        {
+            uint32_t delta = lists[BCACHE_B1].count > lists[BCACHE_B2].count ?
+                lists[BCACHE_B1].count / lists[BCACHE_B2].count : 1;
+
+            cache->arc_p = cache->arc_p > delta ? cache->arc_p - delta : 0;
+        }
+
+        BCACHE_hash_remove(cache, entry);
+        BCACHE_list_remove(cache, entry);
+        BCACHE_list_push(cache, BCACHE_GHOST_FREE, entry);
+
+        *err = BCACHE_replace(cache, in_b2, &victim);
+        target = BCACHE_T2;
+    }
+    else
+    {
+        uint32_t l1 = lists[BCACHE_T1].count + lists[BCACHE_B1].count;
+        uint32_t total = l1 + lists[BCACHE_T2].count + lists[BCACHE_B2].count;
+
+        if (l1 == c)
+        {
+            if (lists[BCACHE_T1].count < c)
+            {
+                BCACHE_ghost_drop(cache, BCACHE_B1);
+                *err = BCACHE_replace(cache, false, &victim);
+            }
+            else
+            {
+                victim = lists[BCACHE_T1].lru;
+                *err = BCACHE_evict(cache, victim, BCACHE_LIST_NONE);
+            }
+        }
+        else
+        {
+            if (total >= 2 * c)
+                BCACHE_ghost_drop(cache, BCACHE_B2);
+
+            *err = BCACHE_replace(cache, false, &victim);
+        }
+    }
+
+    if (0 != *err)
+        return NULL;
+
+    victim->block = block;
+    victim->dirty = false;
+
+    if (load)
+    {
+        cache->stats.device_reads ++;
+
+        size_t size = BCACHE_device_span(cache, block, 1);
+        if (size < cache->config.block_size)
+            memset(&victim->data[size], 0, cache->config.block_size - size);
+
+        *err = cache->dev->read(cache->dev->ctx, (uint64_t)block << cache->block_shift, victim->data, size);
+
+        if (0 != *err)
+        {
+            BCACHE_list_push(cache, BCACHE_FREE, victim);
+            return NULL;
+        }
+    }
+
+    BCACHE_hash_insert(cache, victim);
+    BCACHE_list_push(cache, target, victim);
+    return victim;
+}
+
+static int BCACHE_replace(struct BCACHE *cache, bool in_b2, struct BCACHE_entry **victim)
+{
+    struct BCACHE_list *lists = cache->lists;
+
+    if (lists[BCACHE_FREE].count)
+    {
+        *victim = lists[BCACHE_FREE].lru;
+        BCACHE_list_remove(cache, *victim);
+        return 0;
+    }
+
+    if (BCACHE_POLICY_ARC != cache->config.policy)
+    {
+        *victim = lists[BCACHE_T1].lru;
+        return BCACHE_evict(cache, *victim, BCACHE_LIST_NONE);
+    }
+
+    uint32_t t1 = lists[BCACHE_T1].count;
+
+    if (t1 && (t1 > cache->arc_p || (in_b2 && t1 == cache->arc_p)))
+    {
+        *victim = lists[BCACHE_T1].lru;
+        return BCACHE_evict(cache, *victim, BCACHE_B1);
+    }
+    else if (lists[BCACHE_T2].count)
+    {
+        *victim = lists[BCACHE_T2].lru;
+        return BCACHE_evict(cache, *victim, BCACHE_B2);
+    }
+    else
+    {
+        *victim = lists[BCACHE_T1].lru;
+        return BCACHE_evict(cache, *victim, BCACHE_B1);
+    }
+}
+
+static int BCACHE_evict(struct BCACHE *cache, struct BCACHE_entry *victim, enum BCACHE_list_id ghost)
+{
+    if (victim->dirty)
+    {
+        int err = BCACHE_writeback(cache, victim);
+        if (0 != err)
+            return err;
+    }
+    cache->stats.evictions ++;
+
+    BCACHE_hash_remove(cache, victim);
+    BCACHE_list_remove(cache, victim);
+
+    if (BCACHE_LIST_NONE != ghost)
+    {
+        /// remember evicted block number
+        if (0 == cache->lists[BCACHE_GHOST_FREE].count)
+            BCACHE_ghost_drop(cache, cache->lists[BCACHE_B1].count ? BCACHE_B1 : BCACHE_B2);
+
+        struct BCACHE_entry *entry = cache->lists[BCACHE_GHOST_FREE].lru;
+        BCACHE_list_remove(cache, entry);
+
+        entry->block = victim->block;
+        BCACHE_hash_insert(cache, entry);
+        BCACHE_list_push(cache, ghost, entry);
+    }
+    return 0;
+}
+
+static void BCACHE_ghost_drop(struct BCACHE *cache, enum BCACHE_list_id ghost)
+{
+    struct BCACHE_entry *entry = cache->lists[ghost].lru;
+
+    if (entry)
+    {
+        BCACHE_hash_remove(cache, entry);
+        BCACHE_list_remove(cache, entry);
+        BCACHE_list_push(cache, BCACHE_GHOST_FREE, entry);
+    }
+}
+
+static int BCACHE_writeback(struct BCACHE *cache, struct BCACHE_entry *entry)
+{
+    uint32_t const max = cache->config.coalesce_max;
+    uint32_t first = entry->block;
+    uint32_t count = 1;
+
+    /// @coalescing: extend to continuous dirty blocks before and after
+    while (count < max && 0 < first)
+    {
+        struct BCACHE_entry *iter = BCACHE_hash_find(cache, first - 1);
+
+        if (! iter || ! iter->data || ! iter->dirty)
+            break;
+
+        first --;
+        count ++;
+    }
+
+    count = 0;
+    while (count < max && first + count < cache->device_blocks)
+    {
+        struct BCACHE_entry *iter = BCACHE_hash_find(cache, first + count);
+
+        if (! iter || ! iter->data || ! iter->dirty)
+            break;
+
+        cache->run[count ++] = iter;
+    }
+
+    uint32_t const block_size = cache->config.block_size;
+    void const *buf;
+
+    if (1 == count)
+        buf = entry->data;
+    else
+    {
+        for (uint32_t i = 0; i < count; i ++)
+            memcpy(&cache->staging[i * block_size], cache->run[i]->data, block_size);
+
+        buf = cache->staging;
+    }
+
+    int err = cache->dev->write(cache->dev->ctx, (uint64_t)first << cache->block_shift,
+        buf, BCACHE_device_span(cache, first, count));
+
+    if (0 == err)
+    {
+        for (uint32_t i = 0; i < count; i ++)
+            cache->run[i]->dirty = false;
+
+        cache->stats.dirty -= count;
+        cache->stats.device_writes ++;
+        cache->stats.blocks_written += count;
+    }
+    return err;
+}
+
+static int BCACHE_sync_locked(struct BCACHE *cache)
+{
+    /// @barrier: write back in ascending block order, lowest dirty block starts a run
+    while (cache->stats.dirty)
+    {
+        struct BCACHE_entry *lowest = NULL;
+
+        for (uint32_t i = 0; i < cache->config.block_count; i ++)
+        {
+            struct BCACHE_entry *entry = &cache->entries[i];
+
+            if (entry->dirty && (! lowest || entry->block < lowest->block))
+                lowest = entry;
+        }
+
+        int err = BCACHE_writeback(cache, lowest);
+        if (0 != err)
+            return err;
+    }
+
+    if (cache->dev->sync)
+        return cache->dev->sync(cache->dev->ctx);
+    else
+        return 0;
+}
+
+static size_t BCACHE_device_span(struct BCACHE *cache, uint32_t block, uint32_t count)
+{
+    uint64_t addr = (uint64_t)block << cache->block_shift;
+    uint64_t size = (uint64_t)count << cache->block_shift;
+
+    if (size > cache->dev->size - addr)
+        size = cache->dev->size - addr;
+    return (size_t)size;
+}
+
+static void BCACHE_list_remove(struct BCACHE *cache, struct BCACHE_entry *entry)
+{
+    struct BCACHE_list *list = &cache->lists[entry->list];
+
+    if (entry->prev)
+        entry->prev->next = entry->next;
+    else
+        list->lru = entry->next;
+
+    if (entry->next)
+        entry->next->prev = entry->prev;
+    else
+        list->mru = entry->prev;
+
+    list->count --;
+    entry->prev = entry->next = NULL;
+    entry->list = BCACHE_LIST_NONE;
+}
+
+static void BCACHE_list_push(struct BCACHE *cache, enum BCACHE_list_id id, struct BCACHE_entry *entry)
+{
+    struct BCACHE_list *list = &cache->lists[id];
+
+    entry->list = (uint8_t)id;
+    entry->next = NULL;
+    entry->prev = list->mru;
+
+    if (list->mru)
+        list->mru->next = entry;
+    else
+        list->lru = entry;
+
+    list->mru = entry;
+    list->count ++;
+}
+
+static struct BCACHE_entry *BCACHE_hash_find(struct BCACHE *cache, uint32_t block)
+{
+    struct BCACHE_entry *iter = cache->buckets[(block * 2654435761U) & cache->bucket_mask];
+
+    while (iter && iter->block != block)
+        iter = iter->hash_next;
+    return iter;
+}
+
+static void BCACHE_hash_insert(struct BCACHE *cache, struct BCACHE_entry *entry)
+{
+    struct BCACHE_entry **bucket = &cache->buckets[(entry->block * 2654435761U) & cache->bucket_mask];
+
+    entry->hash_next = *bucket;
+    *bucket = entry;
+}
+
+static void BCACHE_hash_remove(struct BCACHE *cache, struct BCACHE_entry *entry)
+{
+    struct BCACHE_entry **pp = &cache->buckets[(entry->block * 2654435761U) & cache->bucket_mask];
+
+    while (*pp && *pp != entry)
+        pp = &(*pp)->hash_next;
+
+    if (*pp)
+        *pp = entry->hash_next;
+    entry->hash_next = NULL;
+}
+
+static void *BCACHE_alloc(enum BCACHE_placement_t placement, size_t size)
+{
+    void *ptr = NULL;
+
+    if (BCACHE_PLACE_INTERNAL != placement)
+        ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+
+    if (! ptr && BCACHE_PLACE_PSRAM != placement)
+        ptr = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    return ptr;
+}
+
+static void BCACHE_procfs(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+    unsigned idx = 0;
+
+    PROCFS_printf(out, "%-3s %10s %10s %10s %10s %10s %10s %6s\n",
+        "#", "hits", "misses", "ghost_hits", "evictions", "dev_reads", "dev_writes", "dirty");
+
+    mutex_lock(&BCACHE_list_lock);
+    for (struct BCACHE **iter = glist_iter_begin(&BCACHE_caches);
+        iter != glist_iter_end(&BCACHE_caches) && ! PROCFS_full(out);
+        iter = glist_iter_next(&BCACHE_caches, iter))
+    {
+        struct BCACHE_stats stats;
+        BCACHE_get_stats(*iter, &stats, false);
+
+        PROCFS_printf(out, "%-3u %10u %10u %10u %10u %10u %10u %6u\n", idx ++,
+            (unsigned)stats.hits, (unsigned)stats.misses, (unsigned)stats.ghost_hits,
+            (unsigned)stats.evictions, (unsigned)stats.device_reads, (unsigned)stats.device_writes,
+            (unsigned)stats.dirty
+        );
+    }
+    mutex_unlock(&BCACHE_list_lock);
+}
@@ -0,0 +1,400 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <dirent.h>
+
+/// @implements headers
+#include <rtos/devfs.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define INO_CURRENT_DIR                 ((ino_t)-2)
+
+/// power of 2
+#define DEVFS_HASH_BUCKETS              (16)
+
+#if 255 <= DEVFS_MAX_NODES
+    #error "DEVFS_MAX_NODES: ino of nodes are chained by uint8_t"
+#endif
+
+/**
+ *  device node, slot index + 1 is the ino, ino 0 is /dev itself
+ *      .free slot has namelen 0
+ */
+struct DEVFS_node
+{
+    DEVFS_open_t open;
+    DEVFS_release_t release;
+    void *arg;
+    mode_t mode;
+    time_t creation_ts;
+
+    /// ino of next node in the same bucket, 0 for end of chain
+    uint8_t hash_next;
+    uint8_t namelen;
+    char name[DEVFS_NAME_MAX + 1];
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int DEVFS_fs_open(struct fsio_t *fsio);
+static int DEVFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent);
+static int DEVFS_fs_unlink(struct fsio_t *fsio, ino_t ino);
+static ssize_t DEVFS_fs_getdents(int fd, void *buf, size_t bufsize);
+static int DEVFS_fs_fstat(struct fsio_t *fsio, struct stat *st);
+
+static ssize_t DEVFS_read(int fd, void *buf, size_t bufsize);
+static int DEVFS_close(int fd);
+
+static struct DEVFS_node *DEVFS_node_get(ino_t ino);
+static struct DEVFS_node *DEVFS_find(char const *name, size_t namelen, uint8_t **link);
+static void DEVFS_fill_dirent(struct DEVFS_node *node, struct dirent *ent);
+static void DEVFS_remove(struct DEVFS_node *node, uint8_t *link);
+static uint32_t DEVFS_hash(char const *name, size_t namelen);
+
+/// @variable
+static struct FD_implement const DEVFS_fsio =
+{
+    .read = DEVFS_read,
+    .write = NULL,
+    .seek = NULL,
+    .close = DEVFS_close,
+    .ioctl = NULL,
+};
+
+/// driver's open() is called with this lock held, unregister() waits for it
+static mutex_t DEVFS_lock = MUTEX_RECURSIVE_INITIALIZER;
+static uint8_t DEVFS_buckets[DEVFS_HASH_BUCKETS] = {0};
+static struct DEVFS_node DEVFS_nodes[DEVFS_MAX_NODES] = {0};
+
+/***************************************************************************/
+/** @export
+****************************************************************************/
+struct FS_implement const DEVFS_implement =
+{
+    .name = "devfs",
+    .dirent_size = DIRENT_SIZE(DEVFS_NAME_MAX + 1),
+    .fsio = &DEVFS_fsio,
+
+    .open = DEVFS_fs_open,
+    .create = NULL,
+    .truncate = NULL,
+    .unlink = DEVFS_fs_unlink,
+    .format = NULL,
+    .lookup = DEVFS_fs_lookup,
+    .getdents = DEVFS_fs_getdents,
+    .fstat = DEVFS_fs_fstat,
+};
+
+/***************************************************************************/
+/** @implements devfs.h
+****************************************************************************/
+int DEVFS_register(char const *name, mode_t mode, DEVFS_open_t open, void *arg)
+{
+    return DEVFS_register_release(name, mode, open, NULL, arg);
+}
+
+int DEVFS_register_release(char const *name, mode_t mode, DEVFS_open_t open,
+    DEVFS_release_t release, void *arg)
+{
+    size_t namelen = strlen(name);
+
+    if (0 == namelen || NULL != strchr(name, '/'))
+        return __set_errno_neg(EINVAL);
+    if (DEVFS_NAME_MAX < namelen)
+        return __set_errno_neg(ENAMETOOLONG);
+
+    int retval = 0;
+    uint8_t *link;
+
+    mutex_lock(&DEVFS_lock);
+    if (DEVFS_find(name, namelen, &link))
+        retval = __set_errno_neg(EEXIST);
+    else
+    {
+        struct DEVFS_node *node = NULL;
+
+        for (unsigned i = 0; i < lengthof(DEVFS_nodes); i ++)
+        {
+            if (0 == DEVFS_nodes[i].namelen)
+            {
+                node = &DEVFS_nodes[i];
+                break;
+            }
+        }
+
+        if (! node)
+            retval = __set_errno_neg(ENOSPC);
+        else
+        {
+            node->open = open;
+            node->release = release;
+            node->arg = arg;
+            node->mode = (mode & S_IFMT) ? mode : (S_IFCHR | mode);
+            node->creation_ts = time(NULL);
+            node->namelen = (uint8_t)namelen;
+            memcpy(node->name, name, namelen + 1);
+
+            /// @link: *link is the end of chain
+            node->hash_next = 0;
+            *link = (uint8_t)(node - DEVFS_nodes + 1);
+        }
+    }
+    mutex_unlock(&DEVFS_lock);
+
+    return retval;
+}
+
+int DEVFS_unregister(char const *name)
+{
+    size_t namelen = strlen(name);
+    int retval = 0;
+    uint8_t *link;
+
+    mutex_lock(&DEVFS_lock);
+    struct DEVFS_node *node = DEVFS_find(name, namelen, &link);
+
+    if (! node)
+        retval = __set_errno_neg(ENOENT);
+    else
+        DEVFS_remove(node, link);
+    mutex_unlock(&DEVFS_lock);
+
+    return retval;
+}
+
+/***************************************************************************/
+/** @implements FS_implement
+****************************************************************************/
+static int DEVFS_fs_open(struct fsio_t *fsio)
+{
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+        fsio->ino_entry = fsio->ino_working = 0;
+
+    if (0 == fsio->ino_entry)
+        return KERNEL_createfd(FD_TAG_DIR, &DEVFS_fsio, fsio);
+
+    int fd;
+
+    mutex_lock(&DEVFS_lock);
+    struct DEVFS_node *node = DEVFS_node_get(fsio->ino_entry);
+
+    if (! node)
+        fd = __set_errno_neg(ENOENT);
+    else
+        fd = node->open(node->arg, fsio->flags & ~(O_CREAT | O_EXCL | O_DIRECTORY));
+    mutex_unlock(&DEVFS_lock);
+
+    return fd;
+}
+
+static int DEVFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent)
+{
+    ARG_UNUSED(fsio);
+    int retval = 0;
+
+    mutex_lock(&DEVFS_lock);
+    struct DEVFS_node *node = DEVFS_find(name, namelen, NULL);
+
+    if (node)
+        DEVFS_fill_dirent(node, ent);
+    else
+        retval = __set_errno_neg(ENOENT);
+    mutex_unlock(&DEVFS_lock);
+
+    return retval;
+}
+
+static int DEVFS_fs_unlink(struct fsio_t *fsio, ino_t ino)
+{
+    ARG_UNUSED(fsio);
+    int retval = 0;
+
+    /// same as DEVFS_unregister(), the node is resolved by unlinkat() without opening it
+    mutex_lock(&DEVFS_lock);
+    struct DEVFS_node *node = DEVFS_node_get(ino);
+    uint8_t *link;
+
+    if (! node)
+        retval = __set_errno_neg(ENOENT);
+    else
+    {
+        DEVFS_find(node->name, node->namelen, &link);
+        DEVFS_remove(node, link);
+    }
+    mutex_unlock(&DEVFS_lock);
+
+    return retval;
+}
+
+static ssize_t DEVFS_fs_getdents(int fd, void *buf, size_t bufsize)
+{
+    size_t filled = 0;
+    /// position is the slot index to continue, same as readdir() by read()
+    uintptr_t pos = AsFD(fd)->position;
+
+    mutex_lock(&DEVFS_lock);
+    for (; pos < lengthof(DEVFS_nodes); pos ++)
+    {
+        struct DEVFS_node *node = &DEVFS_nodes[pos];
+        if (0 == node->namelen)
+            continue;
+
+        size_t reclen = DIRENT_RECLEN(node->namelen);
+        if (filled + reclen > bufsize)
+            break;
+
+        DEVFS_fill_dirent(node, (struct dirent *)((uint8_t *)buf + filled));
+        filled += reclen;
+    }
+    mutex_unlock(&DEVFS_lock);
+
+    AsFD(fd)->position = pos;
+
+    if (0 == filled && pos < lengthof(DEVFS_nodes))
+        return __set_errno_neg(EINVAL);
+    else
+        return (ssize_t)filled;
+}
+
+static int DEVFS_fs_fstat(struct fsio_t *fsio, struct stat *st)
+{
+    ARG_UNUSED(fsio);
+
+    /// device fds are owned by drivers, only /dev itself reaches here
+    st->st_mode = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+    st->st_nlink = 1;
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t DEVFS_read(int fd, void *buf, size_t bufsize)
+{
+    if (bufsize < DEVFS_implement.dirent_size)
+        return __set_errno_neg(EINVAL);
+
+    ssize_t retval = 0;
+    uintptr_t pos = AsFD(fd)->position;
+
+    mutex_lock(&DEVFS_lock);
+    for (; pos < lengthof(DEVFS_nodes); pos ++)
+    {
+        if (0 != DEVFS_nodes[pos].namelen)
+        {
+            DEVFS_fill_dirent(&DEVFS_nodes[pos], buf);
+            retval = (ssize_t)DEVFS_implement.dirent_size;
+
+            pos ++;
+            break;
+        }
+    }
+    mutex_unlock(&DEVFS_lock);
+
+    AsFD(fd)->position = pos;
+    return retval;
+}
+
+static int DEVFS_close(int fd)
+{
+    ARG_UNUSED(fd);
+    return 0;
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct DEVFS_node *DEVFS_node_get(ino_t ino)
+{
+    if (0 == ino || lengthof(DEVFS_nodes) < ino)
+        return NULL;
+
+    struct DEVFS_node *node = &DEVFS_nodes[ino - 1];
+    return node->namelen ? node : NULL;
+}
+
+static struct DEVFS_node *DEVFS_find(char const *name, size_t namelen, uint8_t **link)
+{
+    uint8_t *iter = &DEVFS_buckets[DEVFS_hash(name, namelen) & (DEVFS_HASH_BUCKETS - 1)];
+
+    while (0 != *iter)
+    {
+        struct DEVFS_node *node = &DEVFS_nodes[*iter - 1];
+
+        if (namelen == node->namelen && 0 == memcmp(name, node->name, namelen))
+        {
+            if (link)
+                *link = iter;
+            return node;
+        }
+        iter = &node->hash_next;
+    }
+
+    /// not found: *link is the end of chain for inserting
+    if (link)
+        *link = iter;
+    return NULL;
+}
+
+/// DEVFS_lock is held, *link is the chain entry of node
+static void DEVFS_remove(struct DEVFS_node *node, uint8_t *link)
+{
+    DEVFS_release_t release = node->release;
+    void *arg = node->arg;
+
+    *link = node->hash_next;
+    memset(node, 0, sizeof(*node));
+
+    if (release)
+        release(arg);
+}
+
+static void DEVFS_fill_dirent(struct DEVFS_node *node, struct dirent *ent)
+{
+    ent->d_filesystem = NULL;
+    ent->d_mode = node->mode;
+    ent->d_ino = (ino_t)(node - DEVFS_nodes + 1);
+    ent->d_size = 0;
+    ent->d_creation_ts = node->creation_ts;
+    ent->d_modificaion_ts = node->creation_ts;
+    ent->d_namelen = node->namelen;
+
+    memcpy(ent->d_name, node->name, node->namelen);
+    ent->d_name[node->namelen] = '\0';
+}
+
+static uint32_t DEVFS_hash(char const *name, size_t namelen)
+{
+    /// @FNV-1a
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < namelen; i ++)
+    {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
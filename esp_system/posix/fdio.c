@@ -3,11 +3,21 @@
 #include <stropts.h>
 #include <unistd.h>
 #include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/mman.h>
+#include <sys/termios.h>
 
 #include <esp_log.h>
 
 #include <rtos/kernel.h>
 
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static ssize_t FD_transfer(struct _reent *r, int fd_out, off_t *off_out, int fd_in, off_t *off_in,
+    size_t count, unsigned int flags);
+static ssize_t FD_transfer_mem(struct _reent *r, int fd_out, uint8_t const *buf, size_t count, unsigned int flags);
+
 /***************************************************************************/
 /** exports
 ****************************************************************************/
@@ -22,6 +32,12 @@ ssize_t console_write(void const *buf, size_t count)
     return (ssize_t)count;
 }
 
+__attribute__((weak))
+int console_drain(void)
+{
+    return 0;
+}
+
 /***************************************************************************/
 /** @implements
 ****************************************************************************/
@@ -133,10 +149,27 @@ ssize_t _read_r(struct _reent *r, int fd, void *buf, size_t bufsize)
 
 ssize_t pread(int fd, void *buf, size_t bufsize, off_t offset)
 {
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+    if (0 > offset)
+        return __set_errno_neg(EINVAL);
+
+    if (AsFD(fd)->implement->pread)
+        return AsFD(fd)->implement->pread(fd, buf, bufsize, offset);
+
+    /// emulated by seeking, the fd position is restored
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (-1 == pos)
+        return -1;
     if (lseek(fd, offset, SEEK_SET) != offset)
         return __set_errno_neg(EINVAL);
-    else
-        return read(fd, buf, bufsize);
+
+    ssize_t retval = read(fd, buf, bufsize);
+    int err = errno;
+
+    lseek(fd, pos, SEEK_SET);
+    errno = err;
+    return retval;
 }
 
 ssize_t readbuf(int fd, void *buf, size_t bufsize)
@@ -249,10 +282,27 @@ ssize_t _write_r(struct _reent *r, int fd, void const *buf, size_t count)
 
 ssize_t pwrite(int fd, void const *buf, size_t count, off_t offset)
 {
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+    if (0 > offset)
+        return __set_errno_neg(EINVAL);
+
+    if (AsFD(fd)->implement->pwrite)
+        return AsFD(fd)->implement->pwrite(fd, buf, count, offset);
+
+    /// emulated by seeking, the fd position is restored
+    off_t pos = lseek(fd, 0, SEEK_CUR);
+    if (-1 == pos)
+        return -1;
     if (lseek(fd, offset, SEEK_SET) != offset)
         return __set_errno_neg(EINVAL);
-    else
-        return write(fd, buf, count);
+
+    ssize_t retval = write(fd, buf, count);
+    int err = errno;
+
+    lseek(fd, pos, SEEK_SET);
+    errno = err;
+    return retval;
 }
 
 ssize_t writebuf(int fd, void const *buf, size_t count)
@@ -297,6 +347,50 @@ ssize_t writeln(int fd, char const *buf, size_t count)
         return (ssize_t)count;
 }
 
+int fsync(int fd)
+{
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+
+    if (AsFD(fd)->implement->sync)
+        return AsFD(fd)->implement->sync(fd);
+    /// filesystem without buffering has nothing to write back
+    else if (AsFD(fd)->fs)
+        return 0;
+    else
+        return __set_errno_neg(EINVAL);
+}
+
+int fdatasync(int fd)
+{
+    return fsync(fd);
+}
+
+/***************************************************************************/
+/** @implements: termios.h
+****************************************************************************/
+int tcdrain(int fd)
+{
+    if (STDOUT_FILENO == fd)
+        fd = __stdout_fd;
+    else if (STDERR_FILENO == fd)
+        fd = __stderr_fd;
+
+    /// console_write() is buffered by console
+    if (-1 == fd)
+        return console_drain();
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+    if (! (FD_TAG_CHAR & AsFD(fd)->tag))
+        return __set_errno_neg(ENOTTY);
+
+    /// terminal's buffered content is its untransmitted output
+    if (AsFD(fd)->implement->sync)
+        return AsFD(fd)->implement->sync(fd);
+    else
+        return 0;
+}
+
 /***************************************************************************/
 /** @implements: uio
 ****************************************************************************/
@@ -315,3 +409,213 @@ ssize_t writev(int fd, struct iovec const *iov, int iovcnt)
     else
         return writebuf(fd, iov->oiv_base, iov->iov_len * (size_t)iovcnt);
 }
+
+/***************************************************************************/
+/** @implements: sendfile.h
+****************************************************************************/
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    return FD_transfer(__getreent(), out_fd, NULL, in_fd, offset, count, 0);
+}
+
+ssize_t splice(int fd_in, off_t *off_in, int fd_out, off_t *off_out, size_t len, unsigned int flags)
+{
+    return FD_transfer(__getreent(), fd_out, off_out, fd_in, off_in, len, flags);
+}
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static ssize_t FD_transfer(struct _reent *r, int fd_out, off_t *off_out, int fd_in, off_t *off_in,
+    size_t count, unsigned int flags)
+{
+    if (STDIN_FILENO == fd_in)
+        fd_in = __stdin_fd;
+    if (0 >= fd_in || CID_FD != AsFD(fd_in)->cid || NULL == AsFD(fd_in)->implement->read)
+        return __set_errno_r_neg(r, EBADF);
+
+    /// stdout / stderr without assigned fd are written to console by _write_r()
+    if (STDOUT_FILENO == fd_out && 0 < __stdout_fd)
+        fd_out = __stdout_fd;
+    else if (STDERR_FILENO == fd_out && 0 < __stderr_fd)
+        fd_out = __stderr_fd;
+
+    if (STDOUT_FILENO != fd_out && STDERR_FILENO != fd_out)
+    {
+        if (0 >= fd_out || CID_FD != AsFD(fd_out)->cid || NULL == AsFD(fd_out)->implement->write)
+            return __set_errno_r_neg(r, EBADF);
+        if (FD_FLAG_NONBLOCK & AsFD(fd_out)->flags)
+            flags |= SPLICE_F_NONBLOCK;
+    }
+    if (0 == count)
+        return 0;
+
+    off_t in_pos = 0, out_pos = 0;
+
+    /// @offset is not NULL: transfer from offset and restore the fd's position after all
+    if (off_in)
+    {
+        in_pos = lseek(fd_in, 0, SEEK_CUR);
+        if (-1 == in_pos || *off_in != lseek(fd_in, *off_in, SEEK_SET))
+            return __set_errno_r_neg(r, EINVAL);
+    }
+    if (off_out)
+    {
+        out_pos = lseek(fd_out, 0, SEEK_CUR);
+        if (-1 == out_pos || *off_out != lseek(fd_out, *off_out, SEEK_SET))
+        {
+            if (off_in) lseek(fd_in, in_pos, SEEK_SET);
+            return __set_errno_r_neg(r, EINVAL);
+        }
+    }
+
+    ssize_t transferred = 0;
+    bool stopped = false;
+    struct FD_implement const *implement = AsFD(fd_in)->implement;
+
+    /**
+     *  @zero copy: writting directly from fd_in's memory / flash mapping, run by run
+     *      .a run is what peek() / flash_addr() reports contiguous, flash runs are mapped by window
+     *      .the rest is transferred by the buffered loop when runs are not available
+     */
+    if (implement->flash_addr || (implement->peek && ! (FD_TAG_FIFO & AsFD(fd_in)->tag)))
+    {
+        off_t pos = lseek(fd_in, 0, SEEK_CUR);
+
+        while (-1 != pos && (size_t)transferred < count)
+        {
+            size_t len = count - (size_t)transferred;
+            void const *ptr = NULL;
+            void *mapped = NULL;
+
+            if (implement->peek)
+            {
+                ptr = implement->peek(fd_in, pos + transferred, &len);
+            }
+            else
+            {
+                uintptr_t paddr;
+                if (len > SENDFILE_MAP_SIZE)
+                    len = SENDFILE_MAP_SIZE;
+
+                if (0 == implement->flash_addr(fd_in, pos + transferred, &paddr, &len) && 0 != len)
+                {
+                    mapped = mmap(NULL, len, PROT_READ, MAP_SHARED, fd_in, pos + transferred);
+                    if (MAP_FAILED == mapped)
+                        mapped = NULL;
+                    ptr = mapped;
+                }
+            }
+            if (NULL == ptr || 0 == len)
+                break;
+
+            ssize_t written = FD_transfer_mem(r, fd_out, ptr, len, flags);
+            if (mapped)
+                munmap(mapped, len);
+
+            if (written > 0)
+                transferred += written;
+
+            if ((size_t)written != len)
+            {
+                if (0 == transferred)
+                    transferred = -1;
+                stopped = true;
+                break;
+            }
+        }
+
+        if (transferred > 0)
+            lseek(fd_in, pos + transferred, SEEK_SET);
+    }
+
+    if (! stopped && (size_t)transferred < count)
+    {
+        size_t bufsize = count - (size_t)transferred;
+        if (bufsize > SENDFILE_BUFSIZE)
+            bufsize = SENDFILE_BUFSIZE;
+
+        uint8_t *buf = KERNEL_malloc(bufsize);
+        if (NULL == buf)
+        {
+            if (0 == transferred)
+                transferred = __set_errno_r_neg(r, ENOMEM);
+            goto fd_transfer_exit;
+        }
+
+        while ((size_t)transferred < count)
+        {
+            size_t len = count - (size_t)transferred;
+            ssize_t readed = _read_r(r, fd_in, buf, len < bufsize ? len : bufsize);
+
+            if (0 > readed)
+            {
+                if (EAGAIN == r->_errno && 0 == transferred && ! (SPLICE_F_NONBLOCK & flags) &&
+                    ! (FD_FLAG_NONBLOCK & AsFD(fd_in)->flags))
+                {
+                    sched_yield();
+                    continue;
+                }
+                if (0 == transferred)
+                    transferred = -1;
+                break;
+            }
+            else if (0 == readed)
+                break;
+
+            ssize_t written = FD_transfer_mem(r, fd_out, buf, (size_t)readed, flags);
+            if (written > 0)
+                transferred += written;
+
+            if (written != readed)
+            {
+                if (0 == transferred)
+                    transferred = -1;
+                break;
+            }
+        }
+        KERNEL_mfree(buf);
+    }
+
+fd_transfer_exit:
+    if (off_in)
+    {
+        if (transferred > 0)
+            *off_in += transferred;
+        lseek(fd_in, in_pos, SEEK_SET);
+    }
+    if (off_out)
+    {
+        if (transferred > 0)
+            *off_out += transferred;
+        lseek(fd_out, out_pos, SEEK_SET);
+    }
+    return transferred;
+}
+
+static ssize_t FD_transfer_mem(struct _reent *r, int fd_out, uint8_t const *buf, size_t count, unsigned int flags)
+{
+    size_t written = 0;
+
+    while (written < count)
+    {
+        ssize_t writting = _write_r(r, fd_out, buf + written, count - written);
+
+        if (writting <= 0)
+        {
+            /// non-blocking: returns what was written, or -1 of EAGAIN when nothing
+            if (EAGAIN == r->_errno && ! (SPLICE_F_NONBLOCK & flags))
+            {
+                sched_yield();
+                continue;
+            }
+            else if (0 == written)
+                return -1;
+            else
+                break;
+        }
+        else
+            written += (size_t)writting;
+    }
+    return (ssize_t)written;
+}
@@ -1,10 +1,15 @@
 #include <rtos/kernel.h>
 
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <sys/errno.h>
 #include <sys/stat.h>
+#include <semaphore.h>
+
+#include <rtos/devfs.h>
+#include <rtos/procfs.h>
 
 /// @implements headers
 #include <fcntl.h>
@@ -17,15 +22,73 @@
 #define INO_PARENT_DIR                  ((ino_t)-1)
 #define INO_CURRENT_DIR                 ((ino_t)-2)
 
+/// scandir() reads this many entries of filesystem's dirent_size by each getdents()
+#define SCANDIR_BATCH_ENTRIES           (8)
+
+/// create() / unlink() / truncate() are serialized by inode, hashed into stripes
+#define FS_INODE_LOCK_STRIPES           (8)
+
+enum FS_mount_state
+{
+    FS_MOUNT_FREE                   = 0,
+    FS_MOUNT_MOUNTED,
+    /// waiting for readers to leave
+    FS_MOUNT_UNMOUNTING,
+};
+
+/**
+ *  mount table slot
+ *      .slots are never freed, readers hold readers count and recheck state without lock
+ *      .name / fs / data are only modified when state is FS_MOUNT_FREE
+ */
+struct FS_mount
+{
+    uint32_t state;
+    uint32_t readers;
+    /// fds opened under the mount
+    uint32_t opened;
+    /// posted by the last reader leaving while FS_MOUNT_UNMOUNTING
+    sem_t drained;
+
+    struct FS_implement const *fs;
+    void *data;
+
+    /// '/name' instead of '/mnt/name'
+    bool toplevel;
+    uint8_t namelen;
+    char name[FILESYSTEM_MOUNT_NAME_MAX + 1];
+};
+
+/**
+ *  fsio of filesystem fds
+ *      .directory fds linked as parent by glist_next are private to path walking,
+ *          they are counted by refs and released with the last child
+ *      .fds returned to user are never linked as parent
+ */
+struct FS_fsio
+{
+    struct fsio_t fsio;
+    /// mount the fd was opened under, NULL for the root filesystem
+    struct FS_mount *mount;
+    uint32_t refs;
+};
+#define AsFsio(fsio)                    ((struct FS_fsio *)(fsio))
+
 struct FS_context
 {
-    mutex_t lock;
     /// @working directory
     int working_dirfd;
     /// @collection of free ext blocks
+    spinlock_t ext_buf_atomic;
     glist_t ext_buf_list;
     /// ext_buf_preallocated
-    struct fsio_t prealloc[20];
+    struct FS_fsio prealloc[20];
+
+    /// mount() / unmount() only, lookups are lock-free
+    mutex_t mount_lock;
+    struct FS_mount mounts[FILESYSTEM_MAX_MOUNTS];
+
+    mutex_t inode_locks[FS_INODE_LOCK_STRIPES];
 };
 
 /***************************************************************************/
@@ -34,7 +97,7 @@ struct FS_context
 // weaked, everything ENOSYS if this is NULL
 __attribute__((weak)) struct FS_implement const *FS_root = NULL;
 
-// @overrides context.c weak reference
+// @overrides _rtos_kernel.c weak reference
 extern __attribute__((nothrow))
     void FILESYSTEM_fd_cleanup(int fd);
 
@@ -48,8 +111,20 @@ static struct FS_context FS_context = {0};
 static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flags, mode_t mode);
 static void *FS_extbuf_alloc(void);
 static void FS_extbuf_release(void *ptr);
-static void FS_dirfd_link_cleanup(int base_dirfd, int fd);
+static void FS_fsio_attach(struct fsio_t *fsio, struct FS_mount *mount);
+static void FS_fsio_release(struct fsio_t *fsio);
+static int FS_dirfd_dup(struct _reent *r, int fd);
+static void FS_dirfd_put(int fd);
 static void FS_dirfd_cleanup(int fd);
+static void FS_set_working_dirfd(int fd);
+static struct FS_mount *FS_mount_acquire(char const *name, size_t namelen, bool toplevel);
+static struct FS_mount *FS_mount_acquire_root(int fd, int parent_fd);
+static void FS_mount_release(struct FS_mount *mount);
+static int FS_mount_open(struct _reent *r, struct FS_mount *mount);
+static int FS_mount_open_path(struct _reent *r, char const **pathname);
+static mutex_t *FS_inode_lock(void const *data, ino_t ino);
+static int FS_scandir_append(struct dirent ***entrylist, int *count, int *alloc,
+    struct dirent const *ent, int (* filter)(struct dirent const *));
 
 /***************************************************************************/
 /** @constructor
@@ -66,13 +141,22 @@ void __FILESYSTEM_introduce(void)
 __attribute__((constructor, nothrow))
 static void FILESYSTEM_initialize(void)
 {
-    mutex_init(&FS_context.lock, MUTEX_FLAG_RECURSIVE);
+    mutex_init(&FS_context.mount_lock, MUTEX_FLAG_NORMAL);
+    for (unsigned i = 0; i < lengthof(FS_context.mounts); i ++)
+        sem_init(&FS_context.mounts[i].drained, 0, 0);
+    for (unsigned i = 0; i < lengthof(FS_context.inode_locks); i ++)
+        mutex_init(&FS_context.inode_locks[i], MUTEX_FLAG_NORMAL);
+
+    spinlock_init(&FS_context.ext_buf_atomic);
     glist_initialize(&FS_context.ext_buf_list);
     FS_context.working_dirfd = -1;
 
     for (unsigned i = 0; i < lengthof(FS_context.prealloc); i ++)
         glist_push_back(&FS_context.ext_buf_list, &FS_context.prealloc[i]);
 
+    FILESYSTEM_mount("/" DEVFS_DIR, &DEVFS_implement, NULL);
+    FILESYSTEM_mount("/" PROCFS_DIR, &PROCFS_implement, NULL);
+
     FILESYSTEM_init_root();
     FILESYSTEM_startup();
 }
@@ -94,23 +178,126 @@ void FILESYSTEM_init_root(void)
 {
 }
 
-void FILESYSTEM_lock(void)
+void FILESYSTEM_fd_cleanup(int fd)
 {
-    mutex_lock(&FS_context.lock);
+    int parent_fd = (int)AsFD(fd)->glist_next;
+
+    // AsFD(fd)->fsio can be null
+    if (AsFD(fd)->fsio)
+        FS_fsio_release(AsFD(fd)->fsio);
+
+    /// @rootdir'parent is self circulation link
+    if (parent_fd != fd)
+        FS_dirfd_put(parent_fd);
 }
 
-void FILESYSTEM_unlock(void)
+int FILESYSTEM_mount(char const *name, struct FS_implement const *fs, void *data)
 {
-    mutex_unlock(&FS_context.lock);
+    bool toplevel = '/' == name[0];
+    if (toplevel)
+        name ++;
+
+    size_t namelen = strlen(name);
+
+    if (0 == namelen || NULL != strchr(name, '/'))
+        return __set_errno_neg(EINVAL);
+    if (FILESYSTEM_MOUNT_NAME_MAX < namelen)
+        return __set_errno_neg(ENAMETOOLONG);
+
+    struct FS_mount *slot = NULL;
+    int err = 0;
+
+    mutex_lock(&FS_context.mount_lock);
+    for (unsigned i = 0; i < lengthof(FS_context.mounts); i ++)
+    {
+        struct FS_mount *mount = &FS_context.mounts[i];
+        uint32_t state = __atomic_load_n(&mount->state, __ATOMIC_ACQUIRE);
+
+        if (FS_MOUNT_FREE == state)
+        {
+            if (! slot)
+                slot = mount;
+        }
+        else if (toplevel == mount->toplevel &&
+            namelen == mount->namelen && 0 == memcmp(name, mount->name, namelen))
+        {
+            err = EEXIST;
+            break;
+        }
+    }
+
+    if (0 == err)
+    {
+        if (! slot)
+            err = ENOSPC;
+        else
+        {
+            slot->fs = fs;
+            slot->data = data;
+            slot->toplevel = toplevel;
+            slot->namelen = (uint8_t)namelen;
+            memcpy(slot->name, name, namelen + 1);
+
+            /// @publish: readers see the slot only after it was filled
+            __atomic_store_n(&slot->state, FS_MOUNT_MOUNTED, __ATOMIC_RELEASE);
+        }
+    }
+    mutex_unlock(&FS_context.mount_lock);
+
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return 0;
 }
 
-void FILESYSTEM_fd_cleanup(int fd)
+void *FILESYSTEM_unmount(char const *name)
 {
-    FS_dirfd_link_cleanup(-1, fd);
+    bool toplevel = '/' == name[0];
+    if (toplevel)
+        name ++;
 
-    // AsFD(fd)->fsio can be null
-    if (AsFD(fd)->fsio)
-        FS_extbuf_release(AsFD(fd)->fsio);
+    size_t namelen = strlen(name);
+    struct FS_mount *slot = NULL;
+
+    mutex_lock(&FS_context.mount_lock);
+    for (unsigned i = 0; i < lengthof(FS_context.mounts); i ++)
+    {
+        struct FS_mount *mount = &FS_context.mounts[i];
+
+        if (FS_MOUNT_MOUNTED == __atomic_load_n(&mount->state, __ATOMIC_ACQUIRE) &&
+            toplevel == mount->toplevel && namelen == mount->namelen && 0 == memcmp(name, mount->name, namelen))
+        {
+            slot = mount;
+            break;
+        }
+    }
+
+    /// @UNMOUNTING slot is neither reused nor found by other mount() / unmount()
+    if (slot)
+    {
+        /// discard posts left by readers of previous unmounting
+        while (0 == sem_trywait(&slot->drained));
+        __atomic_store_n(&slot->state, FS_MOUNT_UNMOUNTING, __ATOMIC_SEQ_CST);
+    }
+    mutex_unlock(&FS_context.mount_lock);
+
+    if (! slot)
+        return __set_errno_nullptr(ENOENT);
+
+    /// @grace period: wait path walkings through the mount without holding mount_lock
+    while (0 != __atomic_load_n(&slot->readers, __ATOMIC_SEQ_CST))
+        sem_wait(&slot->drained);
+
+    /// new fds are opened only by readers or under fds already opened
+    if (0 != __atomic_load_n(&slot->opened, __ATOMIC_ACQUIRE))
+    {
+        __atomic_store_n(&slot->state, FS_MOUNT_MOUNTED, __ATOMIC_RELEASE);
+        return __set_errno_nullptr(EBUSY);
+    }
+
+    void *data = slot->data;
+    __atomic_store_n(&slot->state, FS_MOUNT_FREE, __ATOMIC_RELEASE);
+    return data;
 }
 
 /***************************************************************************/
@@ -122,10 +309,14 @@ int FILESYSTEM_format(char const *pathmnt, char const *fstype)
     if (-1 == fd)
         return fd;
 
+    int retval;
     if (NULL == AsFD(fd)->fs->format)
-        return __set_errno_neg(EPERM);
+        retval = __set_errno_neg(EPERM);
     else
-        return AsFD(fd)->fs->format(AsFD(fd)->fsio, fstype);
+        retval = AsFD(fd)->fs->format(AsFD(fd)->fsio, fstype);
+
+    close(fd);
+    return retval;
 }
 
 int chdir(char const *pathname)
@@ -133,8 +324,9 @@ int chdir(char const *pathname)
     int fd = FS_openat(NULL, FS_context.working_dirfd, pathname, O_DIRECTORY, 0);
     if (-1 == fd)
         return fd;
-    else
-        return fchdir(fd);
+
+    FS_set_working_dirfd(fd);
+    return 0;
 }
 
 int fchdir(int fd)
@@ -142,32 +334,12 @@ int fchdir(int fd)
     if (! (FD_TAG_DIR & AsFD(fd)->tag))
         return __set_errno_neg(ENOTDIR);
 
-    int old_dirfd = FS_context.working_dirfd;
-    FS_context.working_dirfd = fd;
+    /// the working directory is a private fd, caller is free to close() fd
+    int dup_fd = FS_dirfd_dup(__getreent(), fd);
+    if (-1 == dup_fd)
+        return dup_fd;
 
-    if (-1 != old_dirfd)
-    {
-        bool clean_old_dirfd = true;
-        struct KERNEL_fd *iter_dirfd = AsFD(fd);
-
-        /// @find if old dirfd in the new dirfd's chain
-        while (true)
-        {
-            if ((int)iter_dirfd == old_dirfd)
-            {
-                clean_old_dirfd = false;
-                break;
-            }
-
-            /// @rootdir'parent is self circulation link
-            if (iter_dirfd == iter_dirfd->glist_next)
-                break;
-            else
-                iter_dirfd = iter_dirfd->glist_next;
-        }
-
-        if (clean_old_dirfd) close(old_dirfd);
-    }
+    FS_set_working_dirfd(dup_fd);
     return 0;
 }
 
@@ -192,24 +364,45 @@ char *getcwd(char *buf, size_t size)
         {
             struct fsio_t *fsio = AsFD(fd)->fsio;
 
-            DIR *dirp = fdopendir(parent_fd);
-            seekdir(dirp, (off_t)ext->ino_entry);
+            DIR *dirp = NULL;
+            char const *name;
+            size_t entlen;
+            char mntname[sizeof(FILESYSTEM_MOUNT_DIR) + FILESYSTEM_MOUNT_NAME_MAX + 1];
 
-            struct dirent *ent = readdir(dirp);
+            /// @mount root is not an entry of its parent directory
+            struct FS_mount *mount = FS_mount_acquire_root(fd, parent_fd);
+            if (mount)
+            {
+                entlen = mount->toplevel ? 0 : sizeof(FILESYSTEM_MOUNT_DIR);
+                memcpy(mntname, FILESYSTEM_MOUNT_DIR "/", entlen);
+                memcpy(&mntname[entlen], mount->name, mount->namelen);
+                entlen += mount->namelen;
+                name = mntname;
+                FS_mount_release(mount);
+            }
+            else
+            {
+                dirp = fdopendir(parent_fd);
+                seekdir(dirp, (off_t)fsio->ino_entry);
 
-            size_t len = namelen + ent->d_namelen + 1;
+                struct dirent *ent = readdir(dirp);
+                name = ent->d_name;
+                entlen = ent->d_namelen;
+            }
+
+            size_t len = namelen + entlen + 1;
             /// @ERANGE
             if (size < (size_t)len)
             {
-                KERNEL_mfree(dirp);
+                if (dirp) KERNEL_mfree(dirp);
                 return __set_errno_nullptr(ERANGE);
             }
 
             // its possiable when root filesystem
-            if ('.' != ent->d_name[0])
+            if ('.' != name[0])
             {
-                memmove(&buf[ent->d_namelen + 1], buf, namelen);    // overlapped mem
-                memcpy(&buf[1], ent->d_name, ent->d_namelen);
+                memmove(&buf[entlen + 1], buf, namelen);    // overlapped mem
+                memcpy(&buf[1], name, entlen);
             }
             else
                 len --;
@@ -218,7 +411,7 @@ char *getcwd(char *buf, size_t size)
             buf[len] = '\0';
             namelen = len;
 
-            KERNEL_mfree(dirp);
+            if (dirp) KERNEL_mfree(dirp);
 
             fd = parent_fd;
             parent_fd = (int)AsFD(fd)->glist_next;
@@ -343,34 +536,91 @@ int unlink(char const *pathname)
 
 int unlinkat(int dirfd, char const *pathname, int flags)
 {
-    int oflag;
-    if (AT_REMOVEDIR & flags)
-        oflag = O_DIRECTORY;
-    else
-        oflag = 0;
+    /// @split pathname into parent directory and the last name, trailing '/' are ignored
+    size_t pathlen = strlen(pathname);
+    while (1 < pathlen && '/' == pathname[pathlen - 1])
+        pathlen --;
+
+    size_t namepos = pathlen;
+    while (0 < namepos && '/' != pathname[namepos - 1])
+        namepos --;
+
+    size_t namelen = pathlen - namepos;
+    if (0 == namelen)
+        return __set_errno_neg(EBUSY);
+    if (NAME_MAX <= namelen)
+        return __set_errno_neg(ENAMETOOLONG);
+    if ((1 == namelen && '.' == pathname[namepos]) ||
+        (2 == namelen && '.' == pathname[namepos] && '.' == pathname[namepos + 1]))
+    {
+        return __set_errno_neg(EINVAL);
+    }
 
-    if (AT_FDCWD & flags)
-        oflag |= AT_FDCWD;
+    char *dirpath = KERNEL_malloc(namepos + 1);
+    if (! dirpath)
+        return __set_errno_neg(ENOMEM);
 
-    int fd = FS_openat(NULL, dirfd, pathname, oflag, 0);
-    if (-1 == fd)
-        return fd;
+    memcpy(dirpath, pathname, namepos);
+    dirpath[namepos] = '\0';
 
-    /// @acquire ino
-    ino_t ino = ((struct fsio_t *)AsFD(fd)->fsio)->ino_entry;
+    /// @resolve the entry in its parent directory, the entry itself is never opened, eg. device nodes
+    int parent_fd = FS_openat(NULL, dirfd, dirpath, O_DIRECTORY | (AT_FDCWD & flags), 0);
+    KERNEL_mfree(dirpath);
 
-    /// get @parent's filesystem it should always dirfd
-    struct KERNEL_fd *parent = AsFD(fd)->glist_next;
-    struct FS_implement const *fs = parent->fs;
-    void *ext = (struct fsio_t *)parent->fsio;
+    if (-1 == parent_fd)
+        return parent_fd;
 
-    // release fd's memory
-    close(fd);
+    struct FS_implement const *fs = AsFD(parent_fd)->fs;
+    struct fsio_t *fsio = AsFD(parent_fd)->fsio;
+    char const *name = &pathname[namepos];
+    int retval;
+
+    DIR *dirp = fdopendir(parent_fd);
+    if (! dirp)
+    {
+        retval = -1;
+        goto unlinkat_exit;
+    }
+
+    struct dirent *ent;
+    if (fs->lookup)
+    {
+        ent = (struct dirent *)(dirp + 1);
 
-    if (NULL == fs->unlink)
-        return __set_errno_neg(EROFS);
+        if (0 != fs->lookup(fsio, name, namelen, ent))
+            ent = NULL;
+    }
     else
-        return fs->unlink(ext, ino);
+    {
+        while (NULL != (ent = readdir(dirp)))
+        {
+            if (namelen == ent->d_namelen && 0 == strncmp(name, ent->d_name, namelen))
+                break;
+        }
+    }
+
+    if (! ent)
+        retval = __set_errno_neg(ENOENT);
+    else if (S_ISDIR(ent->d_mode) && ! (AT_REMOVEDIR & flags))
+        retval = __set_errno_neg(EISDIR);
+    else if (! S_ISDIR(ent->d_mode) && (AT_REMOVEDIR & flags))
+        retval = __set_errno_neg(ENOTDIR);
+    else if (NULL == fs->unlink)
+        retval = __set_errno_neg(EROFS);
+    else
+    {
+        ino_t ino = ent->d_ino;
+        mutex_t *lock = FS_inode_lock(fsio->data, fsio->ino_entry);
+
+        mutex_lock(lock);
+        retval = fs->unlink(fsio, ino);
+        mutex_unlock(lock);
+    }
+    KERNEL_mfree(dirp);
+
+unlinkat_exit:
+    close(parent_fd);
+    return retval;
 }
 
 int truncate(const char *path, off_t size)
@@ -388,10 +638,17 @@ int ftruncate(int fd, off_t size)
         return __set_errno_neg(EBADF);
 
     struct FS_implement const *fs = (struct FS_implement const *)AsFD(fd)->fs;
-    if (fs->truncate)
-        return fs->truncate(AsFD(fd)->fsio, size);
-    else
+    if (NULL == fs || NULL == fs->truncate)
         return __set_errno_neg(ENOSYS);
+
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    mutex_t *lock = FS_inode_lock(fsio->data, fsio->ino_entry);
+
+    mutex_lock(lock);
+    int retval = fs->truncate(fsio, size);
+    mutex_unlock(lock);
+
+    return retval;
 }
 
 /***************************************************************************/
@@ -489,7 +746,7 @@ void rewinddir(DIR *dirp)
     ((struct dirent *)(dirp + 1))->d_ino = INO_CURRENT_DIR;
 
     struct fsio_t *fsio = (struct fsio_t *)AsFD(dirp->fd)->fsio;
-    ext->ino_entry = ext->ino_working = INO_CURRENT_DIR;
+    fsio->ino_entry = fsio->ino_working = INO_CURRENT_DIR;
 }
 
 int dirfd(DIR *dir)
@@ -502,13 +759,128 @@ int alphasort(struct dirent const **a, struct dirent const **b)
     return strcoll((*a)->d_name, (*b)->d_name);
 }
 
+ssize_t getdents(int fd, void *buf, size_t count)
+{
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+        return __set_errno_neg(EBADF);
+    if (! (FD_TAG_DIR & AsFD(fd)->tag))
+        return __set_errno_neg(ENOTDIR);
+
+    struct FS_implement const *fs = AsFD(fd)->fs;
+    if (fs->getdents)
+        return fs->getdents(fd, buf, count);
+
+    /// @fallback: read() one entry each time in place, then packed
+    size_t filled = 0;
+
+    while (filled + fs->dirent_size <= count)
+    {
+        struct dirent *ent = (struct dirent *)((uint8_t *)buf + filled);
+
+        ssize_t retval = read(fd, ent, fs->dirent_size);
+        if (0 > retval)
+        {
+            if (0 == filled)
+                return retval;
+            else
+                break;
+        }
+        if (0 == retval)
+            break;
+
+        if (! ent->d_filesystem)
+            ent->d_filesystem = fs;
+        ent->d_name[ent->d_namelen] = '\0';
+
+        /// the last record's alignment padding may exceed count
+        filled += DIRENT_RECLEN(ent->d_namelen);
+        if (filled > count)
+            filled = count;
+    }
+
+    if (0 == filled && count < fs->dirent_size)
+        return __set_errno_neg(EINVAL);
+    else
+        return (ssize_t)filled;
+}
+
 int scandir(char const *pathname,
     struct dirent ***entrylist,
     int (* filter)(struct dirent const *),
     int (* compar)(struct dirent const **, struct dirent const **))
 {
-    ARG_UNUSED(pathname, entrylist, filter, compar);
-    return 0;
+    int fd = FS_openat(NULL, FS_context.working_dirfd, pathname, O_DIRECTORY, 0);
+    if (-1 == fd)
+        return fd;
+
+    struct FS_implement const *fs = AsFD(fd)->fs;
+    size_t bufsize = SCANDIR_BATCH_ENTRIES * (size_t)fs->dirent_size;
+    void *buf = KERNEL_malloc(bufsize);
+
+    int count = 0;
+    int alloc = 0;
+    int err = 0;
+
+    *entrylist = NULL;
+
+    if (! buf)
+        err = ENOMEM;
+    else
+    {
+        /// '.' and '..' as readdir() does
+        struct dirent *ent = buf;
+        memset(ent, 0, DIRENT_SIZE(3));
+
+        ent->d_filesystem = fs;
+        ent->d_mode = S_IFDIR | S_IRUSR  | S_IRGRP | S_IROTH;
+        ent->d_ino = INO_CURRENT_DIR;
+        ent->d_namelen = 1;
+        strcpy(ent->d_name, ".");
+        err = FS_scandir_append(entrylist, &count, &alloc, ent, filter);
+
+        if (0 == err)
+        {
+            ent->d_ino = INO_PARENT_DIR;
+            ent->d_namelen = 2;
+            strcpy(ent->d_name, "..");
+            err = FS_scandir_append(entrylist, &count, &alloc, ent, filter);
+        }
+
+        AsFD(fd)->position = 0;
+        while (0 == err)
+        {
+            ssize_t filled = getdents(fd, buf, bufsize);
+            if (0 > filled)
+                err = errno;
+            if (0 >= filled)
+                break;
+
+            for (size_t pos = 0; pos < (size_t)filled && 0 == err; pos += DIRENT_RECLEN(ent->d_namelen))
+            {
+                ent = (struct dirent *)((uint8_t *)buf + pos);
+                err = FS_scandir_append(entrylist, &count, &alloc, ent, filter);
+            }
+        }
+        KERNEL_mfree(buf);
+    }
+
+    if (FS_context.working_dirfd != fd)
+        close(fd);
+
+    if (0 != err)
+    {
+        for (int i = 0; i < count; i ++)
+            free((*entrylist)[i]);
+        free(*entrylist);
+
+        *entrylist = NULL;
+        return __set_errno_neg(err);
+    }
+
+    if (compar && 1 < count)
+        qsort(*entrylist, (size_t)count, sizeof(struct dirent *), (int (*)(void const *, void const *))compar);
+
+    return count;
 }
 
 /***************************************************************************/
@@ -516,24 +888,28 @@ int scandir(char const *pathname,
 ****************************************************************************/
 int stat(char const *restrict pathname, struct stat *restrict st)
 {
-    int fd = open(pathname, O_RDONLY);
+    /// O_DIRECTORY: allows directory, regular file is opened as it is
+    int fd = open(pathname, O_RDONLY | O_DIRECTORY);
+    if (-1 == fd)
+        return fd;
 
     int retval = fstat(fd, st);
-    close(fd);
+    if (FS_context.working_dirfd != fd)
+        close(fd);
     return retval;
 }
 
 int _fstat_r(struct _reent *r, int fd, struct stat *st)
 {
+    memset(st, 0, sizeof(*st));
+
     if (STDIN_FILENO == fd || STDOUT_FILENO == fd || STDERR_FILENO == fd)
     {
-        memset(st, 0, sizeof(*st));
-
         st->st_mode = S_IFCHR;
         return 0;
     }
 
-    if (CID_FD != AsFD(fd)->cid)
+    if (fd <= 0 || CID_FD != AsFD(fd)->cid)
         return __set_errno_r_neg(r, EBADF);
 
     if (FD_TAG_BLOCK & AsFD(fd)->tag)
@@ -551,7 +927,19 @@ int _fstat_r(struct _reent *r, int fd, struct stat *st)
     if (FD_TAG_SOCKET & AsFD(fd)->tag)
         st->st_mode |= S_IFSOCK;
 
-    // TODO: complete fstat() struct stat other fields
+    struct FS_implement const *fs = AsFD(fd)->fs;
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+
+    if (fs && fsio)
+    {
+        st->st_ino = fsio->ino_entry;
+        st->st_size = (off_t)fsio->size;
+        st->st_nlink = 1;
+
+        /// filesystem to complete times / permissions / live size
+        if (fs->fstat && 0 != fs->fstat(fsio, st))
+            return __set_errno_r_neg(r, errno);
+    }
     return 0;
 }
 
@@ -587,13 +975,13 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
 {
     if (NULL == r)
         r = __getreent();
-    if (NULL == FS_root)
-        return __set_errno_r_neg(r, ENOENT);
 
     char *name = KERNEL_malloc(NAME_MAX);
     char const *p = pathname;
 
-    int fd, parent_fd = 0;
+    int fd, parent_fd;
+    /// fd is caller's dirfd: it is never linked as parent nor released by path walking
+    bool borrowed = false;
 
     // ignore dirfd?
     if (AT_FDCWD & flags)
@@ -605,20 +993,37 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
         {
             if (*p) p ++;
 
-            struct fsio_t *fsio = FS_extbuf_alloc();
-            if (! ext)
+            if (NULL == FS_root)
             {
-                fd = __set_errno_r_neg(r, ENOMEM);
-                goto FS_openat_exit;
+                /// @no root filesystem: only mounts are reachable, the mount root acts as @rootdir
+                fd = FS_mount_open_path(r, &p);
+                if (-1 == fd)
+                    goto FS_openat_exit;
+            }
+            else
+            {
+                struct fsio_t *fsio = FS_extbuf_alloc();
+                if (! fsio)
+                {
+                    fd = __set_errno_r_neg(r, ENOMEM);
+                    goto FS_openat_exit;
+                }
+                fsio->ino_entry = fsio->ino_working = INO_CURRENT_DIR;
+                fsio->flags = flags;
+
+                fd = FS_root->open(fsio);
+                if (-1 == fd)
+                {
+                    FS_extbuf_release(fsio);
+                    goto FS_openat_exit;
+                }
+
+                AsFD(fd)->fs = FS_root;
+                AsFD(fd)->implement = FS_root->fsio;
+                FS_fsio_attach(fsio, NULL);
+                /// make @rootdir'parent self circulation link
+                AsFD(fd)->glist_next = (void *)fd;
             }
-            ext->ino_entry = ext->ino_working = INO_CURRENT_DIR;
-            ext->flags = flags;
-
-            fd = FS_root->open(ext);
-
-            AsFD(fd)->fs = FS_root;
-            /// make @rootdir'parent self circulation link
-            AsFD(fd)->glist_next = (void *)fd;
         }
         else
         {
@@ -626,12 +1031,21 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
             goto FS_openat_exit;
         }
     }
+    else if (NULL == AsFD(dirfd)->fs)
+    {
+        fd = __set_errno_r_neg(r, ENOTDIR);
+        goto FS_openat_exit;
+    }
     else
     {
         fd = dirfd;
-        parent_fd = (int)AsFD(fd)->glist_next;
+        borrowed = true;
     }
 
+    /**
+     *  path walking holds one reference of fd, the reference is moved to child fd when it was opened,
+     *      or returned to caller with the last of pathname
+     */
     while (true)
     {
         if (! (*p)) break;
@@ -640,7 +1054,15 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
         while (*p && *p != '/') p ++;
 
         size_t namelen = (size_t)(p - p1);
-        strlcpy(name, p1, namelen);
+        if (NAME_MAX <= namelen)
+        {
+            if (! borrowed)
+                FS_dirfd_put(fd);
+
+            fd = __set_errno_r_neg(r, ENAMETOOLONG);
+            goto FS_openat_exit;
+        }
+        memcpy(name, p1, namelen);
         name[namelen] = '\0';
 
         if (*p == '/')
@@ -648,49 +1070,128 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
 
         if (0 == strcmp("..", name))
         {
-            /// parent_fd is always exists due to @rootdir'parent is self circulation link
-            fd = parent_fd;
             parent_fd = (int)AsFD(fd)->glist_next;
 
-            fchdir(fd);
+            /// @rootdir'parent is self circulation link
+            if (parent_fd != fd)
+            {
+                __atomic_add_fetch(&AsFsio(AsFD(parent_fd)->fsio)->refs, 1, __ATOMIC_RELAXED);
+
+                if (! borrowed)
+                    FS_dirfd_put(fd);
+
+                fd = parent_fd;
+                borrowed = false;
+            }
             continue;
         }
         else if (0 == strcmp(".", name))
             continue;
 
+        /// fd is going to be parent
+        if (borrowed)
+        {
+            fd = FS_dirfd_dup(r, fd);
+            if (-1 == fd)
+                goto FS_openat_exit;
+
+            borrowed = false;
+        }
+
+        /// @mount: '/name' and '/mnt/name' are resolved before the root filesystem
+        if ((int)AsFD(fd)->glist_next == fd && FS_root == AsFD(fd)->fs)
+        {
+            char const *p2 = p;
+            struct FS_mount *mount = FS_mount_acquire(name, namelen, true);
+
+            if (! mount && *p && 0 == strcmp(FILESYSTEM_MOUNT_DIR, name))
+            {
+                while (*p2 && *p2 != '/') p2 ++;
+                mount = FS_mount_acquire(p, (size_t)(p2 - p), false);
+            }
+
+            if (mount)
+            {
+                int mount_fd = FS_mount_open(r, mount);
+                FS_mount_release(mount);
+
+                if (-1 == mount_fd)
+                {
+                    FS_dirfd_put(fd);
+
+                    fd = -1;
+                    goto FS_openat_exit;
+                }
+                AsFD(mount_fd)->glist_next = (void *)fd;
+                fd = mount_fd;
+
+                p = p2;
+                if (*p == '/')
+                    p ++;
+                continue;
+            }
+        }
+
         DIR *dirp = fdopendir(fd);
         if (! dirp)
         {
-            close(fd);
+            FS_dirfd_put(fd);
 
             fd = __set_errno_r_neg(r, ENOTDIR);
             goto FS_openat_exit;
         }
         parent_fd = fd;
 
+        struct FS_implement const *fs = (struct FS_implement const *)AsFD(parent_fd)->fs;
+        struct fsio_t *parent_fsio = AsFD(parent_fd)->fsio;
         struct dirent *ent;
-        while (NULL != (ent = readdir(dirp)))
+
+        /// @serialize lookup & create() in the same directory, O_CREAT only on the last of pathname
+        mutex_t *create_lock = NULL;
+        if (! *p && (O_CREAT & flags))
         {
-            if (namelen == ent->d_namelen && 0 == strncmp(name, ent->d_name, namelen))
-                break;
+            create_lock = FS_inode_lock(parent_fsio->data, parent_fsio->ino_entry);
+            mutex_lock(create_lock);
+        }
+
+        if (fs->lookup)
+        {
+            /// @lookup by filesystem instead of readdir() enumeration
+            ent = (struct dirent *)(dirp + 1);
+
+            if (0 != fs->lookup(AsFD(parent_fd)->fsio, name, namelen, ent))
+                ent = NULL;
+            else if (! ent->d_filesystem)
+                ent->d_filesystem = fs;
+        }
+        else
+        {
+            while (NULL != (ent = readdir(dirp)))
+            {
+                if (namelen == ent->d_namelen && 0 == strncmp(name, ent->d_name, namelen))
+                    break;
+            }
         }
 
         struct fsio_t *fsio = FS_extbuf_alloc();
-        if (! ext)
+        if (! fsio)
         {
-            close(fd);
+            if (create_lock)
+                mutex_unlock(create_lock);
+            FS_dirfd_put(parent_fd);
             KERNEL_mfree(dirp);
 
             fd = __set_errno_r_neg(r, ENOMEM);
             goto FS_openat_exit;
         }
-        ext->ino_entry = ext->ino_working = INO_CURRENT_DIR;
-        ext->data = ((struct fsio_t *)AsFD(fd)->fsio)->data;
+        fsio->ino_entry = fsio->ino_working = INO_CURRENT_DIR;
+        fsio->data = parent_fsio->data;
 
-        struct FS_implement const *fs = (struct FS_implement const *)AsFD(parent_fd)->fs;
         if (! ent)
         {
-            ext->flags = flags & (~O_TRUNC);
+            fsio->flags = flags & (~O_TRUNC);
+            /// create() to know which directory it was creating in
+            fsio->ino_working = parent_fsio->ino_entry;
 
             /// checking last of pathname and O_CREAT
             if (*p || ! (O_CREAT & flags))
@@ -698,96 +1199,177 @@ static int FS_openat(struct _reent *r, int dirfd, char const *pathname, int flag
             else if (NULL == fs->create)
                 fd = __set_errno_r_neg(r, EROFS);
             else
-                fd = fs->create(ext, name, mode);
+                fd = fs->create(fsio, name, mode);
+        }
+        else if (! *p && (O_CREAT & flags) && (O_EXCL & flags))
+        {
+            fd = __set_errno_r_neg(r, EEXIST);
         }
         else
         {
-            ext->ino_entry = ext->ino_working = ent->d_ino;
-            ext->size = ent->d_size;
-            ext->flags = flags & (~O_CREAT);
+            fsio->ino_entry = fsio->ino_working = ent->d_ino;
+            fsio->size = ent->d_size;
+            fsio->flags = flags & (~O_CREAT);
 
-            fd = fs->open(ext);
             // fd's filesystem should be ent->d_filesystem
             fs = ent->d_filesystem;
+            fd = fs->open(fsio);
         }
         KERNEL_mfree(dirp);
 
+        if (create_lock)
+            mutex_unlock(create_lock);
+
         if (fd < 0)
         {
-            if (parent_fd != dirfd)
-                close(parent_fd);
+            FS_extbuf_release(fsio);
+            FS_dirfd_put(parent_fd);
             goto FS_openat_exit;
         }
+        else if (AsFD(fd)->fsio != fsio)
+        {
+            /// @device node: fd was created by driver with its own ext, it is not a filesystem fd
+            ///     close() of driver never reaches FILESYSTEM_fd_cleanup(), it holds no parent
+            FS_extbuf_release(fsio);
+            FS_dirfd_put(parent_fd);
+            AsFD(fd)->glist_next = (void *)fd;
+        }
         else
         {
             AsFD(fd)->glist_next = (void *)parent_fd;
 
             AsFD(fd)->fs = fs;
             AsFD(fd)->implement = fs->fsio;
+            FS_fsio_attach(fsio, AsFsio(parent_fsio)->mount);
         }
     }
 
-    if (FD_TAG_DIR & AsFD(fd)->tag)
+    if ((FD_TAG_DIR & AsFD(fd)->tag) && ! (O_DIRECTORY & flags))
     {
-        if (! (O_DIRECTORY & flags))
-        {
-            if (fd != dirfd)
-                close(fd);
-            fd = __set_errno_r_neg(r, ENOTDIR);
-        }
-        else
-        {
-            /// @rewinddir
-            AsFD(fd)->position = 0;
-        }
+        if (! borrowed)
+            FS_dirfd_put(fd);
+        fd = __set_errno_r_neg(r, ENOTDIR);
+    }
+    else if (borrowed)
+    {
+        /// pathname resolved to dirfd itself
+        fd = FS_dirfd_dup(r, fd);
+    }
+    else if (NULL != AsFD(fd)->fs && 1 < __atomic_load_n(&AsFsio(AsFD(fd)->fsio)->refs, __ATOMIC_ACQUIRE))
+    {
+        /// pathname went back to a linked parent by '..'
+        int dup_fd = FS_dirfd_dup(r, fd);
+        FS_dirfd_put(fd);
+        fd = dup_fd;
+    }
+
+    if (-1 != fd && (FD_TAG_DIR & AsFD(fd)->tag))
+    {
+        /// @rewinddir
+        AsFD(fd)->position = 0;
     }
-    else
-        FS_dirfd_link_cleanup(dirfd, fd);
 
 FS_openat_exit:
     free(name);
     return fd;
 }
 
-static void FS_dirfd_link_cleanup(int base_dirfd, int fd)
+static int FS_dirfd_dup(struct _reent *r, int fd)
 {
-    if (-1 == base_dirfd)
-        base_dirfd = FS_context.working_dirfd;
+    if (NULL == AsFD(fd)->fs || ! (FD_TAG_DIR & AsFD(fd)->tag))
+        return __set_errno_r_neg(r, ENOTDIR);
+
+    struct fsio_t *fsio = FS_extbuf_alloc();
+    if (! fsio)
+        return __set_errno_r_neg(r, ENOMEM);
+
+    struct FS_implement const *fs = AsFD(fd)->fs;
+    *fsio = *(struct fsio_t *)AsFD(fd)->fsio;
+    fsio->flags = O_RDONLY | O_DIRECTORY;
+    fsio->fd_data = NULL;
 
-    struct KERNEL_fd *dirfd_iter = AsFD(fd)->glist_next;
+    int dup_fd = fs->open(fsio);
+    if (-1 == dup_fd)
+    {
+        FS_extbuf_release(fsio);
+        return dup_fd;
+    }
+
+    AsFD(dup_fd)->fs = fs;
+    AsFD(dup_fd)->implement = fs->fsio;
+    FS_fsio_attach(fsio, AsFsio(AsFD(fd)->fsio)->mount);
 
-    /// opened @rootdir'parent is a self circulation link
-    while (fd != (int)dirfd_iter && base_dirfd != (int)dirfd_iter)
+    int parent_fd = (int)AsFD(fd)->glist_next;
+    if (parent_fd == fd)
+    {
+        /// @rootdir'parent is self circulation link
+        AsFD(dup_fd)->glist_next = (void *)dup_fd;
+    }
+    else
     {
-        fd = (int)dirfd_iter;
-        dirfd_iter = dirfd_iter->glist_next;
+        __atomic_add_fetch(&AsFsio(AsFD(parent_fd)->fsio)->refs, 1, __ATOMIC_RELAXED);
+        AsFD(dup_fd)->glist_next = (void *)parent_fd;
+    }
+    return dup_fd;
+}
 
+static void FS_dirfd_put(int fd)
+{
+    /// @device node has no parent
+    if (NULL == AsFD(fd)->fs)
+    {
+        close(fd);
+        return;
+    }
+
+    while (0 == __atomic_sub_fetch(&AsFsio(AsFD(fd)->fsio)->refs, 1, __ATOMIC_ACQ_REL))
+    {
+        int parent_fd = (int)AsFD(fd)->glist_next;
         FS_dirfd_cleanup(fd);
+
+        /// @rootdir'parent is self circulation link
+        if (parent_fd == fd)
+            break;
+        fd = parent_fd;
     }
 }
 
 static void FS_dirfd_cleanup(int fd)
 {
-    FS_extbuf_release(AsFD(fd)->fsio);
+    FS_fsio_release(AsFD(fd)->fsio);
 
     /// @prevent KERNEL_handle_release() @recursive call FILESYSTEM_fd_cleanup()
     AsFD(fd)->fs = NULL;
     KERNEL_handle_release((void *)fd);
 }
 
+static void FS_set_working_dirfd(int fd)
+{
+    int old_dirfd = FS_context.working_dirfd;
+    FS_context.working_dirfd = fd;
+
+    if (-1 != old_dirfd)
+        close(old_dirfd);
+}
+
 static void *FS_extbuf_alloc(void)
 {
-    FILESYSTEM_lock();
-    struct fsio_t *ptr = glist_pop(&FS_context.ext_buf_list);
+    spin_lock(&FS_context.ext_buf_atomic);
+    struct FS_fsio *ptr = glist_pop(&FS_context.ext_buf_list);
+    spin_unlock(&FS_context.ext_buf_atomic);
 
     if (! ptr)
     {
+        /// @malloc outside the spinlock
         ptr = malloc(sizeof(FS_context.prealloc) / 2);
+        if (! ptr)
+            return NULL;
 
+        spin_lock(&FS_context.ext_buf_atomic);
         for (size_t i = 1; i < lengthof(FS_context.prealloc) / 2; i ++)
             glist_push_back(&FS_context.ext_buf_list, &ptr[i]);
+        spin_unlock(&FS_context.ext_buf_atomic);
     }
-    FILESYSTEM_unlock();
 
     memset(ptr, 0, sizeof(*ptr));
     return ptr;
@@ -795,12 +1377,173 @@ static void *FS_extbuf_alloc(void)
 
 static void FS_extbuf_release(void *ptr)
 {
-    if (0 == __get_IPSR())
+    spin_lock(&FS_context.ext_buf_atomic);
+    glist_push_back(&FS_context.ext_buf_list, ptr);
+    spin_unlock(&FS_context.ext_buf_atomic);
+}
+
+static void FS_fsio_attach(struct fsio_t *fsio, struct FS_mount *mount)
+{
+    AsFsio(fsio)->mount = mount;
+    AsFsio(fsio)->refs = 1;
+
+    if (mount)
+        __atomic_add_fetch(&mount->opened, 1, __ATOMIC_RELAXED);
+}
+
+static void FS_fsio_release(struct fsio_t *fsio)
+{
+    struct FS_mount *mount = AsFsio(fsio)->mount;
+    FS_extbuf_release(fsio);
+
+    if (mount)
+        __atomic_sub_fetch(&mount->opened, 1, __ATOMIC_RELEASE);
+}
+
+static int FS_scandir_append(struct dirent ***entrylist, int *count, int *alloc,
+    struct dirent const *ent, int (* filter)(struct dirent const *))
+{
+    if (filter && ! filter(ent))
+        return 0;
+
+    if (*count == *alloc)
     {
-        FILESYSTEM_lock();
-        glist_push_back(&FS_context.ext_buf_list, ptr);
-        FILESYSTEM_unlock();
+        int new_alloc = *alloc ? *alloc * 2 : 16;
+        struct dirent **list = realloc(*entrylist, (size_t)new_alloc * sizeof(struct dirent *));
+
+        if (! list)
+            return ENOMEM;
+
+        *entrylist = list;
+        *alloc = new_alloc;
     }
-    else
-        glist_push_back(&FS_context.ext_buf_list, ptr);
+
+    size_t reclen = DIRENT_RECLEN(ent->d_namelen);
+    struct dirent *dup = malloc(reclen);
+    if (! dup)
+        return ENOMEM;
+
+    memcpy(dup, ent, reclen);
+    (*entrylist)[(*count) ++] = dup;
+    return 0;
+}
+
+static struct FS_mount *FS_mount_acquire(char const *name, size_t namelen, bool toplevel)
+{
+    for (unsigned i = 0; i < lengthof(FS_context.mounts); i ++)
+    {
+        struct FS_mount *mount = &FS_context.mounts[i];
+
+        if (FS_MOUNT_MOUNTED != __atomic_load_n(&mount->state, __ATOMIC_ACQUIRE))
+            continue;
+
+        __atomic_add_fetch(&mount->readers, 1, __ATOMIC_SEQ_CST);
+        /// @recheck: unmount() may started before readers was counted
+        if (FS_MOUNT_MOUNTED == __atomic_load_n(&mount->state, __ATOMIC_SEQ_CST) &&
+            toplevel == mount->toplevel && namelen == mount->namelen && 0 == memcmp(name, mount->name, namelen))
+        {
+            return mount;
+        }
+        FS_mount_release(mount);
+    }
+    return NULL;
+}
+
+static struct FS_mount *FS_mount_acquire_root(int fd, int parent_fd)
+{
+    /// mount roots are linked to @rootdir
+    if ((int)AsFD(parent_fd)->glist_next != parent_fd)
+        return NULL;
+
+    for (unsigned i = 0; i < lengthof(FS_context.mounts); i ++)
+    {
+        struct FS_mount *mount = &FS_context.mounts[i];
+
+        if (FS_MOUNT_MOUNTED != __atomic_load_n(&mount->state, __ATOMIC_ACQUIRE))
+            continue;
+
+        __atomic_add_fetch(&mount->readers, 1, __ATOMIC_SEQ_CST);
+        if (FS_MOUNT_MOUNTED == __atomic_load_n(&mount->state, __ATOMIC_SEQ_CST) &&
+            AsFD(fd)->fs == mount->fs && ((struct fsio_t *)AsFD(fd)->fsio)->data == mount->data)
+        {
+            return mount;
+        }
+        FS_mount_release(mount);
+    }
+    return NULL;
+}
+
+static void FS_mount_release(struct FS_mount *mount)
+{
+    /// @wakeup unmount() by the last reader
+    if (0 == __atomic_sub_fetch(&mount->readers, 1, __ATOMIC_SEQ_CST) &&
+        FS_MOUNT_UNMOUNTING == __atomic_load_n(&mount->state, __ATOMIC_SEQ_CST))
+    {
+        sem_post(&mount->drained);
+    }
+}
+
+static int FS_mount_open(struct _reent *r, struct FS_mount *mount)
+{
+    struct fsio_t *fsio = FS_extbuf_alloc();
+    if (! fsio)
+        return __set_errno_r_neg(r, ENOMEM);
+
+    fsio->ino_entry = fsio->ino_working = INO_CURRENT_DIR;
+    fsio->flags = O_RDONLY | O_DIRECTORY;
+    fsio->data = mount->data;
+
+    int fd = mount->fs->open(fsio);
+    if (-1 == fd)
+    {
+        FS_extbuf_release(fsio);
+        return fd;
+    }
+
+    AsFD(fd)->fs = mount->fs;
+    AsFD(fd)->implement = mount->fs->fsio;
+    FS_fsio_attach(fsio, mount);
+    return fd;
+}
+
+static int FS_mount_open_path(struct _reent *r, char const **pathname)
+{
+    char const *p = *pathname;
+    char const *p1 = p;
+    while (*p && *p != '/') p ++;
+
+    struct FS_mount *mount = FS_mount_acquire(p1, (size_t)(p - p1), true);
+
+    if (! mount && '/' == *p && (size_t)(p - p1) == sizeof(FILESYSTEM_MOUNT_DIR) - 1 &&
+        0 == memcmp(FILESYSTEM_MOUNT_DIR, p1, sizeof(FILESYSTEM_MOUNT_DIR) - 1))
+    {
+        p1 = ++ p;
+        while (*p && *p != '/') p ++;
+        mount = FS_mount_acquire(p1, (size_t)(p - p1), false);
+    }
+    if (! mount)
+        return __set_errno_r_neg(r, ENOENT);
+
+    int fd = FS_mount_open(r, mount);
+    FS_mount_release(mount);
+
+    if (-1 != fd)
+    {
+        /// mount root of no root filesystem is the @rootdir'parent self circulation link
+        AsFD(fd)->glist_next = (void *)fd;
+
+        if (*p == '/')
+            p ++;
+        *pathname = p;
+    }
+    return fd;
+}
+
+static mutex_t *FS_inode_lock(void const *data, ino_t ino)
+{
+    uintptr_t hash = ((uintptr_t)data >> 2) ^ (uintptr_t)ino;
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+
+    return &FS_context.inode_locks[hash % FS_INODE_LOCK_STRIPES];
 }
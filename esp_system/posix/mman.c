@@ -0,0 +1,72 @@
+#include <sys/errno.h>
+#include <sys/mman.h>
+
+#include <rtos/kernel.h>
+
+#include "mmu.h"
+
+/***************************************************************************/
+/** @implements mman.h
+****************************************************************************/
+void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t off)
+{
+    ARG_UNUSED(addr);
+    int err;
+
+    if (0 >= fd || CID_FD != AsFD(fd)->cid)
+    {
+        err = EBADF;
+        goto mmap_error_exit;
+    }
+    if (0 == len || (MAP_FIXED & flags) || ! ((MAP_SHARED | MAP_PRIVATE) & flags))
+    {
+        err = EINVAL;
+        goto mmap_error_exit;
+    }
+    if ((PROT_WRITE | PROT_EXEC) & prot)
+    {
+        err = ENOTSUP;
+        goto mmap_error_exit;
+    }
+
+    struct FD_implement const *implement = AsFD(fd)->implement;
+    if (NULL == implement->flash_addr)
+    {
+        err = ENODEV;
+        goto mmap_error_exit;
+    }
+
+    uintptr_t paddr;
+    size_t count = len;
+
+    err = implement->flash_addr(fd, off, &paddr, &count);
+    if (0 != err)
+        goto mmap_error_exit;
+    /// @file's storage must be contiguous in flash
+    if (count < len)
+    {
+        err = ENODEV;
+        goto mmap_error_exit;
+    }
+
+    void const *vaddr = MMU_map_flash(paddr, len);
+    if (NULL == vaddr)
+        return MAP_FAILED;
+    else
+        return (void *)vaddr;
+
+mmap_error_exit:
+    errno = err;
+    return MAP_FAILED;
+}
+
+int munmap(void *addr, size_t len)
+{
+    ARG_UNUSED(len);
+
+    int err = MMU_unmap(addr);
+    if (0 == err)
+        return 0;
+    else
+        return __set_errno_neg(err);
+}
@@ -15,13 +15,26 @@
 #include <rtos/kernel.h>
 #include <semaphore.h>
 #include <string.h>
+#include <sys/limits.h>
 #include <unistd.h>
+#include <ringbuf.h>
 
 #include <mqueue.h>
+#include <rtos/procfs.h>
 
 /***************************************************************************/
 /** @def
 ****************************************************************************/
+/// mqueue namespace: power of 2
+#ifndef MQUEUE_NAME_BUCKETS
+    #define MQUEUE_NAME_BUCKETS         (32)
+#endif
+
+/// SIGEV_THREAD notifications queued to the notification worker
+#ifndef MQUEUE_NOTIFY_PENDING
+    #define MQUEUE_NOTIFY_PENDING       (16)
+#endif
+
 struct MQ_msg
 {
     struct MQ_msg *glist_next;
@@ -29,6 +42,8 @@ struct MQ_msg
 
     uint8_t payload[sizeof(uintptr_t)];
 };
+#define AsMsg(payload)                  \
+    ((struct MQ_msg *)((uint8_t *)(payload) - offsetof(struct MQ_msg, payload)))
 
 struct MQ_list
 {
@@ -37,14 +52,116 @@ struct MQ_list
     glist_t list;
 };
 
-struct MQ_ext
+/**
+ *  queued messages: a FIFO for each priority
+ *      .bit n of bitmap is set when fifo[n] is not empty, find-first-set picks the next to receive
+ *      .smaller prio is received first
+ */
+struct MQ_prio_queue
+{
+    sem_t sema;
+    spinlock_t lock;
+    uint32_t bitmap;
+    glist_t fifo[MQ_PRIO_MAX];
+};
+_Static_assert(MQ_PRIO_MAX <= 32, "bitmap of MQ_prio_queue");
+
+/**
+ *  MQUEUE_FLAG_RING: bounded queue of cells
+ *      .MPMC: a cell is claimed by CAS of head / tail, and published by its seq
+ *      .SPSC: head is only written by receiver and tail only by sender
+ */
+struct MQ_cell
+{
+    /// @MPMC: seq == position to send, seq == position + 1 to receive
+    uint32_t seq;
+    unsigned int prio;
+
+    uint8_t payload[sizeof(uintptr_t)];
+};
+#define AsCell(payload)                 \
+    ((struct MQ_cell *)((uint8_t *)(payload) - offsetof(struct MQ_cell, payload)))
+
+#define MQ_NOTIFY_NONE                  (0)
+#define MQ_NOTIFY_ARMED                 (1)
+
+struct MQ_notification
+{
+    void (* function)(union sigval);
+    union sigval value;
+};
+
+struct MQ_ring
+{
+    /// positions of next receive / send, cell index is (position & mask)
+    uint32_t head;
+    uint32_t tail;
+    uint32_t mask;
+    uint32_t cell_size;
+
+    /// tasks blocked by empty / full, semaphores are only given when anyone is waiting
+    uint16_t rd_waiters;
+    uint16_t wr_waiters;
+    sem_t readable;
+    sem_t writable;
+};
+
+/**
+ *  MQUEUE_FLAG_VARLEN: messages of their own length in a byte budget of esp_ringbuf
+ *      .esp_ringbuf is never blocked in, tasks are blocked by readable / writable as MQ_ring
+ *      .NOSPLIT: item is prio leading the payload
+ *      .ALLOWSPLIT: item is the payload only
+ */
+struct MQ_varlen
 {
-    struct MQ_list queued;
-    struct MQ_list freed;
-    unsigned int lowest_prio_queued;
+    RingbufHandle_t rb;
+    StaticRingbuffer_t rb_static;
+    uint32_t bytes;
+    uint32_t queued;
+
+    uint16_t rd_waiters;
+    uint16_t wr_waiters;
+    sem_t readable;
+    sem_t writable;
+};
+#define MQ_VARLEN_PRIO_SIZE             (sizeof(uint32_t))
+
+struct MQ_varlen_io
+{
+    void *buf;
+    size_t count;
+    unsigned int prio;
+};
 
+struct MQ_ext
+{
     uint16_t msg_max;
     uint16_t msg_size;
+    uint32_t flags;
+    /// hash of KERNEL_mqd::name, compared before strcmp()
+    uint32_t name_hash;
+
+    /// @list: tasks blocked in receiving, the ring counts rd_waiters itself
+    uint16_t receivers;
+    /**
+     *  mq_notify() registration
+     *      .notify_state and notification are read / written together under notify_lock
+     *      .MQ_NOTIFY_ARMED: taken by the first sender, it copies and clears the registration
+     */
+    spinlock_t notify_lock;
+    uint8_t notify_state;
+    struct sigevent notification;
+
+    union
+    {
+        struct
+        {
+            struct MQ_prio_queue queued;
+            struct MQ_list freed;
+        };
+        struct MQ_ring ring;
+        struct MQ_varlen varlen;
+    };
 
     uint8_t __msg_start[sizeof(uint32_t)];
 };
@@ -52,16 +169,66 @@ struct MQ_ext
 /***************************************************************************/
 /** @internal
 ****************************************************************************/
-static int SVC_mq_find(char const *name, bool extract);
+static int MQ_create(char const *name, struct MQ_ext *ext, handle_t read_rdy, handle_t write_rdy);
+
+static uint32_t MQ_name_hash(char const *name);
+static struct KERNEL_mqd **MQ_name_slot(char const *name, uint32_t hash);
+static int MQ_name_lookup(char const *name);
+static void MQ_name_remove(struct KERNEL_mqd *mqd);
+static void MQ_name_synchronize(void);
 
-static struct MQ_msg *SVC_mqueue_get(struct MQ_list *queue, struct MQ_ext *ext);
-static void SVC_mqueue_post(struct MQ_list *queue, struct MQ_msg *msg, struct MQ_ext *ext);
+static struct MQ_msg *SVC_mqueue_get(struct MQ_list *queue);
 static void SVC_mqueue_release(struct MQ_list *queue, struct MQ_msg *msg);
+static struct MQ_msg *SVC_mqueue_pop(struct MQ_prio_queue *queue);
+static struct MQ_msg *SVC_mqueue_dequeue(struct MQ_prio_queue *queue);
+static void SVC_mqueue_enqueue(struct MQ_prio_queue *queue, struct MQ_msg *msg);
+
+static void *MQ_send_acquire(struct MQ_ext *ext, size_t count, uint32_t timeout);
+static void MQ_send_commit(struct MQ_ext *ext, void *payload, unsigned int prio);
+static void *MQ_recv_borrow(struct MQ_ext *ext, uint32_t timeout, unsigned int *prio);
+static void MQ_recv_release(struct MQ_ext *ext, void *payload);
+static ssize_t MQ_send_batch(struct MQ_ext *ext, uint8_t const *buf, size_t msg_count, unsigned int prio,
+    uint32_t timeout);
+static ssize_t MQ_recv_batch(struct MQ_ext *ext, uint8_t *buf, size_t msg_count, unsigned int *prio,
+    uint32_t timeout);
+static uint32_t MQ_timeo(int mqd, uint32_t timeo);
+static uint32_t MQ_queued(struct MQ_ext *ext);
+static int MQ_wait_queued(struct MQ_ext *ext, uint32_t timeout);
+
+static void MQ_notify(struct MQ_ext *ext);
+static int MQ_notifier_start(void);
+static void *MQ_notifier_routine(void *arg);
+
+static void MQ_ring_init(struct MQ_ext *ext, uint32_t capacity, size_t cell_size);
+static struct MQ_cell *MQ_ring_cell(struct MQ_ext *ext, uint32_t pos);
+static struct MQ_cell *MQ_ring_claim_send(struct MQ_ext *ext);
+static void MQ_ring_publish(struct MQ_ext *ext, struct MQ_cell *cell);
+static struct MQ_cell *MQ_ring_claim_recv(struct MQ_ext *ext);
+static void MQ_ring_free(struct MQ_ext *ext, struct MQ_cell *cell);
+static struct MQ_cell *MQ_ring_wait(struct MQ_ext *ext, struct MQ_cell *(* claim)(struct MQ_ext *),
+    uint16_t *waiters, sem_t *sema, uint32_t timeout);
+static uint32_t MQ_ring_queued(struct MQ_ext *ext);
+static void MQ_ring_signal(uint16_t *waiters, sem_t *sema);
+
+static ssize_t MQ_varlen_send(struct MQ_ext *ext, void const *msg, size_t count, unsigned int prio,
+    uint32_t timeout);
+static ssize_t MQ_varlen_recv(struct MQ_ext *ext, void *buf, size_t bufsize, unsigned int *prio,
+    uint32_t timeout);
+static bool MQ_varlen_wait(struct MQ_ext *ext, bool (* attempt)(struct MQ_ext *, struct MQ_varlen_io *),
+    struct MQ_varlen_io *io, uint16_t *waiters, sem_t *sema, uint32_t timeout);
+static bool MQ_varlen_try_send(struct MQ_ext *ext, struct MQ_varlen_io *io);
+static bool MQ_varlen_try_recv(struct MQ_ext *ext, struct MQ_varlen_io *io);
+static bool MQ_varlen_try_acquire(struct MQ_ext *ext, struct MQ_varlen_io *io);
+static bool MQ_varlen_try_borrow(struct MQ_ext *ext, struct MQ_varlen_io *io);
+static void MQ_varlen_sent(struct MQ_ext *ext);
+static void MQ_varlen_received(struct MQ_ext *ext);
 
 static int mqd_close(int mqd);
 static ssize_t mqd_read(int mqd, void *buf, size_t bufsize);
 static ssize_t mqd_write(int mqd, void const *buf, size_t count);
 
+static void mq_procfs(struct PROCFS_output *out, void *arg);
+
 /// @const
 static struct FD_implement const mqdio =
 {
@@ -71,66 +238,165 @@ static struct FD_implement const mqdio =
 };
 
 /// @var
-static glist_t mq_list = GLIST_INITIALIZER(mq_list);
-static spinlock_t mq_list_lock = SPINLOCK_INITIALIZER;
+/**
+ *  mqueue namespace
+ *      .KERNEL_mqd are chained by glist_next in buckets of their name hash
+ *      .lookups are lock-free, create / unlink are serialized by the mutex: no interrupt is disabled
+ *      .unlinked mqd is freed after all lookups in progress were finished
+ *      .lookups count themselves in readers[] of the epoch they started, synchronizing moves the epoch
+ *          and waits only readers of the previous one, the last of them posts drained
+ */
+static struct
+{
+    mutex_t lock;
+    mutex_t sync_lock;
+    uint32_t epoch;
+    uint32_t readers[2];
+    sem_t drained;
+    struct KERNEL_mqd *buckets[MQUEUE_NAME_BUCKETS];
+} MQ_names =
+{
+    .lock = MUTEX_INITIALIZER,
+    .sync_lock = MUTEX_INITIALIZER,
+    .drained = SEMA_INITIALIZER(0, 1),
+};
+
+/// SIGEV_THREAD notifications of all mqueues are called by one worker
+static struct
+{
+    mutex_t start_lock;
+    thread_id_t thread;
+
+    sem_t pending_sema;
+    spinlock_t lock;
+    uint8_t head;
+    uint8_t count;
+    struct MQ_notification pending[MQUEUE_NOTIFY_PENDING];
+    /// notifications queued to the worker, and those found pending full, both under lock
+    uint32_t queued;
+    uint32_t overflows;
+} MQ_notifier =
+{
+    .start_lock = MUTEX_INITIALIZER,
+    .pending_sema = SEMA_INITIALIZER(0, MQUEUE_NOTIFY_PENDING),
+    .lock = SPINLOCK_INITIALIZER,
+};
+
+/***************************************************************************/
+/** @constructor
+****************************************************************************/
+#ifdef __GNUC__
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmissing-prototypes"
+#endif
+
+__attribute__((constructor, nothrow))
+static void MQUEUE_initialize(void)
+{
+    PROCFS_register("mqueue", mq_procfs, NULL);
+}
+
+#ifdef __GNUC__
+    #pragma GCC diagnostic pop
+#endif
 
 /***************************************************************************/
 /** @implements ultracore.h
 ****************************************************************************/
 int mqueue_create(char const *name, uint16_t msg_size, uint16_t msg_count)
+{
+    return mqueue_create_np(name, msg_size, msg_count, 0);
+}
+
+int mqueue_create_np(char const *name, uint16_t msg_size, uint16_t msg_count, uint32_t flags)
 {
     if (msg_size > MQUEUE_MAX_MSG_SIZE || msg_count > MQUEUE_MAX_MSG)
         return __set_errno_neg(EINVAL);
 
-    size_t __msg_size = msg_size + offsetof(struct MQ_msg, payload);
+    size_t __msg_size;
+    uint32_t capacity = msg_count;
+
+    if (MQUEUE_FLAG_RING & flags)
+    {
+        if (0 == msg_count)
+            return __set_errno_neg(EINVAL);
+
+        /// power of 2: positions are free running uint32_t
+        for (capacity = 1; capacity < msg_count; capacity <<= 1);
+
+        __msg_size = (msg_size + offsetof(struct MQ_cell, payload) + sizeof(uint32_t) - 1) &
+            ~(sizeof(uint32_t) - 1);
+    }
+    else
+        __msg_size = msg_size + offsetof(struct MQ_msg, payload);
 
-    struct MQ_ext *ext = KERNEL_mallocz(offsetof(struct MQ_ext, __msg_start) + __msg_size * msg_count);
+    struct MQ_ext *ext = KERNEL_mallocz(offsetof(struct MQ_ext, __msg_start) + __msg_size * capacity);
     if (NULL == ext)
         return __set_errno_neg(ENOMEM);
 
-    spin_lock(&mq_list_lock);
+    // store attr
+    ext->msg_max = (uint16_t)capacity;
+    ext->msg_size = msg_size;
+    ext->flags = flags & MQUEUE_FLAG_SPSC;
 
-    int mqd = SVC_mq_find(name, false);
-    if (-1 != mqd)
+    if (MQUEUE_FLAG_RING & flags)
     {
-        spin_unlock(&mq_list_lock);
-        return __set_errno_neg(EEXIST);
+        MQ_ring_init(ext, capacity, __msg_size);
+        return MQ_create(name, ext, &ext->ring.readable, &ext->ring.writable);
     }
-
-    mqd = KERNEL_createfd(FD_TAG_MQD, &mqdio, ext);
-    if (-1 != mqd)
+    else
     {
-        AsMqd(mqd)->name = name;
-
-        // store attr
-        ext->msg_max = msg_count;
-        ext->msg_size = msg_size;
-        ext->lowest_prio_queued = 0;
-
         // none queued at beginning
         sem_init(&ext->queued.sema, 0, 0);
         spinlock_init(&ext->queued.lock);
-        glist_initialize(&ext->queued.list);
+        ext->queued.bitmap = 0;
+        for (unsigned i = 0; i < lengthof(ext->queued.fifo); i ++)
+            glist_initialize(&ext->queued.fifo[i]);
 
         // all freed at beginning
         sem_init(&ext->freed.sema, 0, msg_count);
         spinlock_init(&ext->freed.lock);
         glist_initialize(&ext->freed.list);
 
-        AsMqd(mqd)->read_rdy = &ext->queued.sema;
-        AsMqd(mqd)->write_rdy = &ext->freed.sema;
-
         // put all messages into freed
         for (size_t i = 0 ; i < msg_count; i ++)
             glist_push_front(&ext->freed.list, ext->__msg_start + i * __msg_size);
 
-        glist_push_back(&mq_list, AsMqd(mqd));
+        return MQ_create(name, ext, &ext->queued.sema, &ext->freed.sema);
     }
-    else
+}
+
+int mqueue_create_varlen_np(char const *name, uint32_t msg_size, uint32_t bytes, uint32_t flags)
+{
+    if (0 == msg_size || UINT16_MAX < msg_size || 0 == bytes)
+        return __set_errno_neg(EINVAL);
+
+    /// no-split / allow-split storage must be 32-bit aligned
+    bytes = (bytes + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+
+    struct MQ_ext *ext = KERNEL_mallocz(offsetof(struct MQ_ext, __msg_start) + bytes);
+    if (NULL == ext)
+        return __set_errno_neg(ENOMEM);
+
+    bool split = MQUEUE_FLAG_SPLIT == (MQUEUE_FLAG_SPLIT & flags);
+
+    ext->msg_size = (uint16_t)msg_size;
+    ext->flags = MQUEUE_FLAG_VARLEN | (flags & MQUEUE_FLAG_SPLIT);
+    ext->varlen.bytes = bytes;
+    ext->varlen.rb = xRingbufferCreateStatic(bytes, split ? RINGBUF_TYPE_ALLOWSPLIT : RINGBUF_TYPE_NOSPLIT,
+        ext->__msg_start, &ext->varlen.rb_static);
+
+    /// the longest message must fit, otherwise it waits forever
+    if (msg_size + (split ? 0 : MQ_VARLEN_PRIO_SIZE) > xRingbufferGetMaxItemSize(ext->varlen.rb))
+    {
         KERNEL_mfree(ext);
+        return __set_errno_neg(EINVAL);
+    }
 
-    spin_unlock(&mq_list_lock);
-    return mqd;
+    sem_init_np(&ext->varlen.readable, 0, 0, 1);
+    sem_init_np(&ext->varlen.writable, 0, 0, 1);
+
+    return MQ_create(name, ext, &ext->varlen.readable, &ext->varlen.writable);
 }
 
 int mqueue_destroy(int mqd)
@@ -146,15 +412,30 @@ int mqueue_flush(int mqd)
     if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
     {
         struct MQ_ext *ext = AsMqd(mqd)->ext;
-        spin_lock(&ext->queued.lock);
 
-        while (0 == sem_timedwait_ms(&ext->queued.sema, 0))
+        if (MQUEUE_FLAG_VARLEN & ext->flags)
+        {
+            struct MQ_varlen_io io = {.buf = NULL, .count = 0};
+
+            /// receiving into NULL buffer only returns the items
+            while (MQ_varlen_try_recv(ext, &io))
+                __atomic_sub_fetch(&ext->varlen.queued, 1, __ATOMIC_SEQ_CST);
+
+            MQ_ring_signal(&ext->varlen.wr_waiters, &ext->varlen.writable);
+            return 0;
+        }
+        if (MQUEUE_FLAG_RING & ext->flags)
         {
-            void *msg = glist_pop(&ext->queued.list);
-            glist_push_back(&ext->freed.list, msg);
+            struct MQ_cell *cell;
+            while (NULL != (cell = MQ_ring_claim_recv(ext)))
+                MQ_ring_free(ext, cell);
+
+            MQ_ring_signal(&ext->ring.wr_waiters, &ext->ring.writable);
+            return 0;
         }
+        while (0 == sem_timedwait_ms(&ext->queued.sema, 0))
+            SVC_mqueue_release(&ext->freed, SVC_mqueue_dequeue(&ext->queued));
 
-        spin_unlock(&ext->queued.lock);
         return 0;
     }
     else
@@ -165,9 +446,7 @@ int mqueue_queued(int mqd)
 {
     if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
     {
-        int retval;
-        sem_getvalue(AsMqd(mqd)->read_rdy, &retval);
-        return retval;
+        return (int)MQ_queued(AsMqd(mqd)->ext);
     }
     else
         return __set_errno_neg(EBADF);
@@ -175,17 +454,7 @@ int mqueue_queued(int mqd)
 
 ssize_t mqueue_recv(int mqd, void *msg, unsigned int *prio)
 {
-    uint32_t timeo;
-    if (! (FD_FLAG_NONBLOCK & AsFD(mqd)->flags))
-    {
-        timeo = AsFD(mqd)->read_timeo;
-        if (0 == timeo)
-            timeo = WAIT_FOREVER;
-    }
-    else
-        timeo = 0;
-
-    return mqueue_timedrecv(mqd, msg, timeo, prio);
+    return mqueue_timedrecv(mqd, msg, MQ_timeo(mqd, AsFD(mqd)->read_timeo), prio);
 }
 
 ssize_t mqueue_timedrecv(int mqd, void *restrict msg, uint32_t timeout, unsigned int *restrict prio)
@@ -193,60 +462,92 @@ ssize_t mqueue_timedrecv(int mqd, void *restrict msg, uint32_t timeout, unsigned
     if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
     {
         struct MQ_ext *ext = AsMqd(mqd)->ext;
-        int retval = sem_timedwait_ms(&ext->queued.sema, timeout);
-
-        if (0 == retval)
-        {
-            struct MQ_msg *que;
-            que = SVC_mqueue_get(&ext->queued, AsFD(mqd)->ext);
+        if (MQUEUE_FLAG_VARLEN & ext->flags)
+            return MQ_varlen_recv(ext, msg, ext->msg_size, prio, timeout);
 
-            if (prio) *prio = que->prio;
-            memcpy(msg, que->payload, ext->msg_size);
+        void *payload = MQ_recv_borrow(ext, timeout, prio);
 
-            SVC_mqueue_release(&ext->freed, que);
+        if (payload)
+        {
+            memcpy(msg, payload, ext->msg_size);
+            MQ_recv_release(ext, payload);
             return (ssize_t)ext->msg_size;
         }
         else
-            return __set_errno_neg(retval);
+            return -1;
     }
     else
         return __set_errno_neg(EBADF);
-    }
+}
 
 ssize_t mqueue_send(int mqd, void const *msg, unsigned int prio)
 {
-    uint32_t timeo;
-    if (! (FD_FLAG_NONBLOCK & AsFD(mqd)->flags))
-    {
-        timeo = AsFD(mqd)->write_timeo;
-        if (0 == timeo)
-            timeo = WAIT_FOREVER;
-    }
-    else
-        timeo = 0;
-
-    return mqueue_timedsend(mqd, msg, timeo, prio);
+    return mqueue_timedsend(mqd, msg, MQ_timeo(mqd, AsFD(mqd)->write_timeo), prio);
 }
 
 ssize_t mqueue_timedsend(int mqd, void const *msg, uint32_t timeout, unsigned int prio)
 {
     if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
     {
-        struct MQ_ext *ext = AsMqd(mqd)->ext;
-        int retval = sem_timedwait_ms(&ext->freed.sema, timeout);
+        if (MQ_PRIO_MAX <= prio)
+            return __set_errno_neg(EINVAL);
 
-        if (0 == retval)
-        {
-            struct MQ_msg *que = SVC_mqueue_get(&ext->freed, AsFD(mqd)->ext);
+        struct MQ_ext *ext = AsMqd(mqd)->ext;
+        if (MQUEUE_FLAG_VARLEN & ext->flags)
+            return MQ_varlen_send(ext, msg, ext->msg_size, prio, timeout);
 
-            que->prio = prio;
-            memcpy(que->payload, msg, ext->msg_size);
+        void *payload = MQ_send_acquire(ext, ext->msg_size, timeout);
 
-            SVC_mqueue_post(&ext->queued, que, AsFD(mqd)->ext);
+        if (payload)
+        {
+            memcpy(payload, msg, ext->msg_size);
+            MQ_send_commit(ext, payload, prio);
             return (ssize_t)ext->msg_size;
         }
         else
-            return __set_errno_neg(retval);
+            return -1;
+    }
+    else
+        return __set_errno_neg(EBADF);
+}
+
+void *mqueue_send_acquire(int mqd, size_t count, uint32_t timeout)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+        return MQ_send_acquire(AsMqd(mqd)->ext, count, timeout);
+    else
+        return __set_errno_nullptr(EBADF);
+}
+
+int mqueue_send_commit(int mqd, void *payload, unsigned int prio)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+    {
+        /// nothing is published, the slot is still loaned to be committed again
+        if (MQ_PRIO_MAX <= prio)
+            return __set_errno_neg(EINVAL);
+
+        MQ_send_commit(AsMqd(mqd)->ext, payload, prio);
+        return 0;
+    }
+    else
+        return __set_errno_neg(EBADF);
+}
+
+void *mqueue_recv_borrow(int mqd, uint32_t timeout, unsigned int *prio)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+        return MQ_recv_borrow(AsMqd(mqd)->ext, timeout, prio);
+    else
+        return __set_errno_nullptr(EBADF);
+}
+
+int mqueue_recv_release(int mqd, void *payload)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+    {
+        MQ_recv_release(AsMqd(mqd)->ext, payload);
+        return 0;
     }
     else
         return __set_errno_neg(EBADF);
@@ -266,11 +567,15 @@ mqd_t mq_open(char const *name, int flags, ...)
         struct mq_attr *attr = va_arg(vl, struct mq_attr *);
         va_end(vl);
 
-        return mqueue_create(name, (uint16_t)attr->mq_msgsize, (uint16_t)attr->mq_maxmsg);
+        if (MQUEUE_FLAG_VARLEN & attr->mq_flags)
+            return mqueue_create_varlen_np(name, attr->mq_msgsize, attr->mq_maxmsg, attr->mq_flags);
+        else
+            return mqueue_create_np(name, (uint16_t)attr->mq_msgsize, (uint16_t)attr->mq_maxmsg,
+                attr->mq_flags & MQUEUE_FLAG_SPSC);
     }
     else
     {
-        int mqd = SVC_mq_find(name, false);
+        int mqd = MQ_name_lookup(name);
 
         if (-1 == mqd)
             return __set_errno_neg(ENOENT);
@@ -289,12 +594,20 @@ int mq_close(mqd_t mqd)
 
 int mq_unlink(char const *name)
 {
-    int retval = SVC_mq_find(name, true);
+    mutex_lock(&MQ_names.lock);
 
-    if (-1 != retval)
-        retval = close(retval);
+    struct KERNEL_mqd **slot = MQ_name_slot(name, MQ_name_hash(name));
+    struct KERNEL_mqd *mqd = *slot;
 
-    return retval;
+    if (NULL != mqd)
+        __atomic_store_n(slot, mqd->glist_next, __ATOMIC_RELEASE);
+    mutex_unlock(&MQ_names.lock);
+
+    if (NULL == mqd)
+        return __set_errno_neg(ENOENT);
+
+    MQ_name_synchronize();
+    return close((int)mqd);
 }
 
 int mq_getattr(mqd_t mqd, struct mq_attr *attr)
@@ -305,7 +618,7 @@ int mq_getattr(mqd_t mqd, struct mq_attr *attr)
 
         attr->mq_flags = (FD_FLAG_NONBLOCK & AsMqd(mqd)->flags ? O_NONBLOCK : 0);
         attr->mq_msgsize = ext->msg_size;
-        attr->mq_maxmsg = ext->msg_max;
+        attr->mq_maxmsg = MQUEUE_FLAG_VARLEN & ext->flags ? ext->varlen.bytes : ext->msg_max;
         attr->mq_curmsgs = (unsigned)mqueue_queued(mqd);
 
         return 0;
@@ -322,8 +635,54 @@ int mq_setattr(mqd_t mqd, struct mq_attr const *restrict attr, struct mq_attr *r
 
 int mq_notify(mqd_t mqd, struct sigevent const *notification)
 {
-    ARG_UNUSED(mqd, notification);
-    return __set_errno_neg(ENOSYS);
+    if (CID_FD != AsMqd(mqd)->cid || FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
+        return __set_errno_neg(EBADF);
+
+    struct MQ_ext *ext = AsMqd(mqd)->ext;
+
+    /// remove the registration, there is only one process
+    if (NULL == notification)
+    {
+        spin_lock(&ext->notify_lock);
+        ext->notify_state = MQ_NOTIFY_NONE;
+        spin_unlock(&ext->notify_lock);
+        return 0;
+    }
+
+    switch (notification->sigev_notify)
+    {
+    case SIGEV_NONE:
+        break;
+
+    case SIGEV_THREAD:
+        if (NULL == notification->sigev_notify_function)
+            return __set_errno_neg(EINVAL);
+        if (0 != MQ_notifier_start())
+            return __set_errno_neg(EAGAIN);
+        break;
+
+    case SIGEV_SEMAPHORE_NP:
+        if (NULL == notification->sigev_value.sival_ptr)
+            return __set_errno_neg(EINVAL);
+        break;
+
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+
+    int err = 0;
+
+    spin_lock(&ext->notify_lock);
+    if (MQ_NOTIFY_NONE == ext->notify_state)
+    {
+        ext->notification = *notification;
+        ext->notify_state = MQ_NOTIFY_ARMED;
+    }
+    else
+        err = EBUSY;
+    spin_unlock(&ext->notify_lock);
+
+    return 0 == err ? 0 : __set_errno_neg(err);
 }
 
 ssize_t mq_receive(mqd_t mqd, void *buf, size_t bufsize, unsigned int *prio)
@@ -331,6 +690,8 @@ ssize_t mq_receive(mqd_t mqd, void *buf, size_t bufsize, unsigned int *prio)
     struct MQ_ext *ext = AsMqd(mqd)->ext;
     if (bufsize < ext->msg_size)
         return __set_errno_neg(EMSGSIZE);
+    else if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return MQ_varlen_recv(ext, buf, bufsize, prio, MQ_timeo(mqd, AsFD(mqd)->read_timeo));
     else
         return mqueue_recv(mqd, buf, prio);
 }
@@ -346,16 +707,20 @@ ssize_t mq_timedreceive(mqd_t mqd, void *restrict buf, size_t bufsize, unsigned
     if (ts->tv_sec < t)
         return __set_errno_neg(ETIMEDOUT);
 
-    return mqueue_timedrecv(mqd, buf,
-        (uint32_t)((ts->tv_sec - 1) * 1000 + (ts->tv_nsec / 1000)),
-        prio
-    );
+    uint32_t timeout = (uint32_t)((ts->tv_sec - 1) * 1000 + (ts->tv_nsec / 1000));
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return MQ_varlen_recv(ext, buf, bufsize, prio, timeout);
+    else
+        return mqueue_timedrecv(mqd, buf, timeout, prio);
 }
 
 int mq_send(mqd_t mqd, void const *buf, size_t count, unsigned int prio)
 {
     struct MQ_ext *ext = AsMqd(mqd)->ext;
-    if (count < ext->msg_size)
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return (int)MQ_varlen_send(ext, buf, count, prio, MQ_timeo(mqd, AsFD(mqd)->write_timeo));
+    else if (count < ext->msg_size)
         return __set_errno_neg(EMSGSIZE);
     else
         return mqueue_send(mqd, buf, prio);
@@ -365,97 +730,205 @@ int mq_timedsend(mqd_t mqd, void const *buf, size_t count, unsigned int prio,
     struct timespec const *ts)
 {
     struct MQ_ext *ext = AsMqd(mqd)->ext;
-    if (count < ext->msg_size)
+    if (0 == (MQUEUE_FLAG_VARLEN & ext->flags) && count < ext->msg_size)
         return __set_errno_neg(EMSGSIZE);
 
     time_t t = time(NULL);
     if (ts->tv_sec < t)
         return __set_errno_neg(ETIMEDOUT);
 
-    return mqueue_timedsend(mqd, buf,
-        (uint32_t)((ts->tv_sec - 1) * 1000 + (time_t)ts->tv_nsec / 1000),
-        prio);
+    uint32_t timeout = (uint32_t)((ts->tv_sec - 1) * 1000 + (time_t)ts->tv_nsec / 1000);
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return (int)MQ_varlen_send(ext, buf, count, prio, timeout);
+    else
+        return mqueue_timedsend(mqd, buf, timeout, prio);
+}
+
+ssize_t mq_send_batch(mqd_t mqd, void const *buf, size_t msg_count, unsigned int prio)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+    {
+        if (MQ_PRIO_MAX <= prio || MQUEUE_FLAG_VARLEN & ((struct MQ_ext *)AsMqd(mqd)->ext)->flags)
+            return __set_errno_neg(EINVAL);
+        if (0 == msg_count)
+            return 0;
+
+        return MQ_send_batch(AsMqd(mqd)->ext, buf, msg_count, prio,
+            MQ_timeo(mqd, AsMqd(mqd)->write_timeo));
+    }
+    else
+        return __set_errno_neg(EBADF);
+}
+
+ssize_t mq_receive_batch(mqd_t mqd, void *buf, size_t msg_count, unsigned int *prio)
+{
+    if (CID_FD == AsMqd(mqd)->cid && FD_TAG_MQD == (FD_TAG_MQD & AsMqd(mqd)->tag))
+    {
+        if (MQUEUE_FLAG_VARLEN & ((struct MQ_ext *)AsMqd(mqd)->ext)->flags)
+            return __set_errno_neg(EINVAL);
+        if (0 == msg_count)
+            return 0;
+
+        return MQ_recv_batch(AsMqd(mqd)->ext, buf, msg_count, prio,
+            MQ_timeo(mqd, AsMqd(mqd)->read_timeo));
+    }
+    else
+        return __set_errno_neg(EBADF);
 }
 
 /***************************************************************************/
 /** @internal
 ***************************************************************************/
-static int SVC_mq_find(char const *name, bool extract)
+/// create mqd of the ready ext, then publish it to the namespace
+static int MQ_create(char const *name, struct MQ_ext *ext, handle_t read_rdy, handle_t write_rdy)
 {
-    if (NULL == name)
-        return -1;
+    uint32_t hash = MQ_name_hash(name);
+    spinlock_init(&ext->notify_lock);
 
-    int retval = -1;
-    spin_lock(&mq_list_lock);
+    mutex_lock(&MQ_names.lock);
 
-    for (struct KERNEL_mqd **iter = glist_iter_begin(&mq_list);
-        iter != glist_iter_end(&mq_list);
-        iter = glist_iter_next(&mq_list, iter))
+    struct KERNEL_mqd **slot = MQ_name_slot(name, hash);
+    if (NULL != *slot)
     {
-        if (0 == strcmp((*iter)->name, name))
-        {
-            retval = (int)(*iter);
+        mutex_unlock(&MQ_names.lock);
+        KERNEL_mfree(ext);
+        return __set_errno_neg(EEXIST);
+    }
 
-            if (0 != extract)
-                glist_iter_extract(&mq_list, iter);
+    int mqd = KERNEL_createfd(FD_TAG_MQD, &mqdio, ext);
+    if (-1 != mqd)
+    {
+        AsMqd(mqd)->name = name;
+        AsMqd(mqd)->read_rdy = read_rdy;
+        AsMqd(mqd)->write_rdy = write_rdy;
+        ext->name_hash = hash;
 
-            break;
-        }
+        /// publish to lookups after the mqueue was ready
+        AsMqd(mqd)->glist_next = NULL;
+        __atomic_store_n(slot, AsMqd(mqd), __ATOMIC_RELEASE);
     }
+    else
+        KERNEL_mfree(ext);
 
-    spin_unlock(&mq_list_lock);
-    return retval;
+    mutex_unlock(&MQ_names.lock);
+    return mqd;
 }
 
-static struct MQ_msg *SVC_mqueue_get(struct MQ_list *queue, struct MQ_ext *ext)
+/// FNV-1a
+static uint32_t MQ_name_hash(char const *name)
 {
-    spin_lock(&queue->lock);
-    struct MQ_msg *retval = glist_pop(&queue->list);
-    spin_unlock(&queue->lock);;
+    uint32_t hash = 2166136261U;
 
-    if (&ext->queued == queue)
+    if (NULL != name)
     {
-        int queued_count;
-        if (sem_getvalue(&queue->sema, &queued_count) && 0 == queued_count)
-            ext->lowest_prio_queued = 0;
+        for (; '\0' != *name; name ++)
+            hash = (hash ^ (uint8_t)*name) * 16777619U;
     }
-    return retval;
+    return hash;
 }
 
-static void SVC_mqueue_post(struct MQ_list *queue, struct MQ_msg *msg, struct MQ_ext *ext)
+/**
+ *  @returns
+ *      link to the mqd of name, or the NULL link at the end of bucket
+ *      .anonymous mqueues are never matched
+ */
+static struct KERNEL_mqd **MQ_name_slot(char const *name, uint32_t hash)
 {
-    struct MQ_msg **iter;
-    spin_lock(&queue->lock);
+    struct KERNEL_mqd **slot = &MQ_names.buckets[hash & (MQUEUE_NAME_BUCKETS - 1)];
 
-    if (ext->lowest_prio_queued <= msg->prio)
+    for (; NULL != *slot; slot = &(*slot)->glist_next)
     {
-        ext->lowest_prio_queued = msg->prio;
-        glist_push_back(&queue->list, msg);
+        if (NULL != name && hash == ((struct MQ_ext *)(*slot)->ext)->name_hash &&
+            NULL != (*slot)->name && 0 == strcmp((*slot)->name, name))
+        {
+            break;
+        }
+    }
+    return slot;
+}
+
+static int MQ_name_lookup(char const *name)
+{
+    if (NULL == name)
+        return -1;
 
-        goto mqueue_sem_post;
+    uint32_t hash = MQ_name_hash(name);
+    int retval = -1;
+
+    unsigned idx = __atomic_load_n(&MQ_names.epoch, __ATOMIC_SEQ_CST) & 1;
+    __atomic_add_fetch(&MQ_names.readers[idx], 1, __ATOMIC_SEQ_CST);
+
+    for (struct KERNEL_mqd *iter = __atomic_load_n(&MQ_names.buckets[hash & (MQUEUE_NAME_BUCKETS - 1)],
+            __ATOMIC_ACQUIRE);
+        NULL != iter;
+        iter = __atomic_load_n(&iter->glist_next, __ATOMIC_ACQUIRE))
+    {
+        if (hash == ((struct MQ_ext *)iter->ext)->name_hash &&
+            NULL != iter->name && 0 == strcmp(iter->name, name))
+        {
+            retval = (int)iter;
+            break;
+        }
     }
 
-    iter = (struct MQ_msg **)glist_iter_begin(&queue->list);
-    if ((*iter)->prio > msg->prio)
+    /// the epoch was moved since: a synchronizing writer may wait for this reader
+    if (0 == __atomic_sub_fetch(&MQ_names.readers[idx], 1, __ATOMIC_SEQ_CST) &&
+        idx != (__atomic_load_n(&MQ_names.epoch, __ATOMIC_SEQ_CST) & 1))
     {
-        glist_push_front(&queue->list, msg);
-        goto mqueue_sem_post;
+        sem_post(&MQ_names.drained);
     }
+    return retval;
+}
+
+/// mqueue_destroy() closes without mq_unlink()
+static void MQ_name_remove(struct KERNEL_mqd *mqd)
+{
+    struct MQ_ext *ext = mqd->ext;
+    bool found = false;
+
+    mutex_lock(&MQ_names.lock);
 
-    while (iter != glist_iter_end(&queue->list))
+    for (struct KERNEL_mqd **slot = &MQ_names.buckets[ext->name_hash & (MQUEUE_NAME_BUCKETS - 1)];
+        NULL != *slot;
+        slot = &(*slot)->glist_next)
     {
-        if ((*iter)->prio > msg->prio)
+        if (mqd == *slot)
         {
-            glist_iter_insert(&queue->list, iter, msg);
+            __atomic_store_n(slot, mqd->glist_next, __ATOMIC_RELEASE);
+            found = true;
             break;
         }
-        else
-            iter = glist_iter_next(&queue->list, iter);
     }
+    mutex_unlock(&MQ_names.lock);
+
+    if (found)
+        MQ_name_synchronize();
+}
+
+/**
+ *  unlinked mqd may still be walking by lookups, wait them to finish
+ *      .lookups started after the epoch was moved never reach the unlinked mqd
+ *      .drained may be posted by a reader finished between moving and checking, it is re-checked
+ */
+static void MQ_name_synchronize(void)
+{
+    mutex_lock(&MQ_names.sync_lock);
+
+    unsigned idx = __atomic_fetch_add(&MQ_names.epoch, 1, __ATOMIC_SEQ_CST) & 1;
+    while (0 != __atomic_load_n(&MQ_names.readers[idx], __ATOMIC_SEQ_CST))
+        sem_wait(&MQ_names.drained);
+
+    mutex_unlock(&MQ_names.sync_lock);
+}
 
-mqueue_sem_post:
+static struct MQ_msg *SVC_mqueue_get(struct MQ_list *queue)
+{
+    spin_lock(&queue->lock);
+    struct MQ_msg *retval = glist_pop(&queue->list);
     spin_unlock(&queue->lock);
-    sem_post(&queue->sema);
+
+    return retval;
 }
 
 static void SVC_mqueue_release(struct MQ_list *queue, struct MQ_msg *msg)
@@ -467,31 +940,806 @@ static void SVC_mqueue_release(struct MQ_list *queue, struct MQ_msg *msg)
     sem_post(&queue->sema);
 }
 
-/***************************************************************************/
-/** @internal: fd io
-***************************************************************************/
-static ssize_t mqd_read(int mqd, void *buf, size_t bufsize)
+/// queue->lock is held and at least one message is queued
+static struct MQ_msg *SVC_mqueue_pop(struct MQ_prio_queue *queue)
 {
-    if (FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
-        return EBADF;
+    unsigned prio = (unsigned)__builtin_ctz(queue->bitmap);
+    struct MQ_msg *retval = glist_pop(&queue->fifo[prio]);
 
-    struct MQ_ext *ext = AsMqd(mqd)->ext;
-
-    if (bufsize < ext->msg_size)
-        return __set_errno_neg(EMSGSIZE);
-    else
-        return mqueue_recv(mqd, buf, NULL);
+    if (glist_is_empty(&queue->fifo[prio]))
+        queue->bitmap &= ~(1U << prio);
+    return retval;
 }
 
-static ssize_t mqd_write(int mqd, void const *msg, size_t count)
+static struct MQ_msg *SVC_mqueue_dequeue(struct MQ_prio_queue *queue)
 {
-    if (FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
-        return EBADF;
+    spin_lock(&queue->lock);
+    /// sema was taken: bitmap is not empty
+    struct MQ_msg *retval = SVC_mqueue_pop(queue);
+    spin_unlock(&queue->lock);
 
-    struct MQ_ext *ext = AsMqd(mqd)->ext;
+    return retval;
+}
 
-    if (count < ext->msg_size)
-        return __set_errno_neg(EMSGSIZE);
+static void SVC_mqueue_enqueue(struct MQ_prio_queue *queue, struct MQ_msg *msg)
+{
+    spin_lock(&queue->lock);
+    glist_push_back(&queue->fifo[msg->prio], msg);
+    queue->bitmap |= 1U << msg->prio;
+    spin_unlock(&queue->lock);
+
+    sem_post(&queue->sema);
+}
+
+/***************************************************************************/
+/** @internal: loan of message slots
+***************************************************************************/
+static void *MQ_send_acquire(struct MQ_ext *ext, size_t count, uint32_t timeout)
+{
+    if (count > ext->msg_size)
+        return __set_errno_nullptr(EMSGSIZE);
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+    {
+        struct MQ_varlen_io io = {.count = count};
+
+        if (MQUEUE_FLAG_SPLIT == (MQUEUE_FLAG_SPLIT & ext->flags))
+            return __set_errno_nullptr(EINVAL);
+        if (! MQ_varlen_wait(ext, MQ_varlen_try_acquire, &io, &ext->varlen.wr_waiters,
+            &ext->varlen.writable, timeout))
+        {
+            return NULL;
+        }
+        return io.buf;
+    }
+    if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        struct MQ_cell *cell = MQ_ring_wait(ext, MQ_ring_claim_send,
+            &ext->ring.wr_waiters, &ext->ring.writable, timeout);
+
+        return cell ? cell->payload : NULL;
+    }
+
+    if (0 != sem_timedwait_ms(&ext->freed.sema, timeout))
+        return __set_errno_nullptr(0 == timeout ? EAGAIN : ETIMEDOUT);
+    else
+        return SVC_mqueue_get(&ext->freed)->payload;
+}
+
+static void MQ_send_commit(struct MQ_ext *ext, void *payload, unsigned int prio)
+{
+    bool was_empty = 0 == MQ_queued(ext);
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+    {
+        uint8_t *item = (uint8_t *)payload - MQ_VARLEN_PRIO_SIZE;
+
+        *(uint32_t *)item = prio;
+        xRingbufferSendComplete(ext->varlen.rb, item);
+        MQ_varlen_sent(ext);
+    }
+    else if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        struct MQ_cell *cell = AsCell(payload);
+        cell->prio = prio;
+        MQ_ring_publish(ext, cell);
+
+        MQ_ring_signal(&ext->ring.rd_waiters, &ext->ring.readable);
+        /// binary semaphore: pass on to other senders
+        if (ext->msg_max > MQ_ring_queued(ext))
+            MQ_ring_signal(&ext->ring.wr_waiters, &ext->ring.writable);
+    }
+    else
+    {
+        struct MQ_msg *msg = AsMsg(payload);
+        msg->prio = prio;
+        SVC_mqueue_enqueue(&ext->queued, msg);
+    }
+
+    if (was_empty)
+        MQ_notify(ext);
+}
+
+static void *MQ_recv_borrow(struct MQ_ext *ext, uint32_t timeout, unsigned int *prio)
+{
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+    {
+        struct MQ_varlen_io io;
+
+        if (MQUEUE_FLAG_SPLIT == (MQUEUE_FLAG_SPLIT & ext->flags))
+            return __set_errno_nullptr(EINVAL);
+        if (! MQ_varlen_wait(ext, MQ_varlen_try_borrow, &io, &ext->varlen.rd_waiters,
+            &ext->varlen.readable, timeout))
+        {
+            return NULL;
+        }
+
+        if (prio) *prio = io.prio;
+        return io.buf;
+    }
+    if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        struct MQ_cell *cell = MQ_ring_wait(ext, MQ_ring_claim_recv,
+            &ext->ring.rd_waiters, &ext->ring.readable, timeout);
+
+        if (! cell)
+            return NULL;
+
+        if (prio) *prio = cell->prio;
+        return cell->payload;
+    }
+
+    int err = MQ_wait_queued(ext, timeout);
+    if (0 != err)
+        return __set_errno_nullptr(err);
+
+    struct MQ_msg *msg = SVC_mqueue_dequeue(&ext->queued);
+    if (prio) *prio = msg->prio;
+    return msg->payload;
+}
+
+static void MQ_recv_release(struct MQ_ext *ext, void *payload)
+{
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+    {
+        vRingbufferReturnItem(ext->varlen.rb, (uint8_t *)payload - MQ_VARLEN_PRIO_SIZE);
+        MQ_varlen_received(ext);
+    }
+    else if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        MQ_ring_free(ext, AsCell(payload));
+
+        MQ_ring_signal(&ext->ring.wr_waiters, &ext->ring.writable);
+        /// binary semaphore: pass on to other receivers
+        if (0 != MQ_ring_queued(ext))
+            MQ_ring_signal(&ext->ring.rd_waiters, &ext->ring.readable);
+    }
+    else
+        SVC_mqueue_release(&ext->freed, AsMsg(payload));
+}
+
+/**
+ *  batch: the first message waits, the rest are only taken while the queue is not full / empty
+ *      .list: the freed list and the priority FIFOs are locked once for the whole batch
+ *      .ring: cells are claimed without waiting, the other side is signaled once
+ */
+static ssize_t MQ_send_batch(struct MQ_ext *ext, uint8_t const *buf, size_t msg_count, unsigned int prio,
+    uint32_t timeout)
+{
+    size_t count = 0;
+    bool was_empty;
+
+    if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        struct MQ_cell *cell = MQ_ring_wait(ext, MQ_ring_claim_send,
+            &ext->ring.wr_waiters, &ext->ring.writable, timeout);
+
+        was_empty = 0 == MQ_ring_queued(ext);
+
+        while (cell)
+        {
+            cell->prio = prio;
+            memcpy(cell->payload, buf + count * ext->msg_size, ext->msg_size);
+            MQ_ring_publish(ext, cell);
+
+            if (++ count == msg_count)
+                break;
+            cell = MQ_ring_claim_send(ext);
+        }
+        if (0 == count)
+            return -1;
+
+        MQ_ring_signal(&ext->ring.rd_waiters, &ext->ring.readable);
+        if (ext->msg_max > MQ_ring_queued(ext))
+            MQ_ring_signal(&ext->ring.wr_waiters, &ext->ring.writable);
+
+        if (was_empty)
+            MQ_notify(ext);
+        return (ssize_t)count;
+    }
+
+    if (0 != sem_timedwait_ms(&ext->freed.sema, timeout))
+        return __set_errno_neg(0 == timeout ? EAGAIN : ETIMEDOUT);
+    for (count = 1; count < msg_count && 0 == sem_trywait(&ext->freed.sema); count ++);
+
+    glist_t batch = GLIST_INITIALIZER(batch);
+    glist_t filled = GLIST_INITIALIZER(filled);
+    struct MQ_msg *msg;
+
+    spin_lock(&ext->freed.lock);
+    for (size_t i = 0; i < count; i ++)
+        glist_push_back(&batch, glist_pop(&ext->freed.list));
+    spin_unlock(&ext->freed.lock);
+
+    for (size_t i = 0; NULL != (msg = glist_pop(&batch)); i ++)
+    {
+        msg->prio = prio;
+        memcpy(msg->payload, buf + i * ext->msg_size, ext->msg_size);
+        glist_push_back(&filled, msg);
+    }
+
+    was_empty = 0 == MQ_queued(ext);
+
+    spin_lock(&ext->queued.lock);
+    while (NULL != (msg = glist_pop(&filled)))
+        glist_push_back(&ext->queued.fifo[prio], msg);
+    ext->queued.bitmap |= 1U << prio;
+    spin_unlock(&ext->queued.lock);
+
+    for (size_t i = 0; i < count; i ++)
+        sem_post(&ext->queued.sema);
+
+    if (was_empty)
+        MQ_notify(ext);
+    return (ssize_t)count;
+}
+
+static ssize_t MQ_recv_batch(struct MQ_ext *ext, uint8_t *buf, size_t msg_count, unsigned int *prio,
+    uint32_t timeout)
+{
+    size_t count = 0;
+
+    if (MQUEUE_FLAG_RING & ext->flags)
+    {
+        struct MQ_cell *cell = MQ_ring_wait(ext, MQ_ring_claim_recv,
+            &ext->ring.rd_waiters, &ext->ring.readable, timeout);
+
+        while (cell)
+        {
+            if (prio) prio[count] = cell->prio;
+            memcpy(buf + count * ext->msg_size, cell->payload, ext->msg_size);
+            MQ_ring_free(ext, cell);
+
+            if (++ count == msg_count)
+                break;
+            cell = MQ_ring_claim_recv(ext);
+        }
+        if (0 == count)
+            return -1;
+
+        MQ_ring_signal(&ext->ring.wr_waiters, &ext->ring.writable);
+        if (0 != MQ_ring_queued(ext))
+            MQ_ring_signal(&ext->ring.rd_waiters, &ext->ring.readable);
+
+        return (ssize_t)count;
+    }
+
+    int err = MQ_wait_queued(ext, timeout);
+    if (0 != err)
+        return __set_errno_neg(err);
+    for (count = 1; count < msg_count && 0 == sem_trywait(&ext->queued.sema); count ++);
+
+    glist_t batch = GLIST_INITIALIZER(batch);
+    glist_t done = GLIST_INITIALIZER(done);
+    struct MQ_msg *msg;
+
+    spin_lock(&ext->queued.lock);
+    for (size_t i = 0; i < count; i ++)
+        glist_push_back(&batch, SVC_mqueue_pop(&ext->queued));
+    spin_unlock(&ext->queued.lock);
+
+    for (size_t i = 0; NULL != (msg = glist_pop(&batch)); i ++)
+    {
+        if (prio) prio[i] = msg->prio;
+        memcpy(buf + i * ext->msg_size, msg->payload, ext->msg_size);
+        glist_push_back(&done, msg);
+    }
+
+    spin_lock(&ext->freed.lock);
+    while (NULL != (msg = glist_pop(&done)))
+        glist_push_front(&ext->freed.list, msg);
+    spin_unlock(&ext->freed.lock);
+
+    for (size_t i = 0; i < count; i ++)
+        sem_post(&ext->freed.sema);
+
+    return (ssize_t)count;
+}
+
+static uint32_t MQ_timeo(int mqd, uint32_t timeo)
+{
+    if (FD_FLAG_NONBLOCK & AsFD(mqd)->flags)
+        return 0;
+    else if (0 == timeo)
+        return WAIT_FOREVER;
+    else
+        return timeo;
+}
+
+static uint32_t MQ_queued(struct MQ_ext *ext)
+{
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return __atomic_load_n(&ext->varlen.queued, __ATOMIC_ACQUIRE);
+    if (MQUEUE_FLAG_RING & ext->flags)
+        return MQ_ring_queued(ext);
+
+    int queued;
+    sem_getvalue(&ext->queued.sema, &queued);
+    return (uint32_t)queued;
+}
+
+/// @list: take queued.sema, counting the blocked receivers for mq_notify()
+static int MQ_wait_queued(struct MQ_ext *ext, uint32_t timeout)
+{
+    if (0 == sem_trywait(&ext->queued.sema))
+        return 0;
+    if (0 == timeout)
+        return EAGAIN;
+
+    __atomic_add_fetch(&ext->receivers, 1, __ATOMIC_SEQ_CST);
+    int err = sem_timedwait_ms(&ext->queued.sema, timeout);
+    __atomic_sub_fetch(&ext->receivers, 1, __ATOMIC_SEQ_CST);
+
+    return 0 == err ? 0 : ETIMEDOUT;
+}
+
+/***************************************************************************/
+/** @internal: mq_notify()
+***************************************************************************/
+/**
+ *  called by the sender put a message into empty mqueue
+ *      .no notification when any receiver is blocked, it takes the message
+ *      .registration is removed by the notification
+ */
+static void MQ_notify(struct MQ_ext *ext)
+{
+    if (MQ_NOTIFY_ARMED != __atomic_load_n(&ext->notify_state, __ATOMIC_ACQUIRE))
+        return;
+
+    uint16_t *receivers;
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        receivers = &ext->varlen.rd_waiters;
+    else if (MQUEUE_FLAG_RING & ext->flags)
+        receivers = &ext->ring.rd_waiters;
+    else
+        receivers = &ext->receivers;
+    if (0 != __atomic_load_n(receivers, __ATOMIC_SEQ_CST))
+        return;
+
+    /// snapshot and clear the registration together, mq_notify() can not rewrite it in between
+    struct sigevent sev;
+
+    spin_lock(&ext->notify_lock);
+    if (MQ_NOTIFY_ARMED != ext->notify_state)
+    {
+        spin_unlock(&ext->notify_lock);
+        return;
+    }
+    sev = ext->notification;
+    ext->notify_state = MQ_NOTIFY_NONE;
+    spin_unlock(&ext->notify_lock);
+
+    bool queued = false;
+
+    switch (sev.sigev_notify)
+    {
+    case SIGEV_SEMAPHORE_NP:
+        sem_post(sev.sigev_value.sival_ptr);
+        break;
+
+    case SIGEV_THREAD:
+        spin_lock(&MQ_notifier.lock);
+        if (MQ_notifier.count < lengthof(MQ_notifier.pending))
+        {
+            struct MQ_notification *pending = &MQ_notifier.pending[
+                (MQ_notifier.head + MQ_notifier.count) % lengthof(MQ_notifier.pending)];
+
+            pending->function = sev.sigev_notify_function;
+            pending->value = sev.sigev_value;
+            MQ_notifier.count ++;
+            MQ_notifier.queued ++;
+            queued = true;
+        }
+        else
+            MQ_notifier.overflows ++;
+        spin_unlock(&MQ_notifier.lock);
+
+        if (queued)
+            sem_post(&MQ_notifier.pending_sema);
+        else
+        {
+            /// worker is overwhelmed: counted in /proc/mqueue, keep registered for the next message
+            ///     unless re-registered meanwhile
+            spin_lock(&ext->notify_lock);
+            if (MQ_NOTIFY_NONE == ext->notify_state)
+            {
+                ext->notification = sev;
+                ext->notify_state = MQ_NOTIFY_ARMED;
+            }
+            spin_unlock(&ext->notify_lock);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static int MQ_notifier_start(void)
+{
+    int retval = 0;
+
+    mutex_lock(&MQ_notifier.start_lock);
+    if (! MQ_notifier.thread)
+    {
+        MQ_notifier.thread = thread_create(MQ_notifier_routine, &MQ_notifier, THREAD_DEFAULT_PRIORITY,
+            NULL, THREAD_DEFAULT_STACK_SIZE);
+
+        if (! MQ_notifier.thread)
+            retval = -1;
+    }
+    mutex_unlock(&MQ_notifier.start_lock);
+
+    return retval;
+}
+
+static void *MQ_notifier_routine(void *arg)
+{
+    ARG_UNUSED(arg);
+
+    while (true)
+    {
+        sem_wait(&MQ_notifier.pending_sema);
+
+        spin_lock(&MQ_notifier.lock);
+        struct MQ_notification notification = MQ_notifier.pending[MQ_notifier.head];
+        MQ_notifier.head = (uint8_t)((MQ_notifier.head + 1) % lengthof(MQ_notifier.pending));
+        MQ_notifier.count --;
+        spin_unlock(&MQ_notifier.lock);
+
+        notification.function(notification.value);
+    }
+}
+
+/***************************************************************************/
+/** @internal: lock-free ring
+***************************************************************************/
+static void MQ_ring_init(struct MQ_ext *ext, uint32_t capacity, size_t cell_size)
+{
+    struct MQ_ring *ring = &ext->ring;
+
+    ring->head = ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->cell_size = (uint32_t)cell_size;
+    ring->rd_waiters = ring->wr_waiters = 0;
+
+    sem_init_np(&ring->readable, 0, 0, 1);
+    sem_init_np(&ring->writable, 0, 0, 1);
+
+    for (uint32_t pos = 0; pos < capacity; pos ++)
+        MQ_ring_cell(ext, pos)->seq = pos;
+}
+
+static struct MQ_cell *MQ_ring_cell(struct MQ_ext *ext, uint32_t pos)
+{
+    return (struct MQ_cell *)(ext->__msg_start + (pos & ext->ring.mask) * ext->ring.cell_size);
+}
+
+/**
+ *  claim the cell at tail to fill
+ *      .SPSC: tail is advanced by publish
+ *      .MPMC: tail is advanced here, seq still equals the position until publish
+ */
+static struct MQ_cell *MQ_ring_claim_send(struct MQ_ext *ext)
+{
+    struct MQ_ring *ring = &ext->ring;
+    uint32_t pos;
+
+    if (MQUEUE_FLAG_SPSC == (MQUEUE_FLAG_SPSC & ext->flags))
+    {
+        pos = ring->tail;
+        if (pos - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) > ring->mask)
+            return NULL;
+        else
+            return MQ_ring_cell(ext, pos);
+    }
+
+    pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    while (true)
+    {
+        struct MQ_cell *cell = MQ_ring_cell(ext, pos);
+        int32_t diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (0 == diff)
+        {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return cell;
+        }
+        else if (0 > diff)
+            return NULL;    // full: the cell is not received since last round
+        else
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    }
+}
+
+static void MQ_ring_publish(struct MQ_ext *ext, struct MQ_cell *cell)
+{
+    if (MQUEUE_FLAG_SPSC == (MQUEUE_FLAG_SPSC & ext->flags))
+        __atomic_store_n(&ext->ring.tail, ext->ring.tail + 1, __ATOMIC_RELEASE);
+    else
+        __atomic_store_n(&cell->seq, cell->seq + 1, __ATOMIC_RELEASE);
+}
+
+static struct MQ_cell *MQ_ring_claim_recv(struct MQ_ext *ext)
+{
+    struct MQ_ring *ring = &ext->ring;
+    uint32_t pos;
+
+    if (MQUEUE_FLAG_SPSC == (MQUEUE_FLAG_SPSC & ext->flags))
+    {
+        pos = ring->head;
+        if (pos == __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE))
+            return NULL;
+        else
+            return MQ_ring_cell(ext, pos);
+    }
+
+    pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    while (true)
+    {
+        struct MQ_cell *cell = MQ_ring_cell(ext, pos);
+        int32_t diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+
+        if (0 == diff)
+        {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                return cell;
+        }
+        else if (0 > diff)
+            return NULL;    // empty: the cell is not sent in this round
+        else
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+}
+
+static void MQ_ring_free(struct MQ_ext *ext, struct MQ_cell *cell)
+{
+    if (MQUEUE_FLAG_SPSC == (MQUEUE_FLAG_SPSC & ext->flags))
+        __atomic_store_n(&ext->ring.head, ext->ring.head + 1, __ATOMIC_RELEASE);
+    else    /// seq was position + 1: free for the sender of next round
+        __atomic_store_n(&cell->seq, cell->seq + ext->ring.mask, __ATOMIC_RELEASE);
+}
+
+static struct MQ_cell *MQ_ring_wait(struct MQ_ext *ext, struct MQ_cell *(* claim)(struct MQ_ext *),
+    uint16_t *waiters, sem_t *sema, uint32_t timeout)
+{
+    struct MQ_cell *cell;
+
+    while (NULL == (cell = claim(ext)))
+    {
+        if (0 == timeout)
+            return __set_errno_nullptr(EAGAIN);
+
+        __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+
+        /// the other side may have checked the waiters before counted
+        cell = claim(ext);
+        int err = cell ? 0 : sem_timedwait_ms(sema, timeout);
+
+        __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+
+        if (cell)
+            break;
+        if (0 != err)
+            return __set_errno_nullptr(ETIMEDOUT);
+    }
+    return cell;
+}
+
+static uint32_t MQ_ring_queued(struct MQ_ext *ext)
+{
+    uint32_t head = __atomic_load_n(&ext->ring.head, __ATOMIC_ACQUIRE);
+    uint32_t queued = __atomic_load_n(&ext->ring.tail, __ATOMIC_ACQUIRE) - head;
+
+    /// @MPMC: tail is claimed before the cell is published
+    return queued > ext->msg_max ? ext->msg_max : queued;
+}
+
+static void MQ_ring_signal(uint16_t *waiters, sem_t *sema)
+{
+    /// pairs with the waiter: count itself then claim again
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (0 != __atomic_load_n(waiters, __ATOMIC_RELAXED))
+        sem_post(sema);
+}
+
+/***************************************************************************/
+/** @internal: MQUEUE_FLAG_VARLEN
+***************************************************************************/
+static ssize_t MQ_varlen_send(struct MQ_ext *ext, void const *msg, size_t count, unsigned int prio,
+    uint32_t timeout)
+{
+    if (count > ext->msg_size)
+        return __set_errno_neg(EMSGSIZE);
+    if (MQ_PRIO_MAX <= prio)
+        return __set_errno_neg(EINVAL);
+
+    bool was_empty = 0 == MQ_queued(ext);
+    struct MQ_varlen_io io = {.buf = (void *)msg, .count = count, .prio = prio};
+
+    if (! MQ_varlen_wait(ext, MQ_varlen_try_send, &io, &ext->varlen.wr_waiters, &ext->varlen.writable, timeout))
+        return -1;
+
+    MQ_varlen_sent(ext);
+    if (was_empty)
+        MQ_notify(ext);
+    return (ssize_t)count;
+}
+
+static ssize_t MQ_varlen_recv(struct MQ_ext *ext, void *buf, size_t bufsize, unsigned int *prio,
+    uint32_t timeout)
+{
+    struct MQ_varlen_io io = {.buf = buf, .count = bufsize};
+
+    if (! MQ_varlen_wait(ext, MQ_varlen_try_recv, &io, &ext->varlen.rd_waiters, &ext->varlen.readable, timeout))
+        return -1;
+
+    MQ_varlen_received(ext);
+    if (prio) *prio = io.prio;
+    return (ssize_t)io.count;
+}
+
+static bool MQ_varlen_wait(struct MQ_ext *ext, bool (* attempt)(struct MQ_ext *, struct MQ_varlen_io *),
+    struct MQ_varlen_io *io, uint16_t *waiters, sem_t *sema, uint32_t timeout)
+{
+    while (! attempt(ext, io))
+    {
+        if (0 == timeout)
+        {
+            errno = EAGAIN;
+            return false;
+        }
+
+        __atomic_add_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+
+        /// the other side may have checked the waiters before counted
+        bool done = attempt(ext, io);
+        int err = done ? 0 : sem_timedwait_ms(sema, timeout);
+
+        __atomic_sub_fetch(waiters, 1, __ATOMIC_SEQ_CST);
+
+        if (done)
+            break;
+        if (0 != err)
+        {
+            errno = ETIMEDOUT;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool MQ_varlen_try_send(struct MQ_ext *ext, struct MQ_varlen_io *io)
+{
+    if (MQUEUE_FLAG_SPLIT == (MQUEUE_FLAG_SPLIT & ext->flags))
+        return pdTRUE == xRingbufferSend(ext->varlen.rb, io->buf, io->count, 0);
+
+    uint8_t *item;
+    if (pdTRUE != xRingbufferSendAcquire(ext->varlen.rb, (void **)&item, MQ_VARLEN_PRIO_SIZE + io->count, 0))
+        return false;
+
+    *(uint32_t *)item = io->prio;
+    memcpy(item + MQ_VARLEN_PRIO_SIZE, io->buf, io->count);
+    xRingbufferSendComplete(ext->varlen.rb, item);
+    return true;
+}
+
+/// io->count: in bufsize, out length of the message, NULL io->buf drops the message
+static bool MQ_varlen_try_recv(struct MQ_ext *ext, struct MQ_varlen_io *io)
+{
+    if (MQUEUE_FLAG_SPLIT == (MQUEUE_FLAG_SPLIT & ext->flags))
+    {
+        void *head, *tail;
+        size_t head_size, tail_size;
+
+        if (pdTRUE != xRingbufferReceiveSplit(ext->varlen.rb, &head, &tail, &head_size, &tail_size, 0) ||
+            NULL == head)
+        {
+            return false;
+        }
+
+        if (io->buf)
+        {
+            memcpy(io->buf, head, head_size);
+            if (tail) memcpy((uint8_t *)io->buf + head_size, tail, tail_size);
+        }
+        vRingbufferReturnItem(ext->varlen.rb, head);
+        if (tail) vRingbufferReturnItem(ext->varlen.rb, tail);
+
+        io->count = head_size + (tail ? tail_size : 0);
+        io->prio = 0;
+        return true;
+    }
+
+    size_t size;
+    uint8_t *item = xRingbufferReceive(ext->varlen.rb, &size, 0);
+    if (NULL == item)
+        return false;
+
+    io->prio = *(uint32_t *)item;
+    io->count = size - MQ_VARLEN_PRIO_SIZE;
+
+    if (io->buf)
+        memcpy(io->buf, item + MQ_VARLEN_PRIO_SIZE, io->count);
+    vRingbufferReturnItem(ext->varlen.rb, item);
+    return true;
+}
+
+/// @NOSPLIT: loaned item of io->count, it is the length received
+static bool MQ_varlen_try_acquire(struct MQ_ext *ext, struct MQ_varlen_io *io)
+{
+    uint8_t *item;
+    if (pdTRUE != xRingbufferSendAcquire(ext->varlen.rb, (void **)&item, MQ_VARLEN_PRIO_SIZE + io->count, 0))
+        return false;
+
+    io->buf = item + MQ_VARLEN_PRIO_SIZE;
+    return true;
+}
+
+static bool MQ_varlen_try_borrow(struct MQ_ext *ext, struct MQ_varlen_io *io)
+{
+    size_t size;
+    uint8_t *item = xRingbufferReceive(ext->varlen.rb, &size, 0);
+    if (NULL == item)
+        return false;
+
+    io->prio = *(uint32_t *)item;
+    io->count = size - MQ_VARLEN_PRIO_SIZE;
+    io->buf = item + MQ_VARLEN_PRIO_SIZE;
+    return true;
+}
+
+static void MQ_varlen_sent(struct MQ_ext *ext)
+{
+    __atomic_add_fetch(&ext->varlen.queued, 1, __ATOMIC_SEQ_CST);
+
+    MQ_ring_signal(&ext->varlen.rd_waiters, &ext->varlen.readable);
+    /// binary semaphore: pass on to other senders, the space may fit a shorter message
+    if (0 != xRingbufferGetCurFreeSize(ext->varlen.rb))
+        MQ_ring_signal(&ext->varlen.wr_waiters, &ext->varlen.writable);
+}
+
+static void MQ_varlen_received(struct MQ_ext *ext)
+{
+    __atomic_sub_fetch(&ext->varlen.queued, 1, __ATOMIC_SEQ_CST);
+
+    MQ_ring_signal(&ext->varlen.wr_waiters, &ext->varlen.writable);
+    /// binary semaphore: pass on to other receivers
+    if (0 != MQ_queued(ext))
+        MQ_ring_signal(&ext->varlen.rd_waiters, &ext->varlen.readable);
+}
+
+/***************************************************************************/
+/** @internal: fd io
+***************************************************************************/
+static ssize_t mqd_read(int mqd, void *buf, size_t bufsize)
+{
+    if (FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
+        return EBADF;
+
+    struct MQ_ext *ext = AsMqd(mqd)->ext;
+
+    if (bufsize < ext->msg_size)
+        return __set_errno_neg(EMSGSIZE);
+    else if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return MQ_varlen_recv(ext, buf, bufsize, NULL, MQ_timeo(mqd, AsFD(mqd)->read_timeo));
+    else
+        return mqueue_recv(mqd, buf, NULL);
+}
+
+static ssize_t mqd_write(int mqd, void const *msg, size_t count)
+{
+    if (FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
+        return EBADF;
+
+    struct MQ_ext *ext = AsMqd(mqd)->ext;
+
+    if (MQUEUE_FLAG_VARLEN & ext->flags)
+        return MQ_varlen_send(ext, msg, count, 0, MQ_timeo(mqd, AsFD(mqd)->write_timeo));
+    else if (count < ext->msg_size)
+        return __set_errno_neg(EMSGSIZE);
     else
         return mqueue_send(mqd, msg, 0);
 }
@@ -501,8 +1749,57 @@ static int mqd_close(int mqd)
     if (FD_TAG_MQD != (FD_TAG_MQD & AsMqd(mqd)->tag))
         return EBADF;
 
+    MQ_name_remove(AsMqd(mqd));
+
     AsFD(mqd)->read_rdy = AsFD(mqd)->write_rdy = INVALID_HANDLE;
     KERNEL_mfree(AsMqd(mqd)->ext);
 
     return 0;
 }
+
+static void mq_procfs(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+    PROCFS_printf(out, "%-16s %8s %8s %8s\n", "name", "msgsize", "maxmsg", "curmsgs");
+
+    for (unsigned idx = 0; ! PROCFS_full(out); idx ++)
+    {
+        char name[17];
+        struct mq_attr attr;
+        bool found = false;
+
+        /// @snapshot idx-th queue, rendering is out of the lock
+        mutex_lock(&MQ_names.lock);
+        unsigned i = 0;
+
+        for (unsigned bucket = 0; ! found && bucket < lengthof(MQ_names.buckets); bucket ++)
+        {
+            for (struct KERNEL_mqd *iter = MQ_names.buckets[bucket]; NULL != iter; iter = iter->glist_next, i ++)
+            {
+                if (i == idx)
+                {
+                    strncpy(name, iter->name ? iter->name : "", sizeof(name) - 1);
+                    name[sizeof(name) - 1] = '\0';
+
+                    mq_getattr((mqd_t)iter, &attr);
+                    found = true;
+                    break;
+                }
+            }
+        }
+        mutex_unlock(&MQ_names.lock);
+
+        if (! found)
+            break;
+
+        PROCFS_printf(out, "%-16s %8u %8u %8u\n", name,
+            (unsigned)attr.mq_msgsize, (unsigned)attr.mq_maxmsg, (unsigned)attr.mq_curmsgs);
+    }
+
+    spin_lock(&MQ_notifier.lock);
+    uint32_t queued = MQ_notifier.queued;
+    uint32_t overflows = MQ_notifier.overflows;
+    spin_unlock(&MQ_notifier.lock);
+
+    PROCFS_printf(out, "notify queued %u overflows %u\n", (unsigned)queued, (unsigned)overflows);
+}
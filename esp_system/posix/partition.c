@@ -0,0 +1,210 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <string.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "esp_partition.h"
+
+#include <rtos/bcache.h>
+#include <rtos/devfs.h>
+/// @implements headers
+#include <rtos/partition.h>
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int PARTITION_devfs_open(void *arg, int flags);
+
+static ssize_t PARTITION_read(int fd, void *buf, size_t bufsize);
+static ssize_t PARTITION_pread(int fd, void *buf, size_t bufsize, off_t offset);
+static off_t PARTITION_seek(int fd, off_t offset, int origin);
+static int PARTITION_close(int fd);
+static int PARTITION_flash_addr(int fd, off_t offset, uintptr_t *paddr, size_t *count);
+
+static int PARTITION_dev_read(void *ctx, uint64_t addr, void *buf, size_t size);
+static int PARTITION_dev_write(void *ctx, uint64_t addr, void const *buf, size_t size);
+
+static int PARTITION_error(esp_err_t err);
+
+/// @variable
+static struct FD_implement const PARTITION_fdio =
+{
+    .read = PARTITION_read,
+    .write = NULL,
+    .seek = PARTITION_seek,
+    .close = PARTITION_close,
+    .ioctl = NULL,
+    .flash_addr = PARTITION_flash_addr,
+    .pread = PARTITION_pread,
+};
+
+/***************************************************************************/
+/** @implements partition.h
+****************************************************************************/
+int PARTITION_register(char const *label)
+{
+    esp_partition_t const *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        ESP_PARTITION_SUBTYPE_ANY, label);
+
+    if (! partition)
+        return __set_errno_neg(ENOENT);
+    else
+        return DEVFS_register(label, S_IFBLK | S_IRUSR | S_IRGRP | S_IROTH, PARTITION_devfs_open, (void *)partition);
+}
+
+int PARTITION_bcache_device(char const *label, struct BCACHE_device *dev)
+{
+    esp_partition_t const *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        ESP_PARTITION_SUBTYPE_ANY, label);
+
+    if (! partition)
+        return __set_errno_neg(ENOENT);
+
+    dev->ctx = (void *)partition;
+    dev->size = partition->size;
+    dev->read = PARTITION_dev_read;
+    dev->write = PARTITION_dev_write;
+    /// esp_partition_write() is completed when it returns
+    dev->sync = NULL;
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements DEVFS_open_t
+****************************************************************************/
+static int PARTITION_devfs_open(void *arg, int flags)
+{
+    if (O_RDONLY != (O_ACCMODE & flags))
+        return __set_errno_neg(EROFS);
+    else
+        return KERNEL_createfd(FD_TAG_BLOCK, &PARTITION_fdio, arg);
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t PARTITION_read(int fd, void *buf, size_t bufsize)
+{
+    ssize_t retval = PARTITION_pread(fd, buf, bufsize, (off_t)AsFD(fd)->position);
+
+    if (0 < retval)
+        AsFD(fd)->position += (uintptr_t)retval;
+    return retval;
+}
+
+static ssize_t PARTITION_pread(int fd, void *buf, size_t bufsize, off_t offset)
+{
+    esp_partition_t const *partition = AsFD(fd)->ext;
+
+    if ((size_t)offset >= partition->size)
+        return 0;
+    if (bufsize > partition->size - (size_t)offset)
+        bufsize = partition->size - (size_t)offset;
+
+    int err = PARTITION_error(esp_partition_read(partition, (size_t)offset, buf, bufsize));
+    if (0 != err)
+        return __set_errno_neg(err);
+    else
+        return (ssize_t)bufsize;
+}
+
+static off_t PARTITION_seek(int fd, off_t offset, int origin)
+{
+    esp_partition_t const *partition = AsFD(fd)->ext;
+
+    switch (origin)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += (off_t)AsFD(fd)->position;
+        break;
+    case SEEK_END:
+        offset += (off_t)partition->size;
+        break;
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+
+    if (0 > offset)
+        return __set_errno_neg(EINVAL);
+
+    AsFD(fd)->position = (uintptr_t)offset;
+    return offset;
+}
+
+static int PARTITION_close(int fd)
+{
+    ARG_UNUSED(fd);
+    return 0;
+}
+
+static int PARTITION_flash_addr(int fd, off_t offset, uintptr_t *paddr, size_t *count)
+{
+    esp_partition_t const *partition = AsFD(fd)->ext;
+
+    /// encrypted content is not readable through the data bus mapping as raw bytes
+    if (partition->encrypted)
+        return ENODEV;
+    if (0 > offset || (size_t)offset >= partition->size)
+        return ENXIO;
+
+    /// the whole partition is physically contiguous
+    *paddr = partition->address + (uintptr_t)offset;
+    if (*count > partition->size - (size_t)offset)
+        *count = partition->size - (size_t)offset;
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements BCACHE_device
+****************************************************************************/
+static int PARTITION_dev_read(void *ctx, uint64_t addr, void *buf, size_t size)
+{
+    return PARTITION_error(esp_partition_read(ctx, (size_t)addr, buf, size));
+}
+
+static int PARTITION_dev_write(void *ctx, uint64_t addr, void const *buf, size_t size)
+{
+    /// cache blocks are multiple of sectors, every write-back replaces whole sectors
+    int err = PARTITION_error(esp_partition_erase_range(ctx, (size_t)addr, size));
+
+    if (0 == err)
+        err = PARTITION_error(esp_partition_write(ctx, (size_t)addr, buf, size));
+    return err;
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static int PARTITION_error(esp_err_t err)
+{
+    switch (err)
+    {
+    case ESP_OK:
+        return 0;
+    case ESP_ERR_INVALID_ARG:
+    case ESP_ERR_INVALID_SIZE:
+        return EINVAL;
+    default:
+        return EIO;
+    }
+}
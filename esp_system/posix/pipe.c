@@ -0,0 +1,446 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+#include <semaphore.h>
+#include <string.h>
+#include <sys/limits.h>
+#include <unistd.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <ringbuf.h>
+
+#include <rtos/devfs.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+/// capacity of pipe's byte ring, write() <= PIPE_BUF is never split
+#ifndef PIPE_RING_SIZE
+    #define PIPE_RING_SIZE              (4096)
+#endif
+
+#if PIPE_RING_SIZE < PIPE_BUF
+    #error "PIPE_RING_SIZE: must be able to hold an atomic write of PIPE_BUF"
+#endif
+
+struct PIPE
+{
+    RingbufHandle_t ring;
+    StaticRingbuffer_t ring_static;
+
+    /// readers / writers are serialized, the ring allows only one retrieval at a time
+    mutex_t *rd_lock;
+    mutex_t *wr_lock;
+
+    /**
+     *  binary semaphores: read_rdy / write_rdy of pipe's fds
+     *      .readable is given after write(), or when the last writer is closed
+     *      .writable is given after read(), or when the last reader is closed
+     */
+    sem_t readable;
+    sem_t writable;
+
+    /// readers / writers / named / writer_opened are modified with lock
+    spinlock_t lock;
+    uint16_t readers;
+    uint16_t writers;
+    /**
+     *  named FIFO is freed by the last close() after its node was removed, eg. unlink("/dev/fifo")
+     *      .reading before any writer opened it is not EOF
+     */
+    bool named;
+    bool writer_opened;
+
+    uint8_t storage[];
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static ssize_t PIPE_read(int fd, void *buf, size_t bufsize);
+static ssize_t PIPE_write(int fd, void const *buf, size_t count);
+static int PIPE_close(int fd);
+
+static struct PIPE *PIPE_alloc(bool named);
+static void PIPE_free(struct PIPE *pipe);
+static int PIPE_createfd(struct PIPE *pipe, int flags);
+static size_t PIPE_drain(struct PIPE *pipe, uint8_t *buf, size_t bufsize);
+static bool PIPE_eof(struct PIPE *pipe);
+static uint16_t PIPE_readers(struct PIPE *pipe);
+static uint32_t PIPE_timeo(int fd, uint32_t timeo);
+static int PIPE_timeo_error(uint32_t timeo);
+static int FIFO_open(void *arg, int flags);
+static void FIFO_release(void *arg);
+
+/// @variable
+static struct FD_implement const PIPE_rd_implement =
+{
+    .read = PIPE_read,
+    .write = NULL,
+    .seek = NULL,
+    .close = PIPE_close,
+    .ioctl = NULL,
+};
+
+static struct FD_implement const PIPE_wr_implement =
+{
+    .read = NULL,
+    .write = PIPE_write,
+    .seek = NULL,
+    .close = PIPE_close,
+    .ioctl = NULL,
+};
+
+/***************************************************************************/
+/** @implements unistd.h
+****************************************************************************/
+int pipe(int fildes[2])
+{
+    return pipe2(fildes, 0);
+}
+
+int pipe2(int fildes[2], int flags)
+{
+    if (0 != (~(O_NONBLOCK | O_CLOEXEC) & flags))
+        return __set_errno_neg(EINVAL);
+
+    struct PIPE *pipe = PIPE_alloc(false);
+    if (! pipe)
+        return -1;
+
+    /// O_CLOEXEC: no exec() in UltraCore
+    flags &= O_NONBLOCK;
+
+    fildes[0] = PIPE_createfd(pipe, O_RDONLY | flags);
+    if (-1 == fildes[0])
+    {
+        PIPE_free(pipe);
+        return -1;
+    }
+
+    fildes[1] = PIPE_createfd(pipe, O_WRONLY | flags);
+    if (-1 == fildes[1])
+    {
+        /// closing the read end releases the pipe
+        close(fildes[0]);
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements sys/stat.h
+****************************************************************************/
+int mkfifo(char const *path, mode_t mode)
+{
+    static char const prefix[] = "/" DEVFS_DIR "/";
+
+    /// named FIFO is a devfs node, there is no FIFO inode in tmpfs or any other filesystem
+    if (0 != strncmp(path, prefix, sizeof(prefix) - 1))
+        return __set_errno_neg(ENOTSUP);
+
+    struct PIPE *pipe = PIPE_alloc(true);
+    if (! pipe)
+        return -1;
+
+    if (0 != DEVFS_register_release(path + sizeof(prefix) - 1, S_IFIFO | (mode & ~S_IFMT),
+        FIFO_open, FIFO_release, pipe))
+    {
+        PIPE_free(pipe);
+        return -1;
+    }
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t PIPE_read(int fd, void *buf, size_t bufsize)
+{
+    struct PIPE *pipe = AsFD(fd)->ext;
+    uint32_t timeo = PIPE_timeo(fd, AsFD(fd)->read_timeo);
+
+    if (0 != mutex_trylock(pipe->rd_lock, timeo))
+        return __set_errno_neg(PIPE_timeo_error(timeo));
+
+    ssize_t retval;
+    while (true)
+    {
+        /// readable is only a hint, it is re-given below when anything is left
+        sem_trywait(&pipe->readable);
+
+        retval = (ssize_t)PIPE_drain(pipe, buf, bufsize);
+        if (0 < retval || PIPE_eof(pipe))
+            break;
+
+        if (0 != sem_timedwait_ms(&pipe->readable, timeo))
+        {
+            retval = __set_errno_neg(PIPE_timeo_error(timeo));
+            break;
+        }
+    }
+
+    if (0 < retval)
+        sem_post(&pipe->writable);
+    /// more to read or EOF for the next reader
+    if (PIPE_eof(pipe) || xRingbufferGetCurFreeSize(pipe->ring) < PIPE_RING_SIZE)
+        sem_post(&pipe->readable);
+
+    mutex_unlock(pipe->rd_lock);
+    return retval;
+}
+
+static ssize_t PIPE_write(int fd, void const *buf, size_t count)
+{
+    struct PIPE *pipe = AsFD(fd)->ext;
+    uint32_t timeo = PIPE_timeo(fd, AsFD(fd)->write_timeo);
+
+    if (0 != mutex_trylock(pipe->wr_lock, timeo))
+        return __set_errno_neg(PIPE_timeo_error(timeo));
+
+    size_t written = 0;
+    int err = 0;
+
+    while (written < count)
+    {
+        if (0 == PIPE_readers(pipe))
+        {
+            err = EPIPE;
+            break;
+        }
+        sem_trywait(&pipe->writable);
+
+        size_t chunk = xRingbufferGetCurFreeSize(pipe->ring);
+        if (chunk > count - written)
+            chunk = count - written;
+        /// write() of no more than PIPE_BUF is atomic
+        if (count <= PIPE_BUF && chunk < count)
+            chunk = 0;
+
+        /// writers are serialized, free size only grows until send: a refused send waits as full
+        if (0 < chunk && pdTRUE == xRingbufferSend(pipe->ring, (uint8_t const *)buf + written, chunk, 0))
+        {
+            written += chunk;
+            sem_post(&pipe->readable);
+        }
+        else if (0 != sem_timedwait_ms(&pipe->writable, timeo))
+        {
+            err = PIPE_timeo_error(timeo);
+            break;
+        }
+    }
+
+    if (0 < xRingbufferGetCurFreeSize(pipe->ring) || 0 == PIPE_readers(pipe))
+        sem_post(&pipe->writable);
+    mutex_unlock(pipe->wr_lock);
+
+    if (0 < written || 0 == err)
+        return (ssize_t)written;
+    else
+        return __set_errno_neg(err);
+}
+
+static int PIPE_close(int fd)
+{
+    struct PIPE *pipe = AsFD(fd)->ext;
+    sem_t *wakeup = NULL;
+    bool release;
+
+    spin_lock(&pipe->lock);
+    if (&PIPE_rd_implement == AsFD(fd)->implement)
+    {
+        /// wakeup writers to EPIPE
+        if (0 == -- pipe->readers)
+        {
+            wakeup = &pipe->writable;
+            /// named FIFO: the next reader waits for a new writer instead of EOF
+            if (0 == pipe->writers)
+                pipe->writer_opened = false;
+        }
+    }
+    else
+    {
+        /// wakeup readers to EOF
+        if (0 == -- pipe->writers)
+            wakeup = &pipe->readable;
+    }
+    release = ! pipe->named && 0 == pipe->readers && 0 == pipe->writers;
+    spin_unlock(&pipe->lock);
+
+    /// semaphores are inside pipe, they are not recycled as handles
+    AsFD(fd)->read_rdy = AsFD(fd)->write_rdy = INVALID_HANDLE;
+
+    if (release)
+        PIPE_free(pipe);
+    else if (wakeup)
+        sem_post(wakeup);
+    return 0;
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct PIPE *PIPE_alloc(bool named)
+{
+    struct PIPE *pipe = KERNEL_mallocz(sizeof(struct PIPE) + PIPE_RING_SIZE);
+    if (! pipe)
+        return __set_errno_nullptr(ENOMEM);
+
+    /// handle managed mutex: destroyed handle is recycled after pipe was freed
+    pipe->rd_lock = mutex_create(MUTEX_FLAG_NORMAL);
+    pipe->wr_lock = mutex_create(MUTEX_FLAG_NORMAL);
+
+    if (! pipe->rd_lock || ! pipe->wr_lock)
+    {
+        PIPE_free(pipe);
+        return __set_errno_nullptr(ENOMEM);
+    }
+
+    pipe->ring = xRingbufferCreateStatic(PIPE_RING_SIZE, RINGBUF_TYPE_BYTEBUF, pipe->storage, &pipe->ring_static);
+    sem_init_np(&pipe->readable, 0, 0, 1);
+    sem_init_np(&pipe->writable, 0, 1, 1);
+    spinlock_init(&pipe->lock);
+    pipe->named = named;
+
+    return pipe;
+}
+
+static void PIPE_free(struct PIPE *pipe)
+{
+    if (pipe->ring)
+        vRingbufferDelete(pipe->ring);
+    if (pipe->rd_lock)
+        mutex_destroy(pipe->rd_lock);
+    if (pipe->wr_lock)
+        mutex_destroy(pipe->wr_lock);
+
+    KERNEL_mfree(pipe);
+}
+
+static int PIPE_createfd(struct PIPE *pipe, int flags)
+{
+    bool reading = O_WRONLY != (O_ACCMODE & flags);
+    int fd = KERNEL_createfd(FD_TAG_FIFO,
+        reading ? &PIPE_rd_implement : &PIPE_wr_implement, pipe);
+
+    if (-1 != fd)
+    {
+        if (O_NONBLOCK & flags)
+            AsFD(fd)->flags |= FD_FLAG_NONBLOCK;
+
+        spin_lock(&pipe->lock);
+        if (reading)
+        {
+            pipe->readers ++;
+            AsFD(fd)->read_rdy = &pipe->readable;
+        }
+        else
+        {
+            pipe->writers ++;
+            pipe->writer_opened = true;
+            AsFD(fd)->write_rdy = &pipe->writable;
+        }
+        spin_unlock(&pipe->lock);
+    }
+    return fd;
+}
+
+/**
+ *  read everything contiguous up to bufsize, the ring hands out its own storage without copying,
+ *      data wraps around the end of the ring is retrieved by a second pass
+ */
+static size_t PIPE_drain(struct PIPE *pipe, uint8_t *buf, size_t bufsize)
+{
+    size_t filled = 0;
+
+    while (filled < bufsize)
+    {
+        size_t count;
+        void *ptr = xRingbufferReceiveUpTo(pipe->ring, &count, 0, bufsize - filled);
+        if (! ptr)
+            break;
+
+        memcpy(buf + filled, ptr, count);
+        vRingbufferReturnItem(pipe->ring, ptr);
+        filled += count;
+    }
+    return filled;
+}
+
+static bool PIPE_eof(struct PIPE *pipe)
+{
+    spin_lock(&pipe->lock);
+    bool eof = 0 == pipe->writers && (! pipe->named || pipe->writer_opened);
+    spin_unlock(&pipe->lock);
+
+    return eof;
+}
+
+static uint16_t PIPE_readers(struct PIPE *pipe)
+{
+    spin_lock(&pipe->lock);
+    uint16_t readers = pipe->readers;
+    spin_unlock(&pipe->lock);
+
+    return readers;
+}
+
+static uint32_t PIPE_timeo(int fd, uint32_t timeo)
+{
+    if (FD_FLAG_NONBLOCK & AsFD(fd)->flags)
+        return 0;
+    else if (0 == timeo)
+        return WAIT_FOREVER;
+    else
+        return timeo;
+}
+
+/// O_NONBLOCK is EAGAIN, an expired read / write timeout is ETIMEDOUT
+static int PIPE_timeo_error(uint32_t timeo)
+{
+    return 0 == timeo ? EAGAIN : ETIMEDOUT;
+}
+
+/**
+ *  open() of named FIFO never waits for the other end, devfs calls it with devfs locked
+ *      .O_WRONLY | O_NONBLOCK without reader is ENXIO as POSIX
+ *      .O_RDWR opens the read end
+ */
+static int FIFO_open(void *arg, int flags)
+{
+    struct PIPE *pipe = arg;
+
+    if (O_WRONLY == (O_ACCMODE & flags) && (O_NONBLOCK & flags) && 0 == PIPE_readers(pipe))
+        return __set_errno_neg(ENXIO);
+    else
+        return PIPE_createfd(pipe, flags);
+}
+
+/// node was removed: the FIFO becomes an unnamed pipe, it is freed by the last close()
+static void FIFO_release(void *arg)
+{
+    struct PIPE *pipe = arg;
+    bool release;
+
+    spin_lock(&pipe->lock);
+    pipe->named = false;
+    release = 0 == pipe->readers && 0 == pipe->writers;
+    spin_unlock(&pipe->lock);
+
+    if (release)
+        PIPE_free(pipe);
+}
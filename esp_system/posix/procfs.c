@@ -0,0 +1,537 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <esp_heap_caps.h>
+#include <esp_arch.h>
+#include <soc/soc_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <aio.h>
+
+/// @implements headers
+#include <rtos/procfs.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define INO_CURRENT_DIR                 ((ino_t)-2)
+
+/**
+ *  file node, slot index + 1 is the ino, ino 0 is /proc itself
+ *      .free slot has namelen 0
+ */
+struct PROCFS_node
+{
+    PROCFS_generator_t generator;
+    void *arg;
+
+    uint8_t namelen;
+    char name[PROCFS_NAME_MAX + 1];
+};
+
+#define PROCFS_BUILTIN(NAME, GENERATOR) \
+    {.generator = GENERATOR, .arg = NULL, .namelen = sizeof(NAME) - 1, .name = NAME}
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int PROCFS_fs_open(struct fsio_t *fsio);
+static int PROCFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent);
+static int PROCFS_fs_fstat(struct fsio_t *fsio, struct stat *st);
+
+static ssize_t PROCFS_read(int fd, void *buf, size_t bufsize);
+static off_t PROCFS_seek(int fd, off_t offset, int origin);
+static int PROCFS_close(int fd);
+
+static struct PROCFS_node *PROCFS_node_get(ino_t ino);
+static int PROCFS_render(struct PROCFS_node *node, struct fsio_t *fsio);
+static void PROCFS_fill_dirent(struct PROCFS_node *node, struct dirent *ent);
+
+// builtin generators
+static void PROCFS_handles(struct PROCFS_output *out, void *arg);
+static void PROCFS_meminfo(struct PROCFS_output *out, void *arg);
+static void PROCFS_threads(struct PROCFS_output *out, void *arg);
+static void PROCFS_aio(struct PROCFS_output *out, void *arg);
+static void PROCFS_interrupts(struct PROCFS_output *out, void *arg);
+
+/// @variable
+static struct FD_implement const PROCFS_fsio =
+{
+    .read = PROCFS_read,
+    .write = NULL,
+    .seek = PROCFS_seek,
+    .close = PROCFS_close,
+    .ioctl = NULL,
+};
+
+/// register() only, generators are never unregistered
+static mutex_t PROCFS_lock = MUTEX_INITIALIZER;
+static struct PROCFS_node PROCFS_nodes[PROCFS_MAX_NODES] =
+{
+    PROCFS_BUILTIN("handles", PROCFS_handles),
+    PROCFS_BUILTIN("meminfo", PROCFS_meminfo),
+    PROCFS_BUILTIN("threads", PROCFS_threads),
+    PROCFS_BUILTIN("aio", PROCFS_aio),
+    PROCFS_BUILTIN("interrupts", PROCFS_interrupts),
+};
+
+/***************************************************************************/
+/** @export
+****************************************************************************/
+struct FS_implement const PROCFS_implement =
+{
+    .name = "procfs",
+    .dirent_size = DIRENT_SIZE(PROCFS_NAME_MAX + 1),
+    .fsio = &PROCFS_fsio,
+
+    .open = PROCFS_fs_open,
+    .create = NULL,
+    .truncate = NULL,
+    .unlink = NULL,
+    .format = NULL,
+    .lookup = PROCFS_fs_lookup,
+    .getdents = NULL,
+    .fstat = PROCFS_fs_fstat,
+};
+
+/***************************************************************************/
+/** @implements procfs.h
+****************************************************************************/
+int PROCFS_register(char const *name, PROCFS_generator_t generator, void *arg)
+{
+    size_t namelen = strlen(name);
+
+    if (0 == namelen || NULL != strchr(name, '/'))
+        return __set_errno_neg(EINVAL);
+    if (PROCFS_NAME_MAX < namelen)
+        return __set_errno_neg(ENAMETOOLONG);
+
+    struct PROCFS_node *slot = NULL;
+    int retval = 0;
+
+    mutex_lock(&PROCFS_lock);
+    for (unsigned i = 0; i < lengthof(PROCFS_nodes); i ++)
+    {
+        struct PROCFS_node *node = &PROCFS_nodes[i];
+
+        if (0 == node->namelen)
+        {
+            if (! slot)
+                slot = node;
+        }
+        else if (namelen == node->namelen && 0 == memcmp(name, node->name, namelen))
+        {
+            retval = __set_errno_neg(EEXIST);
+            break;
+        }
+    }
+
+    if (0 == retval)
+    {
+        if (! slot)
+            retval = __set_errno_neg(ENOSPC);
+        else
+        {
+            slot->generator = generator;
+            slot->arg = arg;
+            memcpy(slot->name, name, namelen + 1);
+
+            /// @publish: lookups are lock-free, namelen is the last written
+            __atomic_store_n(&slot->namelen, (uint8_t)namelen, __ATOMIC_RELEASE);
+        }
+    }
+    mutex_unlock(&PROCFS_lock);
+
+    return retval;
+}
+
+void PROCFS_printf(struct PROCFS_output *out, char const *fmt, ...)
+{
+    char line[PROCFS_LINE_MAX];
+
+    va_list vl;
+    va_start(vl, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, vl);
+    va_end(vl);
+
+    if (0 < len)
+        PROCFS_write(out, line, (size_t)len < sizeof(line) ? (size_t)len : sizeof(line) - 1);
+}
+
+void PROCFS_write(struct PROCFS_output *out, void const *buf, size_t count)
+{
+    out->rendered += count;
+    if (PROCFS_full(out))
+        return;
+
+    if (count > out->bufsize - out->filled)
+        count = out->bufsize - out->filled;
+
+    memcpy(&out->buf[out->filled], buf, count);
+    out->filled += count;
+}
+
+/***************************************************************************/
+/** @implements FS_implement
+****************************************************************************/
+static int PROCFS_fs_open(struct fsio_t *fsio)
+{
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+        fsio->ino_entry = fsio->ino_working = 0;
+
+    if (0 == fsio->ino_entry)
+        return KERNEL_createfd(FD_TAG_DIR, &PROCFS_fsio, fsio);
+
+    if (O_ACCMODE & fsio->flags)
+        return __set_errno_neg(EACCES);
+
+    struct PROCFS_node *node = PROCFS_node_get(fsio->ino_entry);
+    if (! node)
+        return __set_errno_neg(ENOENT);
+
+    /// @snapshot: rendered once, fsio->fd_data / fsio->size is the text of this fd
+    int err = PROCFS_render(node, fsio);
+    if (0 != err)
+        return __set_errno_neg(err);
+
+    int fd = KERNEL_createfd(FD_TAG_REG, &PROCFS_fsio, fsio);
+    if (-1 == fd)
+    {
+        KERNEL_mfree(fsio->fd_data);
+        fsio->fd_data = NULL;
+    }
+    return fd;
+}
+
+static int PROCFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent)
+{
+    ARG_UNUSED(fsio);
+
+    for (unsigned i = 0; i < lengthof(PROCFS_nodes); i ++)
+    {
+        struct PROCFS_node *node = &PROCFS_nodes[i];
+
+        if (namelen == __atomic_load_n(&node->namelen, __ATOMIC_ACQUIRE) &&
+            0 == memcmp(name, node->name, namelen))
+        {
+            PROCFS_fill_dirent(node, ent);
+            return 0;
+        }
+    }
+    return __set_errno_neg(ENOENT);
+}
+
+static int PROCFS_fs_fstat(struct fsio_t *fsio, struct stat *st)
+{
+    /// size of generated files is the text rendered by open()
+    if (0 == fsio->ino_entry)
+    {
+        st->st_mode = S_IFDIR | S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
+        st->st_size = 0;
+    }
+    else
+    {
+        st->st_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+        st->st_size = (off_t)fsio->size;
+    }
+    st->st_nlink = 1;
+    st->st_blksize = PROCFS_LINE_MAX;
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t PROCFS_read(int fd, void *buf, size_t bufsize)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+
+    if (0 == fsio->ino_entry)
+    {
+        /// @readdir: position is the slot index to continue
+        if (bufsize < PROCFS_implement.dirent_size)
+            return __set_errno_neg(EINVAL);
+
+        uintptr_t pos = AsFD(fd)->position;
+        ssize_t retval = 0;
+
+        for (; pos < lengthof(PROCFS_nodes); pos ++)
+        {
+            if (0 != __atomic_load_n(&PROCFS_nodes[pos].namelen, __ATOMIC_ACQUIRE))
+            {
+                PROCFS_fill_dirent(&PROCFS_nodes[pos], buf);
+                retval = (ssize_t)PROCFS_implement.dirent_size;
+
+                pos ++;
+                break;
+            }
+        }
+        AsFD(fd)->position = pos;
+        return retval;
+    }
+
+    uintptr_t pos = AsFD(fd)->position;
+    if (pos >= fsio->size)
+        return 0;
+
+    if (bufsize > fsio->size - pos)
+        bufsize = fsio->size - pos;
+
+    memcpy(buf, (char const *)fsio->fd_data + pos, bufsize);
+    AsFD(fd)->position = pos + bufsize;
+    return (ssize_t)bufsize;
+}
+
+static off_t PROCFS_seek(int fd, off_t offset, int origin)
+{
+    switch (origin)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += (off_t)AsFD(fd)->position;
+        break;
+    case SEEK_END:
+        offset += (off_t)((struct fsio_t *)AsFD(fd)->fsio)->size;
+        break;
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+
+    if (0 > offset)
+        return __set_errno_neg(EINVAL);
+
+    AsFD(fd)->position = (uintptr_t)offset;
+    return offset;
+}
+
+static int PROCFS_close(int fd)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+
+    if (0 != fsio->ino_entry)
+    {
+        KERNEL_mfree(fsio->fd_data);
+        fsio->fd_data = NULL;
+    }
+    return 0;
+}
+
+/***************************************************************************/
+/** @builtin generators
+****************************************************************************/
+static void PROCFS_handles(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+    struct KERNEL_handle_stats stats;
+
+    KERNEL_handle_stats(&stats);
+    PROCFS_printf(out, "total:      %u\n", (unsigned)stats.total);
+    PROCFS_printf(out, "used:       %u\n", (unsigned)stats.used);
+    PROCFS_printf(out, "peak:       %u\n", (unsigned)stats.peak);
+    PROCFS_printf(out, "destroying: %u\n", (unsigned)stats.destroying);
+}
+
+static void PROCFS_meminfo(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+
+    static struct
+    {
+        char const *name;
+        uint32_t caps;
+    } const heaps[] =
+    {
+        {"internal", MALLOC_CAP_INTERNAL},
+        {"dma", MALLOC_CAP_DMA},
+        {"spiram", MALLOC_CAP_SPIRAM},
+    };
+
+    PROCFS_printf(out, "%-10s %10s %10s %10s %10s\n", "heap", "total", "free", "min_free", "largest");
+    for (unsigned i = 0; i < lengthof(heaps); i ++)
+    {
+        size_t total = heap_caps_get_total_size(heaps[i].caps);
+        if (0 == total)
+            continue;
+
+        PROCFS_printf(out, "%-10s %10u %10u %10u %10u\n", heaps[i].name,
+            (unsigned)total,
+            (unsigned)heap_caps_get_free_size(heaps[i].caps),
+            (unsigned)heap_caps_get_minimum_free_size(heaps[i].caps),
+            (unsigned)heap_caps_get_largest_free_block(heaps[i].caps)
+        );
+    }
+}
+
+static void PROCFS_threads(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+
+#if configUSE_TRACE_FACILITY
+    static char const states[] = {'R', 'r', 'B', 'S', 'D', '?'};
+
+    /// snapshot of task states, only the snapshot is allocated
+    UBaseType_t count = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *tasks = KERNEL_malloc(sizeof(TaskStatus_t) * count);
+
+    if (! tasks)
+    {
+        PROCFS_printf(out, "ENOMEM\n");
+        return;
+    }
+    count = uxTaskGetSystemState(tasks, count, NULL);
+
+    PROCFS_printf(out, "%-4s %-16s %5s %4s %10s\n", "id", "name", "state", "prio", "stack_free");
+    for (UBaseType_t i = 0; i < count && ! PROCFS_full(out); i ++)
+    {
+        unsigned state = (unsigned)tasks[i].eCurrentState;
+
+        PROCFS_printf(out, "%-4u %-16s %5c %4u %10u\n",
+            (unsigned)tasks[i].xTaskNumber,
+            tasks[i].pcTaskName,
+            states[state < lengthof(states) ? state : lengthof(states) - 1],
+            (unsigned)tasks[i].uxCurrentPriority,
+            (unsigned)tasks[i].usStackHighWaterMark
+        );
+    }
+    KERNEL_mfree(tasks);
+#else
+    PROCFS_printf(out, "threads: %u\n", (unsigned)uxTaskGetNumberOfTasks());
+#endif
+}
+
+static void PROCFS_aio(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+    struct aio_stats stats;
+
+    aio_stats_np(&stats, false);
+    PROCFS_printf(out, "submitted:  %u\n", (unsigned)stats.submitted);
+    PROCFS_printf(out, "completed:  %u\n", (unsigned)stats.completed);
+    PROCFS_printf(out, "failed:     %u\n", (unsigned)stats.failed);
+    PROCFS_printf(out, "cancelled:  %u\n", (unsigned)stats.cancelled);
+    PROCFS_printf(out, "queue_full: %u\n", (unsigned)stats.queue_full);
+    PROCFS_printf(out, "max_depth:  %u\n", (unsigned)stats.max_depth);
+    PROCFS_printf(out, "latency_max_us: %u\n", (unsigned)stats.latency_max_us);
+
+    for (unsigned i = 0; i < AIO_LATENCY_BUCKETS; i ++)
+    {
+        if (i + 1 < AIO_LATENCY_BUCKETS)
+            PROCFS_printf(out, "latency_lt_%luus: %u\n", (unsigned long)AIO_LATENCY_BUCKET_US(i),
+                (unsigned)stats.latency_hist[i]);
+        else
+            PROCFS_printf(out, "latency_other: %u\n", (unsigned)stats.latency_hist[i]);
+    }
+}
+
+static void PROCFS_interrupts(struct PROCFS_output *out, void *arg)
+{
+    ARG_UNUSED(arg);
+
+    PROCFS_printf(out, "%-4s", "int");
+    for (unsigned cpu = 0; cpu < SOC_CPU_CORES_NUM; cpu ++)
+        PROCFS_printf(out, " %10s%u", "cpu", cpu);
+    PROCFS_printf(out, "\n");
+
+    /// interrupts never dispatched on any cpu are omitted
+    for (unsigned intr = 0; intr < SOC_CPU_INTR_NUM && ! PROCFS_full(out); intr ++)
+    {
+        uint32_t counts[SOC_CPU_CORES_NUM];
+        uint32_t any = 0;
+
+        for (unsigned cpu = 0; cpu < SOC_CPU_CORES_NUM; cpu ++)
+            any |= counts[cpu] = __intr_nb_count(intr, cpu);
+        if (0 == any)
+            continue;
+
+        PROCFS_printf(out, "%-4u", intr);
+        for (unsigned cpu = 0; cpu < SOC_CPU_CORES_NUM; cpu ++)
+            PROCFS_printf(out, " %11u", (unsigned)counts[cpu]);
+        PROCFS_printf(out, "\n");
+    }
+    /// RTOS tick is not dispatched by the interrupt table
+    PROCFS_printf(out, "tick %u\n", (unsigned)xTaskGetTickCount());
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct PROCFS_node *PROCFS_node_get(ino_t ino)
+{
+    if (0 == ino || lengthof(PROCFS_nodes) < ino)
+        return NULL;
+
+    struct PROCFS_node *node = &PROCFS_nodes[ino - 1];
+    return __atomic_load_n(&node->namelen, __ATOMIC_ACQUIRE) ? node : NULL;
+}
+
+/// @returns 0 or errno, fsio->fd_data is the rendered text of fsio->size bytes
+static int PROCFS_render(struct PROCFS_node *node, struct fsio_t *fsio)
+{
+    size_t bufsize = PROCFS_RENDER_SIZE;
+
+    while (true)
+    {
+        char *buf = KERNEL_malloc(bufsize);
+        if (! buf)
+            return ENOMEM;
+
+        struct PROCFS_output out =
+        {
+            .buf = buf,
+            .bufsize = bufsize,
+            .filled = 0,
+            .rendered = 0,
+        };
+        node->generator(&out, node->arg);
+
+        if (! PROCFS_full(&out))
+        {
+            fsio->fd_data = buf;
+            fsio->size = out.filled;
+            return 0;
+        }
+        KERNEL_mfree(buf);
+
+        /// overflowed: counted size with slack for changing counters, or double when the generator stopped early
+        bufsize = out.rendered > bufsize ? out.rendered + PROCFS_LINE_MAX : bufsize * 2;
+    }
+}
+
+static void PROCFS_fill_dirent(struct PROCFS_node *node, struct dirent *ent)
+{
+    ent->d_filesystem = NULL;
+    ent->d_mode = S_IFREG | S_IRUSR | S_IRGRP | S_IROTH;
+    ent->d_ino = (ino_t)(node - PROCFS_nodes + 1);
+    ent->d_size = 0;
+    ent->d_creation_ts = 0;
+    ent->d_modificaion_ts = 0;
+    ent->d_namelen = node->namelen;
+
+    memcpy(ent->d_name, node->name, node->namelen);
+    ent->d_name[node->namelen] = '\0';
+}
@@ -0,0 +1,979 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <esp_heap_caps.h>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+
+/// @implements headers
+#include <rtos/tmpfs.h>
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define INO_CURRENT_DIR                 ((ino_t)-2)
+/// ino 0 is the root directory, ino (-3 ~ -1) are reserved by filesystem.c
+#define TMPFS_INO_LIMIT                 ((ino_t)-3)
+#define TMPFS_INO_TABLE_INC             (32)
+
+/// directory hash buckets: initial count, resize when average chain length exceeded
+#define TMPFS_HASH_BUCKETS              (8)
+#define TMPFS_HASH_LOAD                 (2)
+
+/// file content allocation granularity
+#define TMPFS_BLOCK_SIZE                (256)
+
+/// readdir() position of end of directory
+#define TMPFS_POS_END                   ((uintptr_t)-1)
+
+struct TMPFS_node
+{
+    struct TMPFS_node *hash_next;
+    struct TMPFS_node *parent;
+    /// directory entries in creation order for readdir()
+    struct TMPFS_node *prev;
+    struct TMPFS_node *next;
+
+    ino_t ino;
+    mode_t mode;
+    /// fds opened this node
+    uint16_t refcount;
+    uint16_t namelen;
+    uint32_t hash;
+
+    time_t creation_ts;
+    time_t modification_ts;
+
+    union
+    {
+        struct
+        {
+            uint8_t *content;
+            size_t size;
+            size_t capacity;
+        } file;
+
+        struct
+        {
+            struct TMPFS_node **buckets;
+            struct TMPFS_node *head;
+            struct TMPFS_node *tail;
+            uint32_t bucket_count;
+            uint32_t count;
+        } dir;
+    };
+
+    char name[];
+};
+
+struct TMPFS
+{
+    mutex_t *lock;
+    unsigned flags;
+
+    size_t size_cap;
+    size_t used;
+
+    /// ino => node
+    struct TMPFS_node **inodes;
+    ino_t inode_count;
+    ino_t inode_hint;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int TMPFS_fs_open(struct fsio_t *fsio);
+static int TMPFS_fs_create(struct fsio_t *fsio, char const *name, mode_t mode);
+static int TMPFS_fs_truncate(struct fsio_t *fsio, off_t size);
+static int TMPFS_fs_unlink(struct fsio_t *fsio, ino_t ino);
+static int TMPFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent);
+static ssize_t TMPFS_fs_getdents(int fd, void *buf, size_t bufsize);
+static int TMPFS_fs_fstat(struct fsio_t *fsio, struct stat *st);
+
+static ssize_t TMPFS_read(int fd, void *buf, size_t bufsize);
+static ssize_t TMPFS_write(int fd, void const *buf, size_t count);
+static off_t TMPFS_seek(int fd, off_t offset, int origin);
+static int TMPFS_close(int fd);
+static ssize_t TMPFS_pread(int fd, void *buf, size_t bufsize, off_t offset);
+static ssize_t TMPFS_pwrite(int fd, void const *buf, size_t count, off_t offset);
+
+static struct TMPFS *TMPFS_root_instance(void);
+static struct TMPFS_node *TMPFS_node_get(struct TMPFS *tmpfs, ino_t ino);
+static struct TMPFS_node *TMPFS_node_alloc(struct TMPFS *tmpfs, char const *name, size_t namelen, mode_t mode);
+static void TMPFS_node_free(struct TMPFS *tmpfs, struct TMPFS_node *node);
+static struct TMPFS_node *TMPFS_dir_find(struct TMPFS_node *dir, char const *name, size_t namelen, uint32_t hash);
+static int TMPFS_dir_insert(struct TMPFS *tmpfs, struct TMPFS_node *dir, struct TMPFS_node *node);
+static void TMPFS_dir_remove(struct TMPFS_node *dir, struct TMPFS_node *node);
+static int TMPFS_file_resize(struct TMPFS *tmpfs, struct TMPFS_node *node, size_t size);
+static ssize_t TMPFS_file_read(struct TMPFS_node *node, uintptr_t pos, void *buf, size_t bufsize);
+static ssize_t TMPFS_file_write(struct TMPFS *tmpfs, struct fsio_t *fsio, struct TMPFS_node *node,
+    uintptr_t pos, void const *buf, size_t count);
+static void TMPFS_fill_dirent(struct TMPFS_node *node, struct dirent *ent);
+static uint32_t TMPFS_hash(char const *name, size_t namelen);
+
+/// @variable
+static struct FD_implement const TMPFS_fsio =
+{
+    .read = TMPFS_read,
+    .write = TMPFS_write,
+    .seek = TMPFS_seek,
+    .close = TMPFS_close,
+    .ioctl = NULL,
+    .pread = TMPFS_pread,
+    .pwrite = TMPFS_pwrite,
+};
+
+static struct TMPFS *TMPFS_root = NULL;
+static mutex_t TMPFS_root_lock = MUTEX_INITIALIZER;
+
+/***************************************************************************/
+/** @export
+****************************************************************************/
+struct FS_implement const TMPFS_implement =
+{
+    .name = "tmpfs",
+    .dirent_size = DIRENT_SIZE(NAME_MAX + 1),
+    .fsio = &TMPFS_fsio,
+
+    .open = TMPFS_fs_open,
+    .create = TMPFS_fs_create,
+    .truncate = TMPFS_fs_truncate,
+    .unlink = TMPFS_fs_unlink,
+    .format = NULL,
+    .lookup = TMPFS_fs_lookup,
+    .getdents = TMPFS_fs_getdents,
+    .fstat = TMPFS_fs_fstat,
+};
+
+/***************************************************************************/
+/** @implements tmpfs.h
+****************************************************************************/
+void *TMPFS_create(size_t size_cap, unsigned flags)
+{
+    struct TMPFS *tmpfs = KERNEL_mallocz(sizeof(struct TMPFS));
+    if (! tmpfs)
+        return __set_errno_nullptr(ENOMEM);
+
+    tmpfs->flags = flags;
+    tmpfs->size_cap = size_cap;
+
+    /// handle managed mutex: destroyed handle is recycled after tmpfs was freed
+    tmpfs->lock = mutex_create(MUTEX_FLAG_RECURSIVE);
+    if (! tmpfs->lock)
+    {
+        KERNEL_mfree(tmpfs);
+        return __set_errno_nullptr(ENOMEM);
+    }
+
+    struct TMPFS_node *root = TMPFS_node_alloc(tmpfs, "", 0, S_IFDIR | S_IRWXU | S_IRWXG | S_IRWXO);
+    if (! root)
+    {
+        mutex_destroy(tmpfs->lock);
+        KERNEL_mfree(tmpfs);
+        return __set_errno_nullptr(ENOMEM);
+    }
+    /// @rootdir'parent is self circulation link
+    root->parent = root;
+
+    return tmpfs;
+}
+
+int TMPFS_destroy(void *data)
+{
+    struct TMPFS *tmpfs = data;
+
+    mutex_lock(tmpfs->lock);
+    for (ino_t ino = 0; ino < tmpfs->inode_count; ino ++)
+    {
+        if (tmpfs->inodes[ino] && tmpfs->inodes[ino]->refcount)
+        {
+            mutex_unlock(tmpfs->lock);
+            return __set_errno_neg(EBUSY);
+        }
+    }
+    for (ino_t ino = 0; ino < tmpfs->inode_count; ino ++)
+    {
+        if (tmpfs->inodes[ino])
+            TMPFS_node_free(tmpfs, tmpfs->inodes[ino]);
+    }
+    mutex_unlock(tmpfs->lock);
+
+    if (TMPFS_root == tmpfs)
+        TMPFS_root = NULL;
+
+    mutex_destroy(tmpfs->lock);
+    KERNEL_mfree(tmpfs->inodes);
+    KERNEL_mfree(tmpfs);
+    return 0;
+}
+
+size_t TMPFS_usage(void *data, size_t *size_cap)
+{
+    struct TMPFS *tmpfs = data;
+
+    if (size_cap)
+        *size_cap = tmpfs->size_cap;
+    return tmpfs->used;
+}
+
+/***************************************************************************/
+/** @implements FS_implement
+****************************************************************************/
+static int TMPFS_fs_open(struct fsio_t *fsio)
+{
+    if (NULL == fsio->data)
+    {
+        fsio->data = TMPFS_root_instance();
+        if (NULL == fsio->data)
+            return -1;
+    }
+    struct TMPFS *tmpfs = fsio->data;
+
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+        fsio->ino_entry = fsio->ino_working = 0;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    int fd;
+    if (! node)
+        fd = __set_errno_neg(ENOENT);
+    else if (S_ISDIR(node->mode))
+        fd = KERNEL_createfd(FD_TAG_DIR, &TMPFS_fsio, fsio);
+    else
+        fd = KERNEL_createfd(FD_TAG_REG, &TMPFS_fsio, fsio);
+
+    if (-1 != fd)
+    {
+        node->refcount ++;
+
+        if (S_ISREG(node->mode) && (O_TRUNC & fsio->flags) && (O_ACCMODE & fsio->flags) != O_RDONLY)
+        {
+            TMPFS_file_resize(tmpfs, node, 0);
+            node->modification_ts = time(NULL);
+        }
+        fsio->size = S_ISREG(node->mode) ? node->file.size : 0;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return fd;
+}
+
+static int TMPFS_fs_create(struct fsio_t *fsio, char const *name, mode_t mode)
+{
+    if (NULL == fsio->data)
+    {
+        fsio->data = TMPFS_root_instance();
+        if (NULL == fsio->data)
+            return -1;
+    }
+    struct TMPFS *tmpfs = fsio->data;
+
+    if (INO_CURRENT_DIR == fsio->ino_working)
+        fsio->ino_working = 0;
+
+    if ((O_DIRECTORY & fsio->flags) || S_ISDIR(mode))
+        mode = S_IFDIR | (mode & ~S_IFMT);
+    else
+        mode = S_IFREG | (mode & ~S_IFMT);
+
+    size_t namelen = strlen(name);
+    int fd;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *dir = TMPFS_node_get(tmpfs, fsio->ino_working);
+
+    if (! dir || ! S_ISDIR(dir->mode))
+        fd = __set_errno_neg(ENOTDIR);
+    else if (TMPFS_dir_find(dir, name, namelen, TMPFS_hash(name, namelen)))
+        fd = __set_errno_neg(EEXIST);
+    else
+    {
+        struct TMPFS_node *node = TMPFS_node_alloc(tmpfs, name, namelen, mode);
+
+        if (! node)
+            fd = -1;
+        else if (0 != TMPFS_dir_insert(tmpfs, dir, node))
+        {
+            TMPFS_node_free(tmpfs, node);
+            fd = -1;
+        }
+        else
+        {
+            fd = KERNEL_createfd(S_ISDIR(mode) ? FD_TAG_DIR : FD_TAG_REG, &TMPFS_fsio, fsio);
+
+            if (-1 != fd)
+            {
+                node->refcount ++;
+
+                fsio->ino_entry = fsio->ino_working = node->ino;
+                fsio->size = 0;
+            }
+            else
+            {
+                TMPFS_dir_remove(dir, node);
+                TMPFS_node_free(tmpfs, node);
+            }
+        }
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return fd;
+}
+
+static int TMPFS_fs_truncate(struct fsio_t *fsio, off_t size)
+{
+    if (0 > size)
+        return __set_errno_neg(EINVAL);
+
+    struct TMPFS *tmpfs = fsio->data;
+    int retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (S_ISDIR(node->mode))
+        retval = __set_errno_neg(EISDIR);
+    else if (0 == (retval = TMPFS_file_resize(tmpfs, node, (size_t)size)))
+    {
+        node->modification_ts = time(NULL);
+        fsio->size = node->file.size;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static int TMPFS_fs_unlink(struct fsio_t *fsio, ino_t ino)
+{
+    struct TMPFS *tmpfs = fsio->data;
+    ino_t dir_ino = INO_CURRENT_DIR == fsio->ino_entry ? 0 : fsio->ino_entry;
+    int retval = 0;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *dir = TMPFS_node_get(tmpfs, dir_ino);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, ino);
+
+    if (! dir || ! node || node->parent != dir || 0 == ino)
+        retval = __set_errno_neg(ENOENT);
+    else if (S_ISDIR(node->mode) && 0 != node->dir.count)
+        retval = __set_errno_neg(ENOTEMPTY);
+    else
+    {
+        TMPFS_dir_remove(dir, node);
+        dir->modification_ts = time(NULL);
+
+        /// @opened node is freed by last close()
+        if (0 == node->refcount)
+            TMPFS_node_free(tmpfs, node);
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static int TMPFS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent)
+{
+    struct TMPFS *tmpfs = fsio->data;
+    ino_t dir_ino = INO_CURRENT_DIR == fsio->ino_entry ? 0 : fsio->ino_entry;
+    int retval = 0;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *dir = TMPFS_node_get(tmpfs, dir_ino);
+    struct TMPFS_node *node = NULL;
+
+    if (dir && S_ISDIR(dir->mode))
+        node = TMPFS_dir_find(dir, name, namelen, TMPFS_hash(name, namelen));
+
+    if (node)
+        TMPFS_fill_dirent(node, ent);
+    else
+        retval = __set_errno_neg(ENOENT);
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static ssize_t TMPFS_fs_getdents(int fd, void *buf, size_t bufsize)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    size_t filled = 0;
+    ssize_t retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (! S_ISDIR(node->mode))
+        retval = __set_errno_neg(ENOTDIR);
+    else
+    {
+        /// same position as readdir() by read()
+        struct TMPFS_node *iter = NULL;
+
+        if (0 == AsFD(fd)->position)
+            iter = node->dir.head;
+        else if (TMPFS_POS_END != AsFD(fd)->position)
+            iter = TMPFS_node_get(tmpfs, (ino_t)AsFD(fd)->position);
+
+        if (iter && iter->parent != node)
+            iter = NULL;
+
+        while (iter)
+        {
+            size_t reclen = DIRENT_RECLEN(iter->namelen);
+            if (filled + reclen > bufsize)
+                break;
+
+            TMPFS_fill_dirent(iter, (struct dirent *)((uint8_t *)buf + filled));
+            filled += reclen;
+            iter = iter->next;
+        }
+        AsFD(fd)->position = iter ? iter->ino : TMPFS_POS_END;
+
+        if (0 == filled && iter)
+            retval = __set_errno_neg(EINVAL);
+        else
+            retval = (ssize_t)filled;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static int TMPFS_fs_fstat(struct fsio_t *fsio, struct stat *st)
+{
+    struct TMPFS *tmpfs = fsio->data;
+    int retval = 0;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else
+    {
+        st->st_mode = node->mode;
+        st->st_nlink = node->parent || 0 == node->ino ? 1 : 0;
+        st->st_size = S_ISREG(node->mode) ? (off_t)node->file.size : 0;
+        st->st_blksize = TMPFS_BLOCK_SIZE;
+        st->st_blocks = S_ISREG(node->mode) ? (blkcnt_t)(node->file.capacity / 512) : 0;
+        st->st_ctime = node->creation_ts;
+        st->st_mtime = node->modification_ts;
+        st->st_atime = node->modification_ts;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t TMPFS_read(int fd, void *buf, size_t bufsize)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    ssize_t retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (S_ISDIR(node->mode))
+    {
+        /// @readdir: position is ino of next entry to read, 0 is the first entry
+        struct TMPFS_node *iter = NULL;
+
+        if (0 == AsFD(fd)->position)
+            iter = node->dir.head;
+        else if (TMPFS_POS_END != AsFD(fd)->position)
+            iter = TMPFS_node_get(tmpfs, (ino_t)AsFD(fd)->position);
+
+        if (bufsize < TMPFS_implement.dirent_size)
+            retval = __set_errno_neg(EINVAL);
+        /// end of directory, or entry was removed after telldir()
+        else if (! iter || iter->parent != node)
+            retval = 0;
+        else
+        {
+            TMPFS_fill_dirent(iter, buf);
+            AsFD(fd)->position = iter->next ? iter->next->ino : TMPFS_POS_END;
+
+            retval = (ssize_t)TMPFS_implement.dirent_size;
+        }
+    }
+    else if (O_WRONLY == (O_ACCMODE & fsio->flags))
+        retval = __set_errno_neg(EBADF);
+    else
+    {
+        retval = TMPFS_file_read(node, AsFD(fd)->position, buf, bufsize);
+        AsFD(fd)->position += (uintptr_t)retval;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static ssize_t TMPFS_write(int fd, void const *buf, size_t count)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    ssize_t retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (S_ISDIR(node->mode))
+        retval = __set_errno_neg(EISDIR);
+    else if (O_RDONLY == (O_ACCMODE & fsio->flags))
+        retval = __set_errno_neg(EBADF);
+    else
+    {
+        if (O_APPEND & fsio->flags)
+            AsFD(fd)->position = node->file.size;
+
+        retval = TMPFS_file_write(tmpfs, fsio, node, AsFD(fd)->position, buf, count);
+        if (0 < retval)
+            AsFD(fd)->position += (uintptr_t)retval;
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static ssize_t TMPFS_pread(int fd, void *buf, size_t bufsize, off_t offset)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    ssize_t retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (S_ISDIR(node->mode))
+        retval = __set_errno_neg(EISDIR);
+    else if (O_WRONLY == (O_ACCMODE & fsio->flags))
+        retval = __set_errno_neg(EBADF);
+    else
+        retval = TMPFS_file_read(node, (uintptr_t)offset, buf, bufsize);
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static ssize_t TMPFS_pwrite(int fd, void const *buf, size_t count, off_t offset)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    ssize_t retval;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (! node)
+        retval = __set_errno_neg(EBADF);
+    else if (S_ISDIR(node->mode))
+        retval = __set_errno_neg(EISDIR);
+    else if (O_RDONLY == (O_ACCMODE & fsio->flags))
+        retval = __set_errno_neg(EBADF);
+    else
+        retval = TMPFS_file_write(tmpfs, fsio, node, (uintptr_t)offset, buf, count);
+    mutex_unlock(tmpfs->lock);
+
+    return retval;
+}
+
+static off_t TMPFS_seek(int fd, off_t offset, int origin)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+    off_t pos;
+
+    if (FD_TAG_DIR & AsFD(fd)->tag)
+    {
+        /// directory position is opaque, only telldir() / seekdir() / rewinddir() make sense
+        if (SEEK_SET == origin)
+            pos = offset;
+        else if (SEEK_CUR == origin && 0 == offset)
+            pos = (off_t)AsFD(fd)->position;
+        else
+            return __set_errno_neg(EINVAL);
+    }
+    else
+    {
+        switch (origin)
+        {
+        case SEEK_SET:
+            pos = offset;
+            break;
+        case SEEK_CUR:
+            pos = (off_t)AsFD(fd)->position + offset;
+            break;
+        case SEEK_END:
+            mutex_lock(tmpfs->lock);
+            fsio->size = TMPFS_node_get(tmpfs, fsio->ino_entry)->file.size;
+            mutex_unlock(tmpfs->lock);
+
+            pos = (off_t)fsio->size + offset;
+            break;
+        default:
+            return __set_errno_neg(EINVAL);
+        }
+
+        if (0 > pos)
+            return __set_errno_neg(EINVAL);
+    }
+
+    AsFD(fd)->position = (uintptr_t)pos;
+    return pos;
+}
+
+static int TMPFS_close(int fd)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct TMPFS *tmpfs = fsio->data;
+
+    mutex_lock(tmpfs->lock);
+    struct TMPFS_node *node = TMPFS_node_get(tmpfs, fsio->ino_entry);
+
+    if (node && node->refcount)
+    {
+        node->refcount --;
+
+        /// @unlinked node is released by last close()
+        if (0 == node->refcount && NULL == node->parent)
+            TMPFS_node_free(tmpfs, node);
+    }
+    mutex_unlock(tmpfs->lock);
+
+    return 0;
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct TMPFS *TMPFS_root_instance(void)
+{
+    if (NULL == TMPFS_root)
+    {
+        mutex_lock(&TMPFS_root_lock);
+        if (NULL == TMPFS_root)
+            TMPFS_root = TMPFS_create(TMPFS_ROOT_SIZE_CAP, TMPFS_ROOT_FLAGS);
+        mutex_unlock(&TMPFS_root_lock);
+    }
+    return TMPFS_root;
+}
+
+static struct TMPFS_node *TMPFS_node_get(struct TMPFS *tmpfs, ino_t ino)
+{
+    if (ino < tmpfs->inode_count)
+        return tmpfs->inodes[ino];
+    else
+        return NULL;
+}
+
+static struct TMPFS_node *TMPFS_node_alloc(struct TMPFS *tmpfs, char const *name, size_t namelen, mode_t mode)
+{
+    if (NAME_MAX < namelen)
+        return __set_errno_nullptr(ENAMETOOLONG);
+
+    size_t size = sizeof(struct TMPFS_node) + namelen + 1;
+
+    /// @ino allocation
+    ino_t ino = tmpfs->inode_hint;
+    while (ino < tmpfs->inode_count && tmpfs->inodes[ino])
+        ino ++;
+
+    /// the ino table is part of the usage, grows by TMPFS_INO_TABLE_INC entries
+    size_t growth = 0;
+    if (ino == tmpfs->inode_count)
+    {
+        if (TMPFS_INO_LIMIT - tmpfs->inode_count < TMPFS_INO_TABLE_INC)
+            return __set_errno_nullptr(ENOSPC);
+
+        growth = TMPFS_INO_TABLE_INC * sizeof(struct TMPFS_node *);
+    }
+    if (tmpfs->size_cap && tmpfs->used + growth + size > tmpfs->size_cap)
+        return __set_errno_nullptr(ENOSPC);
+
+    if (growth)
+    {
+        ino_t inode_count = (ino_t)(tmpfs->inode_count + TMPFS_INO_TABLE_INC);
+        struct TMPFS_node **inodes = KERNEL_mallocz(inode_count * sizeof(struct TMPFS_node *));
+
+        if (! inodes)
+            return __set_errno_nullptr(ENOMEM);
+
+        if (tmpfs->inodes)
+        {
+            memcpy(inodes, tmpfs->inodes, tmpfs->inode_count * sizeof(struct TMPFS_node *));
+            KERNEL_mfree(tmpfs->inodes);
+        }
+        tmpfs->inodes = inodes;
+        tmpfs->inode_count = inode_count;
+        tmpfs->used += growth;
+    }
+
+    struct TMPFS_node *node = KERNEL_mallocz(size);
+    if (! node)
+        return __set_errno_nullptr(ENOMEM);
+
+    node->ino = ino;
+    node->mode = mode;
+    node->namelen = (uint16_t)namelen;
+    node->hash = TMPFS_hash(name, namelen);
+    memcpy(node->name, name, namelen);
+    node->creation_ts = node->modification_ts = time(NULL);
+
+    tmpfs->inodes[ino] = node;
+    tmpfs->inode_hint = (ino_t)(ino + 1);
+    tmpfs->used += size;
+
+    return node;
+}
+
+static void TMPFS_node_free(struct TMPFS *tmpfs, struct TMPFS_node *node)
+{
+    if (S_ISDIR(node->mode))
+    {
+        if (node->dir.buckets)
+            KERNEL_mfree(node->dir.buckets);
+        tmpfs->used -= node->dir.bucket_count * sizeof(struct TMPFS_node *);
+    }
+    else
+    {
+        if (node->file.content)
+            heap_caps_free(node->file.content);
+        tmpfs->used -= node->file.capacity;
+    }
+
+    tmpfs->inodes[node->ino] = NULL;
+    if (node->ino < tmpfs->inode_hint)
+        tmpfs->inode_hint = node->ino;
+
+    tmpfs->used -= sizeof(struct TMPFS_node) + node->namelen + 1;
+    KERNEL_mfree(node);
+}
+
+static struct TMPFS_node *TMPFS_dir_find(struct TMPFS_node *dir, char const *name, size_t namelen, uint32_t hash)
+{
+    if (0 == dir->dir.bucket_count)
+        return NULL;
+
+    struct TMPFS_node *iter = dir->dir.buckets[hash & (dir->dir.bucket_count - 1)];
+
+    while (iter)
+    {
+        if (hash == iter->hash && namelen == iter->namelen && 0 == memcmp(name, iter->name, namelen))
+            break;
+        iter = iter->hash_next;
+    }
+    return iter;
+}
+
+static int TMPFS_dir_insert(struct TMPFS *tmpfs, struct TMPFS_node *dir, struct TMPFS_node *node)
+{
+    if (dir->dir.count + 1 > dir->dir.bucket_count * TMPFS_HASH_LOAD)
+    {
+        uint32_t bucket_count = dir->dir.bucket_count ? dir->dir.bucket_count * 2 : TMPFS_HASH_BUCKETS;
+        size_t growth = (bucket_count - dir->dir.bucket_count) * sizeof(struct TMPFS_node *);
+
+        struct TMPFS_node **buckets = NULL;
+        if (! tmpfs->size_cap || tmpfs->used + growth <= tmpfs->size_cap)
+            buckets = KERNEL_mallocz(bucket_count * sizeof(struct TMPFS_node *));
+
+        if (buckets)
+        {
+            /// @rehash
+            for (struct TMPFS_node *iter = dir->dir.head; iter; iter = iter->next)
+            {
+                uint32_t idx = iter->hash & (bucket_count - 1);
+
+                iter->hash_next = buckets[idx];
+                buckets[idx] = iter;
+            }
+
+            if (dir->dir.buckets)
+                KERNEL_mfree(dir->dir.buckets);
+
+            dir->dir.buckets = buckets;
+            dir->dir.bucket_count = bucket_count;
+            tmpfs->used += growth;
+        }
+        /// longer chains are still correct, only the first table is mandatory
+        else if (0 == dir->dir.bucket_count)
+            return __set_errno_neg(tmpfs->size_cap ? ENOSPC : ENOMEM);
+    }
+
+    uint32_t idx = node->hash & (dir->dir.bucket_count - 1);
+    node->hash_next = dir->dir.buckets[idx];
+    dir->dir.buckets[idx] = node;
+
+    node->parent = dir;
+    node->next = NULL;
+    node->prev = dir->dir.tail;
+
+    if (dir->dir.tail)
+        dir->dir.tail->next = node;
+    else
+        dir->dir.head = node;
+    dir->dir.tail = node;
+
+    dir->dir.count ++;
+    dir->modification_ts = time(NULL);
+    return 0;
+}
+
+static void TMPFS_dir_remove(struct TMPFS_node *dir, struct TMPFS_node *node)
+{
+    struct TMPFS_node **pp = &dir->dir.buckets[node->hash & (dir->dir.bucket_count - 1)];
+
+    while (*pp != node)
+        pp = &(*pp)->hash_next;
+    *pp = node->hash_next;
+
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        dir->dir.head = node->next;
+
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        dir->dir.tail = node->prev;
+
+    dir->dir.count --;
+    node->parent = node->prev = node->next = node->hash_next = NULL;
+}
+
+static int TMPFS_file_resize(struct TMPFS *tmpfs, struct TMPFS_node *node, size_t size)
+{
+    if (size > node->file.capacity)
+    {
+        size_t capacity = (size + TMPFS_BLOCK_SIZE - 1) & ~(size_t)(TMPFS_BLOCK_SIZE - 1);
+
+        /// @growth by doubling when size cap allowed
+        if (capacity < node->file.capacity * 2)
+        {
+            size_t doubled = node->file.capacity * 2;
+
+            if (! tmpfs->size_cap || tmpfs->used + doubled - node->file.capacity <= tmpfs->size_cap)
+                capacity = doubled;
+        }
+        if (tmpfs->size_cap && tmpfs->used + capacity - node->file.capacity > tmpfs->size_cap)
+            return __set_errno_neg(ENOSPC);
+
+        uint32_t caps = (TMPFS_FLAG_PSRAM & tmpfs->flags) ?
+            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+
+        uint8_t *content = heap_caps_realloc(node->file.content, capacity, caps);
+        if (! content)
+            return __set_errno_neg(ENOMEM);
+
+        tmpfs->used += capacity - node->file.capacity;
+        node->file.content = content;
+        node->file.capacity = capacity;
+    }
+    else if (0 == size && node->file.content)
+    {
+        heap_caps_free(node->file.content);
+        tmpfs->used -= node->file.capacity;
+
+        node->file.content = NULL;
+        node->file.capacity = 0;
+    }
+
+    if (size > node->file.size)
+        memset(&node->file.content[node->file.size], 0, size - node->file.size);
+
+    node->file.size = size;
+    return 0;
+}
+
+static ssize_t TMPFS_file_read(struct TMPFS_node *node, uintptr_t pos, void *buf, size_t bufsize)
+{
+    if (pos >= node->file.size)
+        return 0;
+
+    size_t count = node->file.size - pos;
+    if (count > bufsize)
+        count = bufsize;
+
+    memcpy(buf, &node->file.content[pos], count);
+    return (ssize_t)count;
+}
+
+static ssize_t TMPFS_file_write(struct TMPFS *tmpfs, struct fsio_t *fsio, struct TMPFS_node *node,
+    uintptr_t pos, void const *buf, size_t count)
+{
+    if (pos + count < pos)
+        return __set_errno_neg(EFBIG);
+    if (pos + count > node->file.size && 0 != TMPFS_file_resize(tmpfs, node, pos + count))
+        return -1;
+
+    memcpy(&node->file.content[pos], buf, count);
+    node->modification_ts = time(NULL);
+
+    fsio->size = node->file.size;
+    return (ssize_t)count;
+}
+
+static void TMPFS_fill_dirent(struct TMPFS_node *node, struct dirent *ent)
+{
+    ent->d_filesystem = NULL;
+    ent->d_mode = node->mode;
+    ent->d_ino = node->ino;
+    ent->d_size = S_ISREG(node->mode) ? node->file.size : 0;
+    ent->d_creation_ts = node->creation_ts;
+    ent->d_modificaion_ts = node->modification_ts;
+    ent->d_namelen = node->namelen;
+
+    memcpy(ent->d_name, node->name, node->namelen);
+    ent->d_name[node->namelen] = '\0';
+}
+
+static uint32_t TMPFS_hash(char const *name, size_t namelen)
+{
+    /// @FNV-1a
+    uint32_t hash = 2166136261U;
+
+    for (size_t i = 0; i < namelen; i ++)
+    {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
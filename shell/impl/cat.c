@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/errno.h>
+#include <sys/sendfile.h>
 
 #include "sh/ucsh.h"
 
@@ -68,6 +69,14 @@ int UCSH_cat(struct UCSH_env *env)
     int retval = 0;
     char break_cond = '\0';
 
+    /// @file => shell: kernel transfer with large internal buffer, or zero copy by mapped files
+    if (fd != env->fd)
+    {
+        if (-1 == sendfile(output_fd, fd, NULL, size))
+            retval = -1;
+        size = 0;
+    }
+
     while (size > 0)
     {
         retval = read(fd, env->buf, size > 64 ? 64 : size);
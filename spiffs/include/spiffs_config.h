@@ -116,6 +116,22 @@ extern void spiffs_api_unlock(struct spiffs_t *fs);
 #endif
 #endif
 
+// Enable temporal file descriptor cache, a file opened again reuses the
+// descriptor which most recently held it.
+#ifdef CONFIG_SPIFFS_TEMPORAL_FD_CACHE
+#define SPIFFS_TEMPORAL_FD_CACHE        (1)
+#define SPIFFS_TEMPORAL_CACHE_HIT_SCORE (CONFIG_SPIFFS_TEMPORAL_CACHE_HIT_SCORE)
+#else
+#define SPIFFS_TEMPORAL_FD_CACHE        (0)
+#endif
+
+// Enable SPIFFS_ix_map() api, index pages of a file are mapped into memory
+#ifdef CONFIG_SPIFFS_IX_MAP
+#define SPIFFS_IX_MAP                   (1)
+#else
+#define SPIFFS_IX_MAP                   (0)
+#endif
+
 // Always check header of each accessed page to ensure consistent state.
 // If enabled it will increase number of reads, will increase flash.
 #ifdef CONFIG_SPIFFS_PAGE_CHECK
@@ -237,47 +253,6 @@ ESP_STATIC_ASSERT(SPIFFS_OBJ_META_LEN + SPIFFS_OBJ_NAME_LEN + SPIFFS_PAGE_EXTRA_
 // Might be useful for e.g. bootloaders and such.
 #define SPIFFS_READ_ONLY                        0
 
-// Enable this to add a temporal file cache using the fd buffer.
-// The effects of the cache is that SPIFFS_open will find the file faster in
-// certain cases. It will make it a lot easier for spiffs to find files
-// opened frequently, reducing number of readings from the spi flash for
-// finding those files.
-// This will grow each fd by 6 bytes. If your files are opened in patterns
-// with a degree of temporal locality, the system is optimized.
-// Examples can be letting spiffs serve web content, where one file is the css.
-// The css is accessed for each html file that is opened, meaning it is
-// accessed almost every second time a file is opened. Another example could be
-// a log file that is often opened, written, and closed.
-// The size of the cache is number of given file descriptors, as it piggybacks
-// on the fd update mechanism. The cache lives in the closed file descriptors.
-// When closed, the fd know the whereabouts of the file. Instead of forgetting
-// this, the temporal cache will keep handling updates to that file even if the
-// fd is closed. If the file is opened again, the location of the file is found
-// directly. If all available descriptors become opened, all cache memory is
-// lost.
-#define SPIFFS_TEMPORAL_FD_CACHE                1
-
-// Temporal file cache hit score. Each time a file is opened, all cached files
-// will lose one point. If the opened file is found in cache, that entry will
-// gain SPIFFS_TEMPORAL_CACHE_HIT_SCORE points. One can experiment with this
-// value for the specific access patterns of the application. However, it must
-// be between 1 (no gain for hitting a cached entry often) and 255.
-#define SPIFFS_TEMPORAL_CACHE_HIT_SCORE         4
-
-// Enable to be able to map object indices to memory.
-// This allows for faster and more deterministic reading if cases of reading
-// large files and when changing file offset by seeking around a lot.
-// When mapping a file's index, the file system will be scanned for index pages
-// and the info will be put in memory provided by user. When reading, the
-// memory map can be looked up instead of searching for index pages on the
-// medium. This way, user can trade memory against performance.
-// Whole, parts of, or future parts not being written yet can be mapped. The
-// memory array will be owned by spiffs and updated accordingly during garbage
-// collecting or when modifying the indices. The latter is invoked by when the
-// file is modified in some way. The index buffer is tied to the file
-// descriptor.
-#define SPIFFS_IX_MAP                           1
-
 // Set SPIFFS_TEST_VISUALISATION to non-zero to enable SPIFFS_vis function
 // in the api. This function will visualize all filesystem using given printf
 // function.
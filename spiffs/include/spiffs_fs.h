@@ -0,0 +1,146 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#ifndef __FS_SPIFFS_H
+#define __FS_SPIFFS_H                   1
+
+#include <features.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <rtos/filesystem.h>
+
+    /// default config when SPIFFS_FS_implement is used as FS_root
+    #ifndef SPIFFS_FS_ROOT_MAX_FILES
+        #define SPIFFS_FS_ROOT_MAX_FILES    (8)
+    #endif
+    #ifndef SPIFFS_FS_ROOT_CACHE_PAGES
+        #define SPIFFS_FS_ROOT_CACHE_PAGES  (8)
+    #endif
+    #ifndef SPIFFS_FS_ROOT_IX_MAP_ENTRIES
+        #define SPIFFS_FS_ROOT_IX_MAP_ENTRIES   (0)
+    #endif
+    #ifndef SPIFFS_FS_ROOT_BCACHE_BLOCKS
+        #define SPIFFS_FS_ROOT_BCACHE_BLOCKS    (4)
+    #endif
+
+    struct SPIFFS_FS_config
+    {
+        /// label of partition, NULL for first partition with subtype spiffs
+        char const *partition_label;
+        bool format_if_mount_failed;
+        /**
+         *  maximum files opened at same time
+         *      temporal fd cache (CONFIG_SPIFFS_TEMPORAL_FD_CACHE) is scoring within these fds,
+         *      more fds keep more recently opened files cached
+         */
+        uint16_t max_files;
+        /// pages of SPIFFS_CACHE, 0 to disable, maximum 32
+        uint16_t cache_pages;
+        /**
+         *  index map entries allocated for each opened file, 0 to disable
+         *      requires CONFIG_SPIFFS_IX_MAP, every entry maps one data page of file start
+         */
+        uint16_t ix_map_entries;
+        /**
+         *  flash sectors cached by BCACHE under spiffs, 0 to access the partition directly
+         *      .repeated page programming of the same sector is merged into one sector write
+         *      .written back by eviction, fsync(), sync() and SPIFFS_FS_destroy()
+         */
+        uint16_t bcache_blocks;
+    };
+
+    struct SPIFFS_FS_stats
+    {
+        uint32_t total_bytes;
+        uint32_t used_bytes;
+        uint32_t free_blocks;
+        uint32_t max_erase_count;
+
+        /// pages allocated / deleted since mount or last reset
+        uint32_t pages_allocated;
+        uint32_t pages_deleted;
+
+        /// requires CONFIG_SPIFFS_CACHE_STATS, otherwise 0
+        uint32_t cache_hits;
+        uint32_t cache_misses;
+        /// requires CONFIG_SPIFFS_GC_STATS, otherwise 0
+        uint32_t gc_runs;
+    };
+
+__BEGIN_DECLS
+
+    /**
+     *  SPIFFS_FS_implement
+     *      SPIFFS partition as UltraCore filesystem
+     *      .SPIFFS has no directory, the mount is flat: names containing '/' are not listed
+     *      .as root: assign &SPIFFS_FS_implement to FS_root in FILESYSTEM_init_root(),
+     *          the first spiffs partition is mounted on first open by SPIFFS_FS_ROOT_* config
+     *      .as mount: FILESYSTEM_mount(name, &SPIFFS_FS_implement, SPIFFS_FS_create(&config))
+     *      NOTE: do not register the same partition to esp_vfs by esp_vfs_spiffs_register()
+     */
+extern
+    struct FS_implement const SPIFFS_FS_implement;
+
+    /**
+     *  SPIFFS_FS_create()
+     *      mount a spiffs partition, to pass to FILESYSTEM_mount() as data
+     *  @returns
+     *      On success the instance is returned
+     *      On error, NULL is returned, and errno is set to indicate the error
+     *  @errors
+     *      ENOENT: partition is not found
+     *      EINVAL: partition is too large or incompatible with CONFIG_SPIFFS_PAGE_SIZE
+     *      ENOMEM
+     *      ENODEV: mount failed
+     */
+extern __attribute__((nonnull, nothrow))
+    void *SPIFFS_FS_create(struct SPIFFS_FS_config const *config);
+
+    /**
+     *  SPIFFS_FS_destroy()
+     *      unmount, write back the block cache and release the instance
+     *  @errors
+     *      EBUSY: instance still has opened files
+     *      EIO: writing back the block cache failed, the instance stays mounted
+     */
+extern __attribute__((nonnull, nothrow))
+    int SPIFFS_FS_destroy(void *spiffs);
+
+    /**
+     *  SPIFFS_FS_tune()
+     *      change max_files / cache_pages / ix_map_entries of a mounted instance
+     *      .partition_label, format_if_mount_failed and bcache_blocks are ignored
+     *      .the partition is remounted when max_files or cache_pages was changed
+     *  @returns
+     *      On success 0 is returned
+     *      On error, -1 is returned, and errno is set to indicate the error
+     *  @errors
+     *      EBUSY: remount is required but instance still has opened files
+     *      EINVAL
+     *      ENOMEM
+     */
+extern __attribute__((nonnull, nothrow))
+    int SPIFFS_FS_tune(void *spiffs, struct SPIFFS_FS_config const *config);
+
+    /**
+     *  SPIFFS_FS_stats()
+     *      retrieve usage / cache / gc statistics, counters are cleared when reset is true
+     */
+extern __attribute__((nonnull, nothrow))
+    int SPIFFS_FS_stats(void *spiffs, struct SPIFFS_FS_stats *stats, bool reset);
+
+__END_DECLS
+#endif
@@ -0,0 +1,1100 @@
+/****************************************************************************
+  This file is part of UltraCore
+
+  Copyright by UltraCreation Co Ltd 2018
+-------------------------------------------------------------------------------
+    The contents of this file are used with permission, subject to the Mozilla
+  Public License Version 1.1 (the "License"); you may not use this file except
+  in compliance with the License. You may  obtain a copy of the License at
+  http://www.mozilla.org/MPL/MPL-1.1.html
+
+    Software distributed under the License is distributed on an "AS IS" basis,
+  WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License for
+  the specific language governing rights and limitations under the License.
+****************************************************************************/
+#include <rtos/kernel.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/errno.h>
+#include <sys/stat.h>
+
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+
+#include "esp_partition.h"
+#include "esp_rom_spiflash.h"
+
+#include "spiffs.h"
+#include "spiffs_nucleus.h"
+#include "spiffs_api.h"
+
+#include <rtos/bcache.h>
+#include <rtos/partition.h>
+
+/// @implements headers
+#include "spiffs_fs.h"
+
+/***************************************************************************/
+/** @def
+****************************************************************************/
+#define INO_CURRENT_DIR                 ((ino_t)-2)
+
+/// readdir() position of end of directory
+#define SPIFFS_FS_POS_END               ((uintptr_t)-1)
+/// readdir() position of spiffs_DIR cursor
+#define SPIFFS_FS_DIR_POS(DIR)          (((uintptr_t)(DIR)->block << 16) | ((uintptr_t)(DIR)->entry & 0xFFFF))
+/// SPIFFS_cache is indexed by 32 bits map
+#define SPIFFS_FS_MAX_CACHE_PAGES       (32)
+/// read-modify-write chunk of hal callbacks through the block cache
+#define SPIFFS_FS_HAL_CHUNK             (64)
+
+struct SPIFFS_FS_ixmap
+{
+    spiffs_ix_map map;
+    spiffs_page_ix entries[];
+};
+
+struct SPIFFS_FS
+{
+    /// spiffs_api_*() callbacks cast spiffs->user_data as esp_spiffs_t
+    esp_spiffs_t efs;
+    struct SPIFFS_FS_config config;
+
+    /// serialize .opened / .ixmaps bookkeeping against remount
+    mutex_t *lock;
+    /// opened files, remount is not possiable when not 0
+    uint16_t opened;
+    /// index by spiffs_file - 1
+    struct SPIFFS_FS_ixmap **ixmaps;
+
+    /// optional: hal callbacks access the partition through the block cache
+    struct BCACHE_device dev;
+    struct BCACHE *bcache;
+};
+
+/***************************************************************************/
+/** @internal
+****************************************************************************/
+static int SPIFFS_FS_fs_open(struct fsio_t *fsio);
+static int SPIFFS_FS_fs_create(struct fsio_t *fsio, char const *name, mode_t mode);
+static int SPIFFS_FS_fs_truncate(struct fsio_t *fsio, off_t size);
+static int SPIFFS_FS_fs_unlink(struct fsio_t *fsio, ino_t ino);
+static int SPIFFS_FS_fs_format(struct fsio_t *fsio, char const *fstype);
+static int SPIFFS_FS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent);
+static ssize_t SPIFFS_FS_fs_getdents(int fd, void *buf, size_t bufsize);
+static int SPIFFS_FS_fs_fstat(struct fsio_t *fsio, struct stat *st);
+
+static ssize_t SPIFFS_FS_read(int fd, void *buf, size_t bufsize);
+static ssize_t SPIFFS_FS_write(int fd, void const *buf, size_t count);
+static off_t SPIFFS_FS_seek(int fd, off_t offset, int origin);
+static int SPIFFS_FS_close(int fd);
+static int SPIFFS_FS_sync(int fd);
+
+static s32_t SPIFFS_FS_hal_read(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *dst);
+static s32_t SPIFFS_FS_hal_write(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *src);
+static s32_t SPIFFS_FS_hal_erase(spiffs *fs, uint32_t addr, uint32_t size);
+
+static struct SPIFFS_FS *SPIFFS_FS_root_instance(void);
+static int SPIFFS_FS_mount(struct SPIFFS_FS *sfs);
+static void SPIFFS_FS_unmount(struct SPIFFS_FS *sfs);
+static int SPIFFS_FS_file_opened(struct SPIFFS_FS *sfs, struct fsio_t *fsio, spiffs_file fh);
+static void SPIFFS_FS_dir_seek(struct SPIFFS_FS *sfs, spiffs_DIR *dir, uintptr_t position);
+static bool SPIFFS_FS_dir_next(struct SPIFFS_FS *sfs, spiffs_DIR *dir, spiffs_stat *st);
+static void SPIFFS_FS_fill_dirent(spiffs_stat const *st, struct dirent *ent);
+static int SPIFFS_FS_flags(int flags);
+static int SPIFFS_FS_error(spiffs *fs);
+
+/// @variable
+static struct FD_implement const SPIFFS_FS_fsio =
+{
+    .read = SPIFFS_FS_read,
+    .write = SPIFFS_FS_write,
+    .seek = SPIFFS_FS_seek,
+    .close = SPIFFS_FS_close,
+    .ioctl = NULL,
+    .sync = SPIFFS_FS_sync,
+};
+
+static struct SPIFFS_FS *SPIFFS_FS_root = NULL;
+static mutex_t SPIFFS_FS_root_lock = MUTEX_INITIALIZER;
+
+/***************************************************************************/
+/** @export
+****************************************************************************/
+struct FS_implement const SPIFFS_FS_implement =
+{
+    .name = "spiffs",
+    .dirent_size = DIRENT_SIZE(SPIFFS_OBJ_NAME_LEN),
+    .fsio = &SPIFFS_FS_fsio,
+
+    .open = SPIFFS_FS_fs_open,
+    .create = SPIFFS_FS_fs_create,
+    .truncate = SPIFFS_FS_fs_truncate,
+    .unlink = SPIFFS_FS_fs_unlink,
+    .format = SPIFFS_FS_fs_format,
+    .lookup = SPIFFS_FS_fs_lookup,
+    .getdents = SPIFFS_FS_fs_getdents,
+    .fstat = SPIFFS_FS_fs_fstat,
+};
+
+/***************************************************************************/
+/** @implements spiffs_fs.h
+****************************************************************************/
+void *SPIFFS_FS_create(struct SPIFFS_FS_config const *config)
+{
+    if (0 == config->max_files || SPIFFS_FS_MAX_CACHE_PAGES < config->cache_pages)
+        return __set_errno_nullptr(EINVAL);
+
+    esp_partition_subtype_t subtype = config->partition_label ?
+        ESP_PARTITION_SUBTYPE_ANY : ESP_PARTITION_SUBTYPE_DATA_SPIFFS;
+    esp_partition_t const *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+        subtype, config->partition_label);
+
+    if (! partition)
+        return __set_errno_nullptr(ENOENT);
+    if (partition->encrypted ||
+        0 != CONFIG_SPIFFS_PAGE_SIZE % g_rom_flashchip.page_size ||
+        partition->size / g_rom_flashchip.sector_size > (spiffs_block_ix)-1 ||
+        partition->size / CONFIG_SPIFFS_PAGE_SIZE > (spiffs_page_ix)-1)
+    {
+        return __set_errno_nullptr(EINVAL);
+    }
+
+    struct SPIFFS_FS *sfs = KERNEL_mallocz(sizeof(struct SPIFFS_FS));
+    if (! sfs)
+        return __set_errno_nullptr(ENOMEM);
+
+    sfs->config = *config;
+    sfs->efs.partition = partition;
+    sfs->efs.by_label = NULL != config->partition_label;
+
+    if (config->bcache_blocks)
+    {
+        struct BCACHE_config const bcache_config =
+        {
+            .block_size = g_rom_flashchip.sector_size,
+            .block_count = config->bcache_blocks,
+            .coalesce_max = config->bcache_blocks,
+            /// spiffs scans the lookup pages of every block, ARC keeps them from flushing hot blocks
+            .policy = BCACHE_POLICY_ARC,
+            .placement = BCACHE_PLACE_PREFER_PSRAM,
+            .flags = 0,
+        };
+
+        if (0 != PARTITION_bcache_device(partition->label, &sfs->dev) ||
+            NULL == (sfs->bcache = BCACHE_create(&sfs->dev, &bcache_config)))
+        {
+            KERNEL_mfree(sfs);
+            return NULL;
+        }
+        sfs->efs.cfg.hal_erase_f = SPIFFS_FS_hal_erase;
+        sfs->efs.cfg.hal_read_f = SPIFFS_FS_hal_read;
+        sfs->efs.cfg.hal_write_f = SPIFFS_FS_hal_write;
+    }
+    else
+    {
+        sfs->efs.cfg.hal_erase_f = spiffs_api_erase;
+        sfs->efs.cfg.hal_read_f = spiffs_api_read;
+        sfs->efs.cfg.hal_write_f = spiffs_api_write;
+    }
+    sfs->efs.cfg.log_block_size = g_rom_flashchip.sector_size;
+    sfs->efs.cfg.log_page_size = CONFIG_SPIFFS_PAGE_SIZE;
+    sfs->efs.cfg.phys_addr = 0;
+    sfs->efs.cfg.phys_erase_block = g_rom_flashchip.sector_size;
+    sfs->efs.cfg.phys_size = partition->size;
+
+    sfs->lock = mutex_create(MUTEX_FLAG_RECURSIVE);
+    sfs->efs.lock = xSemaphoreCreateMutex();
+    sfs->efs.work = KERNEL_mallocz(2 * CONFIG_SPIFFS_PAGE_SIZE);
+    sfs->efs.fs = KERNEL_mallocz(sizeof(struct spiffs_t));
+
+    if (! sfs->lock || ! sfs->efs.lock || ! sfs->efs.work || ! sfs->efs.fs)
+    {
+        errno = ENOMEM;
+        goto spiffs_create_error_exit;
+    }
+    sfs->efs.fs->user_data = &sfs->efs;
+
+    if (0 != SPIFFS_FS_mount(sfs))
+    {
+        if (ENODEV != errno || ! config->format_if_mount_failed)
+            goto spiffs_create_error_exit;
+
+        SPIFFS_clearerr(sfs->efs.fs);
+        if (SPIFFS_OK != SPIFFS_format(sfs->efs.fs))
+        {
+            SPIFFS_FS_error(sfs->efs.fs);
+            goto spiffs_create_error_exit;
+        }
+        if (0 != SPIFFS_FS_mount(sfs))
+            goto spiffs_create_error_exit;
+    }
+    return sfs;
+
+spiffs_create_error_exit:
+    SPIFFS_FS_unmount(sfs);
+
+    /// nothing worth writing back of a filesystem failed to mount, the error of it is ignored
+    if (sfs->bcache)
+        BCACHE_destroy(sfs->bcache);
+
+    if (sfs->efs.fs)
+        KERNEL_mfree(sfs->efs.fs);
+    if (sfs->efs.work)
+        KERNEL_mfree(sfs->efs.work);
+    if (sfs->efs.lock)
+        vSemaphoreDelete(sfs->efs.lock);
+    if (sfs->lock)
+        mutex_destroy(sfs->lock);
+
+    KERNEL_mfree(sfs);
+    return NULL;
+}
+
+int SPIFFS_FS_destroy(void *data)
+{
+    struct SPIFFS_FS *sfs = data;
+
+    mutex_lock(sfs->lock);
+    if (sfs->opened)
+    {
+        mutex_unlock(sfs->lock);
+        return __set_errno_neg(EBUSY);
+    }
+
+    SPIFFS_FS_unmount(sfs);
+
+    /// @keep the instance mounted when the cache can not be written back, destroy can be retried
+    if (sfs->bcache && 0 != BCACHE_destroy(sfs->bcache))
+    {
+        int err = errno;
+
+        SPIFFS_FS_mount(sfs);
+        mutex_unlock(sfs->lock);
+        return __set_errno_neg(err);
+    }
+
+    if (SPIFFS_FS_root == sfs)
+        SPIFFS_FS_root = NULL;
+    mutex_unlock(sfs->lock);
+
+    KERNEL_mfree(sfs->efs.fs);
+    KERNEL_mfree(sfs->efs.work);
+    vSemaphoreDelete(sfs->efs.lock);
+    mutex_destroy(sfs->lock);
+    KERNEL_mfree(sfs);
+    return 0;
+}
+
+int SPIFFS_FS_tune(void *data, struct SPIFFS_FS_config const *config)
+{
+    struct SPIFFS_FS *sfs = data;
+
+    if (0 == config->max_files || SPIFFS_FS_MAX_CACHE_PAGES < config->cache_pages)
+        return __set_errno_neg(EINVAL);
+#if ! SPIFFS_IX_MAP
+    if (config->ix_map_entries)
+        return __set_errno_neg(ENOTSUP);
+#endif
+
+    int retval = 0;
+    mutex_lock(sfs->lock);
+
+    /// ix_map_entries takes effect on next open()
+    sfs->config.ix_map_entries = config->ix_map_entries;
+
+    if (config->max_files == sfs->config.max_files &&
+        config->cache_pages == sfs->config.cache_pages)
+    {
+        goto spiffs_tune_exit;
+    }
+    if (sfs->opened)
+    {
+        retval = __set_errno_neg(EBUSY);
+        goto spiffs_tune_exit;
+    }
+
+    struct SPIFFS_FS_config old_config = sfs->config;
+
+    SPIFFS_FS_unmount(sfs);
+    sfs->config.max_files = config->max_files;
+    sfs->config.cache_pages = config->cache_pages;
+
+    if (0 != SPIFFS_FS_mount(sfs))
+    {
+        int err = errno;
+
+        /// @restore the working config, the filesystem stays unmounted if it also fails
+        sfs->config = old_config;
+        if (0 != SPIFFS_FS_mount(sfs))
+            err = errno;
+
+        retval = __set_errno_neg(err);
+    }
+
+spiffs_tune_exit:
+    mutex_unlock(sfs->lock);
+    return retval;
+}
+
+int SPIFFS_FS_stats(void *data, struct SPIFFS_FS_stats *stats, bool reset)
+{
+    struct SPIFFS_FS *sfs = data;
+    spiffs *fs = sfs->efs.fs;
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (SPIFFS_OK != SPIFFS_info(fs, &stats->total_bytes, &stats->used_bytes))
+        return SPIFFS_FS_error(fs);
+
+    spiffs_api_lock(fs);
+    stats->free_blocks = fs->free_blocks;
+    stats->max_erase_count = fs->max_erase_count;
+    stats->pages_allocated = fs->stats_p_allocated;
+    stats->pages_deleted = fs->stats_p_deleted;
+#if SPIFFS_CACHE && SPIFFS_CACHE_STATS
+    stats->cache_hits = fs->cache_hits;
+    stats->cache_misses = fs->cache_misses;
+#endif
+#if SPIFFS_GC_STATS
+    stats->gc_runs = fs->stats_gc_runs;
+#endif
+
+    if (reset)
+    {
+        fs->stats_p_allocated = fs->stats_p_deleted = 0;
+    #if SPIFFS_CACHE && SPIFFS_CACHE_STATS
+        fs->cache_hits = fs->cache_misses = 0;
+    #endif
+    #if SPIFFS_GC_STATS
+        fs->stats_gc_runs = 0;
+    #endif
+    }
+    spiffs_api_unlock(fs);
+
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements FS_implement
+****************************************************************************/
+static int SPIFFS_FS_fs_open(struct fsio_t *fsio)
+{
+    if (NULL == fsio->data)
+    {
+        fsio->data = SPIFFS_FS_root_instance();
+        if (NULL == fsio->data)
+            return -1;
+    }
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+        return KERNEL_createfd(FD_TAG_DIR, &SPIFFS_FS_fsio, fsio);
+
+    spiffs_file fh = SPIFFS_open_by_id(sfs->efs.fs, (spiffs_obj_id)fsio->ino_entry,
+        SPIFFS_FS_flags(fsio->flags), 0);
+
+    if (0 > fh)
+        return SPIFFS_FS_error(sfs->efs.fs);
+    else
+        return SPIFFS_FS_file_opened(sfs, fsio, fh);
+}
+
+static int SPIFFS_FS_fs_create(struct fsio_t *fsio, char const *name, mode_t mode)
+{
+    if ((O_DIRECTORY & fsio->flags) || S_ISDIR(mode))
+        return __set_errno_neg(ENOTSUP);
+
+    if (NULL == fsio->data)
+    {
+        fsio->data = SPIFFS_FS_root_instance();
+        if (NULL == fsio->data)
+            return -1;
+    }
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    /// @esp_vfs compatible naming: "/name"
+    char path[SPIFFS_OBJ_NAME_LEN];
+    if (SPIFFS_OBJ_NAME_LEN <= 1 + strlen(name))
+        return __set_errno_neg(ENAMETOOLONG);
+
+    path[0] = '/';
+    strcpy(&path[1], name);
+
+    spiffs_file fh = SPIFFS_open(sfs->efs.fs, path,
+        SPIFFS_FS_flags(fsio->flags) | SPIFFS_O_CREAT | SPIFFS_O_EXCL, 0);
+    if (0 > fh)
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    spiffs_stat st;
+    if (SPIFFS_OK != SPIFFS_fstat(sfs->efs.fs, fh, &st))
+    {
+        int retval = SPIFFS_FS_error(sfs->efs.fs);
+        SPIFFS_close(sfs->efs.fs, fh);
+        return retval;
+    }
+    fsio->ino_entry = (ino_t)st.obj_id;
+
+    return SPIFFS_FS_file_opened(sfs, fsio, fh);
+}
+
+static int SPIFFS_FS_fs_truncate(struct fsio_t *fsio, off_t size)
+{
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+        return __set_errno_neg(EISDIR);
+    if (0 > size)
+        return __set_errno_neg(EINVAL);
+
+    if (SPIFFS_OK != SPIFFS_ftruncate(sfs->efs.fs, (spiffs_file)fsio->ino_working, (u32_t)size))
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    fsio->size = (size_t)size;
+    return 0;
+}
+
+static int SPIFFS_FS_fs_unlink(struct fsio_t *fsio, ino_t ino)
+{
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    spiffs_file fh = SPIFFS_open_by_id(sfs->efs.fs, (spiffs_obj_id)ino, SPIFFS_O_RDWR, 0);
+    if (0 > fh)
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    int retval = 0;
+    if (SPIFFS_OK != SPIFFS_fremove(sfs->efs.fs, fh))
+        retval = SPIFFS_FS_error(sfs->efs.fs);
+
+    /// fremove() does not release fh
+    SPIFFS_close(sfs->efs.fs, fh);
+    SPIFFS_clearerr(sfs->efs.fs);
+
+    return retval;
+}
+
+static int SPIFFS_FS_fs_format(struct fsio_t *fsio, char const *fstype)
+{
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (fstype && 0 != strcmp(fstype, SPIFFS_FS_implement.name))
+        return __set_errno_neg(EINVAL);
+    int retval;
+    mutex_lock(sfs->lock);
+
+    /// the directory of formatting is opened by FILESYSTEM_format()
+    if (sfs->opened)
+    {
+        retval = __set_errno_neg(EBUSY);
+    }
+    else
+    {
+        SPIFFS_FS_unmount(sfs);
+
+        if (SPIFFS_OK != SPIFFS_format(sfs->efs.fs))
+        {
+            retval = SPIFFS_FS_error(sfs->efs.fs);
+            int err = errno;
+
+            if (0 != SPIFFS_FS_mount(sfs))
+                err = errno;
+            errno = err;
+        }
+        else
+            retval = SPIFFS_FS_mount(sfs);
+    }
+
+    mutex_unlock(sfs->lock);
+    return retval;
+}
+
+static int SPIFFS_FS_fs_lookup(struct fsio_t *fsio, char const *name, size_t namelen, struct dirent *ent)
+{
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    char path[SPIFFS_OBJ_NAME_LEN];
+    if (SPIFFS_OBJ_NAME_LEN <= 1 + namelen)
+        return __set_errno_neg(ENOENT);
+
+    path[0] = '/';
+    memcpy(&path[1], name, namelen);
+    path[1 + namelen] = '\0';
+
+    spiffs_stat st;
+    if (SPIFFS_OK != SPIFFS_stat(sfs->efs.fs, path, &st))
+    {
+        SPIFFS_clearerr(sfs->efs.fs);
+        return __set_errno_neg(ENOENT);
+    }
+
+    SPIFFS_FS_fill_dirent(&st, ent);
+    return 0;
+}
+
+static ssize_t SPIFFS_FS_fs_getdents(int fd, void *buf, size_t bufsize)
+{
+    struct SPIFFS_FS *sfs = ((struct fsio_t *)AsFD(fd)->fsio)->data;
+    size_t filled = 0;
+
+    if (SPIFFS_FS_POS_END == AsFD(fd)->position)
+        return 0;
+
+    /// one directory walk for the whole batch
+    spiffs_DIR dir;
+    spiffs_stat st;
+    SPIFFS_FS_dir_seek(sfs, &dir, AsFD(fd)->position);
+
+    while (true)
+    {
+        uintptr_t pos = SPIFFS_FS_DIR_POS(&dir);
+
+        if (! SPIFFS_FS_dir_next(sfs, &dir, &st))
+        {
+            AsFD(fd)->position = SPIFFS_FS_POS_END;
+            break;
+        }
+
+        char const *name = (char const *)st.name;
+        if ('/' == name[0])
+            name ++;
+
+        size_t reclen = DIRENT_RECLEN(strlen(name));
+        if (filled + reclen > bufsize)
+        {
+            /// resume from this entry next time
+            AsFD(fd)->position = pos;
+            break;
+        }
+
+        SPIFFS_FS_fill_dirent(&st, (struct dirent *)((uint8_t *)buf + filled));
+        filled += reclen;
+    }
+
+    if (0 == filled && SPIFFS_FS_POS_END != AsFD(fd)->position)
+        return __set_errno_neg(EINVAL);
+    else
+        return (ssize_t)filled;
+}
+
+static int SPIFFS_FS_fs_fstat(struct fsio_t *fsio, struct stat *st)
+{
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (INO_CURRENT_DIR == fsio->ino_entry)
+    {
+        st->st_mode = S_IFDIR | S_IRWXU | S_IRWXG | S_IRWXO;
+        return 0;
+    }
+
+    spiffs_stat sst;
+    if (SPIFFS_OK != SPIFFS_fstat(sfs->efs.fs, (spiffs_file)fsio->ino_working, &sst))
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    union
+    {
+        struct dirent ent;
+        uint8_t buf[DIRENT_SIZE(SPIFFS_OBJ_NAME_LEN)];
+    } entry;
+    SPIFFS_FS_fill_dirent(&sst, &entry.ent);
+
+    st->st_mode = entry.ent.d_mode;
+    st->st_size = (off_t)entry.ent.d_size;
+    st->st_blksize = (blksize_t)SPIFFS_CFG_LOG_PAGE_SZ(sfs->efs.fs);
+    st->st_mtime = entry.ent.d_modificaion_ts;
+    return 0;
+}
+
+/***************************************************************************/
+/** @implements FD_implement
+****************************************************************************/
+static ssize_t SPIFFS_FS_read(int fd, void *buf, size_t bufsize)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (FD_TAG_DIR & AsFD(fd)->tag)
+    {
+        if (bufsize < SPIFFS_FS_implement.dirent_size)
+            return __set_errno_neg(EINVAL);
+        if (SPIFFS_FS_POS_END == AsFD(fd)->position)
+            return 0;
+
+        /// @readdir: position holds spiffs_DIR cursor of (block << 16 | entry)
+        spiffs_DIR dir;
+        spiffs_stat st;
+
+        SPIFFS_FS_dir_seek(sfs, &dir, AsFD(fd)->position);
+        if (! SPIFFS_FS_dir_next(sfs, &dir, &st))
+        {
+            AsFD(fd)->position = SPIFFS_FS_POS_END;
+            return 0;
+        }
+        AsFD(fd)->position = SPIFFS_FS_DIR_POS(&dir);
+
+        SPIFFS_FS_fill_dirent(&st, buf);
+        return (ssize_t)SPIFFS_FS_implement.dirent_size;
+    }
+    else
+    {
+        s32_t retval = SPIFFS_read(sfs->efs.fs, (spiffs_file)fsio->ino_working, buf, (s32_t)bufsize);
+
+        if (0 > retval)
+        {
+            if (SPIFFS_ERR_END_OF_OBJECT == SPIFFS_errno(sfs->efs.fs))
+            {
+                SPIFFS_clearerr(sfs->efs.fs);
+                return 0;
+            }
+            return SPIFFS_FS_error(sfs->efs.fs);
+        }
+
+        AsFD(fd)->position += (uintptr_t)retval;
+        return retval;
+    }
+}
+
+static ssize_t SPIFFS_FS_write(int fd, void const *buf, size_t count)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (FD_TAG_DIR & AsFD(fd)->tag)
+        return __set_errno_neg(EISDIR);
+
+    s32_t retval = SPIFFS_write(sfs->efs.fs, (spiffs_file)fsio->ino_working, (void *)buf, (s32_t)count);
+    if (0 > retval)
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    AsFD(fd)->position = (uintptr_t)SPIFFS_tell(sfs->efs.fs, (spiffs_file)fsio->ino_working);
+    if (AsFD(fd)->position > fsio->size)
+        fsio->size = AsFD(fd)->position;
+
+    return retval;
+}
+
+static off_t SPIFFS_FS_seek(int fd, off_t offset, int origin)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (FD_TAG_DIR & AsFD(fd)->tag)
+    {
+        /// directory position is opaque, only telldir() / seekdir() / rewinddir() make sense
+        if (SEEK_SET == origin)
+            AsFD(fd)->position = (uintptr_t)offset;
+        else if (SEEK_CUR != origin || 0 != offset)
+            return __set_errno_neg(EINVAL);
+
+        return (off_t)AsFD(fd)->position;
+    }
+
+    int whence;
+    switch (origin)
+    {
+    case SEEK_SET:
+        whence = SPIFFS_SEEK_SET;
+        break;
+    case SEEK_CUR:
+        whence = SPIFFS_SEEK_CUR;
+        break;
+    case SEEK_END:
+        whence = SPIFFS_SEEK_END;
+        break;
+    default:
+        return __set_errno_neg(EINVAL);
+    }
+
+    s32_t pos = SPIFFS_lseek(sfs->efs.fs, (spiffs_file)fsio->ino_working, (s32_t)offset, whence);
+    if (0 > pos)
+        return SPIFFS_FS_error(sfs->efs.fs);
+
+    AsFD(fd)->position = (uintptr_t)pos;
+    return pos;
+}
+
+static int SPIFFS_FS_close(int fd)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    if (FD_TAG_DIR & AsFD(fd)->tag)
+        return 0;
+
+    spiffs_file fh = (spiffs_file)fsio->ino_working;
+
+    mutex_lock(sfs->lock);
+    struct SPIFFS_FS_ixmap *ixmap = sfs->ixmaps[fh - 1];
+
+    if (ixmap)
+    {
+        SPIFFS_ix_unmap(sfs->efs.fs, fh);
+        sfs->ixmaps[fh - 1] = NULL;
+        KERNEL_mfree(ixmap);
+    }
+
+    int retval = 0;
+    if (SPIFFS_OK != SPIFFS_close(sfs->efs.fs, fh))
+        retval = SPIFFS_FS_error(sfs->efs.fs);
+
+    sfs->opened --;
+    mutex_unlock(sfs->lock);
+
+    return retval;
+}
+
+static int SPIFFS_FS_sync(int fd)
+{
+    struct fsio_t *fsio = AsFD(fd)->fsio;
+    struct SPIFFS_FS *sfs = fsio->data;
+
+    /// spiffs' own page cache of the file first, then the sectors under it
+    if (! (FD_TAG_DIR & AsFD(fd)->tag) &&
+        SPIFFS_OK > SPIFFS_fflush(sfs->efs.fs, (spiffs_file)fsio->ino_working))
+    {
+        return SPIFFS_FS_error(sfs->efs.fs);
+    }
+
+    if (sfs->bcache)
+        return BCACHE_sync(sfs->bcache);
+    else
+        return 0;
+}
+
+/***************************************************************************/
+/** @implements spiffs hal through BCACHE
+****************************************************************************/
+/// NOTE: spiffs_t::user_data is &SPIFFS_FS::efs, the first member
+static s32_t SPIFFS_FS_hal_read(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *dst)
+{
+    struct SPIFFS_FS *sfs = fs->user_data;
+
+    if ((ssize_t)size != BCACHE_pread(sfs->bcache, dst, size, addr))
+        return -1;
+    else
+        return 0;
+}
+
+static s32_t SPIFFS_FS_hal_write(spiffs *fs, uint32_t addr, uint32_t size, uint8_t *src)
+{
+    struct SPIFFS_FS *sfs = fs->user_data;
+    uint8_t buf[SPIFFS_FS_HAL_CHUNK];
+
+    /// NOR programming only clears bits, spiffs relies on it to mark pages over written ones
+    while (size)
+    {
+        uint32_t chunk = size < sizeof(buf) ? size : sizeof(buf);
+
+        if ((ssize_t)chunk != BCACHE_pread(sfs->bcache, buf, chunk, addr))
+            return -1;
+        for (uint32_t i = 0; i < chunk; i ++)
+            buf[i] &= src[i];
+        if ((ssize_t)chunk != BCACHE_pwrite(sfs->bcache, buf, chunk, addr))
+            return -1;
+
+        addr += chunk;
+        src += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+static s32_t SPIFFS_FS_hal_erase(spiffs *fs, uint32_t addr, uint32_t size)
+{
+    static uint8_t const erased[SPIFFS_FS_HAL_CHUNK] =
+        {[0 ... SPIFFS_FS_HAL_CHUNK - 1] = 0xFF};
+    struct SPIFFS_FS *sfs = fs->user_data;
+
+    /// the real erase happens on write back of the sector, PARTITION_bcache_device()
+    while (size)
+    {
+        uint32_t chunk = size < sizeof(erased) ? size : sizeof(erased);
+
+        if ((ssize_t)chunk != BCACHE_pwrite(sfs->bcache, erased, chunk, addr))
+            return -1;
+
+        addr += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+/***************************************************************************/
+/** @private
+****************************************************************************/
+static struct SPIFFS_FS *SPIFFS_FS_root_instance(void)
+{
+    if (NULL == SPIFFS_FS_root)
+    {
+        static struct SPIFFS_FS_config const config =
+        {
+            .partition_label = NULL,
+            .format_if_mount_failed = true,
+            .max_files = SPIFFS_FS_ROOT_MAX_FILES,
+            .cache_pages = SPIFFS_FS_ROOT_CACHE_PAGES,
+            .ix_map_entries = SPIFFS_FS_ROOT_IX_MAP_ENTRIES,
+            .bcache_blocks = SPIFFS_FS_ROOT_BCACHE_BLOCKS,
+        };
+
+        mutex_lock(&SPIFFS_FS_root_lock);
+        if (NULL == SPIFFS_FS_root)
+            SPIFFS_FS_root = SPIFFS_FS_create(&config);
+        mutex_unlock(&SPIFFS_FS_root_lock);
+    }
+    return SPIFFS_FS_root;
+}
+
+static int SPIFFS_FS_mount(struct SPIFFS_FS *sfs)
+{
+    esp_spiffs_t *efs = &sfs->efs;
+
+    efs->fds_sz = sfs->config.max_files * sizeof(spiffs_fd);
+    efs->fds = KERNEL_mallocz(efs->fds_sz);
+    sfs->ixmaps = KERNEL_mallocz(sfs->config.max_files * sizeof(struct SPIFFS_FS_ixmap *));
+
+#if SPIFFS_CACHE
+    if (sfs->config.cache_pages)
+    {
+        efs->cache_sz = sizeof(spiffs_cache) +
+            sfs->config.cache_pages * (sizeof(spiffs_cache_page) + efs->cfg.log_page_size);
+        efs->cache = KERNEL_mallocz(efs->cache_sz);
+    }
+    else
+    {
+        efs->cache_sz = 0;
+        efs->cache = NULL;
+    }
+    if (sfs->config.cache_pages && ! efs->cache)
+    {
+        SPIFFS_FS_unmount(sfs);
+        return __set_errno_neg(ENOMEM);
+    }
+#endif
+
+    if (! efs->fds || ! sfs->ixmaps)
+    {
+        SPIFFS_FS_unmount(sfs);
+        return __set_errno_neg(ENOMEM);
+    }
+
+    if (SPIFFS_OK != SPIFFS_mount(efs->fs, &efs->cfg, efs->work, efs->fds, efs->fds_sz,
+        efs->cache, efs->cache_sz, spiffs_api_check))
+    {
+        /// keeps SPIFFS_errno() for caller to decide formatting
+        SPIFFS_FS_unmount(sfs);
+        return __set_errno_neg(ENODEV);
+    }
+    return 0;
+}
+
+static void SPIFFS_FS_unmount(struct SPIFFS_FS *sfs)
+{
+    esp_spiffs_t *efs = &sfs->efs;
+
+    if (efs->fs && SPIFFS_mounted(efs->fs))
+        SPIFFS_unmount(efs->fs);
+
+    if (efs->fds)
+    {
+        KERNEL_mfree(efs->fds);
+        efs->fds = NULL;
+    }
+    if (efs->cache)
+    {
+        KERNEL_mfree(efs->cache);
+        efs->cache = NULL;
+    }
+    if (sfs->ixmaps)
+    {
+        KERNEL_mfree(sfs->ixmaps);
+        sfs->ixmaps = NULL;
+    }
+}
+
+static int SPIFFS_FS_file_opened(struct SPIFFS_FS *sfs, struct fsio_t *fsio, spiffs_file fh)
+{
+    /// NOTE: ino_working holds spiffs file handle of regular file
+    fsio->ino_working = (ino_t)fh;
+
+    int fd = KERNEL_createfd(FD_TAG_REG, &SPIFFS_FS_fsio, fsio);
+    if (-1 == fd)
+    {
+        SPIFFS_close(sfs->efs.fs, fh);
+        return fd;
+    }
+
+    mutex_lock(sfs->lock);
+    sfs->opened ++;
+
+    spiffs_stat st;
+    if (SPIFFS_OK == SPIFFS_fstat(sfs->efs.fs, fh, &st))
+        fsio->size = st.size;
+    else
+        SPIFFS_clearerr(sfs->efs.fs);
+
+#if SPIFFS_IX_MAP
+    /// @index map of file start, failure only lose the acceleration
+    uint16_t entries = sfs->config.ix_map_entries;
+    if (entries)
+    {
+        struct SPIFFS_FS_ixmap *ixmap =
+            KERNEL_malloc(sizeof(struct SPIFFS_FS_ixmap) + entries * sizeof(spiffs_page_ix));
+
+        if (ixmap)
+        {
+            if (SPIFFS_OK == SPIFFS_ix_map(sfs->efs.fs, fh, &ixmap->map, 0,
+                SPIFFS_ix_map_entries_to_bytes(sfs->efs.fs, entries), ixmap->entries))
+            {
+                sfs->ixmaps[fh - 1] = ixmap;
+            }
+            else
+            {
+                SPIFFS_clearerr(sfs->efs.fs);
+                KERNEL_mfree(ixmap);
+            }
+        }
+    }
+#endif
+
+    mutex_unlock(sfs->lock);
+    return fd;
+}
+
+static void SPIFFS_FS_dir_seek(struct SPIFFS_FS *sfs, spiffs_DIR *dir, uintptr_t position)
+{
+    memset(dir, 0, sizeof(*dir));
+
+    dir->fs = sfs->efs.fs;
+    dir->block = (spiffs_block_ix)(position >> 16);
+    dir->entry = (int)(position & 0xFFFF);
+}
+
+static bool SPIFFS_FS_dir_next(struct SPIFFS_FS *sfs, spiffs_DIR *dir, spiffs_stat *st)
+{
+    struct spiffs_dirent out;
+
+    while (true)
+    {
+        if (NULL == SPIFFS_readdir(dir, &out))
+        {
+            SPIFFS_clearerr(sfs->efs.fs);
+            return false;
+        }
+
+        /// flat: skip names not reachable by path walking
+        char const *name = (char const *)out.name;
+        if ('/' == name[0])
+            name ++;
+        if (NULL == strchr(name, '/'))
+            break;
+    }
+
+    memset(st, 0, sizeof(*st));
+    st->obj_id = out.obj_id;
+    st->size = out.size;
+    st->type = out.type;
+    st->pix = out.pix;
+    memcpy(st->name, out.name, sizeof(st->name));
+#if SPIFFS_OBJ_META_LEN
+    memcpy(st->meta, out.meta, sizeof(st->meta));
+#endif
+    return true;
+}
+
+static void SPIFFS_FS_fill_dirent(spiffs_stat const *st, struct dirent *ent)
+{
+    char const *name = (char const *)st->name;
+    if ('/' == name[0])
+        name ++;
+
+    ent->d_filesystem = NULL;
+    ent->d_mode = S_IFREG | S_IRWXU | S_IRWXG | S_IRWXO;
+    ent->d_ino = (ino_t)st->obj_id;
+    ent->d_size = st->size;
+    ent->d_creation_ts = 0;
+    ent->d_modificaion_ts = 0;
+
+#ifdef CONFIG_SPIFFS_USE_MTIME
+    #ifdef CONFIG_SPIFFS_MTIME_WIDE_64_BITS
+        time_t mtime;
+    #else
+        unsigned long mtime;
+    #endif
+    memcpy(&mtime, st->meta, sizeof(mtime));
+    ent->d_modificaion_ts = (time_t)mtime;
+#endif
+
+    ent->d_namelen = (uint16_t)strlen(name);
+    memcpy(ent->d_name, name, ent->d_namelen + 1U);
+}
+
+static int SPIFFS_FS_flags(int flags)
+{
+    int retval;
+
+    switch (O_ACCMODE & flags)
+    {
+    case O_WRONLY:
+        retval = SPIFFS_O_WRONLY;
+        break;
+    case O_RDWR:
+        retval = SPIFFS_O_RDWR;
+        break;
+    default:
+        retval = SPIFFS_O_RDONLY;
+        break;
+    }
+
+    if (O_TRUNC & flags)
+        retval |= SPIFFS_O_TRUNC;
+    if (O_APPEND & flags)
+        retval |= SPIFFS_O_APPEND;
+    return retval;
+}
+
+static int SPIFFS_FS_error(spiffs *fs)
+{
+    int err;
+
+    switch (SPIFFS_errno(fs))
+    {
+    case SPIFFS_ERR_NOT_MOUNTED:
+    case SPIFFS_ERR_NOT_A_FS:
+        err = ENODEV;
+        break;
+    case SPIFFS_ERR_FULL:
+        err = ENOSPC;
+        break;
+    case SPIFFS_ERR_BAD_DESCRIPTOR:
+        err = EBADF;
+        break;
+    case SPIFFS_ERR_OUT_OF_FILE_DESCS:
+        err = EMFILE;
+        break;
+    case SPIFFS_ERR_MOUNTED:
+    case SPIFFS_ERR_FILE_EXISTS:
+        err = EEXIST;
+        break;
+    case SPIFFS_ERR_NOT_FOUND:
+    case SPIFFS_ERR_NOT_A_FILE:
+    case SPIFFS_ERR_DELETED:
+    case SPIFFS_ERR_FILE_DELETED:
+        err = ENOENT;
+        break;
+    case SPIFFS_ERR_NAME_TOO_LONG:
+        err = ENAMETOOLONG;
+        break;
+    case SPIFFS_ERR_RO_NOT_IMPL:
+    case SPIFFS_ERR_RO_ABORTED_OPERATION:
+        err = EROFS;
+        break;
+    default:
+        err = EIO;
+        break;
+    }
+
+    SPIFFS_clearerr(fs);
+    return __set_errno_neg(err);
+}
@@ -29,6 +29,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define __XTENSA_API_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "xtensa_context.h"
 
 
@@ -135,4 +136,16 @@ extern void *xt_get_interrupt_handler_arg(int n);
 */
 bool xt_int_has_handler(unsigned int intr, unsigned int cpu);
 
+/*
+-------------------------------------------------------------------------------
+  Call this function to get how many times the specified interrupt was
+  dispatched to its handler. The RTOS tick timer interrupt is not dispatched
+  by the handler table and is not counted.
+
+    intr       - Interrupt number.
+    cpu        - cpu number.
+-------------------------------------------------------------------------------
+*/
+uint32_t xt_int_count(unsigned int intr, unsigned int cpu);
+
 #endif /* __XTENSA_API_H__ */
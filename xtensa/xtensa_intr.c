@@ -86,6 +86,9 @@
 
     extern xt_handler_table_entry _xt_interrupt_table[XCHAL_NUM_INTERRUPTS * SOC_CPU_CORES_NUM];
 
+    /* Dispatch counters, same layout of _xt_interrupt_table, incremented by xtensa_vectors.S */
+    uint32_t _xt_interrupt_count[XCHAL_NUM_INTERRUPTS * SOC_CPU_CORES_NUM] = {0};
+
     /*
     Default handler for unhandled interrupts.
     */
@@ -102,6 +105,15 @@
         return (_xt_interrupt_table[intr * SOC_CPU_CORES_NUM + cpu].handler != xt_unhandled_interrupt);
     }
 
+    uint32_t xt_int_count(unsigned int intr, unsigned int cpu)
+    {
+        if (intr >= XCHAL_NUM_INTERRUPTS || cpu >= SOC_CPU_CORES_NUM)
+            return 0;
+
+        /* only written by the owning core at the interrupt's level, a plain load is coherent */
+        return __atomic_load_n(&_xt_interrupt_count[intr * SOC_CPU_CORES_NUM + cpu], __ATOMIC_RELAXED);
+    }
+
     /*
     This function registers a handler for the specified interrupt. The "arg"
     parameter specifies the argument to be passed to the handler when it is